@@ -0,0 +1,29 @@
+#include <common/bignumber.hpp>
+
+using Construction::Common::BigNumber;
+using Construction::Common::DoNotOptimize;
+
+// Factorial of the argument, i.e. a growing number times a small one
+BENCHMARK(BigNumberMultiply, 20, 50, 100) {
+    while (state.KeepRunning()) {
+        BigNumber result = 1;
+        for (int i=2; i<=state.GetArgument(); ++i) {
+            result *= BigNumber(i);
+        }
+        DoNotOptimize(result);
+    }
+}
+
+// Fibonacci numbers up to the argument
+BENCHMARK(BigNumberAdd, 100, 1000) {
+    while (state.KeepRunning()) {
+        BigNumber a = 0;
+        BigNumber b = 1;
+        for (int i=0; i<state.GetArgument(); ++i) {
+            BigNumber c = a + b;
+            a = std::move(b);
+            b = std::move(c);
+        }
+        DoNotOptimize(b);
+    }
+}
@@ -0,0 +1,94 @@
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <common/benchmark.hpp>
+#include <common/logger.hpp>
+#include <common/task_pool.hpp>
+
+#include "common.cpp"
+#include "tensor.cpp"
+#include "vector.cpp"
+
+/**
+    Runs the micro-benchmarks of the algebra kernels
+
+        bench [--filter <regex>] [--format text|json|csv] [--output <file>]
+              [--min-time <seconds>] [--threads <n>] [--label <text>]
+
+    The number of threads defaults to one, such that the results can be
+    compared across machines and commits.
+ */
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string format = "text";
+    std::string output;
+    std::string label;
+    unsigned threads = 1;
+
+    auto benchmarks = Construction::Common::Benchmarks::Instance();
+
+    for (int i=1; i<argc; ++i) {
+        std::string arg = argv[i];
+
+        if (i+1 >= argc) {
+            std::cerr << "Missing value for `" << arg << "`" << std::endl;
+            return -1;
+        }
+
+        std::string value = argv[++i];
+
+        if (arg == "--filter") filter = value;
+        else if (arg == "--format") format = value;
+        else if (arg == "--output") output = value;
+        else if (arg == "--label") label = value;
+        else if (arg == "--min-time") benchmarks->SetMinimalTime(std::stod(value));
+        else if (arg == "--threads") threads = std::stoi(value);
+        else {
+            std::cerr << "Unknown option `" << arg << "`" << std::endl;
+            return -1;
+        }
+    }
+
+    if (format != "text" && format != "json" && format != "csv") {
+        std::cerr << "Unknown format `" << format << "`" << std::endl;
+        return -1;
+    }
+
+    Construction::Parallel::GlobalTaskPool::Instance()->SetNumberOfThreads(threads);
+
+    // Only report problems
+    Construction::Logger::Screen("screen");
+    Construction::Logger logger;
+    logger.SetDebugLevel("screen", Construction::Common::DebugLevel::WARNING);
+
+    auto results = benchmarks->Run(filter, [](const Construction::Common::BenchmarkResult& result) {
+        std::cerr << std::left << std::setw(32) << result.name << std::right << std::setw(14) << std::fixed << std::setprecision(0) << result.median << " ns" << std::setw(10) << result.iterations << " iterations" << std::endl;
+    });
+
+    if (format == "text") return 0;
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output);
+
+        if (!file.is_open()) {
+            std::cerr << "Could not open `" << output << "`" << std::endl;
+            return -1;
+        }
+    }
+
+    std::ostream& os = output.empty() ? std::cout : file;
+
+    if (format == "json") {
+        Construction::Common::Benchmarks::WriteJSON(os, results, {
+            { "label", label },
+            { "threads", std::to_string(threads) }
+        });
+    } else {
+        Construction::Common::Benchmarks::WriteCSV(os, results);
+    }
+
+    return 0;
+}
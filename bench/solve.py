@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""
+End-to-end benchmarks of `apple solve` over the example scripts.
+
+Every script is solved with a fixed number of threads and a fixed seed in
+its own working directory. The statistics written by `solve --stats` (wall
+time, CPU time, peak memory, number of coefficients and equations, size of
+the largest matrix) are collected into one JSON file and compared against a
+baseline:
+
+    bench/solve.py --output results.json
+    bench/solve.py --baseline baseline.json --tolerance 0.1
+    bench/solve.py --baseline baseline.json --update
+
+Sizes have to match the baseline exactly, times and memory may grow by the
+given tolerance. The exit code is non-zero if any script failed or regressed.
+"""
+
+import argparse
+import json
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+EXAMPLES = [
+    "examples/einstein.es",
+    "examples/areametric/area_sg1.es",
+    "examples/areametric/area_sg2.es",
+    "examples/areametric/area_sg3.es",
+    "examples/areametric/area_sg4.es",
+    "examples/areametric/area_sg5.es",
+    "examples/ptheory/pt_sg1.es",
+    "examples/ptheory/pt_sg2.es",
+    "examples/ptheory/pt_sg3.es",
+    "examples/ptheory/pt_sg4.es",
+    "examples/ptheory/pt_sg5.es",
+    "examples/ptheory/pt_sg6.es",
+]
+
+# Metrics that describe the problem and must not change
+SIZES = ["coefficients", "equations", "matrix_rows", "matrix_columns", "matrix_entries"]
+
+# Metrics that may vary within the tolerance
+TIMES = ["wall_ms", "cpu_ms", "peak_rss_kb"]
+
+
+def solve(args, script, directory):
+    stats = os.path.join(directory, "stats.json")
+
+    command = [args.apple, "solve", "--threads", str(args.threads), "--parallel", str(args.parallel),
+               "--seed", str(args.seed), "--stats", stats, os.path.join(ROOT, script)]
+
+    if args.glob:
+        command.insert(2, "--global")
+
+    # Without the flag, solve never touches the expression database
+    if args.database == "warm":
+        command.insert(2, "--database")
+
+    start = time.time()
+
+    try:
+        subprocess.run(command, cwd=directory, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, timeout=args.timeout)
+    except subprocess.TimeoutExpired:
+        return {"success": False, "error": "timeout after {} s".format(args.timeout)}
+
+    elapsed = (time.time() - start) * 1e3
+
+    if not os.path.exists(stats):
+        return {"success": False, "error": "no statistics written"}
+
+    with open(stats) as file:
+        result = json.load(file)
+
+    result["process_ms"] = int(elapsed)
+    return result
+
+
+def run(args, script):
+    directory = tempfile.mkdtemp(prefix="construct-bench-")
+
+    try:
+        # Fill the expression database first
+        if args.database == "warm":
+            solve(args, script, directory)
+
+        runs = []
+        for _ in range(args.repeat):
+            result = solve(args, script, directory)
+            if not result.get("success", False):
+                return result
+
+            runs.append(result)
+
+        # Report the median of the repetitions
+        result = runs[0]
+        for key in TIMES + ["process_ms"]:
+            result[key] = int(statistics.median(r[key] for r in runs))
+
+        result["repeat"] = len(runs)
+        return result
+    finally:
+        shutil.rmtree(directory, ignore_errors=True)
+
+
+def compare(results, baseline, tolerance):
+    problems = []
+
+    for script, result in results.items():
+        if not result.get("success", False):
+            problems.append("{}: failed ({})".format(script, result.get("error", "solve returned an error")))
+            continue
+
+        expected = baseline.get(script)
+        if expected is None or not expected.get("success", False):
+            continue
+
+        for key in SIZES:
+            if result.get(key, 0) != expected.get(key, 0):
+                problems.append("{}: {} changed from {} to {}".format(script, key, expected.get(key, 0), result.get(key, 0)))
+
+        for key in TIMES:
+            if key not in expected:
+                continue
+
+            limit = expected[key] * (1 + tolerance)
+            if result[key] > limit and result[key] - expected[key] > 10:
+                problems.append("{}: {} regressed from {} to {} (+{:.0f}%)".format(script, key, expected[key], result[key], 100.0 * (result[key] - expected[key]) / max(expected[key], 1)))
+
+    return problems
+
+
+def main():
+    parser = argparse.ArgumentParser(description="End-to-end benchmarks of apple solve")
+    parser.add_argument("scripts", nargs="*", default=EXAMPLES, help="scripts relative to the repository (default: all examples)")
+    parser.add_argument("--apple", default=os.path.join(ROOT, "bin", "apple"), help="path of the apple executable")
+    parser.add_argument("--threads", type=int, default=1, help="number of worker threads")
+    parser.add_argument("--parallel", type=int, default=1, help="number of equations solved in parallel")
+    parser.add_argument("--seed", type=int, default=1, help="seed for the names of the variables")
+    parser.add_argument("--global", dest="glob", action="store_true", help="solve all equations in one system")
+    parser.add_argument("--database", choices=["clean", "warm"], default="clean", help="solve without the expression database, or with `solve --database` after a run that filled it")
+    parser.add_argument("--repeat", type=int, default=1, help="number of runs per script, the median is reported")
+    parser.add_argument("--timeout", type=int, default=3600, help="timeout per run in seconds")
+    parser.add_argument("--output", help="write the results to this file")
+    parser.add_argument("--baseline", help="compare against this file")
+    parser.add_argument("--tolerance", type=float, default=0.1, help="allowed relative growth of times and memory")
+    parser.add_argument("--update", action="store_true", help="write the results into the baseline file")
+    args = parser.parse_args()
+
+    results = {}
+
+    for script in args.scripts:
+        result = run(args, script)
+        results[script] = result
+
+        if result.get("success", False):
+            print("{:40} {:>10} ms {:>10} ms cpu {:>10} kB {:>6} x {:<6}".format(script, result["wall_ms"], result["cpu_ms"], result["peak_rss_kb"], result.get("matrix_rows", 0), result.get("matrix_columns", 0)))
+        else:
+            print("{:40} {}".format(script, result.get("error", "failed")))
+
+        sys.stdout.flush()
+
+    if args.output:
+        with open(args.output, "w") as file:
+            json.dump(results, file, indent=2, sort_keys=True)
+
+    if args.baseline and args.update:
+        with open(args.baseline, "w") as file:
+            json.dump(results, file, indent=2, sort_keys=True)
+        return 0
+
+    problems = []
+
+    if args.baseline:
+        with open(args.baseline) as file:
+            problems = compare(results, json.load(file), args.tolerance)
+    else:
+        problems = compare(results, {}, args.tolerance)
+
+    for problem in problems:
+        print(problem, file=sys.stderr)
+
+    return 1 if problems else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
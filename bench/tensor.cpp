@@ -0,0 +1,210 @@
+#include <language/api.hpp>
+#include <tensor/tensor.hpp>
+#include <tensor/substitution.hpp>
+#include <tensor/expression_database.hpp>
+
+#include <cstdio>
+#include <unistd.h>
+
+using Construction::Common::DoNotOptimize;
+
+namespace {
+
+    Construction::Tensor::Indices Series(unsigned rank) {
+        return Construction::Tensor::Indices::GetRomanSeries(rank, {1,3});
+    }
+
+    /**
+        \brief Open the expression database in a new temporary file
+     */
+    Construction::Tensor::ExpressionDatabase* TemporaryDatabase(std::string& filename) {
+        char name[] = "/tmp/bench_db_XXXXXX";
+        int descriptor = mkstemp(name);
+        if (descriptor >= 0) close(descriptor);
+
+        // Only reserve the name, the database creates the file itself
+        filename = name;
+        std::remove(name);
+
+        auto db = Construction::Tensor::ExpressionDatabase::Instance();
+        db->Initialize(filename);
+        db->Activate();
+        db->Clear();
+        return db;
+    }
+
+    void RemoveDatabase(Construction::Tensor::ExpressionDatabase* db, const std::string& filename) {
+        db->Clear();
+        db->Deactivate();
+        std::remove((filename + "temp").c_str());
+    }
+
+}
+
+BENCHMARK(EpsilonGammaEvaluate, 3, 4, 5, 6) {
+    auto indices = Series(state.GetArgument());
+    auto tensor = Construction::Language::API::EpsilonGamma(indices);
+    auto combinations = tensor.GetAllIndexCombinations();
+
+    while (state.KeepRunning()) {
+        for (auto& combination : combinations) {
+            auto value = tensor(combination);
+            DoNotOptimize(value);
+        }
+    }
+}
+
+BENCHMARK(IndexCombinations, 4, 6, 8) {
+    auto indices = Series(state.GetArgument());
+
+    while (state.KeepRunning()) {
+        unsigned sum = 0;
+        for (auto& combination : indices.GetCombinations()) {
+            sum += combination.back();
+        }
+        DoNotOptimize(sum);
+    }
+}
+
+BENCHMARK(MaterializedIndexCombinations, 4, 6, 8) {
+    auto indices = Series(state.GetArgument());
+
+    while (state.KeepRunning()) {
+        auto combinations = indices.GetAllIndexCombinations();
+        DoNotOptimize(combinations);
+    }
+}
+
+BENCHMARK(Canonicalize, 4, 5, 6, 7, 8) {
+    auto tensor = Construction::Language::API::Arbitrary(Series(state.GetArgument()));
+
+    while (state.KeepRunning()) {
+        auto result = tensor.Canonicalize();
+        DoNotOptimize(result);
+    }
+}
+
+// Symmetrize in the first pair of indices, like the blocks of a coefficient
+BENCHMARK(Symmetrize, 4, 5, 6, 7, 8) {
+    auto indices = Series(state.GetArgument());
+    auto tensor = Construction::Language::API::Arbitrary(indices);
+    auto block = indices.Partial({0, 1});
+
+    while (state.KeepRunning()) {
+        auto result = tensor.Symmetrize(block);
+        DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(Simplify, 4, 5, 6) {
+    auto indices = Series(state.GetArgument());
+    auto tensor = Construction::Language::API::Arbitrary(indices).Symmetrize(indices.Partial({0, 1}));
+
+    while (state.KeepRunning()) {
+        auto result = tensor.Simplify();
+        DoNotOptimize(result);
+    }
+}
+
+// Symmetric in {a b} and {c d}, like a coefficient with two blocks
+BENCHMARK(SimplifySymmetrized, 4, 5, 6) {
+    auto indices = Series(state.GetArgument());
+    auto tensor = Construction::Language::API::Arbitrary(indices).Symmetrize(indices.Partial({0, 1})).Symmetrize(indices.Partial({2, 3}));
+
+    while (state.KeepRunning()) {
+        auto result = tensor.Simplify();
+        DoNotOptimize(result);
+    }
+}
+
+// Only evaluate one component of every orbit of the symmetries
+BENCHMARK(SimplifyWithSymmetry, 4, 5, 6) {
+    auto indices = Series(state.GetArgument());
+    auto tensor = Construction::Language::API::Arbitrary(indices).Symmetrize(indices.Partial({0, 1})).Symmetrize(indices.Partial({2, 3}));
+
+    Construction::Tensor::Symmetry symmetry;
+    symmetry.Add(Construction::Tensor::ElementarySymmetry(std::vector<unsigned>({ 0, 1 })));
+    symmetry.Add(Construction::Tensor::ElementarySymmetry(std::vector<unsigned>({ 2, 3 })));
+
+    while (state.KeepRunning()) {
+        auto result = tensor.Simplify(symmetry);
+        DoNotOptimize(result);
+    }
+}
+
+// Merge chains of substitutions e_i = e_{i+1} + 2 e_{i+2} - 1/3 e_{i+3}
+BENCHMARK(SubstitutionMerge, 4, 8, 16) {
+    using Construction::Tensor::Scalar;
+
+    std::vector<Construction::Tensor::Substitution> substitutions;
+
+    for (unsigned i=1; i<=state.GetArgument(); ++i) {
+        Construction::Tensor::Substitution substitution;
+        substitution.Insert(Scalar::Variable("e", i), Scalar::Variable("e", i+1) + Scalar(2) * Scalar::Variable("e", i+2) - Scalar(1, 3) * Scalar::Variable("e", i+3));
+        substitutions.push_back(substitution);
+    }
+
+    while (state.KeepRunning()) {
+        auto result = Construction::Tensor::Substitution::Merge(substitutions);
+        DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(ScalarAddChain, 10, 100) {
+    using Construction::Tensor::Scalar;
+
+    while (state.KeepRunning()) {
+        Scalar result = Scalar(0);
+        for (unsigned i=1; i<=state.GetArgument(); ++i) {
+            result += Scalar(static_cast<int>(i), 7) * Scalar::Variable("e", i % 10 + 1);
+        }
+        DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(ScalarMultiplyChain, 10, 100) {
+    using Construction::Tensor::Scalar;
+
+    while (state.KeepRunning()) {
+        Scalar result = Scalar(1);
+        for (unsigned i=1; i<=state.GetArgument(); ++i) {
+            result *= Scalar(static_cast<int>(i % 5 + 1), 3);
+        }
+        DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(ExpressionDatabaseInsert) {
+    std::string filename;
+    auto db = TemporaryDatabase(filename);
+
+    Construction::Tensor::Expression expression = Construction::Language::API::Arbitrary(Series(4));
+
+    unsigned i = 0;
+    while (state.KeepRunning()) {
+        db->Insert("Arbitrary(" + std::to_string(i++) + ")", expression);
+    }
+
+    RemoveDatabase(db, filename);
+}
+
+BENCHMARK(ExpressionDatabaseGet) {
+    std::string filename;
+    auto db = TemporaryDatabase(filename);
+
+    Construction::Tensor::Expression expression = Construction::Language::API::Arbitrary(Series(4));
+
+    // More keys than fit into the cache to also read from disk
+    const unsigned keys = 256;
+    for (unsigned i=0; i<keys; ++i) {
+        db->Insert("Arbitrary(" + std::to_string(i) + ")", expression);
+    }
+
+    unsigned i = 0;
+    while (state.KeepRunning()) {
+        auto result = db->Get("Arbitrary(" + std::to_string(i++ % keys) + ")");
+        DoNotOptimize(result);
+    }
+
+    RemoveDatabase(db, filename);
+}
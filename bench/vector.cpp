@@ -0,0 +1,23 @@
+#include <language/api.hpp>
+#include <vector/matrix.hpp>
+
+using Construction::Common::DoNotOptimize;
+
+// System of the equation T_{ab...} = T_{ba...} on an arbitrary tensor,
+// i.e. the kind of sparse rational matrix that comes out of an equation
+BENCHMARK(ToRowEchelonForm, 4, 5, 6) {
+    auto indices = Construction::Tensor::Indices::GetRomanSeries(state.GetArgument(), {1,3});
+    auto exchanged = indices;
+    std::swap(exchanged[0], exchanged[1]);
+
+    auto tensor = Construction::Language::API::Arbitrary(indices);
+    auto equation = tensor - Construction::Language::API::RenameIndices(tensor, indices, exchanged);
+
+    auto matrix = equation.ToHomogeneousLinearSystem().first;
+
+    while (state.KeepRunning()) {
+        auto copy = matrix;
+        copy.ToRowEchelonForm();
+        DoNotOptimize(copy);
+    }
+}
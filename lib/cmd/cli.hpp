@@ -11,6 +11,7 @@
 
 #include <language/cli.hpp>
 #include <language/command.hpp>
+#include <language/command_cache.hpp>
 
 #include <vector/matrix.hpp>
 //#include <vector/linear_system.hpp>
@@ -83,8 +84,22 @@ namespace Construction {
                 return "Open an interactive session to generate tensors. Keep in mind that the coefficient syntax is NOT supported here.";
             }
 
+            void RegisterFlags() {
+                AddLocalFlag<bool>(parallel, "parallel", "p", false, "Execute independent statements of the script concurrently");
+                AddLocalFlag<bool>(lazy, "lazy", "l", false, "Calculate silent assignments only when their value is used");
+                AddLocalFlag<std::string>(database, "database", "D", "", "Also store the results of slow commands in the given expression database, s.t. later sessions can reuse them");
+            }
+
             int Run(const Cobalt::Arguments& args) {
+                // Reuse the results of previous commands. Only if a database is
+                // given, they also survive the session
+                if (!database.empty()) {
+                    Construction::Tensor::ExpressionDatabase::Instance()->Initialize(database);
+                }
+                Construction::Language::CommandCache::Enable();
+
                 Construction::Language::CLI cli;
+                cli.SetLazy(lazy);
 
                 // Hook readline completion
                 rl_attempted_completion_function = &getCommandCompletions;
@@ -92,7 +107,13 @@ namespace Construction {
                 // If there is a filename given, execute this
                 if (args.size() > 0) {
                     std::string filename = args[0];
-                    cli.ExecuteScript(filename);
+
+                    if (parallel) {
+                        cli.ExecuteScriptInParallel(filename);
+                    } else {
+                        cli.ExecuteScript(filename);
+                    }
+
                     return 0;
                 }
 
@@ -112,7 +133,11 @@ namespace Construction {
                         std::cin >> input;
 
                         if (input == "Y") {
-                            Construction::Language::Session::Instance()->LoadFromFile(crashFile);
+                            try {
+                                Construction::Language::Session::Instance()->Restore(crashFile);
+                            } catch (const Construction::Language::CannotOpenSessionException& e) {
+                                Construction::Logger::Error("Could not restore the previous session");
+                            }
                             break;
                         } else if (input == "n") break;
                         else
@@ -127,7 +152,7 @@ namespace Construction {
 
                     if (input == "Exit") {
                         // Delete crash file
-                        remove(crashFile.c_str());
+                        Construction::Language::Session::RemoveCheckpoint(crashFile);
 
                         std::cout << "Bye!" << std::endl;
                         break;
@@ -141,6 +166,10 @@ namespace Construction {
 
                 return 0;
             }
+        private:
+            bool parallel;
+            bool lazy;
+            std::string database;
         };
 
     }
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cobalt.hpp>
+
+#include <fstream>
+#include <sstream>
+
+#include <server/client.hpp>
+
+namespace Construction {
+    namespace Cmd {
+
+        class RemoteCommand : public Cobalt::Command<RemoteCommand> {
+        public:
+            static std::string Use() {
+                return "remote [filename]";
+            }
+
+            static std::string Short() {
+                return "Solve a script file on a running construction server";
+            }
+
+            static std::string Long() {
+                return "Send a script file or CLI commands to a running construction server and print the result. The coefficients generated by previous jobs of the server are reused.";
+            }
+
+            void RegisterFlags() {
+                AddLocalFlag<std::string>(path, "socket", "u", "construction.sock", "Path of the Unix domain socket of the server");
+                AddLocalFlag<std::string>(command, "execute", "e", "", "Execute CLI commands instead of solving a script file");
+                AddLocalFlag<bool>(status, "status", "i", false, "Print the status of the server");
+                AddLocalFlag<bool>(stop, "shutdown", "q", false, "Stop the server after the running jobs");
+                AddLocalFlag<int>(parallelEqns, "parallel", "p", 1, "Number of equations that are solved in parallel");
+                AddLocalFlag<bool>(abc, "abc", "a", false, "Do not print the full tensors but only the scalars in front of base tensors");
+                AddLocalFlag<bool>(colored, "colored", "c", false, "Prettify the output");
+                AddLocalFlag<bool>(global, "global", "g", false, "Solve all equations at once in one sparse linear system");
+                AddLocalFlag<int>(seed, "seed", "s", 0, "Seed for the names of the variables (0 = random)");
+            }
+
+            int Run(const Cobalt::Arguments& args) {
+                using Construction::Server::Message;
+
+                Construction::Server::Client client (path);
+
+                if (status) return client.Submit(Message::Type::STATUS, "", std::cout, std::cerr);
+                if (stop) return client.Submit(Message::Type::SHUTDOWN, "", std::cout, std::cerr);
+
+                // Execute the commands in the server's session
+                if (!command.empty()) return client.Submit(Message::Type::COMMAND, command, std::cout, std::cerr);
+
+                // Send the content of the script
+                if (args.size() == 0) {
+                    std::cerr << "You need to specify a file to solve" << std::endl;
+                    return -1;
+                }
+
+                std::ifstream file (args[0]);
+                if (!file.is_open()) {
+                    std::cerr << "Could not open `" << args[0] << "`" << std::endl;
+                    return -1;
+                }
+
+                std::stringstream script;
+                script << file.rdbuf();
+
+                client.SetOption("parallel", std::to_string(parallelEqns));
+                client.SetOption("abc", abc ? "1" : "0");
+                client.SetOption("colored", colored ? "1" : "0");
+                client.SetOption("global", global ? "1" : "0");
+                client.SetOption("seed", std::to_string(seed));
+
+                return client.Submit(Message::Type::SOLVE, script.str(), std::cout, std::cerr);
+            }
+        private:
+            std::string path;
+            std::string command;
+            bool status;
+            bool stop;
+            int parallelEqns;
+            bool abc;
+            bool colored;
+            bool global;
+            int seed;
+        };
+
+    }
+}
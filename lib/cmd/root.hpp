@@ -4,11 +4,12 @@
 
 #include <cmd/solve.hpp>
 #include <cmd/cli.hpp>
+#include <cmd/remote.hpp>
 
 namespace Construction {
     namespace Cmd {
 
-        class RootCommand : public Cobalt::Command<RootCommand, SolveCommand, CliCommand> {
+        class RootCommand : public Cobalt::Command<RootCommand, SolveCommand, CliCommand, RemoteCommand> {
         public:
             static std::string Use() {
                 return "apple";
@@ -24,6 +25,9 @@ namespace Construction {
 
             void RegisterFlags() {
                 AddPersistentFlag<bool>(debugMode, "debug", "d", false, "Print everything that is happening");
+                AddPersistentFlag<int>(threads, "threads", "t", 0, "Number of threads (0 = one per hardware thread)");
+                AddPersistentFlag<bool>(pin, "pin", "P", false, "Pin the worker threads to the CPU cores");
+                AddPersistentFlag<bool>(profile, "profile", "r", false, "Profile the calculation and print the timings at the end");
             }
 
             void PersistentPreRun(const Cobalt::Arguments& args) {
@@ -44,9 +48,20 @@ namespace Construction {
                 std::cerr << "        \\  .-,   )-.  /           " << std::endl;
                 std::cerr << "         /`  .'-'.  `\\            " << std::endl;
                 std::cerr << "        ;_.-`.___.'-.;             " << std::endl << std::endl;
+
+                // Configure the global executor and the scheduler
+                Construction::Equations::SetNumberOfThreads(std::max(threads, 0));
+                Construction::Parallel::GlobalTaskPool::Instance()->SetPinning(pin);
+
+                if (profile) {
+                    Construction::Common::Profiler::Enable();
+                }
             }
         private:
             bool debugMode;
+            int threads;
+            bool pin;
+            bool profile;
         };
 
     }
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cobalt.hpp>
+
+#include <common/logger.hpp>
+#include <common/task_pool.hpp>
+#include <equations/coefficient.hpp>
+#include <equations/scheduler.hpp>
+#include <tensor/expression_database.hpp>
+#include <language/command_cache.hpp>
+
+#include <server/server.hpp>
+
+namespace Construction {
+    namespace Cmd {
+
+        class ServerCommand : public Cobalt::Command<ServerCommand> {
+        public:
+            static std::string Use() {
+                return "construction-server";
+            }
+
+            static std::string Short() {
+                return "Solve scripts for the `apple remote` clients";
+            }
+
+            static std::string Long() {
+                return "Run a server on a Unix domain socket that solves scripts and executes commands for the `apple remote` clients. The caches and the generated coefficients are kept between the jobs.";
+            }
+
+            void RegisterFlags() {
+                AddLocalFlag<std::string>(path, "socket", "s", "construction.sock", "Path of the Unix domain socket");
+                AddLocalFlag<int>(jobs, "jobs", "j", 2, "Number of jobs that are handled at the same time (at most one script and one CLI job)");
+                AddLocalFlag<int>(threads, "threads", "t", 0, "Number of threads (0 = one per hardware thread)");
+                AddLocalFlag<int>(cacheSize, "cache-size", "c", 512, "Memory of the cached coefficients in MiB, older ones are dropped first");
+                AddLocalFlag<bool>(database, "database", "D", false, "Also store the generated coefficients in the expression database on disk");
+                AddLocalFlag<bool>(debugMode, "debug", "d", false, "Print everything that is happening");
+            }
+
+            int Run(const Cobalt::Arguments& args) {
+                Construction::Logger::Screen("screen");
+
+                Construction::Logger logger;
+                logger.SetDebugLevel("screen", debugMode ? Construction::Common::DebugLevel::DEBUG : Construction::Common::DebugLevel::INFO);
+
+                // Configure the global executor and the scheduler
+                Construction::Equations::SetNumberOfThreads(std::max(threads, 0));
+
+                // Share the generated coefficients and command results between the jobs
+                Construction::Equations::CoefficientCache::Enable();
+                Construction::Equations::CoefficientCache::Instance()->SetMaximalSize(static_cast<size_t>(std::max(cacheSize, 1)) * 1024 * 1024);
+                Construction::Language::CommandCache::Enable();
+
+                Construction::Tensor::ExpressionDatabase::Instance()->Initialize("construct.db");
+                if (!database) {
+                    Construction::Tensor::ExpressionDatabase::Instance()->Deactivate();
+                }
+
+                Construction::Server::Server server (path, std::max(jobs, 1));
+
+                if (!server.Listen()) return -1;
+
+                server.Run();
+                return 0;
+            }
+        private:
+            std::string path;
+            int jobs;
+            int threads;
+            int cacheSize;
+            bool database;
+            bool debugMode;
+        };
+
+    }
+}
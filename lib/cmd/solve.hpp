@@ -5,40 +5,20 @@
 #define RECOVER_FROM_EXCEPTIONS 	0
 #define DEBUG_MODE
 
-#include <regex>
+#include <iomanip>
 #include <common/logger.hpp>
+#include <common/trace.hpp>
+#include <common/statistics.hpp>
+#include <common/profiler.hpp>
+#include <common/memory.hpp>
 
-#include <equations/equations.hpp>
+#include <equations/solver.hpp>
 #include <tensor/expression_database.hpp>
 #include <common/progressbar.hpp>
 
 namespace Construction {
     namespace Cmd {
 
-        std::string TrimLeft(const std::string& str, char c = ' ') {
-            std::string output = str;
-
-            while (output.size() > 0 && output[0] == c) {
-                output = output.substr(1);
-            }
-
-            return output;
-        }
-
-        std::string TrimRight(const std::string& str, char c = ' ') {
-            std::string output = str;
-
-            while (output.size() > 0 && output[output.size()-1] == c) {
-                output = output.substr(0, output.size()-1);
-            }
-
-            return output;
-        }
-
-        std::string Trim(const std::string& str, char c = ' ') {
-            return TrimLeft(TrimRight(str, c), c);
-        }
-
         class SolveCommand : public Cobalt::Command<SolveCommand> {
         public:
             static std::string Use() {
@@ -57,6 +37,11 @@ namespace Construction {
                 AddLocalFlag<int>(parallelEqns, "parallel", "p", 1, "Number of equations that are solved in parallel");
                 AddLocalFlag<bool>(abc, "abc", "a", false, "Do not print the full tensors but only the scalars in front of base tensors");
                 AddLocalFlag<bool>(colored, "colored", "c", false, "Prettify the output");
+                AddLocalFlag<bool>(global, "global", "g", false, "Solve all equations at once in one sparse linear system");
+                AddLocalFlag<std::string>(traceFile, "trace", "T", "", "Write a timeline of the calculation in the Chrome trace format to the file");
+                AddLocalFlag<std::string>(statsFile, "stats", "S", "", "Write the time, memory and size of the calculation as JSON to the file");
+                AddLocalFlag<int>(seed, "seed", "s", 0, "Seed for the names of the variables (0 = random)");
+                AddLocalFlag<bool>(database, "database", "D", false, "Reuse and store the generated tensors in the expression database `construct.db`");
             }
 
             int Run(const Cobalt::Arguments& args) {
@@ -71,99 +56,65 @@ namespace Construction {
                     return -1;
                 }
 
-                // Add options for debugging
-                Construction::Equations::SubstitutionManager::Instance()->SetMaxTickets(parallelEqns);
-
                 if (Lookup<bool>("debug")) {
                     logger.SetDebugLevel("screen", Construction::Common::DebugLevel::DEBUG);
                 }
 
+                if (!traceFile.empty()) {
+                    Construction::Common::Trace::Enable();
+                }
+
+                if (seed != 0) {
+                    Construction::Equations::Coefficient::SetSeed(seed);
+                }
+
                 logger << Construction::Logger::DEBUG << "Start to solve file `" << args[0] << "`" << Construction::Logger::endl;
 
                 Construction::Common::TimeMeasurement time;
 
                 // Initialize database
                 Construction::Tensor::ExpressionDatabase::Instance()->Initialize("construct.db");
-                Construction::Tensor::ExpressionDatabase::Instance()->Deactivate(); // Deactivate for now
+                if (!database) {
+                    Construction::Tensor::ExpressionDatabase::Instance()->Deactivate();
+                }
 
                 // Open file
                 std::ifstream file (args[0]);
                 if (!file.is_open()) return -1;
 
-                std::vector<std::shared_ptr<Construction::Equations::Equation>> equations;
-
-                // Read line per line and add them as equations
-                std::string line;
-                while (std::getline(file, line)) {
-                    // Trim lines to deal with Refik's input
-                    line = Trim(line);
-
-                    // Delete all "\r"s
-                    line = std::regex_replace(line, std::regex("\\r"), "");
-
-                    // Ignore empty lines
-                    if (line == "") continue;
+                Construction::Equations::Solver::Options options;
+                options.parallel = parallelEqns;
+                options.abc = abc;
+                options.colored = colored;
+                options.global = global;
 
-                    // Ignore comments
-                    if (line.size() > 1 && line[0] == '/' && line[1] == '/') continue;
+                Construction::Equations::Solver solver (options, std::cout, std::cerr);
 
-                    // Add the equation
-                    auto eq = std::make_shared<Construction::Equations::Equation>(line);
-
-                    // If the equation isn't empty, add it
-                    if (!eq->IsEmpty()) {
-                        equations.push_back(std::move(eq));
-                    }
-                }
-
-                // Print all the coefficients
-                std::cerr << (colored  ? "\033[32m" : "") << "Coefficients:" << (colored? "\033[0m" : "") << std::endl;
-                for (auto it = Construction::Equations::Coefficients::Instance()->begin(); it != Construction::Equations::Coefficients::Instance()->end(); ++it) {
-                    std::cout << (colored ? "  \033[36m" : "") << it->second->ToString(false) << (colored ? "\033[0m" : "") << std::endl;
-                }
-                std::cerr << std::endl;
-
-                // Print the code
-                for (auto& eq : equations) {
-                    std::cerr<< (colored ? " \033[36m" : " ") << "> " << eq->ToLaTeX() << "\033[0m" << std::endl;
-                }
-                std::cerr << std::endl;
-
-                // Calculate number of coefficients and equations
-                int numberOfSteps = equations.size() + Construction::Equations::Coefficients::Instance()->GetNumberOfSteps();
+                // Read line per line and add them as equations
+                solver.Load(file);
+                solver.PrintDefinitions();
 
                 // Create progress bar
-                Construction::Common::ProgressBar progress (numberOfSteps, 100);
-
-                // Register an observer for the coefficients
-                for (auto it = Construction::Equations::Coefficients::Instance()->begin(); it != Construction::Equations::Coefficients::Instance()->end(); ++it) {
-                    it->second->RegisterObserver([&](const Construction::Equations::CoefficientReference&) {
-                        progress++;
-                    });
-                }
-
-                // Register an observer for the equations
-                for (auto& eq : equations) {
-                    eq->RegisterObserver([&](const Construction::Equations::Equation&) {
-                        progress++;
-                    });
-                }
+                Construction::Common::ProgressBar progress (solver.GetNumberOfSteps(), 100);
 
                 // Start progress bar
                 logger << Construction::Logger::INFO << "Start calculating ..." << Construction::Logger::endl;
 
                 progress.Start();
 
-                // Start the generation of all required coefficients
-                Construction::Equations::Coefficients::Instance()->StartAll();
+                try {
+                    solver.Solve([&]() {
+                        progress++;
+                    });
+                } catch (const std::exception& e) {
+                    progress.Stop();
 
-                // Wait for all equations to be solved
-                for (auto& eq : equations) {
-                    eq->Wait();
-                }
+                    Construction::Logger::Error("Could not solve `", args[0], "`: ", e.what());
 
-                // Print the result
-                int offset = 0;
+                    WriteTrace();
+                    WriteStatistics(args[0], solver.GetNumberOfEquations(), time, false);
+                    return -1;
+                }
 
                 // Clean the line
                 for (int i=0; i<200; i++) {
@@ -171,149 +122,102 @@ namespace Construction {
                 }
                 std::cerr << "\r";
 
-                // Collect all the variables in the coefficients
-                std::vector<Construction::Tensor::Scalar> variables;
-                for (auto it = Construction::Equations::Coefficients::Instance()->begin(); it != Construction::Equations::Coefficients::Instance()->end(); ++it) {
-                    auto tensor = *it->second->Get();
-                    auto stuff = tensor.ExtractVariables();
-                    for (auto& pair : stuff) {
-                        auto _it = std::find(variables.begin(), variables.end(), pair.first);
-                        if (_it == variables.end()) variables.push_back(pair.first);
-                    }
-                }
-
-                // Build a substitution
-                Construction::Tensor::Substitution substitution;
-                int pos = 1;
-                for (auto& variable : variables) {
-                    substitution.Insert(variable, Construction::Tensor::Scalar::Variable("e", pos++));
-                }
-
                 // Print the results
-                if (!abc) {
-                    for (auto it = Construction::Equations::Coefficients::Instance()->begin(); it != Construction::Equations::Coefficients::Instance()->end(); ++it) {
-                    //auto tensor = it->second->Get()->RedefineVariables("e", offset);
-                    //auto tensor = substitution(*it->second->GetAsync()).CollectByVariables();
-                    auto tensor = substitution(*it->second->GetAsync());//.Simplify();
-
-                    auto summands = tensor.GetSummands();
-
-                    if (!tensor.IsZeroTensor()) {
-                        offset += summands.size();
-                    }
+                solver.PrintResult();
+                solver.PrintCosts();
 
-                    std::cout << (colored ? "  \033[36m" : "") << it->second->ToString(false) << (colored ? "\033[0m" : "") << " = " << std::endl;
-
-                    for (int i=0; i<summands.size(); ++i) {
-                        auto t = summands[i];
-
-                        if (t.IsScaled()) {
-                            auto s = t.SeparateScalefactor();
-                            s.first = s.first.Simplify();
-
-                            std::cout << (colored ? "     \033[32m" : "     ");
-
-                            if (s.first.IsAdded()) {
-                                std::cout << "(" << s.first << ")";
-                            } else {
-                                std::cout << s.first;
-                            }
-
-                            std::cout << (colored ? "\033[0m" : "") << " * " << (colored ? "\033[33m" : "");
-
-                            if (s.second.IsAdded()) {
-                                std::cout << "(" << s.second << ")";
-                            } else std::cout << s.second;
-                        } else if (t.IsScalar()) {
-                            std::cout << "     " << (colored ? "\033[32m" : "") << t.ToString();
-                        } else {
-                            std::cout << "     " << (colored ? "\033[33m" : "") << t.ToString();
-                        }
-
-                        if (colored) std::cout << "\033[0m";
-
-                        if (i < summands.size()-1) std::cout << " + ";
+                // Print the memory of the results and the allocation counters
+                {
+                    auto coefficients = Construction::Equations::Coefficients::Instance()->MemoryFootprint();
+                    auto cache = Construction::Tensor::ExpressionDatabase::Instance()->MemoryFootprint();
 
-                        std::cout << std::endl;
-                    }
+                    std::cerr << (colored  ? "\033[32m" : "") << "Memory:" << (colored? "\033[0m" : "") << std::endl;
+                    std::cerr << "  Coefficients: " << Construction::Common::MemoryStatistics::FormatBytes(coefficients) << std::endl;
+                    std::cerr << "  Database cache: " << Construction::Common::MemoryStatistics::FormatBytes(cache) << std::endl;
+                    std::cerr << "  Peak RSS: " << Construction::Common::MemoryStatistics::FormatBytes(Construction::Common::Statistics::GetPeakMemory() * 1024) << std::endl << std::endl;
 
-                    std::cout << std::endl;
+                    Construction::Common::MemoryStatistics::Print(std::cerr);
+                    std::cerr << std::endl;
                 }
-                } else {
-    int coeffPos = 1;
-    for (auto it = Construction::Equations::Coefficients::Instance()->begin(); it != Construction::Equations::Coefficients::Instance()->end(); ++it) {
-        //auto tensor = it->second->Get()->RedefineVariables("e", offset);
-        //auto tensor = substitution(*it->second->GetAsync()).CollectByVariables();
-        auto tensor = substitution(*it->second->GetAsync()).Simplify();
 
-        auto summands = tensor.GetSummands();
-
-        if (!tensor.IsZeroTensor()) {
-            offset += summands.size();
-        }
-
-        std::cout << (colored ? "  \033[36m" : "") << it->second->ToString(false) << (colored ? "\033[0m" : "") << " : " << std::endl;
-
-        for (int i=0; i<summands.size(); ++i) {
-            auto t = summands[i];
-
-            if (t.IsScaled()) {
-                auto s = t.SeparateScalefactor();
-                auto abc = Construction::Tensor::Scalar(s.second.GetSummands().size(), 1) * s.first;
+                // Print the timings of the profiler
+                if (Construction::Common::Profiler::IsEnabled()) {
+                    std::cerr << (colored  ? "\033[32m" : "") << "Profile:" << (colored? "\033[0m" : "") << std::endl;
+                    Construction::Common::Profiler::Instance()->Print(std::cerr);
+                    std::cerr << std::endl;
+                }
 
-                std::cout << "     " << (colored ? "\033[32m" : "");
+                time.Stop();
+                std::cerr << time << std::endl;
 
-                char c = 'a' + static_cast<char>(i);
+                std::cerr << "Finished." << std::endl;
 
-                std::cout << c << coeffPos << " = " << abc.ToString();
-            } else if (t.IsScalar()) {
-                std::cout << "     " << (colored ? "\033[32m" : "") << t.ToString();
-            } else {
-                std::cout << "     " << (colored ? "\033[33m" : "") << t.ToString();
+                WriteTrace();
+                WriteStatistics(args[0], solver.GetNumberOfEquations(), time, true);
+                return 0;
             }
+        private:
+            void WriteTrace() const {
+                if (traceFile.empty()) return;
 
-            if (colored) std::cout << "\033[0m";
-
-            std::cout << std::endl;
-        }
+                Construction::Common::Trace::Disable();
 
-        std::cout << std::endl;
-        coeffPos++;
+                if (!Construction::Common::Trace::Instance()->Write(traceFile)) {
+                    Construction::Logger::Error("Could not write the trace to `", traceFile, "`");
                 }
+            }
 
+            /**
+                Writes the statistics of the run, which are read by the
+                end-to-end benchmarks in bench/solve.py
+             */
+            void WriteStatistics(const std::string& filename, size_t numberOfEquations, const Construction::Common::TimeMeasurement& time, bool success) const {
+                if (statsFile.empty()) return;
+
+                std::ofstream file (statsFile);
+                if (!file.is_open()) {
+                    Construction::Logger::Error("Could not write the statistics to `", statsFile, "`");
+                    return;
                 }
 
-                // Finally check all the coefficients
-                /*
-                {
-                    Construction::Logger::Debug("Run a final test ...");
-                    int violations = 0;
-                    for (auto &eq : equations) {
-                        Construction::Tensor::Tensor result;
-
-                        // Check the equation
-                        auto correct = eq->Test(&result);
-
-                        if (!correct) {
-                            Construction::Logger::Error("Equation `", eq->ToLaTeX(), "` is violated.\nFound ", result);
-                            ++violations;
-                        }
-                    }
-                    Construction::Logger::Debug("Found ", violations, " violation(s)");
+                file << "{" << std::endl;
+                file << "  \"file\": \"" << filename << "\"," << std::endl;
+                file << "  \"success\": " << (success ? "true" : "false") << "," << std::endl;
+                file << "  \"threads\": " << Construction::Parallel::GlobalTaskPool::Instance()->GetNumberOfThreads() << "," << std::endl;
+                file << "  \"parallel\": " << parallelEqns << "," << std::endl;
+                file << "  \"global\": " << (global ? "true" : "false") << "," << std::endl;
+                file << "  \"seed\": " << seed << "," << std::endl;
+                file << "  \"wall_ms\": " << static_cast<long long>(time.GetMilliseconds()) << "," << std::endl;
+                file << "  \"cpu_ms\": " << static_cast<long long>(Construction::Common::Statistics::GetCPUTime()) << "," << std::endl;
+                file << "  \"peak_rss_kb\": " << Construction::Common::Statistics::GetPeakMemory() << "," << std::endl;
+                file << "  \"coefficients\": " << Construction::Equations::Coefficients::Instance()->Size() << "," << std::endl;
+                file << "  \"equations\": " << numberOfEquations << "," << std::endl;
+                file << "  \"coefficients_bytes\": " << Construction::Equations::Coefficients::Instance()->MemoryFootprint() << "," << std::endl;
+                file << "  \"cache_bytes\": " << Construction::Tensor::ExpressionDatabase::Instance()->MemoryFootprint();
+
+                for (auto& counter : Construction::Common::MemoryStatistics::GetAll()) {
+                    file << "," << std::endl << "  \"" << counter.first << "_allocations\": " << counter.second->GetAllocations();
+                    file << "," << std::endl << "  \"" << counter.first << "_peak_bytes\": " << counter.second->GetPeakBytes();
                 }
-                */
 
-                time.Stop();
-                std::cerr << time << std::endl;
+                for (auto& pair : Construction::Common::Statistics::Instance()->GetAll()) {
+                    auto key = pair.first;
+                    std::replace(key.begin(), key.end(), '.', '_');
 
-                std::cerr << "Finished." << std::endl;
+                    file << "," << std::endl << "  \"" << key << "\": " << pair.second;
+                }
 
-                return 0;
+                file << std::endl << "}" << std::endl;
             }
         private:
             int parallelEqns;
             bool abc;
             bool colored;
+            bool global;
+            std::string traceFile;
+            std::string statsFile;
+            int seed;
+            bool database;
         };
 
     }
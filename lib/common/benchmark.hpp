@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <ostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include <common/singleton.hpp>
+
+namespace Construction {
+    namespace Common {
+
+        /**
+            \brief Prevent the compiler from optimizing a value away
+         */
+        template<class T>
+        inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+            asm volatile("" : : "g"(&value) : "memory");
+#else
+            volatile const void* pointer = &value;
+            (void)pointer;
+#endif
+        }
+
+        /**
+            \class BenchmarkState
+
+            \brief Drives the iterations of a single benchmark
+
+            The benchmark does its setup first and then loops with
+
+                while (state.KeepRunning()) { ... }
+
+            Every iteration is timed on its own. The loop runs until the
+            minimal time is reached, but at least the minimal and at most
+            the maximal number of iterations. The first iteration is a
+            warm up and not recorded.
+         */
+        class BenchmarkState {
+        public:
+            typedef std::chrono::steady_clock   clock;
+        public:
+            BenchmarkState(long long argument, double minTime, size_t minIterations, size_t maxIterations)
+                : argument(argument), minTime(minTime), minIterations(minIterations), maxIterations(maxIterations) { }
+        public:
+            bool KeepRunning() {
+                auto now = clock::now();
+
+                if (running) {
+                    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+
+                    if (warmup) {
+                        warmup = false;
+                    } else {
+                        samples.push_back(static_cast<double>(duration));
+                        total += duration * 1e-9;
+                    }
+                }
+
+                running = samples.size() < maxIterations && (samples.size() < minIterations || total < minTime);
+
+                last = clock::now();
+                return running;
+            }
+
+            long long GetArgument() const { return argument; }
+
+            const std::vector<double>& GetSamples() const { return samples; }
+        private:
+            long long argument;
+
+            double minTime;
+            size_t minIterations;
+            size_t maxIterations;
+
+            bool running = false;
+            bool warmup = true;
+            double total = 0;
+
+            clock::time_point last;
+            std::vector<double> samples;
+        };
+
+        /**
+            \class BenchmarkResult
+
+            \brief Statistics of the iterations of one benchmark in nanoseconds
+         */
+        class BenchmarkResult {
+        public:
+            BenchmarkResult(const std::string& name, std::vector<double> samples) : name(name), iterations(samples.size()) {
+                if (samples.empty()) return;
+
+                std::sort(samples.begin(), samples.end());
+
+                min = samples.front();
+                max = samples.back();
+                median = (samples.size() % 2 == 1) ? samples[samples.size()/2] : 0.5 * (samples[samples.size()/2 - 1] + samples[samples.size()/2]);
+
+                for (auto& sample : samples) mean += sample;
+                mean /= samples.size();
+
+                for (auto& sample : samples) stddev += (sample - mean) * (sample - mean);
+                stddev = std::sqrt(stddev / samples.size());
+            }
+        public:
+            std::string name;
+            size_t iterations;
+
+            double mean = 0;
+            double median = 0;
+            double min = 0;
+            double max = 0;
+            double stddev = 0;
+        };
+
+        /**
+            \class Benchmarks
+
+            \brief Registry of all the micro-benchmarks
+
+            Benchmarks are registered with the BENCHMARK macro. A benchmark
+            with arguments is run once for every argument and reported as
+            `Name/argument`.
+         */
+        class Benchmarks : public Singleton<Benchmarks> {
+        public:
+            typedef std::function<void(BenchmarkState&)>    Function;
+
+            struct Entry {
+                std::string name;
+                Function fn;
+                std::vector<long long> arguments;
+            };
+        public:
+            void Register(const std::string& name, Function fn, const std::vector<long long>& arguments) {
+                entries.push_back({ name, fn, arguments });
+            }
+        public:
+            void SetMinimalTime(double time) { minTime = time; }
+            void SetMinimalIterations(size_t n) { minIterations = n; }
+            void SetMaximalIterations(size_t n) { maxIterations = n; }
+        public:
+            /**
+                \brief Run all benchmarks whose name matches the filter
+
+                Calls the callback after every finished benchmark, e.g.
+                to report the progress.
+             */
+            std::vector<BenchmarkResult> Run(const std::string& filter = "", std::function<void(const BenchmarkResult&)> callback = nullptr) const {
+                std::vector<BenchmarkResult> results;
+                std::regex regex (filter.empty() ? ".*" : filter);
+
+                for (auto& entry : entries) {
+                    auto arguments = entry.arguments;
+                    bool hasArguments = !arguments.empty();
+                    if (!hasArguments) arguments.push_back(0);
+
+                    for (auto& argument : arguments) {
+                        auto name = hasArguments ? entry.name + "/" + std::to_string(argument) : entry.name;
+                        if (!std::regex_search(name, regex)) continue;
+
+                        BenchmarkState state (argument, minTime, minIterations, maxIterations);
+                        entry.fn(state);
+
+                        results.emplace_back(name, state.GetSamples());
+                        if (callback) callback(results.back());
+                    }
+                }
+
+                return results;
+            }
+        public:
+            static void WriteJSON(std::ostream& os, const std::vector<BenchmarkResult>& results, const std::vector<std::pair<std::string, std::string>>& context) {
+                os << std::fixed << std::setprecision(1);
+                os << "{" << std::endl << "  \"context\": {";
+
+                for (unsigned i=0; i<context.size(); ++i) {
+                    os << (i > 0 ? "," : "") << std::endl << "    \"" << context[i].first << "\": \"" << context[i].second << "\"";
+                }
+
+                os << std::endl << "  }," << std::endl << "  \"benchmarks\": [";
+
+                for (unsigned i=0; i<results.size(); ++i) {
+                    auto& result = results[i];
+
+                    os << (i > 0 ? "," : "") << std::endl;
+                    os << "    { \"name\": \"" << result.name << "\", \"iterations\": " << result.iterations;
+                    os << ", \"mean_ns\": " << result.mean << ", \"median_ns\": " << result.median;
+                    os << ", \"min_ns\": " << result.min << ", \"max_ns\": " << result.max;
+                    os << ", \"stddev_ns\": " << result.stddev << " }";
+                }
+
+                os << std::endl << "  ]" << std::endl << "}" << std::endl;
+            }
+
+            static void WriteCSV(std::ostream& os, const std::vector<BenchmarkResult>& results) {
+                os << std::fixed << std::setprecision(1);
+                os << "name,iterations,mean_ns,median_ns,min_ns,max_ns,stddev_ns" << std::endl;
+
+                for (auto& result : results) {
+                    os << result.name << "," << result.iterations << "," << result.mean << "," << result.median << ",";
+                    os << result.min << "," << result.max << "," << result.stddev << std::endl;
+                }
+            }
+        private:
+            std::vector<Entry> entries;
+
+            double minTime = 0.5;
+            size_t minIterations = 5;
+            size_t maxIterations = 1000000;
+        };
+
+        class BenchmarkRegistrar {
+        public:
+            BenchmarkRegistrar(const std::string& name, Benchmarks::Function fn, const std::vector<long long>& arguments) {
+                Benchmarks::Instance()->Register(name, fn, arguments);
+            }
+        };
+
+    }
+}
+
+#define BENCHMARK(name, ...) \
+    static void Benchmark##name(Construction::Common::BenchmarkState& state); \
+    static Construction::Common::BenchmarkRegistrar registrar_benchmark_##name (#name, Benchmark##name, { __VA_ARGS__ }); \
+    static void Benchmark##name(Construction::Common::BenchmarkState& state)
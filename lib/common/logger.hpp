@@ -4,6 +4,10 @@
 #include <unordered_map>
 #include <mutex>
 #include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 
@@ -11,6 +15,20 @@
 #include <common/singleton.hpp>
 #include <memory>
 
+/**
+    Minimal level of the messages that are compiled in, see DebugLevel.
+    Messages logged with the LOGGER_* macros above this level are removed
+    by the compiler. By default the debug messages are only compiled in
+    with DEBUG_MODE.
+ */
+#ifndef CONSTRUCTION_LOG_LEVEL
+#ifdef DEBUG_MODE
+#define CONSTRUCTION_LOG_LEVEL 6
+#else
+#define CONSTRUCTION_LOG_LEVEL 5
+#endif
+#endif
+
 namespace Construction {
     namespace Common {
 
@@ -77,6 +95,18 @@ namespace Construction {
             void SetDebugLevel(DebugLevel level) { this->level = level; }
         public:
             virtual void Print(const std::string&) const = 0;
+
+            /**
+                \brief Make sure everything printed so far is written
+             */
+            virtual void Flush() const { }
+
+            /**
+                \brief Stop the background work of the logger
+
+                Messages printed afterwards are written directly.
+             */
+            virtual void Close() { }
         protected:
             void PrintTimestamp() const {
                 if (!includeTimeStamp) return;
@@ -137,6 +167,7 @@ namespace Construction {
                 }
 
                 Print(content + "\n");
+                Flush();
             }
 
             void Error(const std::string& content) const {
@@ -156,6 +187,7 @@ namespace Construction {
                 }
 
                 Print(content + "\n");
+                Flush();
             }
 
             void Warning(const std::string& content) const {
@@ -253,19 +285,133 @@ namespace Construction {
             }
         };
 
+        /**
+            \class FileLogger
+
+            \brief Appends the messages to a file from a background thread
+
+            The messages are collected in a buffer that a writer thread
+            appends to the file, which stays open, whenever the buffer is
+            large enough or some time has passed. Errors are flushed
+            immediately so that they survive a crash. Only the writer thread
+            touches the file until it is closed, afterwards the messages are
+            written directly.
+         */
         class FileLogger : public AbstractLogger {
         public:
-            FileLogger(const std::string& filename) : AbstractLogger(false, true, true, DebugLevel::DEBUG), filename(filename) { }
+            static constexpr size_t BUFFER_SIZE = 64 * 1024;
+        public:
+            FileLogger(const std::string& filename) : AbstractLogger(false, true, true, DebugLevel::DEBUG), filename(filename), file(filename, std::fstream::out | std::fstream::app) {
+                writer = std::thread([this]() { Run(); });
+            }
 
-            virtual ~FileLogger() throw() { }
+            virtual ~FileLogger() throw() {
+                Close();
+            }
         public:
             virtual void Print(const std::string& content) const override {
-                std::ofstream file (filename, std::fstream::out | std::fstream::app);
+                bool full;
+
+                {
+                    std::unique_lock<std::mutex> lock(bufferMutex);
+
+                    if (closed) {
+                        Write(content);
+                        return;
+                    }
+
+                    buffer += content;
+                    full = buffer.size() >= BUFFER_SIZE;
+                }
+
+                if (full) condition.notify_one();
+            }
+
+            /**
+                \brief Wait until the writer thread wrote the buffer
+             */
+            virtual void Flush() const override {
+                std::unique_lock<std::mutex> lock(bufferMutex);
+                if (closed) return;
+
+                auto ticket = ++requested;
+                condition.notify_one();
+
+                flushed.wait(lock, [this, ticket]() { return written >= ticket; });
+            }
+
+            virtual void Close() override {
+                {
+                    std::unique_lock<std::mutex> lock(bufferMutex);
+                    if (stop) return;
+                    stop = true;
+                }
+
+                condition.notify_one();
+                writer.join();
+            }
+        private:
+            void Run() {
+                std::string pending;
+
+                while (true) {
+                    size_t ticket;
+
+                    {
+                        std::unique_lock<std::mutex> lock(bufferMutex);
+                        condition.wait_for(lock, std::chrono::milliseconds(200), [this]() { return stop || requested > written || buffer.size() >= BUFFER_SIZE; });
+
+                        ticket = requested;
+
+                        // Write the rest under the lock, so that the messages
+                        // printed directly afterwards come behind it
+                        if (stop) {
+                            Write(buffer);
+                            buffer.clear();
+
+                            closed = true;
+                            written = ticket;
+                            flushed.notify_all();
+                            return;
+                        }
+
+                        pending.swap(buffer);
+                    }
+
+                    Write(pending);
+                    pending.clear();
+
+                    {
+                        std::unique_lock<std::mutex> lock(bufferMutex);
+                        written = ticket;
+                    }
+
+                    flushed.notify_all();
+                }
+            }
+
+            void Write(const std::string& content) const {
+                if (content.empty()) return;
+
                 file << content;
-                file.close();
+                file.flush();
             }
         private:
             std::string filename;
+
+            mutable std::ofstream file;
+
+            mutable std::string buffer;
+            mutable std::mutex bufferMutex;
+            mutable std::condition_variable condition;
+            mutable std::condition_variable flushed;
+
+            mutable size_t requested = 0;
+            size_t written = 0;
+            bool stop = false;
+            bool closed = false;
+
+            std::thread writer;
         };
 
         class LoggerManager : public Singleton<LoggerManager> {
@@ -280,6 +426,7 @@ namespace Construction {
 
                 }
 
+                UpdateLevel();
                 return result;
             }
 
@@ -293,6 +440,15 @@ namespace Construction {
 
                 }
 
+                // The manager is never destroyed, so write the buffers and
+                // join the writer threads at exit
+                static bool registered = false;
+                if (!registered) {
+                    std::atexit([]() { LoggerManager::Instance()->Close(); });
+                    registered = true;
+                }
+
+                UpdateLevel();
                 return result;
             }
         public:
@@ -302,6 +458,44 @@ namespace Construction {
                 if (it == logger.end()) return;
 
                 it->second->SetDebugLevel(level);
+                UpdateLevel();
+            }
+
+            /**
+                \brief Check if any logger prints messages of the given level
+
+                Only reads an atomic, so it can be used to skip assembling
+                messages nobody will see.
+             */
+            static bool IsEnabled(DebugLevel level) {
+                return static_cast<int>(level) <= Level().load(std::memory_order_relaxed);
+            }
+
+            void Flush() const {
+                for (auto& pair : logger) {
+                    pair.second->Flush();
+                }
+            }
+
+            void Close() {
+                for (auto& pair : logger) {
+                    pair.second->Close();
+                }
+            }
+        private:
+            static std::atomic<int>& Level() {
+                static std::atomic<int> level (static_cast<int>(DebugLevel::NOTHING));
+                return level;
+            }
+
+            void UpdateLevel() {
+                int level = static_cast<int>(DebugLevel::NOTHING);
+
+                for (auto& pair : logger) {
+                    level = std::max(level, static_cast<int>(pair.second->GetDebugLevel()));
+                }
+
+                Level() = level;
             }
         public:
             void Nothing(const std::string& content) const {
@@ -438,11 +632,18 @@ namespace Construction {
         }
 
         inline void DoDebug(const std::string& msg) {
-#ifdef DEBUG_MODE
+#if CONSTRUCTION_LOG_LEVEL >= 6
             Common::LoggerManager::Instance()->Debug(msg);
 #endif
         }
 
+        /**
+            \brief Check if messages of the given level are compiled in and printed by any logger
+         */
+        static inline bool IsEnabled(Common::DebugLevel level) {
+            return static_cast<int>(level) <= CONSTRUCTION_LOG_LEVEL && Common::LoggerManager::IsEnabled(level);
+        }
+
         template<typename T>
         std::string Compose(const T& arg) {
             std::stringstream ss;
@@ -459,42 +660,56 @@ namespace Construction {
 
         template<typename... Args>
         static void Nothing(const Args&... args) {
+            if (!IsEnabled(Common::DebugLevel::NOTHING)) return;
+
             Logger logger;
             logger.DoNothing(logger.Compose(args...));
         }
 
         template<typename... Args>
         static void Critical(const Args&... args) {
+            if (!IsEnabled(Common::DebugLevel::CRITICAL)) return;
+
             Logger logger;
             logger.DoCritical(logger.Compose(args...));
         }
 
         template<typename... Args>
         static void Error(const Args&... args) {
+            if (!IsEnabled(Common::DebugLevel::ERROR)) return;
+
             Logger logger;
             logger.DoError(logger.Compose(args...));
         }
 
         template<typename... Args>
         static void Warning(const Args&... args) {
+            if (!IsEnabled(Common::DebugLevel::WARNING)) return;
+
             Logger logger;
             logger.DoWarning(logger.Compose(args...));
         }
 
         template<typename... Args>
         static void Success(const Args&... args) {
+            if (!IsEnabled(Common::DebugLevel::SUCCESS)) return;
+
             Logger logger;
             logger.DoSuccess(logger.Compose(args...));
         }
 
         template<typename... Args>
         static void Info(const Args&... args) {
+            if (!IsEnabled(Common::DebugLevel::INFO)) return;
+
             Logger logger;
             logger.DoInfo(logger.Compose(args...));
         }
 
         template<typename... Args>
         static void Debug(const Args&... args) {
+            if (!IsEnabled(Common::DebugLevel::DEBUG)) return;
+
             Logger logger;
             logger.DoDebug(logger.Compose(args...));
         }
@@ -578,3 +793,20 @@ namespace Construction {
     };
 
 }
+
+/**
+    Log a message whose arguments are only evaluated if the level is
+    compiled in and printed by any logger, e.g.
+
+        LOGGER_DEBUG("Start symmetrization of ", ToString());
+ */
+#define LOGGER_LOG(level, method, ...) \
+    do { \
+        if (Construction::Logger::IsEnabled(Construction::Common::DebugLevel::level)) Construction::Logger::method(__VA_ARGS__); \
+    } while (false)
+
+#define LOGGER_CRITICAL(...) LOGGER_LOG(CRITICAL, Critical, __VA_ARGS__)
+#define LOGGER_ERROR(...) LOGGER_LOG(ERROR, Error, __VA_ARGS__)
+#define LOGGER_WARNING(...) LOGGER_LOG(WARNING, Warning, __VA_ARGS__)
+#define LOGGER_INFO(...) LOGGER_LOG(INFO, Info, __VA_ARGS__)
+#define LOGGER_DEBUG(...) LOGGER_LOG(DEBUG, Debug, __VA_ARGS__)
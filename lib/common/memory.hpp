@@ -0,0 +1,332 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Construction {
+    namespace Common {
+
+        /**
+            \class MemoryCounter
+
+            \brief Counts the live allocations and bytes of one subsystem
+
+            Counting tens of millions of scalar nodes with an atomic
+            operation each is noticeable, so every thread accumulates the
+            changes in thread local storage and only adds them to the
+            global counters after a number of events or once the bytes
+            changed by more than a threshold. The counters hence lag behind
+            by at most that much per thread, which is the same for the
+            peak, i.e. the maximal number of live bytes seen so far. The
+            pending changes of a thread are added when it exits.
+         */
+        class MemoryCounter {
+        public:
+            static constexpr unsigned MAX_COUNTERS = 8;
+            static constexpr unsigned FLUSH_EVENTS = 256;
+            static constexpr long long FLUSH_BYTES = 64 * 1024;
+        public:
+            MemoryCounter(unsigned id) : id(id) {
+                assert(id < MAX_COUNTERS);
+                Counters()[id] = this;
+            }
+        public:
+            void Allocate(size_t size) {
+                auto& local = GetLocal();
+
+                ++local.allocations;
+                local.bytes += size;
+
+                if (++local.events >= FLUSH_EVENTS || local.bytes >= FLUSH_BYTES) Flush(local);
+            }
+
+            void Deallocate(size_t size) {
+                auto& local = GetLocal();
+
+                ++local.deallocations;
+                local.bytes -= static_cast<long long>(size);
+
+                if (++local.events >= FLUSH_EVENTS || local.bytes <= -FLUSH_BYTES) Flush(local);
+            }
+
+            /**
+                \brief Add the pending changes of the calling thread
+             */
+            void Flush() {
+                Flush(GetLocal());
+            }
+        public:
+            // Number of allocations that were not freed yet
+            long long GetLive() const { return allocations.load(std::memory_order_relaxed) - deallocations.load(std::memory_order_relaxed); }
+
+            // Number of allocations since the start of the program
+            long long GetAllocations() const { return allocations.load(std::memory_order_relaxed); }
+
+            long long GetBytes() const { return bytes.load(std::memory_order_relaxed); }
+            long long GetPeakBytes() const { return peak.load(std::memory_order_relaxed); }
+        private:
+            // Trivially destructible, so it can still be used while the program shuts down
+            struct Local {
+                long long allocations;
+                long long deallocations;
+                long long bytes;
+                unsigned events;
+            };
+
+            /**
+                \brief Adds the pending changes of all counters when the thread exits
+             */
+            struct Exit {
+                ~Exit() {
+                    for (unsigned id=0; id<MAX_COUNTERS; ++id) {
+                        if (Counters()[id]) Counters()[id]->Flush(Locals()[id]);
+                    }
+                }
+            };
+
+            static MemoryCounter** Counters() {
+                static MemoryCounter* counters[MAX_COUNTERS] = { };
+                return counters;
+            }
+
+            static Local* Locals() {
+                static thread_local Local locals[MAX_COUNTERS];
+                return locals;
+            }
+
+            Local& GetLocal() {
+                auto& local = Locals()[id];
+
+                // Nothing pending, i.e. the first event since the last flush,
+                // make sure the thread adds its changes when it exits
+                if (local.events == 0) {
+                    static thread_local Exit exit;
+                    (void)exit;
+                }
+
+                return local;
+            }
+
+            void Flush(Local& local) {
+                allocations.fetch_add(local.allocations, std::memory_order_relaxed);
+                deallocations.fetch_add(local.deallocations, std::memory_order_relaxed);
+
+                long long current = bytes.fetch_add(local.bytes, std::memory_order_relaxed) + local.bytes;
+                long long maximum = peak.load(std::memory_order_relaxed);
+
+                while (current > maximum && !peak.compare_exchange_weak(maximum, current, std::memory_order_relaxed)) { }
+
+                local = Local();
+            }
+        private:
+            unsigned id;
+
+            std::atomic<long long> allocations { 0 };
+            std::atomic<long long> deallocations { 0 };
+            std::atomic<long long> bytes { 0 };
+            std::atomic<long long> peak { 0 };
+        };
+
+        /**
+            \class MemoryStatistics
+
+            \brief Global allocation counters per subsystem
+
+            Tensor and scalar nodes are counted by the class specific
+            `operator new` of AbstractTensor and AbstractScalar, the entries
+            of the sparse matrices by the allocator of their map. Values that
+            live on the stack or inside other objects, e.g. the fractions
+            in a matrix, are not nodes and hence not counted.
+         */
+        class MemoryStatistics {
+        public:
+            static MemoryCounter& TensorNodes() {
+                static MemoryCounter counter (0);
+                return counter;
+            }
+
+            static MemoryCounter& ScalarNodes() {
+                static MemoryCounter counter (1);
+                return counter;
+            }
+
+            static MemoryCounter& MatrixEntries() {
+                static MemoryCounter counter (2);
+                return counter;
+            }
+        public:
+            /**
+                \brief All the counters, after adding the pending changes of the calling thread
+             */
+            static std::vector<std::pair<std::string, const MemoryCounter*>> GetAll() {
+                TensorNodes().Flush();
+                ScalarNodes().Flush();
+                MatrixEntries().Flush();
+
+                return {
+                    { "tensor_nodes", &TensorNodes() },
+                    { "scalar_nodes", &ScalarNodes() },
+                    { "matrix_entries", &MatrixEntries() }
+                };
+            }
+
+            /**
+                \brief Print the counters as a table
+             */
+            static void Print(std::ostream& os) {
+                os << std::left << std::setw(16) << "Subsystem" << std::right;
+                for (auto& column : { "live", "allocations", "bytes", "peak" }) {
+                    os << std::setw(14) << column;
+                }
+                os << std::endl;
+
+                for (auto& entry : GetAll()) {
+                    os << std::left << std::setw(16) << entry.first << std::right;
+                    os << std::setw(14) << entry.second->GetLive();
+                    os << std::setw(14) << entry.second->GetAllocations();
+                    os << std::setw(14) << FormatBytes(entry.second->GetBytes());
+                    os << std::setw(14) << FormatBytes(entry.second->GetPeakBytes());
+                    os << std::endl;
+                }
+            }
+
+            static std::string FormatBytes(long long bytes) {
+                std::stringstream ss;
+                ss << std::fixed << std::setprecision(1);
+
+                if (bytes < 1024) ss << bytes << " B";
+                else if (bytes < 1024 * 1024) ss << bytes / 1024.0 << " kB";
+                else if (bytes < 1024ll * 1024 * 1024) ss << bytes / (1024.0 * 1024) << " MB";
+                else ss << bytes / (1024.0 * 1024 * 1024) << " GB";
+
+                return ss.str();
+            }
+        };
+
+        /**
+            \class CountingAllocator
+
+            \brief Allocator that reports every allocation to a memory counter
+         */
+        template<class T, MemoryCounter& (*Counter)()>
+        class CountingAllocator {
+        public:
+            typedef T value_type;
+
+            template<class U>
+            struct rebind {
+                typedef CountingAllocator<U, Counter> other;
+            };
+        public:
+            CountingAllocator() = default;
+
+            template<class U>
+            CountingAllocator(const CountingAllocator<U, Counter>&) { }
+        public:
+            T* allocate(size_t n) {
+                Counter().Allocate(n * sizeof(T));
+                return std::allocator<T>().allocate(n);
+            }
+
+            void deallocate(T* pointer, size_t n) {
+                Counter().Deallocate(n * sizeof(T));
+                std::allocator<T>().deallocate(pointer, n);
+            }
+        public:
+            template<class U>
+            bool operator==(const CountingAllocator<U, Counter>&) const { return true; }
+
+            template<class U>
+            bool operator!=(const CountingAllocator<U, Counter>&) const { return false; }
+        };
+
+        /*
+            Estimates of the memory a value owns on the heap, i.e. without
+            the `sizeof` of the value itself which is already part of the
+            object that contains it. Classes take part by implementing
+            `size_t DeepSize() const`, which includes their own `sizeof`.
+         */
+
+        // Bookkeeping of a node in a red-black tree and a hash map
+        constexpr size_t TREE_NODE_OVERHEAD = 4 * sizeof(void*);
+        constexpr size_t HASH_NODE_OVERHEAD = 2 * sizeof(void*);
+
+        template<class T>
+        inline typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value, size_t>::type HeapSize(const T&) { return 0; }
+
+        template<class T>
+        inline auto HeapSize(const T& value) -> decltype(value.DeepSize()) { return value.DeepSize() - sizeof(T); }
+
+        inline size_t HeapSize(const std::string& value);
+
+        template<class A, class B>
+        inline size_t HeapSize(const std::pair<A, B>& value);
+
+        template<class T, class D>
+        inline size_t HeapSize(const std::unique_ptr<T, D>& value);
+
+        template<class T, class A>
+        inline size_t HeapSize(const std::vector<T, A>& value);
+
+        template<class K, class V, class C, class A>
+        inline size_t HeapSize(const std::map<K, V, C, A>& value);
+
+        template<class K, class V, class H, class E, class A>
+        inline size_t HeapSize(const std::unordered_map<K, V, H, E, A>& value);
+
+        inline size_t HeapSize(const std::string& value) {
+            // Short strings are stored inside the object
+            return (value.capacity() + 1 > sizeof(std::string)) ? value.capacity() + 1 : 0;
+        }
+
+        template<class A, class B>
+        inline size_t HeapSize(const std::pair<A, B>& value) {
+            return HeapSize(value.first) + HeapSize(value.second);
+        }
+
+        template<class T, class D>
+        inline size_t HeapSize(const std::unique_ptr<T, D>& value) {
+            return value ? value->DeepSize() : 0;
+        }
+
+        template<class T, class A>
+        inline size_t HeapSize(const std::vector<T, A>& value) {
+            size_t result = value.capacity() * sizeof(T);
+            for (auto& element : value) result += HeapSize(element);
+            return result;
+        }
+
+        template<class K, class V, class C, class A>
+        inline size_t HeapSize(const std::map<K, V, C, A>& value) {
+            size_t result = value.size() * (TREE_NODE_OVERHEAD + sizeof(std::pair<const K, V>));
+            for (auto& element : value) result += HeapSize(element.first) + HeapSize(element.second);
+            return result;
+        }
+
+        template<class K, class V, class H, class E, class A>
+        inline size_t HeapSize(const std::unordered_map<K, V, H, E, A>& value) {
+            size_t result = value.bucket_count() * sizeof(void*) + value.size() * (HASH_NODE_OVERHEAD + sizeof(std::pair<const K, V>));
+            for (auto& element : value) result += HeapSize(element.first) + HeapSize(element.second);
+            return result;
+        }
+
+        /**
+            \brief Estimate the memory of the value including everything it owns
+         */
+        template<class T>
+        inline size_t MemoryFootprint(const T& value) {
+            return sizeof(T) + HeapSize(value);
+        }
+
+    }
+}
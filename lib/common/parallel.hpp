@@ -0,0 +1,129 @@
+#pragma once
+
+#include <vector>
+#include <future>
+#include <algorithm>
+
+#include <common/task_pool.hpp>
+
+namespace Construction {
+    namespace Parallel {
+
+        /**
+            \brief Default grain size
+
+            Splits the range into about four chunks per thread, which
+            leaves enough room for the load balancing of the pool.
+         */
+        inline size_t DefaultGrainSize(size_t n) {
+            size_t threads = GlobalTaskPool::Instance()->GetNumberOfThreads();
+            return std::max<size_t>(1, n / (4 * std::max<size_t>(1, threads)));
+        }
+
+        /**
+            \brief Split a range into chunks and run them on the global pool
+
+            Calls fn(begin, end) for consecutive chunks of at most grain
+            elements. The chunks run on the global task pool, the calling
+            thread helps while waiting. Exceptions thrown in a chunk are
+            rethrown in the calling thread.
+         */
+        template<class F>
+        void ForChunks(size_t begin, size_t end, F fn, size_t grain = 0) {
+            if (end <= begin) return;
+
+            size_t n = end - begin;
+            if (grain == 0) grain = DefaultGrainSize(n);
+
+            // Not worth the overhead
+            if (n <= grain) {
+                fn(begin, end);
+                return;
+            }
+
+            auto pool = GlobalTaskPool::Instance()->GetPool();
+
+            std::vector<std::future<void>> futures;
+            futures.reserve((n + grain - 1) / grain);
+
+            for (size_t first = begin; first < end; first += grain) {
+                size_t last = std::min(end, first + grain);
+
+                futures.push_back(pool->Enqueue([&fn, first, last]() {
+                    fn(first, last);
+                }));
+            }
+
+            pool->Wait();
+
+            // Propagate exceptions
+            for (auto& future : futures) {
+                future.get();
+            }
+        }
+
+        /**
+            \brief Parallel loop
+
+            Calls fn(i) for all i in [begin, end).
+         */
+        template<class F>
+        void For(size_t begin, size_t end, F fn, size_t grain = 0) {
+            ForChunks(begin, end, [&fn](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i) {
+                    fn(i);
+                }
+            }, grain);
+        }
+
+        /**
+            \brief Parallel map into a preallocated output
+
+            Sets output[i] = fn(input[i]). The output is resized to the
+            size of the input before, every task writes its own slots
+            and hence needs no locking.
+         */
+        template<class T, class S, class F>
+        void Map(const std::vector<T>& input, std::vector<S>& output, F fn, size_t grain = 0) {
+            output.resize(input.size());
+
+            For(0, input.size(), [&](size_t i) {
+                output[i] = fn(input[i]);
+            }, grain);
+        }
+
+        /**
+            \brief Parallel reduction
+
+            Every chunk accumulates into its own copy of the identity via
+            fn(accumulator, i). The accumulators of the chunks are combined
+            in the order of the chunks with combine(result, accumulator),
+            so the result does not depend on the scheduling.
+         */
+        template<class T, class F, class C>
+        T Reduce(size_t begin, size_t end, const T& identity, F fn, C combine, size_t grain = 0) {
+            if (end <= begin) return identity;
+
+            size_t n = end - begin;
+            if (grain == 0) grain = DefaultGrainSize(n);
+
+            std::vector<T> accumulators ((n + grain - 1) / grain, identity);
+
+            ForChunks(begin, end, [&](size_t first, size_t last) {
+                auto& accumulator = accumulators[(first - begin) / grain];
+
+                for (size_t i = first; i < last; ++i) {
+                    fn(accumulator, i);
+                }
+            }, grain);
+
+            T result = identity;
+            for (auto& accumulator : accumulators) {
+                combine(result, accumulator);
+            }
+
+            return result;
+        }
+
+    }
+}
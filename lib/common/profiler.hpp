@@ -0,0 +1,408 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <common/singleton.hpp>
+
+namespace Construction {
+    namespace Common {
+
+        /**
+            \class ProfileStatistics
+
+            \brief Timings of all the calls of one zone in nanoseconds
+
+            Besides the total, minimum and maximum the durations are sorted
+            into a logarithmic histogram with four buckets per power of two,
+            from which the percentiles are estimated within about 10%.
+         */
+        class ProfileStatistics {
+        public:
+            static constexpr unsigned BUCKETS = 4 * 64;
+        public:
+            void Add(unsigned long long duration) {
+                ++count;
+                total += duration;
+                min = std::min(min, duration);
+                max = std::max(max, duration);
+                ++histogram[Bucket(duration)];
+            }
+
+            void Merge(const ProfileStatistics& other) {
+                count += other.count;
+                total += other.total;
+                children += other.children;
+                min = std::min(min, other.min);
+                max = std::max(max, other.max);
+
+                for (unsigned i=0; i<BUCKETS; ++i) {
+                    histogram[i] += other.histogram[i];
+                }
+            }
+        public:
+            unsigned long long GetCount() const { return count; }
+
+            // Time spent in the zone including the nested zones
+            unsigned long long GetInclusive() const { return total; }
+
+            // Time spent in the zone without the nested zones
+            unsigned long long GetExclusive() const { return (total > children) ? total - children : 0; }
+
+            unsigned long long GetMean() const { return count > 0 ? total / count : 0; }
+            unsigned long long GetMin() const { return count > 0 ? min : 0; }
+            unsigned long long GetMax() const { return max; }
+
+            /**
+                \brief Estimate the p-th percentile (0 < p <= 1)
+             */
+            unsigned long long GetPercentile(double p) const {
+                if (count == 0) return 0;
+
+                unsigned long long rank = static_cast<unsigned long long>(p * count + 0.5);
+                if (rank < 1) rank = 1;
+
+                unsigned long long seen = 0;
+                for (unsigned i=0; i<BUCKETS; ++i) {
+                    seen += histogram[i];
+                    if (seen >= rank) return std::max(min, std::min(max, Middle(i)));
+                }
+
+                return max;
+            }
+        private:
+            static unsigned Bucket(unsigned long long duration) {
+                if (duration < 4) return static_cast<unsigned>(duration);
+
+                unsigned exponent = 0;
+                while ((duration >> exponent) >= 8) ++exponent;
+
+                // The two bits after the leading one
+                return 4 * (exponent + 1) + static_cast<unsigned>((duration >> exponent) & 3);
+            }
+
+            static unsigned long long Middle(unsigned bucket) {
+                if (bucket < 4) return bucket;
+
+                unsigned exponent = bucket / 4 - 1;
+                unsigned long long lower = (4ull + bucket % 4) << exponent;
+
+                return lower + (1ull << exponent) / 2;
+            }
+        private:
+            friend class Profiler;
+
+            unsigned long long count = 0;
+            unsigned long long total = 0;
+            unsigned long long children = 0;
+            unsigned long long min = std::numeric_limits<unsigned long long>::max();
+            unsigned long long max = 0;
+
+            unsigned long long histogram[BUCKETS] = { };
+        };
+
+        /**
+            \class Profiler
+
+            \brief Hierarchical profiler of the calculation
+
+            Zones are opened with the PROFILE_ZONE macro and closed at the
+            end of the scope. Every thread records into its own call tree,
+            so a zone only touches the (uncontended) lock of its thread.
+            For the report the trees of all threads are merged by the call
+            path, i.e. `Simplify` called from a coefficient and `Simplify`
+            called from an equation are reported separately. Direct recursion
+            is folded into the outermost call and zones of tasks that run on
+            another thread start a new path at the top level.
+
+            If profiling is disabled, which is the default, opening a zone
+            costs a single atomic load.
+         */
+        class Profiler : public Singleton<Profiler> {
+        public:
+            struct Node {
+                const char* name;
+                unsigned parent;
+                std::vector<unsigned> children;
+                ProfileStatistics statistics;
+                unsigned recursion;
+            };
+
+            struct ThreadData {
+                std::mutex mutex;
+                std::vector<Node> nodes;
+                unsigned current = 0;
+
+                ThreadData() {
+                    nodes.push_back({ "", 0, {}, ProfileStatistics(), 0 });
+                }
+            };
+
+            /**
+                One line of the report, the zones are ordered depth first
+             */
+            struct Entry {
+                std::string name;
+                unsigned depth;
+                ProfileStatistics statistics;
+            };
+        public:
+            static bool IsEnabled() {
+                return Enabled().load(std::memory_order_relaxed);
+            }
+
+            static void Enable() {
+                Instance();
+                Enabled() = true;
+            }
+
+            static void Disable() {
+                Enabled() = false;
+            }
+        public:
+            /**
+                \brief Enter the zone with the given name in the current thread
+
+                The name has to outlive the profiler, usually it is a
+                string literal.
+             */
+            void Enter(const char* name) {
+                auto& data = GetThreadData();
+                std::unique_lock<std::mutex> lock(data.mutex);
+
+                auto& node = data.nodes[data.current];
+
+                // Direct recursion is accounted to the outermost call
+                if (node.name == name || std::strcmp(node.name, name) == 0) {
+                    ++node.recursion;
+                    return;
+                }
+
+                for (auto child : node.children) {
+                    auto& other = data.nodes[child].name;
+                    if (other == name || std::strcmp(other, name) == 0) {
+                        data.current = child;
+                        return;
+                    }
+                }
+
+                unsigned id = data.nodes.size();
+                data.nodes[data.current].children.push_back(id);
+                data.nodes.push_back({ name, data.current, {}, ProfileStatistics(), 0 });
+                data.current = id;
+            }
+
+            /**
+                \brief Leave the current zone of this thread
+             */
+            void Leave(unsigned long long duration) {
+                auto& data = GetThreadData();
+                std::unique_lock<std::mutex> lock(data.mutex);
+
+                auto& node = data.nodes[data.current];
+
+                if (node.recursion > 0) {
+                    --node.recursion;
+                    return;
+                }
+
+                node.statistics.Add(duration);
+
+                data.current = node.parent;
+                data.nodes[data.current].statistics.children += duration;
+            }
+        public:
+            /**
+                \brief Forget all the timings recorded so far
+             */
+            void Reset() {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                for (auto& data : threads) {
+                    std::unique_lock<std::mutex> dataLock(data->mutex);
+
+                    for (auto& node : data->nodes) {
+                        node.statistics = ProfileStatistics();
+                    }
+                }
+            }
+
+            /**
+                \brief Merge the call trees of all threads
+             */
+            std::vector<Entry> GetReport() const {
+                std::vector<Entry> result;
+                std::vector<std::vector<unsigned>> children (1);
+                result.push_back({ "", 0, ProfileStatistics() });
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                for (auto& data : threads) {
+                    std::unique_lock<std::mutex> dataLock(data->mutex);
+                    Merge(*data, 0, 0, result, children);
+                }
+
+                // Order depth first
+                std::vector<Entry> ordered;
+                Flatten(0, result, children, ordered);
+
+                return ordered;
+            }
+
+            /**
+                \brief Print the report as a table
+             */
+            void Print(std::ostream& os) const {
+                auto report = GetReport();
+
+                if (report.empty()) {
+                    os << "No profiling data recorded" << std::endl;
+                    return;
+                }
+
+                size_t width = 4;
+                for (auto& entry : report) {
+                    width = std::max(width, 2 * entry.depth + entry.name.size());
+                }
+
+                os << std::left << std::setw(width + 2) << "Zone" << std::right;
+                for (auto& column : { "calls", "total", "self", "mean", "min", "p50", "p95", "p99", "max" }) {
+                    os << std::setw(10) << column;
+                }
+                os << std::endl;
+
+                for (auto& entry : report) {
+                    auto& s = entry.statistics;
+
+                    os << std::string(2 * entry.depth, ' ') << std::left << std::setw(width + 2 - 2 * entry.depth) << entry.name << std::right;
+                    os << std::setw(10) << s.GetCount();
+
+                    for (auto value : { s.GetInclusive(), s.GetExclusive(), s.GetMean(), s.GetMin(), s.GetPercentile(0.5), s.GetPercentile(0.95), s.GetPercentile(0.99), s.GetMax() }) {
+                        os << std::setw(10) << FormatDuration(value);
+                    }
+
+                    os << std::endl;
+                }
+            }
+
+            static std::string FormatDuration(unsigned long long nanoseconds) {
+                std::stringstream ss;
+                ss << std::fixed << std::setprecision(1);
+
+                if (nanoseconds < 1000) ss << nanoseconds << " ns";
+                else if (nanoseconds < 1000000) ss << nanoseconds * 1e-3 << " us";
+                else if (nanoseconds < 1000000000) ss << nanoseconds * 1e-6 << " ms";
+                else ss << nanoseconds * 1e-9 << " s";
+
+                return ss.str();
+            }
+        private:
+            static std::atomic<bool>& Enabled() {
+                static std::atomic<bool> enabled (false);
+                return enabled;
+            }
+
+            ThreadData& GetThreadData() {
+                static thread_local std::shared_ptr<ThreadData> data;
+
+                if (!data) {
+                    data = std::make_shared<ThreadData>();
+
+                    std::unique_lock<std::mutex> lock(mutex);
+                    threads.push_back(data);
+                }
+
+                return *data;
+            }
+
+            static void Merge(const ThreadData& data, unsigned node, unsigned target, std::vector<Entry>& result, std::vector<std::vector<unsigned>>& children) {
+                for (auto child : data.nodes[node].children) {
+                    auto& source = data.nodes[child];
+
+                    // Find the zone with the same name below the target
+                    unsigned id = 0;
+                    for (auto other : children[target]) {
+                        if (result[other].name == source.name) {
+                            id = other;
+                            break;
+                        }
+                    }
+
+                    if (id == 0) {
+                        id = result.size();
+                        result.push_back({ source.name, result[target].depth + 1, ProfileStatistics() });
+                        children.push_back({});
+                        children[target].push_back(id);
+                    }
+
+                    result[id].statistics.Merge(source.statistics);
+                    Merge(data, child, id, result, children);
+                }
+            }
+
+            static void Flatten(unsigned node, const std::vector<Entry>& result, const std::vector<std::vector<unsigned>>& children, std::vector<Entry>& ordered) {
+                for (auto child : children[node]) {
+                    if (result[child].statistics.GetCount() == 0 && children[child].empty()) continue;
+
+                    ordered.push_back(result[child]);
+                    ordered.back().depth -= 1;
+
+                    Flatten(child, result, children, ordered);
+                }
+            }
+        private:
+            mutable std::mutex mutex;
+            std::vector<std::shared_ptr<ThreadData>> threads;
+        };
+
+        constexpr unsigned ProfileStatistics::BUCKETS;
+
+        /**
+            \class ProfileZone
+
+            \brief Times the enclosing scope if the profiler is enabled
+         */
+        class ProfileZone {
+        public:
+            ProfileZone(const char* name) : enabled(Profiler::IsEnabled()) {
+                if (!enabled) return;
+
+                GetProfiler()->Enter(name);
+                start = std::chrono::steady_clock::now();
+            }
+
+            ~ProfileZone() {
+                if (!enabled) return;
+
+                auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                GetProfiler()->Leave(static_cast<unsigned long long>(duration));
+            }
+
+            ProfileZone(const ProfileZone&) = delete;
+            ProfileZone& operator=(const ProfileZone&) = delete;
+        private:
+            // Singleton::Instance() locks, which we do not want in every zone
+            static Profiler* GetProfiler() {
+                static Profiler* profiler = Profiler::Instance();
+                return profiler;
+            }
+        private:
+            bool enabled;
+            std::chrono::steady_clock::time_point start;
+        };
+
+    }
+}
+
+#define PROFILE_ZONE_CONCAT_(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) Construction::Common::ProfileZone PROFILE_ZONE_CONCAT(profile_zone_, __LINE__) (name)
@@ -37,6 +37,10 @@ namespace Construction {
                 time.Start();
             }
 
+            void Stop() {
+                running = false;
+            }
+
             void Increase() {
                 if (pos < max) pos++;
             }
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <new>
+#include <iterator>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <initializer_list>
+
+namespace Construction {
+    namespace Common {
+
+        /**
+            \class SmallVector
+
+            \brief Vector that stores up to N elements without allocating
+
+            The first N elements live inside the object itself, only a
+            vector that grows beyond that moves its elements to the heap.
+            The interface follows std::vector as far as it is needed, the
+            iterators are plain pointers and are invalidated by every
+            operation that changes the size.
+
+            Example:
+                SmallVector<int, 4> values = { 1, 2, 3 };
+                values.push_back(4);        // still inline
+                values.push_back(5);        // moves to the heap
+         */
+        template<typename T, unsigned N>
+        class SmallVector {
+        public:
+            typedef T           value_type;
+            typedef T*          iterator;
+            typedef const T*    const_iterator;
+            typedef T&          reference;
+            typedef const T&    const_reference;
+            typedef size_t      size_type;
+        public:
+            SmallVector() : elements(Inline()) { }
+
+            SmallVector(std::initializer_list<T> list) : elements(Inline()) {
+                reserve(list.size());
+                for (auto& element : list) {
+                    new (elements + count) T(element);
+                    ++count;
+                }
+            }
+
+            template<typename Iterator>
+            SmallVector(Iterator first, Iterator last) : elements(Inline()) {
+                insert(end(), first, last);
+            }
+
+            SmallVector(const SmallVector& other) : elements(Inline()) {
+                reserve(other.count);
+                for (auto& element : other) {
+                    new (elements + count) T(element);
+                    ++count;
+                }
+            }
+
+            SmallVector(SmallVector&& other) : elements(Inline()) {
+                Steal(std::move(other));
+            }
+
+            ~SmallVector() {
+                clear();
+                Release();
+            }
+        public:
+            SmallVector& operator=(const SmallVector& other) {
+                if (this == &other) return *this;
+
+                clear();
+                reserve(other.count);
+                for (auto& element : other) {
+                    new (elements + count) T(element);
+                    ++count;
+                }
+                return *this;
+            }
+
+            SmallVector& operator=(SmallVector&& other) {
+                if (this == &other) return *this;
+
+                clear();
+                Release();
+                Steal(std::move(other));
+                return *this;
+            }
+        public:
+            iterator begin() { return elements; }
+            iterator end() { return elements + count; }
+
+            const_iterator begin() const { return elements; }
+            const_iterator end() const { return elements + count; }
+
+            size_type size() const { return count; }
+            size_type capacity() const { return space; }
+            bool empty() const { return count == 0; }
+
+            /**
+                \brief Returns if the elements are stored inside the object
+             */
+            bool IsInline() const { return elements == Inline(); }
+
+            T* data() { return elements; }
+            const T* data() const { return elements; }
+
+            T& operator[](size_type id) { return elements[id]; }
+            const T& operator[](size_type id) const { return elements[id]; }
+
+            T& at(size_type id) {
+                if (id >= count) throw std::out_of_range("SmallVector::at");
+                return elements[id];
+            }
+
+            const T& at(size_type id) const {
+                if (id >= count) throw std::out_of_range("SmallVector::at");
+                return elements[id];
+            }
+
+            T& front() { return elements[0]; }
+            const T& front() const { return elements[0]; }
+
+            T& back() { return elements[count-1]; }
+            const T& back() const { return elements[count-1]; }
+        public:
+            void reserve(size_type size) {
+                if (size <= space) return;
+
+                T* moved = static_cast<T*>(::operator new(size * sizeof(T)));
+
+                for (size_type i=0; i<count; ++i) {
+                    new (moved + i) T(std::move(elements[i]));
+                    elements[i].~T();
+                }
+
+                Release();
+
+                elements = moved;
+                space = size;
+            }
+
+            void push_back(const T& element) {
+                emplace_back(element);
+            }
+
+            void push_back(T&& element) {
+                emplace_back(std::move(element));
+            }
+
+            template<typename... Args>
+            void emplace_back(Args&&... args) {
+                if (count == space) {
+                    // The arguments may refer to an element of this vector
+                    T element (std::forward<Args>(args)...);
+                    reserve(2 * space);
+                    new (elements + count) T(std::move(element));
+                } else {
+                    new (elements + count) T(std::forward<Args>(args)...);
+                }
+                ++count;
+            }
+
+            void pop_back() {
+                elements[--count].~T();
+            }
+
+            iterator insert(iterator position, const T& element) {
+                // The element may be part of this vector
+                T copy (element);
+                return insert(position, &copy, &copy + 1);
+            }
+
+            /**
+                \brief Insert the range [first, last) before the position
+
+                The range must not point into this vector.
+             */
+            template<typename Iterator>
+            iterator insert(iterator position, Iterator first, Iterator last) {
+                size_type offset = position - elements;
+                size_type inserted = std::distance(first, last);
+                if (inserted == 0) return elements + offset;
+
+                if (count + inserted > space) {
+                    reserve(std::max<size_type>(2 * space, count + inserted));
+                }
+
+                // Move the tail to the back, starting with the last element
+                for (size_type i=count; i-- > offset; ) {
+                    new (elements + i + inserted) T(std::move(elements[i]));
+                    elements[i].~T();
+                }
+
+                for (size_type i=offset; first != last; ++first, ++i) {
+                    new (elements + i) T(*first);
+                }
+
+                count += inserted;
+                return elements + offset;
+            }
+
+            iterator erase(iterator position) {
+                return erase(position, position + 1);
+            }
+
+            iterator erase(iterator first, iterator last) {
+                iterator target = first;
+
+                for (iterator it = last; it != end(); ++it, ++target) {
+                    *target = std::move(*it);
+                }
+
+                while (end() != target) pop_back();
+
+                return first;
+            }
+
+            void clear() {
+                while (count > 0) pop_back();
+            }
+        public:
+            size_t DeepSize() const {
+                size_t result = sizeof(SmallVector);
+                if (!IsInline()) result += space * sizeof(T);
+                for (auto& element : *this) result += HeapSizeOf(element, 0);
+                return result;
+            }
+        private:
+            template<typename S>
+            static auto HeapSizeOf(const S& element, int) -> decltype(element.DeepSize()) { return element.DeepSize() - sizeof(S); }
+
+            template<typename S>
+            static size_t HeapSizeOf(const S&, long) { return 0; }
+
+            T* Inline() { return reinterpret_cast<T*>(&storage); }
+            const T* Inline() const { return reinterpret_cast<const T*>(&storage); }
+
+            void Release() {
+                if (!IsInline()) ::operator delete(elements);
+
+                elements = Inline();
+                space = N;
+            }
+
+            /**
+                Take the heap buffer of the other vector or move its inline elements
+             */
+            void Steal(SmallVector&& other) {
+                if (other.IsInline()) {
+                    for (auto& element : other) {
+                        new (elements + count) T(std::move(element));
+                        ++count;
+                    }
+                    other.clear();
+                    return;
+                }
+
+                elements = other.elements;
+                count = other.count;
+                space = other.space;
+
+                other.elements = other.Inline();
+                other.count = 0;
+                other.space = N;
+            }
+        private:
+            typename std::aligned_storage<N * sizeof(T), alignof(T)>::type storage;
+
+            T* elements;
+            unsigned count = 0;
+            unsigned space = N;
+        };
+
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <algorithm>
+
+#include <sys/resource.h>
+
+#include <common/singleton.hpp>
+
+namespace Construction {
+    namespace Common {
+
+        /**
+            \class Statistics
+
+            \brief Counters that describe the size of a calculation
+
+            Collects named counters, e.g. the dimensions of the largest
+            matrix that was reduced, which are reported at the end of a
+            run and compared between commits.
+         */
+        class Statistics : public Singleton<Statistics> {
+        public:
+            void Add(const std::string& name, long long value) {
+                std::unique_lock<std::mutex> lock(mutex);
+                values[name] += value;
+            }
+
+            void Maximum(const std::string& name, long long value) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                auto it = values.find(name);
+                if (it == values.end()) values[name] = value;
+                else it->second = std::max(it->second, value);
+            }
+
+            long long Get(const std::string& name) const {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                auto it = values.find(name);
+                return (it != values.end()) ? it->second : 0;
+            }
+
+            std::map<std::string, long long> GetAll() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return values;
+            }
+        public:
+            /**
+                \brief User and system CPU time of the process in milliseconds
+             */
+            static double GetCPUTime() {
+                struct rusage usage;
+                if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+
+                return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-3;
+            }
+
+            /**
+                \brief Peak resident set size of the process in kilobytes
+             */
+            static long GetPeakMemory() {
+                struct rusage usage;
+                if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+
+#ifdef __APPLE__
+                return usage.ru_maxrss / 1024;
+#else
+                return usage.ru_maxrss;
+#endif
+            }
+        private:
+            std::map<std::string, long long> values;
+            mutable std::mutex mutex;
+        };
+
+    }
+}
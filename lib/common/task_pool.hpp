@@ -5,109 +5,138 @@
 #include <thread>
 #include <mutex>
 #include <memory>
-#include <queue>
-#include <stack>
+#include <deque>
 #include <vector>
 #include <map>
 #include <future>
 #include <condition_variable>
 #include <functional>
+#include <algorithm>
 #include <stdexcept>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <common/singleton.hpp>
 #include <common/logger.hpp>
 
 namespace Construction {
     namespace Common {
 
+        /**
+            \class TaskPool
+
+            \brief Work-stealing pool of worker threads
+
+            Every worker owns a deque of tasks. Tasks that are enqueued
+            from inside a worker are pushed to the back of its own deque
+            and the worker takes its tasks from the back as well, so it
+            works depth-first on what it spawned last. Tasks from threads
+            outside of the pool go into a shared injection queue. An idle
+            worker steals from the front of the other deques. Stealing never
+            blocks: a deque whose lock is held is simply skipped.
+
+            Wait() only waits for the tasks that were enqueued by the
+            calling task, or by the calling thread if it is not executing
+            a task of the pool. Instead of blocking, the waiting thread
+            executes pending tasks itself. Hence a task may enqueue further tasks and
+            wait for them (e.g. symmetrizing summands that symmetrize their
+            own summands) without deadlocking the pool, and all the cores
+            stay busy in the meantime.
+         */
         class TaskPool {
-        public:
-            TaskPool(int threads = std::thread::hardware_concurrency()) : terminate(false), stopped(false) {
-                threadPool.reserve(threads);
-
-                for (size_t i = 0; i < threads; ++i) {
-                    threadPool.emplace_back([this] {
-                        while (true) {
-                            std::function<void()> task;
+        private:
+            typedef std::shared_ptr<std::atomic<unsigned>>     Counter;
+
+            struct Task {
+                std::function<void()> fn;
+                Counter counter;
+            };
+
+            class WorkQueue {
+            public:
+                void Push(Task&& task) {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    tasks.push_back(std::move(task));
+                }
 
-                            std::thread::id id;
+                // Take the most recent task (used by the owner)
+                bool Pop(Task& task) {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    if (tasks.empty()) return false;
 
-                            // Scope based locking
-                            {
-                                std::unique_lock<std::mutex> lock(this->tasksMutex);
+                    task = std::move(tasks.back());
+                    tasks.pop_back();
+                    return true;
+                }
 
-                                // Wait until queue is not empty or termination signal is sent
-                                this->condition.wait(lock, [this] {
-                                    return this->terminate || !this->tasks.empty();
-                                });
+                // Take the oldest task (used by thieves), without blocking
+                bool Steal(Task& task) {
+                    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+                    if (!lock.owns_lock() || tasks.empty()) return false;
 
-                                if (this->terminate && this->tasks.empty()) return;
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                    return true;
+                }
+            private:
+                std::deque<Task> tasks;
+                std::mutex mutex;
+            };
+
+            // The worker the current thread belongs to and the counters
+            // of the tasks that are currently executed by this thread
+            struct Worker {
+                const TaskPool* pool = nullptr;
+                unsigned index = 0;
+
+                std::vector<std::pair<const TaskPool*, Counter>> groups;
+            };
+
+            static Worker& CurrentWorker() {
+                static thread_local Worker worker;
+                return worker;
+            }
+        public:
+            /**
+                Creates a pool with the given number of workers. If pin is
+                set, the i-th worker is bound to the i-th CPU core (only
+                supported on Linux).
+             */
+            TaskPool(int threads = std::thread::hardware_concurrency(), bool pin = false) : terminate(false), stopped(false), pending(0), waiting(0) {
+                if (threads < 1) threads = 1;
 
-                                id = this->tasks.front().first;
+                // One queue per worker plus the injection queue
+                queues.reserve(threads + 1);
+                for (int i = 0; i <= threads; ++i) {
+                    queues.emplace_back(new WorkQueue());
+                }
 
-                                // Move the top task to our reference and remove it from the queue
-                                task = std::move(this->tasks.front().second);
-                                this->tasks.erase(this->tasks.begin());
-                            }
+                threadPool.reserve(threads);
 
+                for (unsigned i = 0; i < threads; ++i) {
+                    threadPool.emplace_back([this, i] {
+                        CurrentWorker().pool = this;
+                        CurrentWorker().index = i;
 
-                            // Execute task
-                            task();
+                        while (true) {
+                            if (RunPendingTask()) continue;
 
-                            {
-                                std::unique_lock<std::mutex> lock(tasksMutex);
+                            std::unique_lock<std::mutex> lock(this->sleepMutex);
 
-                                // Decrease the number of remaining tasks
-                                std::atomic_fetch_sub_explicit(this->remainingTasks[id].get(), static_cast<unsigned>(1), std::memory_order_relaxed);
-			    }
+                            // Wait until there is work or termination signal is sent
+                            this->condition.wait(lock, [this] {
+                                return this->terminate || this->pending > 0;
+                            });
 
-                            // Notify that a task was finished
-                            this->condition_finished.notify_all();
+                            if (this->terminate && this->pending == 0) return;
                         }
                     });
-                }
 
-                // Start the observer
-                /*observer = std::thread([&]() {
-                    while (true) {
-                        // First check if there is recursion in the helpers
-                        std::thread::id current_helper;
-                        if (HasRecursionInHelper(&current_helper)) {
-                            // If the worker already has an helper, wait for
-                            // it to be finished
-                            if (helper_ids[current_helper] > 3) {
-                                continue;
-                            }
-
-                            // spawn a helper for the top helper
-                            SpawnHelper(current_helper, false); 
-
-                            // Add the ID to the list
-                            helper_ids[current_helper] += 1;
-                            continue;
-                        }
-
-                        // No recursion in any helpers, check if a worker is stuck
-                        std::thread::id current;
-                        if (HasRecursion(&current)) {
-                            // If the worker already has an helper, wait for
-                            // it to be finished
-                            if (worker_ids[current] > 3) {
-                                continue;
-                            }
-
-                            // Spawn a helper for this
-                            SpawnHelper(current, true); 
-
-                            // Add the ID to the list
-                            worker_ids[current] += 1;
-                            continue;
-                        }
-
-                        // Check if the shut down signal was sent
-                        if (this->terminate && this->tasks.empty()) return;
-                    }
-                });*/
+                    if (pin) Pin(threadPool.back(), i);
+                }
             }
 
             TaskPool(const TaskPool&) = delete;
@@ -139,6 +168,10 @@ namespace Construction {
             -> std::future<typename std::result_of<F(Args...)>::type> {
                 using return_type = typename std::result_of<F(Args...)>::type;
 
+                // don't allow enqueueing after stopping the pool
+                if (terminate || stopped)
+                    throw std::runtime_error("enqueue on stopped TaskPool");
+
                 // Make a shared_ptr to the task, where the arguments are already forwarded, and the result
                 // is given by a std::future
                 auto task = std::make_shared<std::packaged_task<return_type()> >(
@@ -148,49 +181,63 @@ namespace Construction {
                 // Obtain future to the result
                 std::future<return_type> res = task->get_future();
 
-                // Scope based locking
-                {
-                    std::unique_lock<std::mutex> lock(tasksMutex);
-
-                    // don't allow enqueueing after stopping the pool
-                    if (terminate || stopped)
-                        throw std::runtime_error("enqueue on stopped TaskPool");
+                // Increase the number of active tasks of the current task
+                auto counter = GetCounter();
+                counter->fetch_add(1);
 
-                    // Put task in the queue
-                    std::pair< std::thread::id, std::function<void()> > obj = { std::this_thread::get_id() , [task]() {
-                        (*task)();
-                    } };
+                // Put the task in the queue of the current worker, or in the
+                // injection queue if we are not in a worker of this pool
+                auto& worker = CurrentWorker();
+                unsigned index = (worker.pool == this) ? worker.index : threadPool.size();
 
-                    tasks.emplace_back(obj);
+                queues[index]->Push({ [task]() { (*task)(); }, std::move(counter) });
+                ++pending;
 
-                    // If the thread has no tasks so far, add to the list
-                    if (this->remainingTasks.find(std::this_thread::get_id()) == this->remainingTasks.end()) {
-			this->remainingTasks.insert({ std::this_thread::get_id(), std::make_shared<std::atomic<unsigned>>(0) });
-                    }
-
-                    // Increase the number of active tasks;
-                    std::atomic_fetch_add_explicit(this->remainingTasks[std::this_thread::get_id()].get(), static_cast<unsigned>(1), std::memory_order_relaxed);
- 
+                // Wake up one thread and everyone who is helping
+                {
+                    std::unique_lock<std::mutex> lock(sleepMutex);
                 }
-
-                // Wake up one thread and return the future
                 condition.notify_one();
-                
+                if (waiting > 0) condition_finished.notify_all();
+
                 return res;
             }
 
             bool Empty() {
-                return tasks.empty();
+                return pending == 0;
+            }
+
+            /**
+                Returns true if the calling thread is a worker of the pool
+                or executes one of its tasks while waiting.
+             */
+            bool IsExecuting() const {
+                auto& worker = CurrentWorker();
+                if (worker.pool == this) return true;
+
+                for (auto& group : worker.groups) {
+                    if (group.first == this) return true;
+                }
+
+                return false;
             }
 
+            /**
+                Apply fn to all the elements in parallel and return the results
+                in order. The first exception of a task is rethrown once all the
+                tasks are finished.
+             */
             template<typename S, typename T>
             std::vector<S> Map(std::vector<T> elements, std::function<S(const T&)> fn) {
                 std::map<unsigned, S> results;
                 std::mutex resultsMutex;
 
+                std::vector<std::future<void>> futures;
+                futures.reserve(elements.size());
+
                 // Enqueue all elements
                 for (int i=0; i<elements.size(); i++) {
-                    Enqueue([&results, &fn, &resultsMutex](unsigned id, const T& value) {
+                    futures.push_back(Enqueue([&results, &fn, &resultsMutex](unsigned id, const T& value) {
                         // Calculate the element
                         S e = fn(value);
 
@@ -198,12 +245,17 @@ namespace Construction {
                         std::unique_lock<std::mutex> lock(resultsMutex);
 
                         results.insert({ id, std::move(e) });
-                    }, i, elements[i]);
+                    }, i, elements[i]));
                 }
 
                 // Wait for all tasks to finish
                 Wait();
 
+                // Rethrow the first exception of the tasks
+                for (auto& future : futures) {
+                    future.get();
+                }
+
                 std::vector<S> result;
                 for (auto& pair : results) {
                     result.push_back(std::move(pair.second));
@@ -217,9 +269,12 @@ namespace Construction {
                 std::map<unsigned, S> results;
                 std::mutex resultsMutex;
 
+                std::vector<std::future<void>> futures;
+                futures.reserve(elements.size());
+
                 // Enqueue all elements
                 for (int i=0; i<elements.size(); i++) {
-                    Enqueue([&results, &fn, &resultsMutex](unsigned id, const T& value) {
+                    futures.push_back(Enqueue([&results, &fn, &resultsMutex](unsigned id, const T& value) {
                         // Calculate the element
                         fn(value, [&](S&& value) {
                             // Lock the mutex
@@ -227,12 +282,17 @@ namespace Construction {
 
                             results.insert({ id, std::move(value) });
                         });
-                    }, i, elements[i]);
+                    }, i, elements[i]));
                 }
 
                 // Wait for all tasks to finish
                 Wait();
 
+                // Rethrow the first exception of the tasks
+                for (auto& future : futures) {
+                    future.get();
+                }
+
                 std::vector<S> result;
                 for (auto& pair : results) {
                     result.push_back(std::move(pair.second));
@@ -241,22 +301,35 @@ namespace Construction {
                 return result;
             }
 
-            // Wait for all tasks to finish
+            /**
+                Wait for all tasks enqueued by the current task to finish.
+                While waiting, pending tasks are executed by the calling
+                thread.
+             */
             void Wait() {
-                std::unique_lock<std::mutex> lock(tasksMutex);
+                auto counter = GetCounter();
 
-                this->condition_finished.wait(lock, [this]() -> bool {
-		            auto it = this->remainingTasks.find(std::this_thread::get_id());
-		            if (it == this->remainingTasks.end()) return true;
-                    return *(it->second) == 0;
-                });
+                while (*counter > 0) {
+                    // Help executing the tasks
+                    if (RunPendingTask()) continue;
+
+                    // Nothing to do, wait for a task to finish or new work
+                    std::unique_lock<std::mutex> lock(sleepMutex);
+                    ++waiting;
+
+                    this->condition_finished.wait(lock, [&]() -> bool {
+                        return *counter == 0 || this->pending > 0;
+                    });
+
+                    --waiting;
+                }
             }
 
             void Shutdown() {
                 // Scope based locking
                 {
-                    // Put unique lock on task mutex.
-                    std::unique_lock<std::mutex> lock(tasksMutex);
+                    // Put unique lock on the sleep mutex.
+                    std::unique_lock<std::mutex> lock(sleepMutex);
 
                     // Set termination flag to true.
                     terminate = true;
@@ -270,169 +343,289 @@ namespace Construction {
                     thread.join();
                 }
 
-                // Empty workers vector.
-                threadPool.empty();
-
                 // Indicate that the pool has been shut down.
                 stopped = true;
             }
+
+            size_t GetNumberOfThreads() const {
+                return threadPool.size();
+            }
         protected:
-            bool HasRecursion(std::thread::id id) const {
-                for (auto& pair : tasks) {
-                    if (pair.first == id) return true;
+            static void Pin(std::thread& thread, unsigned i) {
+#ifdef __linux__
+                unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(i % cores, &set);
+
+                if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &set) != 0) {
+                    Construction::Logger::Warning("Could not pin worker ", i, " to a CPU core");
                 }
-                return false;
+#endif
             }
 
             /**
-                \brief Checks if one of the workers added a task
+                \brief Executes a single pending task
 
-                Checks if one of the workers added a task. This is necessary
-                to detect recursive job spawning that potentielly freezes the
-                task pool.
-
-                \param out      The ID to the first worker that has a pending task
+                Takes a task from the own queue, the injection queue or
+                steals it from another worker. Returns false if there was
+                no task to execute.
              */
-            bool HasRecursion(std::thread::id* out = nullptr) const {
-                for (auto& thread : threadPool) {
-                    auto id = thread.get_id();
+            bool RunPendingTask() {
+                Task task;
+                if (!NextTask(task)) return false;
 
-                    if (HasRecursion(id)) {
-                        if (out) (*out) = id;
-                        return true;
-                    }
-                }
+                --pending;
 
-                return false;
-            }
+                // Execute task. Tasks it enqueues are counted separately,
+                // so that its Wait() does not depend on the tasks of
+                // whoever executes it.
+                auto& groups = CurrentWorker().groups;
+                groups.push_back({ this, std::make_shared<std::atomic<unsigned>>(0) });
 
-            /**
-                \brief Check if there is recursion in a helper
-             */
-            bool HasRecursionInHelper(std::thread::id* out = nullptr) const {
-                if (helpers.empty()) return false;
+                task.fn();
 
-                for (auto& helper : helpers) {
-                    if (HasRecursion(helper.get_id())) {
-                        if (out) (*out) = helper.get_id();
-                        return true;
-                    }
+                groups.pop_back();
+
+                // Decrease the number of remaining tasks of the task that
+                // enqueued it and notify that a task was finished
+                if (task.counter->fetch_sub(1) == 1) {
+                    std::unique_lock<std::mutex> lock(sleepMutex);
+                    condition_finished.notify_all();
                 }
 
-                return false;
+                return true;
             }
 
-            /**
-                \brief Spawn a helper thread to get rid of the recursion of the given worker
+            bool NextTask(Task& task) {
+                if (pending == 0) return false;
 
-                Spawn a helper thread to get rid of the recursion of the given worker.
+                auto& worker = CurrentWorker();
+                unsigned n = queues.size();
+                unsigned self = (worker.pool == this) ? worker.index : n - 1;
 
-                \param id       The id of the worker
-             */
-            void SpawnHelper(std::thread::id id, bool fromWorker=true) {
-                helpers.emplace_back(std::bind([&](std::thread::id id, bool fromWorker) {
-                    while (true) {
-                        std::function<void()> task;
-
-                        Construction::Logger::Debug("Began helper loop in thread ", std::this_thread::get_id(), " for thread ", id);
-
-                        // Choose task where the id is tasks
-                        {
-                            std::unique_lock<std::mutex> lock (tasksMutex);
-
-                            bool found=false;
-
-                            for (auto it = tasks.begin(); it != tasks.end(); ++it) {
-                                if (it->first == id) {
-                                    task = std::move(it->second);
-                                    found = true;
-
-                                    // Delete the task from the queue
-                                    tasks.erase(it);
-                                    break;
-                                }
-                            }
-
-                            // No more recursion, kill the helper
-                            if (!found) {
-                                return;
-                            }
-                        }
+                // First try the own queue and the injection queue
+                if (self < n - 1 && queues[self]->Pop(task)) return true;
+                if (queues[n - 1]->Steal(task)) return true;
 
-                        Construction::Logger::Debug("Started working on task from thread ", id);
-
-                        // Execute the task
-                        task();
+                // Then steal from the other workers
+                for (unsigned i = 1; i < n; ++i) {
+                    unsigned victim = (self + i) % n;
+                    if (queues[victim]->Steal(task)) return true;
+                }
 
-                        Construction::Logger::Debug("Finished task from thread ", id);
+                // The own queue may have been contended
+                if (self < n - 1 && queues[self]->Pop(task)) return true;
 
-                        // Execute the task in the helper thread
-                        {
-                            std::unique_lock<std::mutex> lock (tasksMutex);
+                return false;
+            }
 
-                            // Decrease the number of remaining tasks
-			    std::atomic_fetch_sub_explicit(this->remainingTasks[id].get(), static_cast<unsigned>(1), std::memory_order_relaxed);
+            Counter GetCounter() {
+                auto& groups = CurrentWorker().groups;
+                for (auto it = groups.rbegin(); it != groups.rend(); ++it) {
+                    if (it->first == this) return it->second;
+                }
 
-                            if (fromWorker) {
-                                worker_ids[id]--;
-                            } else helper_ids[id]--;
-                        }
+                std::unique_lock<std::mutex> lock(countersMutex);
 
-                        // Notify all the workers for this task to be finished
-                        this->condition_finished.notify_all();
-                    }
-                }, id, fromWorker));
+                auto& counter = remainingTasks[std::this_thread::get_id()];
+                if (!counter) counter = std::make_shared<std::atomic<unsigned>>(0);
 
-                auto id_ = helpers[helpers.size()-1].get_id();
-                Construction::Logger::Debug("New helper: ", id_, " (Number of helpers: ", helpers.size(), ")");
+                return counter;
             }
         private:
             std::vector<std::thread> threadPool;
-            std::vector<std::thread> helpers;
-            std::vector< std::pair<std::thread::id, std::function<void()>> > tasks;
-            std::map<std::thread::id, std::shared_ptr<std::atomic<unsigned>>> remainingTasks;
-            std::map<std::thread::id, unsigned> worker_ids;
-            std::map<std::thread::id, unsigned> helper_ids;
-            std::thread observer;
-
-            mutable std::mutex tasksMutex;
+            std::vector<std::unique_ptr<WorkQueue>> queues;
+            std::map<std::thread::id, Counter> remainingTasks;
+
+            std::mutex countersMutex;
+            std::mutex sleepMutex;
             std::condition_variable condition;
             std::condition_variable condition_finished;
 
             std::atomic<bool> terminate;
             std::atomic<bool> stopped;
+            std::atomic<int> pending;
+            std::atomic<int> waiting;
         };
 
     }
 
     namespace Parallel {
 
+        /**
+            \class GlobalTaskPool
+
+            \brief The process-wide executor
+
+            All the parallel algorithms run on this pool, so the number
+            of threads is controlled in one place (e.g. by the --threads
+            flag). The pool is created on first use. Changing the number of
+            threads or the pinning afterwards replaces the pool. Callers that
+            got the old pool keep it alive until they are done; the change
+            waits for them and for the tasks left in the old pool. It is
+            refused from inside a task of the pool, which would wait for
+            itself.
+
+            Every operation takes the pool once. A caller that enqueues tasks
+            and waits for them has to do both on the same pool, i.e. keep the
+            pointer from GetPool().
+         */
         class GlobalTaskPool : public Singleton<GlobalTaskPool> {
         public:
-            // Initialize the global task pool
-            GlobalTaskPool() : pool(std::thread::hardware_concurrency()) { }
+            typedef std::shared_ptr<Common::TaskPool>   PoolPointer;
+        private:
+            // Hands the pool back to Retire instead of deleting it in the last user
+            struct Release {
+                GlobalTaskPool* owner;
+
+                void operator()(Common::TaskPool* pool) const {
+                    owner->Released(pool);
+                }
+            };
+        public:
+            GlobalTaskPool() : threads(std::thread::hardware_concurrency()), pin(false) { }
         public:
+            /**
+                Set the number of worker threads. Zero means one thread
+                per hardware thread.
+
+                \throws std::runtime_error If called from a task of the pool
+             */
+            void SetNumberOfThreads(unsigned n) {
+                if (n == 0) n = std::max(1u, std::thread::hardware_concurrency());
+
+                std::unique_lock<std::mutex> lock(mutex);
+                if (n == threads) return;
+
+                CheckNotExecuting();
+
+                threads = n;
+                Retire(lock);
+            }
+
+            unsigned GetNumberOfThreads() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return threads;
+            }
+
+            /**
+                \throws std::runtime_error If called from a task of the pool
+             */
+            void SetPinning(bool value) {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (value == pin) return;
+
+                CheckNotExecuting();
+
+                pin = value;
+                Retire(lock);
+            }
+
+            bool IsPinning() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return pin;
+            }
+
+            /**
+                The current pool. Keep the pointer as long as tasks are
+                enqueued to or waited for on it.
+             */
+            PoolPointer GetPool() {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                if (!pool) {
+                    Construction::Logger::Debug("Start global task pool with ", threads, " thread(s)");
+                    pool = PoolPointer(new Common::TaskPool(threads, pin), Release { this });
+                }
+
+                return pool;
+            }
+        public:
+            /**
+                Enqueue a task to the current pool. Use GetPool() to wait for it.
+             */
             template<class F, class... Args>
             auto Enqueue(F &&f, Args &&... args)
             -> std::future<typename std::result_of<F(Args...)>::type> {
-                return pool.Enqueue(f, args...);
+                auto pool = GetPool();
+                return pool->Enqueue(f, args...);
             }
 
             template<typename S, typename T>
             std::vector<S> Map(std::vector<T> elements, std::function<S(const T&)> fn) {
-                return pool.Map(elements, fn);
+                auto pool = GetPool();
+                return pool->Map(elements, fn);
             }
 
             template<typename S, typename T>
             std::vector<S> MapEmit(std::vector<T> elements, std::function<void(const T&, std::function<void(S&&)>)> fn) {
-                return pool.MapEmit(elements, fn);
+                auto pool = GetPool();
+                return pool->MapEmit(elements, fn);
+            }
+        private:
+            void CheckNotExecuting() const {
+                if (pool && pool->IsExecuting()) {
+                    throw std::runtime_error("Cannot replace the global task pool from one of its tasks");
+                }
             }
 
-            void Wait() {
-                pool.Wait();
+            /**
+                Detaches the current pool and releases the lock. Once nobody
+                uses the old pool anymore, it is destroyed here, which runs
+                the tasks that are still queued.
+             */
+            void Retire(std::unique_lock<std::mutex>& lock) {
+                PoolPointer retired;
+                std::swap(retired, pool);
+                lock.unlock();
+
+                if (!retired) return;
+
+                Common::TaskPool* old = retired.get();
+
+                std::unique_lock<std::mutex> retireLock(retireMutex);
+                retiring.push_back(old);
+
+                // The last user, maybe this one, hands the pool back
+                retireLock.unlock();
+                retired.reset();
+                retireLock.lock();
+
+                released.wait(retireLock, [&]() {
+                    return std::find(retiring.begin(), retiring.end(), old) == retiring.end();
+                });
+
+                retireLock.unlock();
+                delete old;
+            }
+
+            void Released(Common::TaskPool* old) {
+                {
+                    std::unique_lock<std::mutex> lock(retireMutex);
+
+                    auto it = std::find(retiring.begin(), retiring.end(), old);
+                    if (it != retiring.end()) {
+                        retiring.erase(it);
+                        released.notify_all();
+                        return;
+                    }
+                }
+
+                // Not retired, i.e. the executor itself is destroyed
+                delete old;
             }
         private:
-            Common::TaskPool pool;
+            PoolPointer pool;
+            unsigned threads;
+            bool pin;
+
+            mutable std::mutex mutex;
+
+            std::vector<Common::TaskPool*> retiring;
+            std::mutex retireMutex;
+            std::condition_variable released;
         };
 
         template<typename S, typename T>
@@ -2,7 +2,6 @@
 
 #include <chrono>
 #include <ostream>
-#include <stack>
 #include <string>
 #include <iostream>
 
@@ -32,6 +31,14 @@ namespace Construction {
                 return stopped;
             }
 
+            /**
+                \brief Elapsed time in milliseconds, until now if still running
+             */
+            double GetMilliseconds() const {
+                auto end = stopped ? end_time : std::chrono::high_resolution_clock::now();
+                return std::chrono::duration<double, std::milli>(end - start_time).count();
+            }
+
             friend std::ostream& operator<<(std::ostream& os, const TimeMeasurement& time) {
                 auto end_time = (time.stopped) ? time.end_time : std::chrono::high_resolution_clock::now();
 
@@ -71,33 +78,6 @@ namespace Construction {
             bool stopped;
         };
 
-        class TimeMeasurementManager : public Singleton<TimeMeasurementManager> {
-        public:
-            void Start(const std::string& name) {
-                measurements.push({ name, { measurements.size() , TimeMeasurement() } });
-            }
-
-            void Stop() {
-                // Stop measurement
-                measurements.top().second.second.Stop();
-
-                std::cout << "\033[90m";
-                for (int i=0; i<measurements.top().second.first; i++) {
-                   std::cout << "   "; 
-                } 
-                std::cout << measurements.top().first << " : " << measurements.top().second.second << "\033[0m" << std::endl;
-
-                // Remove the element
-                measurements.pop();
-            }
-        private:
-            std::stack< std::pair<std::string, std::pair<unsigned, TimeMeasurement> > > measurements;
-        };
-
-    }
-
-    static Common::TimeMeasurementManager* Profiler() {
-        return Common::TimeMeasurementManager::Instance();
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <common/singleton.hpp>
+
+namespace Construction {
+    namespace Common {
+
+        /**
+            \class Trace
+
+            \brief Timeline of the calculation in the Chrome trace format
+
+            Records begin and end events of the expensive steps (coefficients,
+            symmetrizations, equations, merges, Gaussian eliminations) together
+            with the thread and some sizes. Every thread writes into its own
+            buffer, which is only registered once, so recording an event does
+            not take any lock. The buffers are written as a JSON file that can
+            be opened in chrome://tracing or Perfetto once the calculation is
+            finished.
+
+            If tracing is disabled, recording an event costs a single atomic
+            load.
+         */
+        class Trace : public Singleton<Trace> {
+        public:
+            typedef std::vector<std::pair<std::string, long long>>  Arguments;
+        private:
+            struct Event {
+                std::string name;
+                char phase;
+                long long timestamp;
+                Arguments args;
+            };
+
+            struct Buffer {
+                unsigned id;
+                std::vector<Event> events;
+            };
+        public:
+            Trace() : start(std::chrono::steady_clock::now()) { }
+        public:
+            static bool IsEnabled() {
+                return Enabled().load(std::memory_order_relaxed);
+            }
+
+            static void Enable() {
+                Instance();
+                Enabled() = true;
+            }
+
+            static void Disable() {
+                Enabled() = false;
+            }
+        public:
+            void Begin(const std::string& name, const Arguments& args = Arguments()) {
+                Record(name, 'B', args);
+            }
+
+            void End(const std::string& name, const Arguments& args = Arguments()) {
+                Record(name, 'E', args);
+            }
+        public:
+            /**
+                \brief Write all the events as Chrome trace JSON
+
+                Must only be called if no other thread records events.
+             */
+            bool Write(const std::string& filename) const {
+                std::ofstream file (filename);
+                if (!file.is_open()) return false;
+
+                file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+                bool first = true;
+
+                std::unique_lock<std::mutex> lock(mutex);
+                for (auto& buffer : buffers) {
+                    for (auto& event : buffer->events) {
+                        if (!first) file << ",";
+                        first = false;
+
+                        file << "\n{\"name\":\"" << Escape(event.name) << "\",\"ph\":\"" << event.phase << "\"";
+                        file << ",\"ts\":" << event.timestamp << ",\"pid\":1,\"tid\":" << buffer->id;
+
+                        if (!event.args.empty()) {
+                            file << ",\"args\":{";
+                            for (unsigned i=0; i<event.args.size(); ++i) {
+                                if (i > 0) file << ",";
+                                file << "\"" << Escape(event.args[i].first) << "\":" << event.args[i].second;
+                            }
+                            file << "}";
+                        }
+
+                        file << "}";
+                    }
+                }
+
+                file << "\n]}" << std::endl;
+
+                return true;
+            }
+        private:
+            static std::atomic<bool>& Enabled() {
+                static std::atomic<bool> enabled (false);
+                return enabled;
+            }
+
+            void Record(const std::string& name, char phase, const Arguments& args) {
+                auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+                GetBuffer().events.push_back({ name, phase, timestamp, args });
+            }
+
+            Buffer& GetBuffer() {
+                static thread_local std::shared_ptr<Buffer> buffer;
+
+                if (!buffer) {
+                    buffer = std::make_shared<Buffer>();
+
+                    std::unique_lock<std::mutex> lock(mutex);
+                    buffer->id = buffers.size() + 1;
+                    buffers.push_back(buffer);
+                }
+
+                return *buffer;
+            }
+
+            static std::string Escape(const std::string& text) {
+                std::string result;
+
+                for (auto c : text) {
+                    if (c == '"' || c == '\\') result += '\\';
+                    if (c == '\n') {
+                        result += "\\n";
+                        continue;
+                    }
+                    result += c;
+                }
+
+                return result;
+            }
+        private:
+            std::chrono::steady_clock::time_point start;
+
+            mutable std::mutex mutex;
+            std::vector<std::shared_ptr<Buffer>> buffers;
+        };
+
+        /**
+            \class TraceScope
+
+            \brief Records a begin event on construction and an end event on destruction
+
+            Arguments, e.g. the size of a matrix or its rank, are added with
+            Set(), which overwrites earlier values of the same key. They are
+            recorded with the end event, the trace viewers show them for the
+            whole slice. Since computing sizes may be expensive, check
+            IsEnabled() before doing so:
+
+                Common::TraceScope trace ("Simplify");
+                if (trace.IsEnabled()) {
+                    trace.Set("summands", summands.size());
+                }
+
+            If tracing is disabled, nothing but the flag is touched.
+         */
+        class TraceScope {
+        public:
+            explicit TraceScope(const char* name) : enabled(Trace::IsEnabled()), name(name) {
+                if (enabled) GetTrace()->Begin(name);
+            }
+
+            ~TraceScope() {
+                if (enabled) GetTrace()->End(name, args);
+            }
+
+            TraceScope(const TraceScope&) = delete;
+            TraceScope& operator=(const TraceScope&) = delete;
+        public:
+            bool IsEnabled() const { return enabled; }
+
+            void Set(const char* key, long long value) {
+                if (!enabled) return;
+
+                for (auto& arg : args) {
+                    if (arg.first == key) {
+                        arg.second = value;
+                        return;
+                    }
+                }
+
+                args.push_back({ key, value });
+            }
+        private:
+            // Singleton::Instance() locks, which we do not want in every scope
+            static Trace* GetTrace() {
+                static Trace* trace = Trace::Instance();
+                return trace;
+            }
+        private:
+            bool enabled;
+            const char* name;
+            Trace::Arguments args;
+        };
+
+    }
+}
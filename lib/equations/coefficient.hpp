@@ -1,16 +1,24 @@
 #pragma once
 
+#include <atomic>
+#include <list>
 #include <unordered_map>
+#include <map>
+#include <vector>
 #include <mutex>
 #include <thread>
 #include <functional>
 #include <random>
 #include <memory>
 #include <algorithm>
+#include <numeric>
 #include <string>
 
 #include <common/task_pool.hpp>
+#include <common/trace.hpp>
+#include <common/profiler.hpp>
 #include <common/uuid.hpp>
+#include <equations/scheduler.hpp>
 #include <language/session.hpp>
 #include <tensor/index.hpp>
 #include <tensor/tensor.hpp>
@@ -147,6 +155,77 @@ namespace Construction {
                 return result;
             }
 
+            /**
+                \brief The symmetries the generated tensor has in its indices
+
+                The blocks are symmetrized one after another, and the exchange
+                symmetries swap a block and its derivatives with the next ones
+                if both have the same structure, see Coefficient::Calculate.
+                The exchanges are applied one after another as well, so an
+                exchange only holds in the result if the next one, which
+                shares a block with it, is not applied.
+             */
+            Construction::Tensor::Symmetry GetSymmetry() const {
+                Construction::Tensor::Symmetry result;
+                std::vector<std::pair<unsigned, unsigned>> units;
+
+                unsigned offset = 0;
+                for (auto& block : blocks) {
+                    units.push_back({ offset, offset + block.indices + block.derivatives - 1 });
+
+                    if (block.indices > 1 && block.symmetry != SymmetryType::NONE) {
+                        std::vector<unsigned> positions (block.indices);
+                        std::iota(positions.begin(), positions.end(), offset);
+
+                        result.Add(Construction::Tensor::ElementarySymmetry(positions, block.symmetry == SymmetryType::SYMMETRIC));
+                    }
+                    offset += block.indices;
+
+                    if (block.derivatives > 1) {
+                        std::vector<unsigned> positions (block.derivatives);
+                        std::iota(positions.begin(), positions.end(), offset);
+
+                        result.Add(Construction::Tensor::ElementarySymmetry(positions, true));
+                    }
+                    offset += block.derivatives;
+                }
+
+                auto exchanged = [&](unsigned i) {
+                    return i < exchangeSymmetries.size() && i+1 < blocks.size() && exchangeSymmetries[i] && blocks[i] == blocks[i+1];
+                };
+
+                for (unsigned i=0; i<exchangeSymmetries.size() && i+1 < blocks.size(); ++i) {
+                    if (!exchanged(i) || exchanged(i+1)) continue;
+
+                    // Empty blocks have nothing to exchange
+                    if (blocks[i].indices + blocks[i].derivatives == 0) continue;
+
+                    result.Add(Construction::Tensor::ElementarySymmetry(std::vector<std::pair<unsigned, unsigned>>({ units[i], units[i+1] }), true));
+                }
+
+                return result;
+            }
+
+            /**
+                \brief The index structure of the coefficient without its name
+
+                Two coefficients with the same structure are generated in
+                exactly the same way, only the names of their variables differ.
+             */
+            std::string GetStructure() const {
+                std::string result;
+
+                for (auto& block : blocks) {
+                    result += std::to_string(block.indices) + "," + std::to_string(static_cast<int>(block.symmetry)) + "," + std::to_string(block.derivatives) + ";";
+                }
+
+                for (auto exchange : exchangeSymmetries) {
+                    result += exchange ? "x" : "-";
+                }
+
+                return result;
+            }
+
             bool operator<(const CoefficientDefinition& other) const {
                 if (blocks.size() < other.blocks.size()) return true;
                 else if (blocks.size() > other.blocks.size()) return false;
@@ -430,16 +509,304 @@ namespace Construction {
             bool ignoreNextToken = false;
         };
 
+        class Coefficient;
+
+        /**
+            \class VariableIndex
+
+            \brief Inverted index from variables to the coefficients they appear in
+
+            Every finished coefficient registers the variables of its tensor.
+            The SubstitutionManager uses this index to update only those
+            coefficients that actually contain one of the substituted variables.
+
+            The index does not keep the coefficients alive. A coefficient removes
+            itself when it is destroyed, and entries that expired anyway are
+            dropped once they are found.
+         */
+        class VariableIndex : public Singleton<VariableIndex> {
+        private:
+            typedef std::pair<const Coefficient*, std::weak_ptr<Coefficient>>   Reference;
+        public:
+            /**
+                \brief Replace the variables registered for a coefficient
+             */
+            void Update(const std::shared_ptr<Coefficient>& coefficient, const std::vector<Construction::Tensor::Scalar>& variables) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                // Remove the old entries
+                Erase(coefficient.get());
+
+                // Insert the new entries
+                std::vector<std::string> names;
+                for (auto& variable : variables) {
+                    auto name = variable.ToString();
+
+                    coefficientsOf[name].push_back({ coefficient.get(), coefficient });
+                    names.push_back(name);
+                }
+
+                variablesOf[coefficient.get()] = std::move(names);
+            }
+
+            /**
+                \brief Forget a coefficient, called by the destructor of Coefficient
+             */
+            void Remove(const Coefficient* coefficient) {
+                std::unique_lock<std::mutex> lock(mutex);
+                Erase(coefficient);
+            }
+
+            /**
+                \brief Find all the coefficients that contain one of the variables
+
+                Returns every coefficient at most once.
+             */
+            std::vector<std::shared_ptr<Coefficient>> Find(const std::vector<Construction::Tensor::Scalar>& variables) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                std::vector<std::shared_ptr<Coefficient>> result;
+
+                for (auto& variable : variables) {
+                    auto it = coefficientsOf.find(variable.ToString());
+                    if (it == coefficientsOf.end()) continue;
+
+                    auto& list = it->second;
+
+                    for (auto jt = list.begin(); jt != list.end(); ) {
+                        auto coefficient = jt->second.lock();
+
+                        // Drop the coefficients that are gone
+                        if (!coefficient) {
+                            jt = list.erase(jt);
+                            continue;
+                        }
+
+                        if (std::find(result.begin(), result.end(), coefficient) == result.end()) {
+                            result.push_back(coefficient);
+                        }
+
+                        ++jt;
+                    }
+
+                    if (list.empty()) coefficientsOf.erase(it);
+                }
+
+                return result;
+            }
+
+            /**
+                \brief Number of variables registered for a coefficient
+             */
+            size_t Count(const std::shared_ptr<Coefficient>& coefficient) const {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                auto it = variablesOf.find(coefficient.get());
+                return it != variablesOf.end() ? it->second.size() : 0;
+            }
+
+            bool Contains(const std::shared_ptr<Coefficient>& coefficient) const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return variablesOf.find(coefficient.get()) != variablesOf.end();
+            }
+
+            size_t Size() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return coefficientsOf.size();
+            }
+
+            /**
+                \brief Forget all the coefficients, e.g. before the next job of the server
+             */
+            void Clear() {
+                std::unique_lock<std::mutex> lock(mutex);
+                coefficientsOf.clear();
+                variablesOf.clear();
+            }
+        private:
+            // Remove the entries of a coefficient and the expired ones next to them
+            void Erase(const Coefficient* coefficient) {
+                auto it = variablesOf.find(coefficient);
+                if (it == variablesOf.end()) return;
+
+                for (auto& name : it->second) {
+                    auto jt = coefficientsOf.find(name);
+                    if (jt == coefficientsOf.end()) continue;
+
+                    // Do not lock the others here, the last reference may be
+                    // dropped under the mutex otherwise
+                    auto& list = jt->second;
+                    list.erase(std::remove_if(list.begin(), list.end(), [&](const Reference& entry) {
+                        return entry.first == coefficient || entry.second.expired();
+                    }), list.end());
+
+                    if (list.empty()) coefficientsOf.erase(jt);
+                }
+
+                variablesOf.erase(it);
+            }
+        private:
+            std::map<std::string, std::vector<Reference>> coefficientsOf;
+            std::map<const Coefficient*, std::vector<std::string>> variablesOf;
+
+            mutable std::mutex mutex;
+        };
+
+        /**
+            \class CoefficientCache
+
+            \brief Memo of the generated coefficients, shared by all the jobs of a process
+
+            The generation of a coefficient only depends on its index structure,
+            see CoefficientDefinition::GetStructure. A long running process, i.e.
+            the construction server, enables the cache such that every structure
+            is only generated once. Later coefficients with the same structure
+            get a copy with new names for the variables.
+
+            Unlike the ExpressionDatabase the cache never touches the disk. It is
+            disabled by default, since `apple solve` generates every structure
+            at most once anyway. The most recently used structures are kept up
+            to a limit of bytes, s.t. a server that sees many different scripts
+            does not grow without bound.
+         */
+        class CoefficientCache : public Singleton<CoefficientCache> {
+        public:
+            static bool IsEnabled() {
+                return Enabled().load(std::memory_order_relaxed);
+            }
+
+            static void Enable() {
+                Enabled() = true;
+            }
+
+            static void Disable() {
+                Enabled() = false;
+            }
+        public:
+            /**
+                \brief Look up the tensor of a structure
+
+                \returns True if the structure was found
+             */
+            bool Get(const std::string& structure, Tensor::Tensor& tensor) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                auto it = map.find(structure);
+
+                if (it == map.end()) {
+                    ++misses;
+                    return false;
+                }
+
+                // Mark as most recently used
+                entries.splice(entries.begin(), entries, it->second);
+
+                ++hits;
+                tensor = it->second->second;
+                return true;
+            }
+
+            void Insert(const std::string& structure, const Tensor::Tensor& tensor) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                // Keep the first tensor of a structure, like before
+                if (map.find(structure) != map.end()) return;
+
+                entries.push_front({ structure, tensor });
+                map[structure] = entries.begin();
+                bytes += GetSize(entries.front());
+
+                Shrink();
+            }
+
+            void Clear() {
+                std::unique_lock<std::mutex> lock(mutex);
+                entries.clear();
+                map.clear();
+                bytes = 0;
+            }
+
+            /**
+                \brief Limit the memory of the tensors, older structures are dropped first
+             */
+            void SetMaximalSize(size_t size) {
+                std::unique_lock<std::mutex> lock(mutex);
+                maximalSize = size;
+                Shrink();
+            }
+        public:
+            size_t Size() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return map.size();
+            }
+
+            size_t GetHits() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return hits;
+            }
+
+            size_t GetMisses() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return misses;
+            }
+
+            size_t GetEvictions() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return evictions;
+            }
+
+            size_t MemoryFootprint() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return bytes + map.bucket_count() * sizeof(void*);
+            }
+        private:
+            void Shrink() {
+                // Always keep the most recent structure
+                while (bytes > maximalSize && entries.size() > 1) {
+                    auto& last = entries.back();
+
+                    bytes -= GetSize(last);
+                    map.erase(last.first);
+                    entries.pop_back();
+
+                    ++evictions;
+                }
+            }
+
+            static size_t GetSize(const std::pair<std::string, Tensor::Tensor>& entry) {
+                return Common::HASH_NODE_OVERHEAD + Common::TREE_NODE_OVERHEAD + 2 * Common::MemoryFootprint(entry.first) + Common::MemoryFootprint(entry.second);
+            }
+
+            static std::atomic<bool>& Enabled() {
+                static std::atomic<bool> enabled (false);
+                return enabled;
+            }
+        private:
+            typedef std::list<std::pair<std::string, Tensor::Tensor>>   EntryList;
+
+            EntryList entries;
+            std::unordered_map<std::string, EntryList::iterator> map;
+
+            size_t bytes = 0;
+            size_t maximalSize = 512 * 1024 * 1024;
+
+            size_t hits = 0;
+            size_t misses = 0;
+            size_t evictions = 0;
+
+            mutable std::mutex mutex;
+        };
+
         /**
             \class Coefficient
 
             Container class that handles the calculation of a specific
             coefficient in a set of equations. It is calculated in the
-            background once Start is called.
+            background by the Scheduler once Start is called.
 
             Once the calculation is finished, the state changes and one
             can access the tensor via Get(). A call of Get() before the
-            thread is finished will block the main thread, so be careful!
+            calculation is finished will block the main thread, so be careful!
          */
         class Coefficient : public Unique<Coefficient, 103>, public std::enable_shared_from_this<Coefficient> {
         public:
@@ -455,11 +822,17 @@ namespace Construction {
         public:
             Coefficient(CoefficientDefinition defn, const std::string& id) : defn(defn), id(id), state(DEFERRED) {
                 name = id + GetRandomString(4);
+
+                task = Scheduler::Instance()->Create(Scheduler::Stage::COEFFICIENT, [this]() {
+                    Calculate();
+                });
             }
 
             virtual ~Coefficient() {
-                // Join the thread
-                thread.join();
+                // Make sure the calculation is not running any more
+                Scheduler::Instance()->Cancel(task);
+
+                VariableIndex::Instance()->Remove(this);
             }
         public:
             // Is the coefficient calculation deferred, i.e. not started yet?
@@ -484,9 +857,26 @@ namespace Construction {
             /**
                 Register an observer that is notified once the
                 state of the tensor changes
+
+                \returns The id to unregister the observer with
+             */
+            size_t RegisterObserver(ObserverFunction observer) {
+                std::unique_lock<std::mutex> lock(observersMutex);
+
+                observers.push_back({ ++lastObserver, observer });
+                return lastObserver;
+            }
+
+            /**
+                Remove an observer, e.g. if the object it refers to is
+                destroyed. Waits for a running notification to finish.
              */
-            void RegisterObserver(ObserverFunction observer) {
-                observers.push_back(observer);
+            void UnregisterObserver(size_t id) {
+                std::unique_lock<std::mutex> lock(observersMutex);
+
+                observers.erase(std::remove_if(observers.begin(), observers.end(), [id](const std::pair<size_t, ObserverFunction>& observer) {
+                    return observer.first == id;
+                }), observers.end());
             }
         private:
             /**
@@ -501,19 +891,33 @@ namespace Construction {
                 logger << Construction::Logger::DEBUG << "Notify all the observers of " << ref << Construction::Logger::endl;
 
                 // Iterate over all observers
-                for (auto& fn : observers) {
-                    fn(ref);
+                std::unique_lock<std::mutex> lock(observersMutex);
+
+                for (auto& observer : observers) {
+                    observer.second(ref);
                 }
             }
         public:
             /**
-                Start the calculation of the coefficient in a new thread
+                Submit the calculation of the coefficient to the scheduler
              */
             void Start() {
-                // Start calculation in thread
-                thread = std::thread(&Coefficient::Calculate, this);
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+
+                    if (state != DEFERRED) return;
+                    state = CALCULATING;
+                }
+
+                Scheduler::Instance()->Submit(task);
             }
 
+            /**
+                The scheduler task of the calculation. Equations depend
+                on the tasks of their coefficients.
+             */
+            Scheduler::TaskReference GetTask() const { return task; }
+
             /**
                 Blocks the current thread until the calculation was either
                 not started, is finished or an error occured.
@@ -567,6 +971,25 @@ namespace Construction {
                 if (isUnlocked) readMutex.unlock();
                 return !isUnlocked;
             }
+
+            /**
+                \brief Locks a coefficient until the end of the scope, also if an exception is thrown
+             */
+            class ScopedLock {
+            public:
+                explicit ScopedLock(Coefficient& coefficient) : coefficient(coefficient) {
+                    coefficient.Lock();
+                }
+
+                ~ScopedLock() {
+                    coefficient.Unlock();
+                }
+
+                ScopedLock(const ScopedLock&) = delete;
+                ScopedLock& operator=(const ScopedLock&) = delete;
+            private:
+                Coefficient& coefficient;
+            };
         public:
             /**
                 \brief Calculate the number of steps needed to calculate the coefficient
@@ -599,7 +1022,7 @@ namespace Construction {
 
                 Calculates the actual tensor with the correct symmetries. It
                 shall not be used outside of the Start method, since this will
-                generate the thread in the correct fashion and garantuees the
+                submit the task in the correct fashion and garantuees the
                 deferred calculation to work.
 
                 In between steps, the tensor will be stored on disk s.t. a
@@ -610,6 +1033,13 @@ namespace Construction {
                 // Lock the mutex
                 std::unique_lock<std::mutex> lock(mutex);
 
+                PROFILE_ZONE("Coefficient::Calculate");
+
+                Common::TraceScope trace ("Coefficient::Calculate");
+                if (trace.IsEnabled()) {
+                    trace.Set("indices", defn.indices.Size());
+                }
+
                 try {
                     // Set the state to calculating
                     state = CALCULATING;
@@ -681,79 +1111,145 @@ namespace Construction {
                             }
                         }
 
-                        // ---------- Arbitrary -----------
+                        // ---------- Shared cache -----------
+
+                        Construction::Tensor::Tensor cached;
+                        std::string structure = defn.GetStructure();
 
-                        // Generate current string
-                        std::string currentCmd = "Arbitrary(" + indices.ToCommand() + ")";
+                        if (CoefficientCache::IsEnabled() && CoefficientCache::Instance()->Get(structure, cached)) {
+                            Construction::Logger::Debug("Found coefficient ", structure, " in the cache");
 
-                        // Generate the tensors
-                        if (!db->Contains(currentCmd)) {
-                            tensor = std::make_shared<Construction::Tensor::Tensor>(Construction::Language::API::Arbitrary(indices));
+                            tensor = std::make_shared<Construction::Tensor::Tensor>(cached.RedefineVariables(GetRandomString()));
 
-                            // Insert into the database
-                            db->Insert(currentCmd, *tensor);
+                            // Report the same steps as a generation
+                            unsigned steps = 2 + exchangedIndices.size();
+                            for (auto& block : blocks) {
+                                if (block.first.Size() > 1 && block.second != CoefficientDefinition::SymmetryType::NONE) ++steps;
+                            }
+
+                            for (unsigned i=0; i<steps; ++i) {
+                                Notify();
+                            }
                         } else {
-                            Construction::Logger::Debug("Found coefficient in database");
+                            // ---------- Arbitrary -----------
 
-                            auto expr = db->Get(currentCmd).As<Construction::Tensor::Tensor>();
-                            Construction::Logger::Debug("Found ", expr);
+                            // Generate current string
+                            std::string currentCmd = "Arbitrary(" + indices.ToCommand() + ")";
 
-                            // Copy from database
-                            tensor = std::make_shared<Construction::Tensor::Tensor>(expr);
-                        }
+                            // Generate the tensors
+                            if (!db->Contains(currentCmd)) {
+                                Common::TraceScope phase ("Arbitrary");
+                                if (phase.IsEnabled()) {
+                                    phase.Set("indices", indices.Size());
+                                }
 
-                        Notify();
+                                tensor = std::make_shared<Construction::Tensor::Tensor>(Construction::Language::API::Arbitrary(indices));
+                                if (phase.IsEnabled()) phase.Set("summands", tensor->GetNumberOfSummands());
 
-                        // ---------- Symmetrizations -----------
+                                // Insert into the database
+                                db->Insert(currentCmd, *tensor);
+                            } else {
+                                Construction::Logger::Debug("Found coefficient in database");
 
-                        for (auto& block : blocks) {
-                            // If there are no indices in the block, do nothing
-                            if (block.first.Size() == 0 || block.first.Size() == 1) continue;
+                                auto expr = db->Get(currentCmd).As<Construction::Tensor::Tensor>();
+                                Construction::Logger::Debug("Found ", expr);
 
-                            switch (block.second) {
-                                case CoefficientDefinition::SymmetryType::NONE:
-                                    // Do nothing
-                                    break;
+                                // Copy from database
+                                tensor = std::make_shared<Construction::Tensor::Tensor>(expr);
+                            }
 
-                                case CoefficientDefinition::SymmetryType::SYMMETRIC:
-                                    // Make symmetric
-                                    if (block.first.Size() > 1) {
-                                        currentCmd = "Symmetrize(" + currentCmd + ", " + block.first.ToCommand() + ")";
+                            Notify();
 
-                                        if (!db->Contains(currentCmd)) {
-                                            tensor = std::make_shared<Construction::Tensor::Tensor>(tensor->Symmetrize(block.first));
-                                            db->Insert(currentCmd, *tensor);
-                                        } else {
-                                            tensor = std::make_shared<Construction::Tensor::Tensor>(db->Get(currentCmd).As<Construction::Tensor::Tensor>());
+                            // ---------- Symmetrizations -----------
+
+                            for (auto& block : blocks) {
+                                // If there are no indices in the block, do nothing
+                                if (block.first.Size() == 0 || block.first.Size() == 1) continue;
+
+                                switch (block.second) {
+                                    case CoefficientDefinition::SymmetryType::NONE:
+                                        // Do nothing
+                                        break;
+
+                                    case CoefficientDefinition::SymmetryType::SYMMETRIC:
+                                        // Make symmetric
+                                        if (block.first.Size() > 1) {
+                                            currentCmd = "Symmetrize(" + currentCmd + ", " + block.first.ToCommand() + ")";
+
+                                            if (!db->Contains(currentCmd)) {
+                                                Common::TraceScope phase ("Symmetrize");
+                                                if (phase.IsEnabled()) {
+                                                    phase.Set("indices", block.first.Size());
+                                                    phase.Set("summands", tensor->GetNumberOfSummands());
+                                                }
+
+                                                tensor = std::make_shared<Construction::Tensor::Tensor>(tensor->Symmetrize(block.first));
+                                                if (phase.IsEnabled()) phase.Set("result", tensor->GetNumberOfSummands());
+                                                db->Insert(currentCmd, *tensor);
+                                            } else {
+                                                tensor = std::make_shared<Construction::Tensor::Tensor>(db->Get(currentCmd).As<Construction::Tensor::Tensor>());
+                                            }
                                         }
-                                    }
-                                    Notify();
-                                    break;
-
-                                case CoefficientDefinition::SymmetryType::ANTISYMMETRIC:
-                                    // Make antisymmetric
-                                    if (block.first.Size() > 1) {
-                                        currentCmd = "AntiSymmetrize(" + currentCmd + ", " + block.first.ToCommand() + ")";
-
-                                        if (!db->Contains(currentCmd)) {
-                                            tensor = std::make_shared<Construction::Tensor::Tensor>(tensor->AntiSymmetrize(block.first));
-                                            db->Insert(currentCmd, *tensor);
-                                        } else {
-                                            tensor = std::make_shared<Construction::Tensor::Tensor>(db->Get(currentCmd).As<Construction::Tensor::Tensor>());
+                                        Notify();
+                                        break;
+
+                                    case CoefficientDefinition::SymmetryType::ANTISYMMETRIC:
+                                        // Make antisymmetric
+                                        if (block.first.Size() > 1) {
+                                            currentCmd = "AntiSymmetrize(" + currentCmd + ", " + block.first.ToCommand() + ")";
+
+                                            if (!db->Contains(currentCmd)) {
+                                                Common::TraceScope phase ("AntiSymmetrize");
+                                                if (phase.IsEnabled()) {
+                                                    phase.Set("indices", block.first.Size());
+                                                    phase.Set("summands", tensor->GetNumberOfSummands());
+                                                }
+
+                                                tensor = std::make_shared<Construction::Tensor::Tensor>(tensor->AntiSymmetrize(block.first));
+                                                if (phase.IsEnabled()) phase.Set("result", tensor->GetNumberOfSummands());
+                                                db->Insert(currentCmd, *tensor);
+                                            } else {
+                                                tensor = std::make_shared<Construction::Tensor::Tensor>(db->Get(currentCmd).As<Construction::Tensor::Tensor>());
+                                            }
                                         }
-                                    }
-                                    Notify();
-                                    break;
+                                        Notify();
+                                        break;
+                                }
                             }
-                        }
 
-                        // ---------- Exchange Symmetrizations -----------
+                            // ---------- Exchange Symmetrizations -----------
+
+                            for (auto& exchanged : exchangedIndices) {
+                                currentCmd = "ExchangeSymmetrize(" + currentCmd + ", " + indices.ToCommand() + ", " + exchanged.ToCommand() +")";
+
+                                if (!db->Contains(currentCmd)) {
+                                    Common::TraceScope phase ("ExchangeSymmetrize");
+                                    if (phase.IsEnabled()) {
+                                        phase.Set("indices", indices.Size());
+                                        phase.Set("summands", tensor->GetNumberOfSummands());
+                                    }
+
+                                    tensor = std::make_shared<Construction::Tensor::Tensor>(tensor->ExchangeSymmetrize(indices, exchanged));
+                                    if (phase.IsEnabled()) phase.Set("result", tensor->GetNumberOfSummands());
+
+                                    db->Insert(currentCmd, *tensor);
+                                } else {
+                                    tensor = std::make_shared<Construction::Tensor::Tensor>(db->Get(currentCmd).As<Construction::Tensor::Tensor>());
+                                }
 
-                        for (auto& exchanged : exchangedIndices) {
-                            currentCmd = "ExchangeSymmetrize(" + currentCmd + ", " + indices.ToCommand() + ", " + exchanged.ToCommand() +")";
+                                Notify();
+                            }
 
+                            // ---------- Simplify -----------
+                            currentCmd = "LinearIndependent(" + currentCmd + ")";
                             if (!db->Contains(currentCmd)) {
-                                tensor = std::make_shared<Construction::Tensor::Tensor>(tensor->ExchangeSymmetrize(indices, exchanged));
+                                Common::TraceScope phase ("LinearIndependent");
+                                if (phase.IsEnabled()) {
+                                    phase.Set("summands", tensor->GetNumberOfSummands());
+                                }
+
+                                tensor = std::make_shared<Construction::Tensor::Tensor>(tensor->Simplify(defn.GetSymmetry()).RedefineVariables(GetRandomString()));
+                                if (phase.IsEnabled()) phase.Set("result", tensor->GetNumberOfSummands());
 
                                 db->Insert(currentCmd, *tensor);
                             } else {
@@ -761,20 +1257,12 @@ namespace Construction {
                             }
 
                             Notify();
-                        }
 
-                        // ---------- Simplify -----------
-                        currentCmd = "LinearIndependent(" + currentCmd + ")";
-                        if (!db->Contains(currentCmd)) {
-                            tensor = std::make_shared<Construction::Tensor::Tensor>(tensor->Simplify().RedefineVariables(GetRandomString()));
-
-                            db->Insert(currentCmd, *tensor);
-                        } else {
-                            tensor = std::make_shared<Construction::Tensor::Tensor>(db->Get(currentCmd).As<Construction::Tensor::Tensor>());
+                            if (CoefficientCache::IsEnabled()) {
+                                CoefficientCache::Instance()->Insert(structure, *tensor);
+                            }
                         }
 
-                        Notify();
-
                         // Assign the tensor to the session
                         Session::Instance()->Set(name, std::move(*tensor));
                     }
@@ -794,6 +1282,9 @@ namespace Construction {
                 // Finished
                 state = FINISHED;
 
+                // Register the variables of the coefficient
+                VariableIndex::Instance()->Update(GetReference(), tensor->GetVariables());
+
                 Construction::Logger logger;
                 logger << Construction::Logger::DEBUG << "Finished coefficient " << GetReference() << ": `" << ToString() << "`" << Construction::Logger::endl;
 
@@ -801,12 +1292,23 @@ namespace Construction {
                 variable.notify_all();
             }
         public:
+            /**
+                \brief Seed the generator of the random names
+
+                Makes the names of the variables reproducible, as long as
+                the coefficients are calculated in the same order.
+             */
+            static void SetSeed(unsigned seed) {
+                std::unique_lock<std::mutex> lock(GetRandomMutex());
+                GetRandomEngine().seed(seed);
+            }
+
             /**
                 Generate a random string out of alphabeticals
              */
             static std::string GetRandomString(int size = 3) {
-                static std::random_device device;
-                static std::mt19937 engine (device());
+                std::unique_lock<std::mutex> lock(GetRandomMutex());
+                auto& engine = GetRandomEngine();
 
                 static std::vector<char> elements = {
                     'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
@@ -825,6 +1327,17 @@ namespace Construction {
 
                 return output;
             }
+        private:
+            static std::mt19937& GetRandomEngine() {
+                static std::random_device device;
+                static std::mt19937 engine (device());
+                return engine;
+            }
+
+            static std::mutex& GetRandomMutex() {
+                static std::mutex mutex;
+                return mutex;
+            }
         public:
             std::string ToString(bool includeResult=true) const {
                 std::stringstream ss;
@@ -842,12 +1355,14 @@ namespace Construction {
             mutable std::mutex readMutex;
 
             std::condition_variable variable;
-            std::thread thread;
+            Scheduler::TaskReference task;
 
             //Session session;
             State state;
 
-            std::vector<ObserverFunction> observers;
+            std::vector<std::pair<size_t, ObserverFunction>> observers;
+            size_t lastObserver = 0;
+            std::mutex observersMutex;
 
             std::string id;
             std::string name;
@@ -953,6 +1468,30 @@ namespace Construction {
             }
 
             size_t Size() const { return map.size(); }
+
+            /**
+                \brief Forget all the coefficients
+
+                Only allowed if no calculation is running, i.e. after the
+                Scheduler finished, since the coefficients are destroyed.
+             */
+            void Clear() {
+                map.clear();
+            }
+
+            /**
+                \brief Estimate the memory of all the calculated coefficients
+             */
+            size_t MemoryFootprint() {
+                size_t result = 0;
+
+                for (auto& it : map) {
+                    auto tensor = it.second->GetAsync();
+                    if (tensor) result += tensor->DeepSize();
+                }
+
+                return result;
+            }
         public:
             unsigned int GetNumberOfSteps() const {
                 unsigned int steps = 0;
@@ -0,0 +1,979 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <functional>
+
+#include <common/error.hpp>
+#include <common/logger.hpp>
+#include <common/singleton.hpp>
+#include <language/cli.hpp>
+#include <equations/coefficient.hpp>
+
+namespace Construction {
+    namespace Equations {
+
+        /**
+            \class CompiledNode
+
+            \brief Node of a compiled equation
+
+            A compiled node evaluates to a tensor. The result is handed out
+            as a pointer to a constant tensor, so coefficients and constant
+            subexpressions can be passed on by reference without being copied.
+         */
+        class CompiledNode {
+        public:
+            typedef std::shared_ptr<const Tensor::Tensor>   TensorPointer;
+        public:
+            virtual ~CompiledNode() = default;
+        public:
+            virtual TensorPointer Evaluate() const = 0;
+
+            /**
+                Returns true if the node does not depend on any coefficient,
+                i.e. if it can be evaluated before the coefficients are
+                calculated.
+             */
+            virtual bool IsConstant() const { return false; }
+        };
+
+        typedef std::shared_ptr<CompiledNode>   CompiledNodePointer;
+
+        /**
+            \class CompiledOperand
+
+            \brief Operand of a compiled command
+
+            Either a tensor valued node or a constant, i.e. indices,
+            a numeric or a string, which is evaluated while compiling.
+         */
+        class CompiledOperand {
+        public:
+            CompiledOperand() = default;
+            CompiledOperand(const CompiledNodePointer& node) : node(node) { }
+            CompiledOperand(const Tensor::Expression& constant) : constant(constant) { }
+        public:
+            bool IsTensor() const { return node != nullptr; }
+            bool IsConstant() const { return !node || node->IsConstant(); }
+
+            const CompiledNodePointer& GetNode() const { return node; }
+            const Tensor::Expression& GetConstant() const { return constant; }
+        private:
+            CompiledNodePointer node;
+            Tensor::Expression constant;
+        };
+
+        /**
+            \class CompiledArguments
+
+            \brief The evaluated arguments of a compiled command
+         */
+        class CompiledArguments {
+        public:
+            CompiledArguments(const std::vector<CompiledOperand>& operands) : operands(operands) {
+                tensors.reserve(operands.size());
+
+                for (auto& operand : operands) {
+                    if (operand.IsTensor()) {
+                        tensors.push_back(operand.GetNode()->Evaluate());
+                    } else {
+                        tensors.push_back(nullptr);
+                    }
+                }
+            }
+        public:
+            size_t Size() const { return operands.size(); }
+
+            const Tensor::Tensor& GetTensor(unsigned pos) const {
+                if (pos >= tensors.size() || !tensors[pos]) throw WrongArgumentTypeException();
+                return *tensors[pos];
+            }
+
+            const Tensor::Indices& GetIndices(unsigned pos) const {
+                auto& expr = Get(pos);
+                if (!expr.IsIndices()) throw WrongArgumentTypeException();
+                return *expr.As<Tensor::Indices>();
+            }
+
+            const Tensor::Scalar& GetNumeric(unsigned pos) const {
+                auto& expr = Get(pos);
+                if (!expr.IsScalar()) throw WrongArgumentTypeException();
+                return *expr.As<Tensor::Scalar>();
+            }
+        private:
+            const Tensor::Expression& Get(unsigned pos) const {
+                if (pos >= operands.size() || operands[pos].IsTensor()) throw WrongArgumentTypeException();
+                return operands[pos].GetConstant();
+            }
+        private:
+            const std::vector<CompiledOperand>& operands;
+            std::vector<CompiledNode::TensorPointer> tensors;
+        };
+
+        /**
+            \class ConstantNode
+
+            \brief A tensor that does not depend on any coefficient
+         */
+        class ConstantNode : public CompiledNode {
+        public:
+            ConstantNode(const TensorPointer& tensor) : tensor(tensor) { }
+        public:
+            virtual TensorPointer Evaluate() const { return tensor; }
+            virtual bool IsConstant() const { return true; }
+        private:
+            TensorPointer tensor;
+        };
+
+        /**
+            \class CoefficientNode
+
+            \brief Reference to a coefficient in a compiled equation
+
+            The tensor is read directly from the coefficient. If indices
+            are given, the indices of the coefficient are renamed, which
+            is how coefficients appear in the equations.
+         */
+        class CoefficientNode : public CompiledNode {
+        public:
+            CoefficientNode(const CoefficientReference& ref) : ref(ref), rename(false) { }
+            CoefficientNode(const CoefficientReference& ref, const Tensor::Indices& from, const Tensor::Indices& to)
+                : ref(ref), from(from), to(to), rename(true) { }
+        public:
+            virtual TensorPointer Evaluate() const {
+                auto tensor = ref->GetAsync();
+                if (!tensor) throw Exception("The coefficient `" + ref->GetName() + "` is not calculated yet");
+
+                if (!rename) return tensor;
+                return std::make_shared<const Tensor::Tensor>(Language::API::RenameIndices(*tensor, from, to));
+            }
+        private:
+            CoefficientReference ref;
+            Tensor::Indices from;
+            Tensor::Indices to;
+            bool rename;
+        };
+
+        /**
+            \class CallNode
+
+            \brief Call of a function on the evaluated arguments
+         */
+        class CallNode : public CompiledNode {
+        public:
+            typedef std::function<Tensor::Tensor(const CompiledArguments&)>   Function;
+        public:
+            CallNode(const Function& fn, const std::vector<CompiledOperand>& operands) : fn(fn), operands(operands) { }
+        public:
+            virtual TensorPointer Evaluate() const {
+                CompiledArguments args (operands);
+                return std::make_shared<const Tensor::Tensor>(fn(args));
+            }
+
+            virtual bool IsConstant() const {
+                for (auto& operand : operands) {
+                    if (!operand.IsConstant()) return false;
+                }
+                return true;
+            }
+        private:
+            Function fn;
+            std::vector<CompiledOperand> operands;
+        };
+
+        /**
+            \class CommandCallNode
+
+            \brief Fallback for commands without a direct implementation
+
+            Commands that are not known to the compiler are executed by
+            the command registered in the CommandManagement.
+         */
+        class CommandCallNode : public CompiledNode {
+        public:
+            CommandCallNode(const std::string& name, const std::vector<CompiledOperand>& operands) : name(name), operands(operands) { }
+        public:
+            static Tensor::Expression Execute(const std::string& name, const std::vector<CompiledOperand>& operands) {
+                auto command = Language::CommandManagement::Instance()->CreateCommand(name);
+
+                for (auto& operand : operands) {
+                    if (operand.IsTensor()) {
+                        auto arg = std::make_shared<Language::TensorArgument>();
+                        arg->SetTensor(*operand.GetNode()->Evaluate());
+                        command->AddArgument(std::move(arg));
+                        continue;
+                    }
+
+                    auto& expr = operand.GetConstant();
+
+                    if (expr.IsScalar()) {
+                        command->AddArgument(std::make_shared<Language::NumericArgument>(*expr.As<Tensor::Scalar>()));
+                    } else if (expr.IsIndices()) {
+                        command->AddArgument(std::make_shared<Language::IndexArgument>(*expr.As<Tensor::Indices>()));
+                    } else if (expr.IsString()) {
+                        command->AddArgument(std::make_shared<Language::StringArgument>(expr.ToString()));
+                    } else {
+                        throw Exception(std::string("Unexpected argument of type `") + expr.TypeToString() + "` in `" + name + "`");
+                    }
+                }
+
+                return (*command)();
+            }
+        public:
+            virtual TensorPointer Evaluate() const {
+                auto result = Execute(name, operands);
+                if (!result.IsTensor()) throw Exception("The command `" + name + "` does not evaluate to a tensor");
+
+                return std::make_shared<const Tensor::Tensor>(result.As<Tensor::Tensor>());
+            }
+
+            virtual bool IsConstant() const {
+                for (auto& operand : operands) {
+                    if (!operand.IsConstant()) return false;
+                }
+                return true;
+            }
+        private:
+            std::string name;
+            std::vector<CompiledOperand> operands;
+        };
+
+        /**
+            \class SharedNode
+
+            \brief Subexpression that occurs in more than one place
+
+            Wraps the node of the first occurrence of a subexpression that
+            depends on coefficients, see SubexpressionTable. As soon as it is
+            used a second time, the result is memoized together with the
+            tensors of the coefficients it was calculated from. A merge of
+            substitutions replaces the tensor of a coefficient, which makes
+            the next evaluation calculate the result again.
+
+            The node is not locked while it is evaluated, since the worker
+            may run another equation with the same subexpression meanwhile.
+            Hence two equations may occasionally calculate it both.
+         */
+        class SharedNode : public CompiledNode {
+        public:
+            SharedNode(const CompiledNodePointer& node, const std::vector<CoefficientReference>& coefficients)
+                : node(node), coefficients(coefficients) { }
+        public:
+            virtual TensorPointer Evaluate() const {
+                if (uses < 2) return node->Evaluate();
+
+                std::vector<TensorPointer> inputs;
+                for (auto& ref : coefficients) {
+                    inputs.push_back(ref->GetAsync());
+                }
+
+                // Scope based locking
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    if (result && IsUpToDate(inputs)) return result;
+                }
+
+                auto value = node->Evaluate();
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                result = value;
+                this->inputs.assign(inputs.begin(), inputs.end());
+
+                return value;
+            }
+
+            virtual bool IsConstant() const { return node->IsConstant(); }
+
+            /**
+                \brief Register another occurrence of the subexpression
+             */
+            void Use() { ++uses; }
+        private:
+            bool IsUpToDate(const std::vector<TensorPointer>& current) const {
+                for (unsigned i=0; i<current.size(); ++i) {
+                    if (!current[i] || inputs[i].lock() != current[i]) return false;
+                }
+                return true;
+            }
+        private:
+            CompiledNodePointer node;
+            std::vector<CoefficientReference> coefficients;
+
+            std::atomic<unsigned> uses { 1 };
+
+            mutable TensorPointer result;
+            mutable std::vector<std::weak_ptr<const Tensor::Tensor>> inputs;
+            mutable std::mutex mutex;
+        };
+
+        /**
+            \class Renaming
+
+            \brief Consistent renaming between two occurrences of a subexpression
+
+            Maps the indices of the first occurrence to the ones of another
+            occurrence, both in the order of their first appearance. The result
+            of the first occurrence can only be renamed if its contracted
+            indices keep their names. Otherwise they could be captured by
+            the renamed free indices.
+         */
+        class Renaming {
+        public:
+            Renaming(const std::vector<std::string>& from, const std::vector<std::string>& to) : from(from), to(to) { }
+        public:
+            bool IsIdentity() const { return from == to; }
+
+            /**
+                \brief Rename the result of the first occurrence
+
+                \returns False if the renaming is not possible
+             */
+            bool Apply(const Tensor::Tensor& tensor, Tensor::Tensor& result) const {
+                auto free = tensor.GetIndices();
+
+                std::set<std::string> names;
+                for (auto& index : free) {
+                    names.insert(index.GetName());
+                }
+
+                std::map<std::string, std::string> mapping;
+
+                for (unsigned i=0; i<from.size(); ++i) {
+                    if (names.find(from[i]) != names.end()) {
+                        mapping[from[i]] = to[i];
+                    } else if (from[i] != to[i]) {
+                        return false;
+                    }
+                }
+
+                Tensor::Indices source;
+                Tensor::Indices target;
+
+                for (auto& index : free) {
+                    auto it = mapping.find(index.GetName());
+                    if (it == mapping.end() || it->second == index.GetName()) continue;
+
+                    Tensor::Index renamed (it->second, it->second, index.GetRange());
+                    renamed.SetContravariant(index.IsContravariant());
+
+                    source.Insert(index);
+                    target.Insert(renamed);
+                }
+
+                result = (source.Size() == 0) ? tensor : Language::API::RenameIndices(tensor, source, target);
+                return true;
+            }
+        private:
+            std::vector<std::string> from;
+            std::vector<std::string> to;
+        };
+
+        /**
+            \class RenamedNode
+
+            \brief Occurrence of a shared subexpression with other index names
+
+            If the renaming is not possible for the result, the node falls
+            back to its own compiled subexpression.
+         */
+        class RenamedNode : public CompiledNode {
+        public:
+            RenamedNode(const CompiledNodePointer& source, const Renaming& renaming, const CompiledNodePointer& fallback)
+                : source(source), renaming(renaming), fallback(fallback) { }
+        public:
+            virtual TensorPointer Evaluate() const {
+                Tensor::Tensor result;
+
+                if (!renaming.Apply(*source->Evaluate(), result)) {
+                    return fallback->Evaluate();
+                }
+
+                return std::make_shared<const Tensor::Tensor>(result);
+            }
+
+            virtual bool IsConstant() const { return source->IsConstant(); }
+        private:
+            CompiledNodePointer source;
+            Renaming renaming;
+            CompiledNodePointer fallback;
+        };
+
+        /**
+            \class SubexpressionTable
+
+            \brief Common subexpressions of all the equations of a script
+
+            The subexpressions are keyed by their syntax tree, where every index
+            is replaced by the position of its first appearance. Hence
+            `Multiply(Gamma({a m}), Epsilon({m b c}))` and
+            `Multiply(Gamma({d m}), Epsilon({m e f}))` share the same entry and
+            the second one is the first one with renamed indices.
+
+            Subexpressions without coefficients are evaluated once while the
+            first equation is compiled, every other equation gets the tensor by
+            reference or renamed. Subexpressions with coefficients are shared
+            by a SharedNode. Solver::Reset clears the table.
+         */
+        class SubexpressionTable : public Singleton<SubexpressionTable> {
+        public:
+            struct Entry {
+                std::vector<std::string> indices;
+                CompiledOperand operand;
+            };
+        public:
+            bool Find(const std::string& key, Entry& entry) const {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                auto it = entries.find(key);
+                if (it == entries.end()) return false;
+
+                entry = it->second;
+                return true;
+            }
+
+            void Insert(const std::string& key, const Entry& entry) {
+                std::unique_lock<std::mutex> lock(mutex);
+                entries.insert({ key, entry });
+            }
+
+            void Hit() {
+                std::unique_lock<std::mutex> lock(mutex);
+                ++hits;
+            }
+
+            void Clear() {
+                std::unique_lock<std::mutex> lock(mutex);
+                entries.clear();
+                hits = 0;
+            }
+        public:
+            size_t Size() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return entries.size();
+            }
+
+            size_t GetHits() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return hits;
+            }
+        private:
+            std::map<std::string, Entry> entries;
+            size_t hits = 0;
+
+            mutable std::mutex mutex;
+        };
+
+        /**
+            \class CompiledExpression
+
+            \brief An equation compiled into a tree of direct API calls
+
+            The syntax tree of an equation is compiled once, when the
+            equation is constructed. Coefficients are bound to their
+            CoefficientReference and the common commands are bound
+            directly to the functions in Language::API. Subexpressions
+            that do not depend on any coefficient, like products of metrics,
+            are evaluated once during compilation.
+
+            Evaluating the compiled expression hence neither touches the
+            Session nor formats or parses any strings, and the tensors are
+            passed between the calls by reference.
+
+            Subexpressions that occur again, also in other equations and with
+            other index names, are compiled only once, see SubexpressionTable.
+         */
+        class CompiledExpression {
+        public:
+            typedef std::map<std::string, CoefficientReference>     CoefficientMap;
+        public:
+            CompiledExpression() = default;
+
+            CompiledExpression(const std::string& code, const CoefficientMap& coefficients) {
+                Language::Parser parser;
+                auto document = parser.Parse(code);
+
+                if (document == nullptr) {
+                    throw Exception("Cannot parse `" + code + "`");
+                }
+
+                auto operand = Compile(document, coefficients);
+                if (!operand.IsTensor()) {
+                    throw Exception("The equation does not evaluate to a tensor");
+                }
+
+                root = operand.GetNode();
+            }
+        public:
+            bool IsValid() const { return root != nullptr; }
+
+            Tensor::Tensor Evaluate() const {
+                if (!root) throw Exception("The equation was not compiled");
+                return *root->Evaluate();
+            }
+        private:
+            typedef CallNode::Function  Function;
+            typedef Language::ArgumentType  ArgumentType;
+
+            /**
+                \brief Command that is directly bound to the API
+
+                Besides the function it keeps the types of the arguments as
+                registered for the command of the same name. If `repeatLast`
+                is set, the last type may be repeated arbitrarily often.
+             */
+            struct DirectCall {
+                DirectCall(const Function& function, const std::vector<ArgumentType>& arguments, bool repeatLast=false) : function(function), arguments(arguments), repeatLast(repeatLast) { }
+
+                Function function;
+                std::vector<ArgumentType> arguments;
+                bool repeatLast;
+            };
+
+            /**
+                Commands that are directly bound to the API. They mirror
+                the Execute() methods of the commands of the same name.
+             */
+            static const std::map<std::string, DirectCall>& DirectCalls() {
+                static const std::map<std::string, DirectCall> calls = {
+                    { "Add", { [](const CompiledArguments& args) {
+                        auto result = Tensor::Tensor::Zero();
+                        for (unsigned i=0; i<args.Size(); ++i) result += args.GetTensor(i);
+                        return result;
+                    }, { ArgumentType::TENSOR, ArgumentType::TENSOR }, true }},
+                    { "Subtract", { [](const CompiledArguments& args) {
+                        auto result = args.GetTensor(0);
+                        for (unsigned i=1; i<args.Size(); ++i) result -= args.GetTensor(i);
+                        return result;
+                    }, { ArgumentType::TENSOR, ArgumentType::TENSOR }, true }},
+                    { "Negate", { [](const CompiledArguments& args) {
+                        return -args.GetTensor(0);
+                    }, { ArgumentType::TENSOR } }},
+                    { "Scale", { [](const CompiledArguments& args) {
+                        return Language::API::Scale(args.GetTensor(0), args.GetNumeric(1));
+                    }, { ArgumentType::TENSOR, ArgumentType::NUMERIC } }},
+                    { "Multiply", { [](const CompiledArguments& args) {
+                        auto result = args.GetTensor(0);
+                        for (unsigned i=1; i<args.Size(); ++i) result *= args.GetTensor(i);
+                        return result;
+                    }, { ArgumentType::TENSOR, ArgumentType::TENSOR }, true }},
+                    { "Contract", { [](const CompiledArguments& args) {
+                        auto result = args.GetTensor(0);
+                        for (unsigned i=1; i<args.Size(); ++i) result *= args.GetTensor(i);
+                        return result;
+                    }, { ArgumentType::TENSOR, ArgumentType::TENSOR }, true }},
+                    { "Symmetrize", { [](const CompiledArguments& args) {
+                        auto result = Language::API::Symmetrize(args.GetTensor(0), args.GetIndices(1));
+                        for (unsigned i=2; i<args.Size(); ++i) result = Language::API::Symmetrize(result, args.GetIndices(i));
+                        return result;
+                    }, { ArgumentType::TENSOR, ArgumentType::INDEX }, true }},
+                    { "AntiSymmetrize", { [](const CompiledArguments& args) {
+                        auto result = Language::API::AntiSymmetrize(args.GetTensor(0), args.GetIndices(1));
+                        for (unsigned i=2; i<args.Size(); ++i) result = Language::API::AntiSymmetrize(result, args.GetIndices(i));
+                        return result;
+                    }, { ArgumentType::TENSOR, ArgumentType::INDEX }, true }},
+                    { "ExchangeSymmetrize", { [](const CompiledArguments& args) {
+                        return Language::API::ExchangeSymmetrize(args.GetTensor(0), args.GetIndices(1), args.GetIndices(2));
+                    }, { ArgumentType::TENSOR, ArgumentType::INDEX, ArgumentType::INDEX } }},
+                    { "RenameIndices", { [](const CompiledArguments& args) {
+                        return Language::API::RenameIndices(args.GetTensor(0), args.GetIndices(1), args.GetIndices(2));
+                    }, { ArgumentType::TENSOR, ArgumentType::INDEX, ArgumentType::INDEX } }},
+                    { "Expand", { [](const CompiledArguments& args) {
+                        return args.GetTensor(0).Expand();
+                    }, { ArgumentType::TENSOR } }},
+                    { "Simplify", { [](const CompiledArguments& args) {
+                        return args.GetTensor(0).Simplify();
+                    }, { ArgumentType::TENSOR } }},
+                    { "Gamma", { [](const CompiledArguments& args) {
+                        return Language::API::Gamma(args.GetIndices(0));
+                    }, { ArgumentType::INDEX } }},
+                    { "InverseGamma", { [](const CompiledArguments& args) {
+                        return Language::API::InverseGamma(args.GetIndices(0));
+                    }, { ArgumentType::INDEX } }},
+                    { "Epsilon", { [](const CompiledArguments& args) {
+                        return Language::API::Epsilon(args.GetIndices(0));
+                    }, { ArgumentType::INDEX } }},
+                    { "InverseEpsilon", { [](const CompiledArguments& args) {
+                        return Language::API::InverseEpsilon(args.GetIndices(0));
+                    }, { ArgumentType::INDEX } }},
+                    { "EpsilonGamma", { [](const CompiledArguments& args) {
+                        return Language::API::EpsilonGamma(args.GetIndices(0));
+                    }, { ArgumentType::INDEX } }},
+                    { "Delta", { [](const CompiledArguments& args) {
+                        return Language::API::Delta(args.GetIndices(0));
+                    }, { ArgumentType::INDEX } }}
+                };
+
+                return calls;
+            }
+
+            static ArgumentType TypeOf(const CompiledOperand& operand) {
+                if (operand.IsTensor()) return ArgumentType::TENSOR;
+
+                auto& expr = operand.GetConstant();
+
+                if (expr.IsScalar()) return ArgumentType::NUMERIC;
+                else if (expr.IsIndices()) return ArgumentType::INDEX;
+                else if (expr.IsString()) return ArgumentType::STRING;
+                else if (expr.IsSubstitution()) return ArgumentType::SUBSTITUTION;
+
+                return ArgumentType::UNKNOWN;
+            }
+
+            /**
+                \brief Validates the operands of a direct call
+
+                Performs the same checks as Command::ValidateArguments, since
+                the direct calls never create the command itself.
+
+                \throws WrongNumberOfArgumentsException
+                \throws WrongArgumentTypeException
+             */
+            static void ValidateOperands(const DirectCall& call, const std::vector<CompiledOperand>& operands) {
+                if (call.repeatLast) {
+                    if (operands.size() < call.arguments.size()) {
+                        throw WrongNumberOfArgumentsException();
+                    }
+                } else {
+                    if (operands.size() != call.arguments.size()) {
+                        throw WrongNumberOfArgumentsException();
+                    }
+                }
+
+                for (unsigned i=0; i<operands.size(); ++i) {
+                    auto expected = call.arguments[std::min<size_t>(i, call.arguments.size()-1)];
+                    auto type = TypeOf(operands[i]);
+
+                    if (type != expected) {
+                        throw WrongArgumentTypeException(
+                            Language::ArgumentDictionary::TypeToString(expected),
+                            Language::ArgumentDictionary::TypeToString(type)
+                        );
+                    }
+                }
+            }
+
+            /**
+                Evaluates nodes that do not depend on a coefficient once
+             */
+            static CompiledOperand Fold(const CompiledNodePointer& node) {
+                if (!node->IsConstant()) return CompiledOperand(node);
+                return CompiledOperand(std::make_shared<ConstantNode>(node->Evaluate()));
+            }
+
+            static CompiledOperand Compile(const std::shared_ptr<Language::Node>& node, const CoefficientMap& coefficients) {
+                using namespace Language;
+
+                if (node->IsNumeric()) {
+                    auto str = std::dynamic_pointer_cast<NumericNode>(node)->GetText();
+
+                    if (str.find(".") == std::string::npos) {
+                        return CompiledOperand(Tensor::Expression(Tensor::Scalar::Fraction(std::atoi(str.c_str()), 1)));
+                    }
+                    return CompiledOperand(Tensor::Expression(Tensor::Scalar::Fraction(std::atof(str.c_str()))));
+                } else if (node->IsIndices()) {
+                    IndexArgument arg(std::dynamic_pointer_cast<IndicesNode>(node)->GetText());
+                    return CompiledOperand(Tensor::Expression(arg.GetIndices()));
+                } else if (node->IsString()) {
+                    return CompiledOperand(Tensor::Expression(Tensor::StringExpression(std::dynamic_pointer_cast<StringNode>(node)->GetText())));
+                } else if (node->IsLiteral()) {
+                    auto id = std::dynamic_pointer_cast<LiteralNode>(node)->GetText();
+
+                    auto it = coefficients.find(id);
+                    if (it != coefficients.end()) {
+                        return CompiledOperand(std::make_shared<CoefficientNode>(it->second));
+                    }
+
+                    throw Exception("Unknown variable `" + id + "`");
+                } else if (node->IsNegation() || node->IsBinary() || node->IsCommand()) {
+                    CanonicalForm form;
+
+                    if (IsShareable(node) && Canonicalize(node, form)) {
+                        return CompileShared(node, form, coefficients);
+                    }
+
+                    return CompileComposite(node, coefficients);
+                }
+
+                throw Exception("Cannot compile `" + node->ToString() + "`");
+            }
+
+            /**
+                \brief Syntax tree of a subexpression modulo index renaming
+
+                The key replaces every index by the position of its first
+                appearance, the names are kept in `indices` in this order.
+             */
+            struct CanonicalForm {
+                std::string key;
+                std::vector<std::string> indices;
+                std::vector<std::string> literals;
+            };
+
+            /**
+                \returns False if the subexpression cannot be shared, i.e. if it
+                          contains a string or a command that is not bound to
+                          the API, which could have side effects
+             */
+            static bool Canonicalize(const std::shared_ptr<Language::Node>& node, CanonicalForm& form) {
+                using namespace Language;
+
+                if (node->IsNumeric()) {
+                    form.key += std::dynamic_pointer_cast<NumericNode>(node)->GetText();
+                } else if (node->IsIndices()) {
+                    std::stringstream ss (std::dynamic_pointer_cast<IndicesNode>(node)->GetText());
+                    std::string name;
+
+                    form.key += "{";
+
+                    while (ss >> name) {
+                        auto it = std::find(form.indices.begin(), form.indices.end(), name);
+                        if (it == form.indices.end()) it = form.indices.insert(it, name);
+
+                        form.key += "#" + std::to_string(it - form.indices.begin()) + " ";
+                    }
+
+                    form.key += "}";
+                } else if (node->IsLiteral()) {
+                    auto name = std::dynamic_pointer_cast<LiteralNode>(node)->GetText();
+
+                    form.key += name;
+                    form.literals.push_back(name);
+                } else if (node->IsNegation()) {
+                    form.key += "-(";
+                    if (!Canonicalize(std::dynamic_pointer_cast<NegationNode>(node)->GetNode(), form)) return false;
+                    form.key += ")";
+                } else if (node->IsBinary()) {
+                    auto binary = std::dynamic_pointer_cast<BinaryNode>(node);
+
+                    form.key += "(";
+                    if (!Canonicalize(binary->GetLeft(), form)) return false;
+                    form.key += std::string(1, binary->GetOperator());
+                    if (!Canonicalize(binary->GetRight(), form)) return false;
+                    form.key += ")";
+                } else if (node->IsCommand()) {
+                    auto command = std::dynamic_pointer_cast<CommandNode>(node);
+                    auto name = command->GetIdentifier()->GetText();
+
+                    if (DirectCalls().find(name) == DirectCalls().end()) return false;
+
+                    form.key += name + "(";
+                    for (auto& arg : *command->GetArguments()) {
+                        if (!Canonicalize(arg, form)) return false;
+                        form.key += ",";
+                    }
+                    form.key += ")";
+                } else {
+                    return false;
+                }
+
+                return true;
+            }
+
+            /**
+                A renamed coefficient is already a cheap CoefficientNode
+             */
+            static bool IsShareable(const std::shared_ptr<Language::Node>& node) {
+                using namespace Language;
+
+                if (!node->IsCommand()) return true;
+
+                auto command = std::dynamic_pointer_cast<CommandNode>(node);
+                auto args = command->GetArguments();
+
+                return !(command->GetIdentifier()->GetText() == "RenameIndices" && args->Size() == 3 && (*args->begin())->IsLiteral());
+            }
+
+            /**
+                \brief Compile a subexpression or reuse it from the SubexpressionTable
+             */
+            static CompiledOperand CompileShared(const std::shared_ptr<Language::Node>& node, const CanonicalForm& form, const CoefficientMap& coefficients) {
+                auto table = SubexpressionTable::Instance();
+                SubexpressionTable::Entry entry;
+
+                if (table->Find(form.key, entry)) {
+                    Renaming renaming (entry.indices, form.indices);
+
+                    if (entry.operand.IsConstant()) {
+                        if (renaming.IsIdentity()) {
+                            table->Hit();
+                            return entry.operand;
+                        }
+
+                        Tensor::Tensor result;
+                        if (renaming.Apply(*entry.operand.GetNode()->Evaluate(), result)) {
+                            table->Hit();
+                            return CompiledOperand(std::make_shared<ConstantNode>(std::make_shared<const Tensor::Tensor>(result)));
+                        }
+                    } else {
+                        auto shared = std::static_pointer_cast<SharedNode>(entry.operand.GetNode());
+
+                        shared->Use();
+                        table->Hit();
+
+                        if (renaming.IsIdentity()) return entry.operand;
+                        return CompiledOperand(std::make_shared<RenamedNode>(shared, renaming, CompileComposite(node, coefficients).GetNode()));
+                    }
+
+                    return CompileComposite(node, coefficients);
+                }
+
+                auto operand = CompileComposite(node, coefficients);
+                if (!operand.IsTensor()) return operand;
+
+                if (!operand.IsConstant()) {
+                    std::vector<CoefficientReference> refs;
+
+                    for (auto& name : form.literals) {
+                        auto it = coefficients.find(name);
+                        if (it != coefficients.end()) refs.push_back(it->second);
+                    }
+
+                    operand = CompiledOperand(std::make_shared<SharedNode>(operand.GetNode(), refs));
+                }
+
+                table->Insert(form.key, { form.indices, operand });
+                return operand;
+            }
+
+            static CompiledOperand CompileComposite(const std::shared_ptr<Language::Node>& node, const CoefficientMap& coefficients) {
+                using namespace Language;
+
+                if (node->IsNegation()) {
+                    auto operand = Compile(std::dynamic_pointer_cast<NegationNode>(node)->GetNode(), coefficients);
+
+                    if (operand.IsTensor()) {
+                        return Fold(std::make_shared<CallNode>(DirectCalls().at("Negate").function, std::vector<CompiledOperand>({ operand })));
+                    }
+
+                    if (!operand.GetConstant().IsScalar()) throw IncompatibleTypesException();
+
+                    return CompiledOperand(Tensor::Expression(-*operand.GetConstant().As<Tensor::Scalar>()));
+                } else if (node->IsBinary()) {
+                    return CompileBinary(std::dynamic_pointer_cast<BinaryNode>(node), coefficients);
+                } else if (node->IsCommand()) {
+                    return CompileCommand(std::dynamic_pointer_cast<CommandNode>(node), coefficients);
+                }
+
+                throw Exception("Cannot compile `" + node->ToString() + "`");
+            }
+
+            static CompiledOperand CompileBinary(const std::shared_ptr<Language::BinaryNode>& node, const CoefficientMap& coefficients) {
+                using namespace Language;
+
+                auto lhs = Compile(node->GetLeft(), coefficients);
+                auto rhs = Compile(node->GetRight(), coefficients);
+                auto op = node->GetOperator();
+
+                // Operations on tensors
+                if (lhs.IsTensor() && rhs.IsTensor()) {
+                    Function fn;
+
+                    switch (op) {
+                        case '+': fn = [](const CompiledArguments& args) { return args.GetTensor(0) + args.GetTensor(1); }; break;
+                        case '-': fn = [](const CompiledArguments& args) { return args.GetTensor(0) - args.GetTensor(1); }; break;
+                        case '*': fn = [](const CompiledArguments& args) { return args.GetTensor(0) * args.GetTensor(1); }; break;
+                        default: throw IncompatibleTypesException();
+                    }
+
+                    return Fold(std::make_shared<CallNode>(fn, std::vector<CompiledOperand>({ lhs, rhs })));
+                }
+
+                // Scaling of tensors
+                if (op == '*' && (lhs.IsTensor() || rhs.IsTensor())) {
+                    auto& tensor = lhs.IsTensor() ? lhs : rhs;
+                    auto& scalar = lhs.IsTensor() ? rhs : lhs;
+
+                    if (!scalar.GetConstant().IsScalar()) throw IncompatibleTypesException();
+
+                    return Fold(std::make_shared<CallNode>(DirectCalls().at("Scale").function, std::vector<CompiledOperand>({ tensor, scalar })));
+                }
+
+                // Operations on scalars
+                if (lhs.IsTensor() || rhs.IsTensor() || !lhs.GetConstant().IsScalar() || !rhs.GetConstant().IsScalar()) {
+                    throw IncompatibleTypesException();
+                }
+
+                auto left = lhs.GetConstant().As<Tensor::Scalar>();
+                auto right = rhs.GetConstant().As<Tensor::Scalar>();
+
+                switch (op) {
+                    case '+': return CompiledOperand(Tensor::Expression(*left + *right));
+                    case '-': return CompiledOperand(Tensor::Expression(*left - *right));
+                    case '*': return CompiledOperand(Tensor::Expression(*left * *right));
+                }
+
+                throw IncompatibleTypesException();
+            }
+
+            static CompiledOperand CompileCommand(const std::shared_ptr<Language::CommandNode>& node, const CoefficientMap& coefficients) {
+                using namespace Language;
+
+                auto name = node->GetIdentifier()->GetText();
+                auto args = node->GetArguments();
+
+                // Rename the indices of a coefficient directly on the coefficient
+                if (name == "RenameIndices" && args->Size() == 3) {
+                    auto it = args->begin();
+                    auto first = *it;
+
+                    if (first->IsLiteral()) {
+                        auto ref = coefficients.find(std::dynamic_pointer_cast<LiteralNode>(first)->GetText());
+
+                        auto from = Compile(*(++it), coefficients);
+                        auto to = Compile(*(++it), coefficients);
+
+                        if (ref != coefficients.end() && !from.IsTensor() && from.GetConstant().IsIndices() && !to.IsTensor() && to.GetConstant().IsIndices()) {
+                            return CompiledOperand(std::make_shared<CoefficientNode>(ref->second, *from.GetConstant().As<Tensor::Indices>(), *to.GetConstant().As<Tensor::Indices>()));
+                        }
+                    }
+                }
+
+                std::vector<CompiledOperand> operands;
+                for (auto& arg : *args) {
+                    operands.push_back(Compile(arg, coefficients));
+                }
+
+                // Bind the common commands directly to the API
+                auto it = DirectCalls().find(name);
+                if (it != DirectCalls().end()) {
+                    ValidateOperands(it->second, operands);
+                    return Fold(std::make_shared<CallNode>(it->second.function, operands));
+                }
+
+                // Make sure the command exists
+                try {
+                    CommandManagement::Instance()->CreateCommand(name);
+                } catch (const UnknownCommandException&) {
+                    throw Exception("Unknown command `" + name + "`");
+                }
+
+                auto call = std::make_shared<CommandCallNode>(name, operands);
+
+                // Constant commands can evaluate to anything
+                if (call->IsConstant()) {
+                    auto result = CommandCallNode::Execute(name, operands);
+
+                    if (result.IsTensor()) {
+                        return CompiledOperand(std::make_shared<ConstantNode>(std::make_shared<const Tensor::Tensor>(result.As<Tensor::Tensor>())));
+                    }
+
+                    return CompiledOperand(result);
+                }
+
+                return CompiledOperand(call);
+            }
+        private:
+            CompiledNodePointer root;
+        };
+
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include <equations/coefficient.hpp>
+
+namespace Construction {
+    namespace Equations {
+
+        /**
+            \class CostModel
+
+            \brief Estimates the cost of solving an equation
+
+            The cost of solving an equation is dominated by the homogeneous
+            linear system that is built from it. It has one row per index
+            combination and one column per variable, hence we estimate the
+            cost as
+
+                (number of index combinations) * (number of variables)
+
+            Before the coefficients are calculated, the number of variables
+            of a coefficient is estimated by the number of independent
+            components of its blocks. Once they are calculated, the real
+            number of variables can be used instead.
+         */
+        class CostModel {
+        public:
+            /**
+                Number of index combinations of a tensor with the given
+                number of free indices in the given dimension
+             */
+            static double IndexCombinations(unsigned numIndices, unsigned dimension=3) {
+                return std::pow(static_cast<double>(dimension), static_cast<double>(numIndices));
+            }
+
+            /**
+                Number of independent components of a block of indices with
+                the given symmetry in the given dimension
+             */
+            static double NumberOfComponents(unsigned numIndices, CoefficientDefinition::SymmetryType symmetry, unsigned dimension=3) {
+                switch (symmetry) {
+                    case CoefficientDefinition::SymmetryType::SYMMETRIC:
+                        // (dimension + numIndices - 1) choose numIndices
+                        return Binomial(dimension + numIndices - 1, numIndices);
+
+                    case CoefficientDefinition::SymmetryType::ANTISYMMETRIC:
+                        return Binomial(dimension, numIndices);
+
+                    default:
+                        return IndexCombinations(numIndices, dimension);
+                }
+            }
+
+            /**
+                Estimates the number of variables of a coefficient from its
+                definition, i.e. before it was calculated
+             */
+            static double EstimateVariables(const CoefficientDefinition& defn) {
+                unsigned dimension = Dimension(defn);
+                double result = 1;
+
+                for (auto& block : defn.blocks) {
+                    result *= NumberOfComponents(block.indices, block.symmetry, dimension);
+
+                    // Derivative indices are always symmetrized
+                    result *= NumberOfComponents(block.derivatives, CoefficientDefinition::SymmetryType::SYMMETRIC, dimension);
+                }
+
+                return result;
+            }
+
+            /**
+                Estimates the cost of an equation with the given number of
+                free indices in which the given coefficients appear
+             */
+            static double Estimate(const std::vector<CoefficientDefinition>& definitions, unsigned numIndices, unsigned dimension=3) {
+                double variables = 0;
+
+                for (auto& defn : definitions) {
+                    variables += EstimateVariables(defn);
+                }
+
+                return Cost(numIndices, variables, dimension);
+            }
+
+            static double Cost(unsigned numIndices, double variables, unsigned dimension=3) {
+                return IndexCombinations(numIndices, dimension) * variables;
+            }
+
+            /**
+                Turns a cost into a scheduler priority. Cheaper
+                equations get a higher priority.
+             */
+            static int ToPriority(double cost) {
+                static const double max = static_cast<double>(std::numeric_limits<int>::max());
+                return -static_cast<int>(std::min(cost, max));
+            }
+
+            static unsigned Dimension(const CoefficientDefinition& defn) {
+                if (defn.indices.Size() == 0) return 3;
+                return defn.indices[0].GetRange().GetDimension();
+            }
+        private:
+            static double Binomial(unsigned n, unsigned k) {
+                if (k > n) return 0;
+
+                double result = 1;
+                for (unsigned i=1; i<=k; ++i) {
+                    result *= static_cast<double>(n - k + i) / i;
+                }
+
+                return result;
+            }
+        };
+
+    }
+}
@@ -6,6 +6,12 @@
 #include <common/singleton.hpp>
 #include <language/cli.hpp>
 #include <equations/coefficient.hpp>
+#include <equations/scheduler.hpp>
+#include <equations/cost_model.hpp>
+#include <equations/compiled_expression.hpp>
+#include <common/time_measurement.hpp>
+#include <common/trace.hpp>
+#include <common/profiler.hpp>
 
 using Construction::Language::CLI;
 
@@ -20,109 +26,75 @@ namespace Construction {
                    into the coefficients.
 
             Class that manages the substitution of results from equations
-            Class that manages the substitution of results from equations
-            into the coefficients. This works by a ticket system, i.e. any
-            equation that can be calculated asks the manager for a ticket.
-            If there are no tickets available for now, the equation thread
-            is blocked until new tickets are available.
-
-            If an equation has a ticket, it can be evaluated and the resulting
-            substitution is send by the ticket back into the manager.
+            into the coefficients. Every solved equation hands its substitution
+            to the manager. The first substitution after a merge schedules a
+            MERGE task in the Scheduler, all further substitutions are collected
+            until this task runs.
+
+            Since the merge stage is a barrier for the equation stage, no equation
+            is solved while the coefficients are updated and every equation sees
+            the results of all merges that happened before it was started.
+
+            A merge only touches the coefficients that contain one of the
+            substituted variables according to the VariableIndex. They are
+            locked one by one and updated in parallel. Pending equations are
+            not indexed: they hold no tensor until they are evaluated from the
+            coefficients when they are solved, i.e. after the merge.
          */
         class SubstitutionManager : public Singleton<SubstitutionManager> {
         public:
-            // The manager is either serving a locked
-            enum State {
-                SERVING,
-                LOCKED
-            };
-        protected:
             /**
-                \class Ticket
-
-
+                \brief Hand in the substitution of a solved equation
              */
-            class Ticket : public std::enable_shared_from_this<Ticket> {
-            public:
-                enum State {
-                    WAITING,
-                    FULFILLED
-                };
-            public:
-                void Fulfill(const Substitution& substitution) {
-                    SubstitutionManager::Instance()->Fulfill(shared_from_this(), substitution);
-                }
-            public:
-                friend class SubstitutionManager;
-            private:
-                State state;
-            };
-
-            void Fulfill(std::shared_ptr<Ticket> ticket, const Substitution& substition) {
-                {
-                    // Lock the mutex
-                    std::unique_lock<std::mutex> lock(mutex);
-
-                    // Check if the ticket was already served
-                    auto it = std::find(tickets.begin(), tickets.end(), ticket);
-                    if (it == tickets.end()) return;
-
-                    // Remove the ticket from the list and mark it fulfilled
-                    tickets.erase(it);
-                    ticket->state = Ticket::FULFILLED;
+            void Fulfill(const Substitution& substitution) {
+                // Lock the mutex
+                std::unique_lock<std::mutex> lock(mutex);
 
-                    // Insert the substitution
-                    substitutions.push_back(substition);
+                // Insert the substitution
+                substitutions.push_back(substitution);
 
-                    // Set the state to locked to keep the manager
-                    // from giving further tickets
-                    state = LOCKED;
+                Construction::Logger::Debug("Received substitution ", substitution);
 
-                    Construction::Logger::Debug("Fulfilled ticket ", ticket);
-                }
+                // Schedule a merge if there is none pending
+                if (!mergeScheduled) {
+                    mergeScheduled = true;
 
-                // If no ticket left, apply the substitutions
-                if (tickets.size() == 0) {
-                    Apply();
+                    auto scheduler = Scheduler::Instance();
+                    scheduler->Submit(scheduler->Create(Scheduler::Stage::MERGE, [this]() {
+                        Apply();
+                    }));
                 }
             }
-        public:
-            std::shared_ptr<Ticket> GetTicket() {
-                // Lock the mutex
-                std::unique_lock<std::mutex> lock(mutex);
 
-                // Wait for the thread to be ticket less
-                variable.wait(lock, [&]() {
-                    return state == SERVING;
-                });
+            /**
+                \brief Forget all the substitutions, e.g. before the next job of the server
+             */
+            void Clear() {
+                std::unique_lock<std::mutex> lock(mutex);
 
-                // Create ticket
-                auto ticket = std::make_shared<Ticket>();
+                substitutions.clear();
+            }
+        private:
+            void Apply() {
+                std::vector<Tensor::Substitution> substitutions;
 
-                // Add to the list and return one for the thread
-                tickets.push_back(ticket);
+                // Take all the collected substitutions
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
 
-                // If the number of tickets is equal to a threshold
-                // set the state to LOCKED
-                if (tickets.size() == maxTickets) {
-                    state = LOCKED;
+                    std::swap(substitutions, this->substitutions);
+                    mergeScheduled = false;
                 }
 
-                Construction::Logger logger;
-                logger << Construction::Logger::DEBUG << "Issued ticket " << ticket << Construction::Logger::endl;
+                if (substitutions.empty()) return;
 
-                return std::move(ticket);
-            }
-        public:
-            void SetMaxTickets(int tickets=4) {
-                maxTickets = tickets;
-            }
-        private:
-            void Apply() {
-                // Lock the mutex
-                std::unique_lock<std::mutex> lock(mutex);
+                PROFILE_ZONE("SubstitutionManager::Apply");
+                Common::TraceScope trace ("SubstitutionManager::Apply");
+                if (trace.IsEnabled()) {
+                    trace.Set("substitutions", substitutions.size());
+                }
 
-                Construction::Logger::Debug("Apply substitutions (from ", substitutions.size(), " tickets)");
+                Construction::Logger::Debug("Apply substitutions (from ", substitutions.size(), " equations)");
 
                 // Merge
                 {
@@ -137,52 +109,49 @@ namespace Construction {
 
                 Construction::Logger::Debug("Merged substitutions into ", merged);
 
-                // Reset the list of substitutions
-                substitutions.clear();
+                // Find the coefficients that contain one of the substituted variables
+                std::vector<Tensor::Scalar> variables;
+                for (auto& s : merged) {
+                    variables.push_back(s.first);
+                }
 
-                // Lock all the coefficients
-                CoefficientsLock coeffsLock;
+                auto affected = VariableIndex::Instance()->Find(variables);
 
-                // Print all coefficients before any update
-                Construction::Logger::Debug("==================== UPDATE ALL COEFFICIENTS ======================");
-                for (auto& pair : *Coefficients::Instance()) {
-                    Construction::Logger::Debug("Coefficient before update: ", pair.second->ToString());
-                }
+                trace.Set("variables", variables.size());
+                trace.Set("coefficients", affected.size());
 
-                // Iterate over all coefficients and apply the
-                for (auto& pair : *Coefficients::Instance()) {
-                    auto ref = pair.second;
+                Construction::Logger::Debug("==================== UPDATE ", affected.size(), " OF ", Coefficients::Instance()->Size(), " COEFFICIENTS ======================");
 
-                    if (ref->IsFinished()) {
-                        Construction::Logger::Debug("Update coefficient ", ref->GetName());
+                // Update the affected coefficients in parallel, each one is locked on its own
+                Parallel::Map<bool, CoefficientReference>(affected, [&](const CoefficientReference& ref) -> bool {
+                    if (!ref->IsFinished()) return false;
 
-                        ref->SetTensor(merged(*ref->GetAsync()).FastSimplify());
+                    Coefficient::ScopedLock guard (*ref);
 
-                        Construction::Logger::Debug("Updated coefficient: ", ref->ToString());
+                    LOGGER_DEBUG("Update coefficient ", ref->ToString());
 
-                        // Overwrite the tensor in the session
-                        Session::Instance()->Set(ref->GetName(), *ref->GetAsync());
-                    }
-                }
+                    ref->SetTensor(merged(*ref->GetAsync()).FastSimplify());
 
-                Construction::Logger::Debug("==================== FINISHED UPDATE ======================");
+                    LOGGER_DEBUG("Updated coefficient: ", ref->ToString());
 
-                // Set the state back to serving
-                state = SERVING;
+                    // Overwrite the tensor in the session
+                    Session::Instance()->Set(ref->GetName(), *ref->GetAsync());
 
-                // Wake up all sleeping threads
-                variable.notify_all();
+                    // The variables of the coefficient changed
+                    VariableIndex::Instance()->Update(ref, ref->GetAsync()->GetVariables());
+
+                    return true;
+                });
+
+                Construction::Logger::Debug("==================== FINISHED UPDATE ======================");
             }
-        private:
-            State state;
 
-            int maxTickets = 4;
+        private:
+            bool mergeScheduled = false;
 
             std::vector<Tensor::Substitution> substitutions;
-            std::vector<std::shared_ptr<Ticket>> tickets;
 
-            std::mutex mutex;
-            std::condition_variable variable;
+            mutable std::mutex mutex;
         };
 
         /**
@@ -210,8 +179,13 @@ namespace Construction {
 
             with the right symmetries for lambda.
 
+            The equation is compiled into a CompiledExpression once, when it
+            is constructed, so solving it does not go through the CLI.
+
             Once all the coefficients in the equation are calculated, the
-            equation is solved in a separate thread.
+            equation is solved by the Scheduler. Cheap equations, according
+            to the CostModel, are solved first, since they usually eliminate
+            variables and make the expensive ones cheaper.
          */
         class Equation {
         public:
@@ -222,16 +196,32 @@ namespace Construction {
                 ABORTED
             };
         public:
-            // Constructor
-            Equation(const std::string& code) : state(WAITING), code(code) {
+            /**
+                Constructor. If solve is false, the equation is only
+                compiled, but not solved by the Scheduler, e.g. because
+                it is part of a GlobalSystem.
+             */
+            Equation(const std::string& code, bool solve=true) : state(WAITING), code(code) {
+                task = Scheduler::Instance()->Create(Scheduler::Stage::EQUATION, [this]() {
+                    Solve();
+                });
+
                 // Parse the code
                 Parse(code);
+
+                // Solve once all the coefficients are calculated
+                if (!isEmpty && solve) {
+                    Scheduler::Instance()->Submit(task);
+                }
             }
 
             ~Equation() {
-                // Join the thread of the calculation
-                if (!isEmpty) {
-                    thread.join();
+                // Make sure the equation is not solved any more
+                Scheduler::Instance()->Cancel(task);
+
+                // The coefficients may outlive the equation
+                for (unsigned i=0; i<observerIds.size(); ++i) {
+                    coefficients[i]->UnregisterObserver(observerIds[i]);
                 }
             }
         public:
@@ -242,13 +232,22 @@ namespace Construction {
             bool IsEmpty() const { return isEmpty; }
         public:
             std::string GetCode() const { return code; }
+        public:
+            // The cost estimated from the coefficient definitions
+            double GetEstimatedCost() const { return estimatedCost; }
+
+            // The cost of the system that was actually built
+            double GetActualCost() const { return actualCost; }
+
+            // The time it took to solve the equation
+            const Common::TimeMeasurement& GetTime() const { return time; }
         public:
             /**
                 \brief Parses the expression
 
                 Parses the expression. All occuring coefficients are
-                extracted and the equation is registered as an observer for
-                the coefficients.
+                extracted and the equation is made dependent on their
+                calculation.
 
                 Everything that is not a coefficient will be put in the
                 equation string. Note that there is no syntax checking at this
@@ -322,9 +321,12 @@ namespace Construction {
                         }
 
                         if (!found) {
-                            // Add the notification method
-                            ref->RegisterObserver(
-                                    std::bind(&Equation::OnCoefficientCalculated, this, std::placeholders::_1));
+                            // Solve after the coefficient is calculated
+                            Scheduler::Instance()->DependsOn(task, ref->GetTask());
+
+                            // Update the cost once the coefficient is calculated
+                            observerIds.push_back(ref->RegisterObserver(
+                                    std::bind(&Equation::OnCoefficientCalculated, this, std::placeholders::_1)));
 
                             // Put on the list
                             coefficients.push_back(std::move(ref));
@@ -348,36 +350,70 @@ namespace Construction {
                 }
 
                 substName = "subst" + Coefficient::GetRandomString(3);
-                testName = "test" + Coefficient::GetRandomString(3);
 
                 eq = substName + " = HomogeneousSystem(" + current + "):";
-                test = testName + " = " + current + ":";
+
+                // Compile the equation
+                if (!isEmpty) {
+                    CompiledExpression::CoefficientMap map;
+                    for (auto& ref : coefficients) {
+                        map[ref->GetName()] = ref;
+                    }
+
+                    try {
+                        compiled = CompiledExpression(current, map);
+                    } catch (const Exception& e) {
+                        compileError = e.what();
+                    }
+                }
+
+                // Estimate the cost from the coefficient definitions
+                {
+                    std::vector<CoefficientDefinition> definitions;
+                    for (auto& ref : coefficients) {
+                        definitions.push_back(ref->GetDefinition());
+                        numIndices = std::max(numIndices, static_cast<unsigned>(ref->GetDefinition().indices.Size()));
+                    }
+
+                    if (!definitions.empty()) dimension = CostModel::Dimension(definitions[0]);
+
+                    estimatedCost = CostModel::Estimate(definitions, numIndices, dimension);
+                    Scheduler::Instance()->SetPriority(task, CostModel::ToPriority(estimatedCost));
+                }
             }
         public:
             /**
-                \brief Callback that is invoked by finished coefficients
+                \brief Callback that is invoked by the coefficients
 
-                Callback that is called by finished coefficients
+                Once a coefficient is calculated, its estimated number of
+                variables is replaced by the real one and the priority of
+                the equation is updated.
              */
             void OnCoefficientCalculated(const CoefficientReference& coefficient) {
-                // Check if all coefficients are calculated
-                for (auto& c : coefficients) {
-                    // If not finished, do nothing
-                    if (!c->IsFinished()) {
-                        return;
+                if (!coefficient->IsFinished()) return;
+
+                double variables = 0;
+                for (auto& ref : coefficients) {
+                    if (VariableIndex::Instance()->Contains(ref)) {
+                        variables += VariableIndex::Instance()->Count(ref);
+                    } else {
+                        variables += CostModel::EstimateVariables(ref->GetDefinition());
                     }
                 }
 
-                // Lock the mutex
-                std::unique_lock<std::mutex> lock(startMutex);
-
-                Construction::Logger logger;
-                logger << Construction::Logger::DEBUG << "Finished all coefficients for equation `" << eq << "`" << Construction::Logger::endl;
+                auto cost = CostModel::Cost(numIndices, variables, dimension);
+                Scheduler::Instance()->SetPriority(task, CostModel::ToPriority(cost));
+            }
 
-                if (state == WAITING) {
-                    // Solve the equation in a new thread#
-                    this->thread = std::thread(&Equation::Solve, this);
+            /**
+                \brief Evaluates the equation with the current coefficients
+             */
+            Tensor::Tensor Evaluate() const {
+                if (!compiled.IsValid()) {
+                    throw Exception(compileError);
                 }
+
+                return compiled.Evaluate();
             }
 
             void Solve() {
@@ -389,49 +425,51 @@ namespace Construction {
                 Construction::Logger logger;
                 logger << Construction::Logger::DEBUG << "Start solving equation `" << eq << "`" << Construction::Logger::endl;
 
-                //   I. Get a ticket to promise to yield a substitution
-                //      or wait until a ticket can be returned
-                auto ticket = SubstitutionManager::Instance()->GetTicket();
+                time.Start();
 
-                //  II. Use the CLI to parse the equation and execute it
-                //      to obtain the substitution
-                // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
-                CLI cli;
+                PROFILE_ZONE("Equation::Solve");
+                Common::TraceScope trace ("Equation::Solve");
 
-                // Set the coefficient of the session
+                //   I. Evaluate the compiled equation to obtain the tensor
+                // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
                 try {
-                    cli(eq);
+                    auto tensor = Evaluate();
 
-                    auto session = Session::Instance();
+                    actualCost = CostModel::Cost(tensor.GetIndices().Size(), tensor.GetVariables().size(), dimension);
 
-                    // III. Convert the output into a substitution
+                    if (trace.IsEnabled()) {
+                        trace.Set("indices", tensor.GetIndices().Size());
+                        trace.Set("variables", tensor.GetVariables().size());
+                        trace.Set("summands", tensor.GetNumberOfSummands());
+                    }
+
+                    //  II. Solve the homogeneous system to obtain the substitution
                     // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
-                    auto subst = session->Get(substName).As<Tensor::Substitution>();
+                    auto subst = Language::API::HomogeneousSystem(tensor);
 
                     // Store the substitution in the
                     this->substitution = subst;
 
                     Construction::Logger::Debug("Found substitution ", subst, " from equation ", eq);
 
-                    //  IV. Give the substitution to the ticket
+                    // III. Give the substitution to the manager
                     // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
-                    ticket->Fulfill(subst);
+                    SubstitutionManager::Instance()->Fulfill(subst);
                 } catch (const Exception& e) {
                     state = ABORTED;
 
-                    // TODO: THROW EXCEPTION
                     Construction::Logger::Error("Error in equation `", eq, "`: ", e.what());
 
-                    throw;
-
                     variable.notify_all();
                     Notify();
 
-                    return;
+                    // Let the scheduler report the error
+                    throw;
                 }
 
                 // Set the state to solved
                 state = SOLVED;
+                time.Stop();
 
                 logger << Construction::Logger::DEBUG << "Solved equation `" << eq << "`" << Construction::Logger::endl;
 
@@ -456,11 +494,7 @@ namespace Construction {
                 Wait();
 
                 // Execute the test
-                CLI cli;
-                cli(test);
-
-                // Get the result
-                auto testResult = Session::Instance()->Get(testName).As<Tensor::Tensor>().CollectByVariables();
+                auto testResult = Evaluate().CollectByVariables();
 
                 // Improve the expression
                 {
@@ -497,7 +531,7 @@ namespace Construction {
                 std::unique_lock<std::mutex> lock(mutex);
 
                 variable.wait(lock, [&]() {
-                    return state == SOLVED;
+                    return state == SOLVED || state == ABORTED;
                 });
             }
 
@@ -567,22 +601,29 @@ namespace Construction {
                 return output;
             }
         private:
-            std::thread thread;
+            Scheduler::TaskReference task;
             std::mutex mutex;
-            std::mutex startMutex;
             std::condition_variable variable;
 
             bool isEmpty;
 
             std::string code;
             std::string eq;
-            std::string test;
             std::string substName;
-            std::string testName;
             std::vector<CoefficientReference> coefficients;
+            std::vector<size_t> observerIds;
+
+            CompiledExpression compiled;
+            std::string compileError;
 
             Tensor::Substitution substitution;
 
+            unsigned numIndices = 0;
+            unsigned dimension = 3;
+            double estimatedCost = 0;
+            double actualCost = 0;
+            Common::TimeMeasurement time;
+
             std::vector<ObserverFunction> observers;
 
             State state;
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <tensor/tensor.hpp>
+#include <tensor/substitution.hpp>
+#include <vector/sparse_system.hpp>
+#include <common/statistics.hpp>
+
+namespace Construction {
+    namespace Equations {
+
+        /**
+            \class GlobalSystem
+
+            \brief One linear system for all the equations of a file
+
+            Instead of solving every equation on its own and merging the
+            resulting substitutions, the linear relations of all equations
+            are collected in one sparse system over all the variables of
+            the coefficients. Rows that appear in several equations are only
+            stored once and the system is reduced a single time, after which
+            the substitution can be read off directly.
+         */
+        class GlobalSystem {
+        public:
+            typedef Tensor::Fraction                        value_type;
+            typedef Vector::SparseSystem<value_type>        system_type;
+        public:
+            /**
+                \brief Add the linear relations of an equation
+             */
+            void Insert(const Tensor::Tensor& tensor) {
+                auto system = tensor.ToHomogeneousLinearSystem();
+
+                auto& matrix = system.first;
+                auto& vars = system.second;
+
+                // Map the local variables to the columns of the system
+                std::vector<unsigned> map;
+                for (auto& variable : vars) {
+                    map.push_back(GetColumn(variable));
+                }
+
+                for (unsigned i=0; i<matrix.GetNumberOfRows(); ++i) {
+                    system_type::Row row;
+
+                    for (unsigned j=0; j<matrix.GetNumberOfColumns(); ++j) {
+                        auto value = matrix.At(i, j);
+                        if (value != value_type(0)) row[map[j]] = value;
+                    }
+
+                    ++numberOfRows;
+                    this->system.Insert(std::move(row));
+                }
+            }
+        public:
+            /**
+                \brief Reduce the system and read off the substitution
+             */
+            Tensor::Substitution Solve() {
+                {
+                    auto statistics = Common::Statistics::Instance();
+                    statistics->Maximum("matrix.rows", GetNumberOfUniqueRows());
+                    statistics->Maximum("matrix.columns", GetNumberOfVariables());
+                    statistics->Maximum("matrix.entries", static_cast<long long>(GetNumberOfUniqueRows()) * GetNumberOfVariables());
+                }
+
+                system.Reduce();
+
+                Tensor::Substitution result;
+
+                system.ForEachPivot([&](unsigned column, const system_type::Row& row) {
+                    Tensor::Scalar rhs = Tensor::Scalar::Fraction(0, 1);
+
+                    for (auto& entry : row) {
+                        if (entry.first == column) continue;
+                        value_type value = entry.second;
+                        rhs += -variables[entry.first] * Tensor::Scalar::Fraction(value);
+                    }
+
+                    result.Insert(variables[column], rhs);
+                });
+
+                return result;
+            }
+        public:
+            // Number of rows before removing duplicates
+            size_t GetNumberOfRows() const { return numberOfRows; }
+
+            // Number of distinct rows
+            size_t GetNumberOfUniqueRows() const { return system.GetNumberOfRows(); }
+
+            size_t GetNumberOfVariables() const { return variables.size(); }
+        private:
+            unsigned GetColumn(const Tensor::Scalar& variable) {
+                auto name = variable.ToString();
+
+                auto it = columns.find(name);
+                if (it != columns.end()) return it->second;
+
+                unsigned column = variables.size();
+                columns[name] = column;
+                variables.push_back(variable);
+
+                return column;
+            }
+        private:
+            system_type system;
+
+            std::map<std::string, unsigned> columns;
+            std::vector<Tensor::Scalar> variables;
+
+            size_t numberOfRows = 0;
+        };
+
+    }
+}
@@ -0,0 +1,565 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <limits>
+
+#include <common/singleton.hpp>
+#include <common/logger.hpp>
+#include <common/task_pool.hpp>
+
+namespace Construction {
+    namespace Equations {
+
+        /**
+            \class Scheduler
+
+            \brief Runs the dependency graph of coefficients, equations and
+                   merges on a fixed number of worker threads.
+
+            Every coefficient, every equation and every merge of substitutions
+            is a task in a directed acyclic graph. A task becomes ready once it
+            was submitted and all the tasks it depends on are finished. The ready
+            tasks are executed by a fixed pool of workers, s.t. the machine is not
+            oversubscribed no matter how many coefficients a file contains.
+
+            Each stage has a concurrency limit, e.g. only a given number of
+            equations is solved at the same time. A barrier stage (MERGE by
+            default) waits for the running tasks of the stage it guards (EQUATION)
+            to finish and keeps new ones from starting until it is done.
+
+            Among all ready tasks the one with the highest priority is picked.
+            For equal priorities, the task that unblocks a dependent with the
+            fewest pending dependencies goes first, i.e. the coefficients of an
+            equation that is almost ready are calculated before the others.
+            The equations get negative priorities from the CostModel, hence the
+            ready coefficients are calculated first and the equations are solved
+            in a few large merges, the cheapest first.
+
+            Example:
+                auto scheduler = Scheduler::Instance();
+
+                auto a = scheduler->Create(Scheduler::Stage::COEFFICIENT, [](){ ... });
+                auto b = scheduler->Create(Scheduler::Stage::EQUATION, [](){ ... });
+
+                scheduler->DependsOn(b, a);
+                scheduler->Submit(b);
+                scheduler->Submit(a);
+
+                scheduler->Wait();
+         */
+        class Scheduler : public Singleton<Scheduler> {
+        public:
+            enum class Stage {
+                COEFFICIENT = 0,
+                EQUATION = 1,
+                MERGE = 2
+            };
+        public:
+            /**
+                \class Task
+
+                A single node in the dependency graph. It is only
+                modified by the scheduler while holding its lock.
+             */
+            class Task {
+            public:
+                enum State {
+                    CREATED,
+                    WAITING,
+                    READY,
+                    RUNNING,
+                    FINISHED,
+                    FAILED,
+                    CANCELLED
+                };
+            public:
+                Task(Stage stage, std::function<void()> fn, int priority, unsigned long id) : stage(stage), fn(fn), state(CREATED), priority(priority), pending(0), id(id) { }
+            public:
+                Stage GetStage() const { return stage; }
+                unsigned long GetId() const { return id; }
+            public:
+                friend class Scheduler;
+            private:
+                Stage stage;
+                std::function<void()> fn;
+                State state;
+                int priority;
+                unsigned pending;
+                unsigned long id;
+
+                std::vector<std::weak_ptr<Task>> dependents;
+            };
+
+            typedef std::shared_ptr<Task>   TaskReference;
+        public:
+            Scheduler() : numberOfWorkers(std::max(1u, std::thread::hardware_concurrency())), nextId(0), outstanding(0), terminate(false) {
+                limits[Stage::COEFFICIENT] = numberOfWorkers;
+                limits[Stage::EQUATION] = 1;
+                limits[Stage::MERGE] = 1;
+
+                // Merges must not overlap with the solution of equations
+                barriers[Stage::MERGE] = Stage::EQUATION;
+            }
+
+            virtual ~Scheduler() {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    terminate = true;
+                }
+
+                condition.notify_all();
+
+                for (auto& worker : workers) {
+                    worker.join();
+                }
+            }
+        public:
+            /**
+                \brief Set the number of workers
+
+                Set the number of worker threads. The workers are spawned
+                on the first submission. If they already run, missing ones
+                are spawned right away, and with fewer workers the surplus
+                threads stay idle, since no more tasks than workers run at
+                the same time.
+             */
+            void SetNumberOfWorkers(unsigned workers) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+
+                    // Coefficients use all the workers unless told otherwise
+                    if (limits[Stage::COEFFICIENT] == numberOfWorkers) {
+                        limits[Stage::COEFFICIENT] = std::max(1u, workers);
+                    }
+
+                    numberOfWorkers = std::max(1u, workers);
+
+                    if (!this->workers.empty()) StartWorkers();
+                }
+
+                condition.notify_all();
+            }
+
+            unsigned GetNumberOfWorkers() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return numberOfWorkers;
+            }
+
+            /**
+                \brief Set the maximal number of tasks of a stage that run at the same time
+             */
+            void SetLimit(Stage stage, unsigned limit) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    limits[stage] = std::max(1u, limit);
+                }
+
+                condition.notify_all();
+            }
+
+            unsigned GetLimit(Stage stage) const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return limits.at(stage);
+            }
+
+            /**
+                \brief Make a stage a barrier for another stage
+
+                Tasks of the barrier stage only run if no task of the guarded
+                stage is running. As long as a barrier task is ready or running,
+                no further task of the guarded stage is started.
+             */
+            void SetBarrier(Stage barrier, Stage guarded) {
+                std::unique_lock<std::mutex> lock(mutex);
+                barriers[barrier] = guarded;
+            }
+        public:
+            /**
+                \brief Create a new task
+
+                Create a new task in the given stage. The task is not executed
+                before it was submitted and all its dependencies are finished.
+             */
+            TaskReference Create(Stage stage, std::function<void()> fn, int priority=0) {
+                std::unique_lock<std::mutex> lock(mutex);
+                return std::make_shared<Task>(stage, std::move(fn), priority, nextId++);
+            }
+
+            /**
+                \brief Add a dependency between two tasks
+
+                The task will not start before the dependency is finished.
+                If the dependency failed or was cancelled, the task is cancelled
+                as well.
+             */
+            void DependsOn(const TaskReference& task, const TaskReference& dependency) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                if (dependency->state == Task::FINISHED) return;
+
+                if (dependency->state == Task::FAILED || dependency->state == Task::CANCELLED) {
+                    CancelUnlocked(task);
+                    return;
+                }
+
+                dependency->dependents.push_back(task);
+                ++task->pending;
+
+                // Not ready any more
+                if (task->state == Task::READY) {
+                    RemoveFromReady(task);
+                    task->state = Task::WAITING;
+                }
+            }
+
+            /**
+                \brief Submit a task to the scheduler
+
+                Submit a task. It is executed once all the tasks it
+                depends on are finished.
+             */
+            void Submit(const TaskReference& task) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+
+                    if (task->state != Task::CREATED) return;
+
+                    ++outstanding;
+
+                    if (task->pending == 0) {
+                        task->state = Task::READY;
+                        ready.push_back(task);
+                    } else {
+                        task->state = Task::WAITING;
+                    }
+
+                    StartWorkers();
+                }
+
+                condition.notify_all();
+            }
+
+            /**
+                \brief Change the priority of a task
+
+                Tasks with higher priority are preferred among all
+                ready tasks.
+             */
+            void SetPriority(const TaskReference& task, int priority) {
+                std::unique_lock<std::mutex> lock(mutex);
+                task->priority = priority;
+            }
+
+            /**
+                \brief Cancel a task
+
+                Cancel a task and all tasks depending on it. If the task is
+                currently running, this blocks until it is finished.
+             */
+            void Cancel(const TaskReference& task) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                finished.wait(lock, [&]() {
+                    return task->state != Task::RUNNING;
+                });
+
+                CancelUnlocked(task);
+            }
+
+            bool IsDone(const TaskReference& task) const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return IsDoneUnlocked(task);
+            }
+        public:
+            /**
+                \brief Wait for a single task
+
+                Blocks until the given task is finished, failed or cancelled.
+             */
+            void Wait(const TaskReference& task) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                finished.wait(lock, [&]() {
+                    return IsDoneUnlocked(task);
+                });
+            }
+
+            /**
+                \brief Wait for all submitted tasks
+
+                Blocks until all submitted tasks are finished. If one of
+                the tasks threw an exception, it is rethrown here.
+             */
+            void Wait() {
+                std::exception_ptr exception;
+
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+
+                    finished.wait(lock, [&]() {
+                        return outstanding == 0;
+                    });
+
+                    std::swap(exception, error);
+                }
+
+                if (exception) std::rethrow_exception(exception);
+            }
+        private:
+            void StartWorkers() {
+                while (workers.size() < numberOfWorkers) {
+                    workers.emplace_back([this]() {
+                        Work();
+                    });
+                }
+            }
+
+            void Work() {
+                while (true) {
+                    TaskReference task;
+
+                    // Scope based locking
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+
+                        condition.wait(lock, [&]() {
+                            if (terminate) return true;
+
+                            task = Next();
+                            return task != nullptr;
+                        });
+
+                        if (!task) return;
+
+                        task->state = Task::RUNNING;
+                        ++running[task->stage];
+                    }
+
+                    // Execute the task
+                    std::exception_ptr exception;
+                    try {
+                        task->fn();
+                    } catch (...) {
+                        exception = std::current_exception();
+                    }
+
+                    // Scope based locking
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+
+                        --running[task->stage];
+                        --outstanding;
+
+                        // Release everything captured by the task
+                        task->fn = nullptr;
+
+                        if (exception) {
+                            task->state = Task::FAILED;
+                            if (!error) error = exception;
+
+                            Construction::Logger::Debug("Task ", task->id, " failed, cancel its dependents");
+
+                            for (auto& weak : task->dependents) {
+                                auto dependent = weak.lock();
+                                if (dependent) CancelUnlocked(dependent);
+                            }
+                        } else {
+                            task->state = Task::FINISHED;
+
+                            for (auto& weak : task->dependents) {
+                                auto dependent = weak.lock();
+                                if (!dependent || dependent->pending == 0) continue;
+
+                                --dependent->pending;
+
+                                if (dependent->pending == 0 && dependent->state == Task::WAITING) {
+                                    dependent->state = Task::READY;
+                                    ready.push_back(dependent);
+                                }
+                            }
+                        }
+
+                        task->dependents.clear();
+                    }
+
+                    condition.notify_all();
+                    finished.notify_all();
+                }
+            }
+
+            /**
+                Picks the next task that is allowed to run and removes it
+                from the list of ready tasks. Returns nullptr if there is none.
+             */
+            TaskReference Next() {
+                // Surplus workers after the number of workers was reduced
+                if (RunningTotal() >= numberOfWorkers) return nullptr;
+
+                auto best = ready.end();
+                unsigned bestUrgency = 0;
+
+                for (auto it = ready.begin(); it != ready.end(); ++it) {
+                    auto& task = *it;
+
+                    if (!CanRun(task->stage)) continue;
+
+                    if (best == ready.end()) {
+                        best = it;
+                        bestUrgency = Urgency(task);
+                        continue;
+                    }
+
+                    if (task->priority != (*best)->priority) {
+                        if (task->priority > (*best)->priority) {
+                            best = it;
+                            bestUrgency = Urgency(task);
+                        }
+                        continue;
+                    }
+
+                    auto urgency = Urgency(task);
+                    if (urgency < bestUrgency || (urgency == bestUrgency && task->id < (*best)->id)) {
+                        best = it;
+                        bestUrgency = urgency;
+                    }
+                }
+
+                if (best == ready.end()) return nullptr;
+
+                auto task = *best;
+                ready.erase(best);
+                return task;
+            }
+
+            /**
+                Checks if a task of the given stage may be started
+                right now, i.e. the stage limit is not reached and
+                no barrier is in the way.
+             */
+            bool CanRun(Stage stage) const {
+                if (Running(stage) >= limits.at(stage)) return false;
+
+                for (auto& pair : barriers) {
+                    // The stage is a barrier, wait for the guarded stage to drain
+                    if (pair.first == stage && Running(pair.second) > 0) return false;
+
+                    // The stage is guarded, do not start while a barrier is pending
+                    if (pair.second == stage && (Running(pair.first) > 0 || IsQueued(pair.first))) return false;
+                }
+
+                return true;
+            }
+
+            unsigned RunningTotal() const {
+                unsigned result = 0;
+                for (auto& pair : running) result += pair.second;
+                return result;
+            }
+
+            unsigned Running(Stage stage) const {
+                auto it = running.find(stage);
+                return it != running.end() ? it->second : 0;
+            }
+
+            bool IsQueued(Stage stage) const {
+                for (auto& task : ready) {
+                    if (task->stage == stage) return true;
+                }
+                return false;
+            }
+
+            /**
+                The smallest number of pending dependencies among all the
+                tasks that depend on the given one. The lower, the sooner
+                another task is unblocked by running it.
+             */
+            unsigned Urgency(const TaskReference& task) const {
+                unsigned result = std::numeric_limits<unsigned>::max();
+
+                for (auto& weak : task->dependents) {
+                    auto dependent = weak.lock();
+                    if (!dependent || dependent->state == Task::CANCELLED) continue;
+
+                    result = std::min(result, dependent->pending);
+                }
+
+                return result;
+            }
+
+            void RemoveFromReady(const TaskReference& task) {
+                auto it = std::find(ready.begin(), ready.end(), task);
+                if (it != ready.end()) ready.erase(it);
+            }
+
+            bool IsDoneUnlocked(const TaskReference& task) const {
+                return task->state == Task::FINISHED || task->state == Task::FAILED || task->state == Task::CANCELLED;
+            }
+
+            void CancelUnlocked(const TaskReference& task) {
+                if (IsDoneUnlocked(task)) return;
+
+                if (task->state == Task::READY || task->state == Task::WAITING) {
+                    --outstanding;
+                }
+
+                RemoveFromReady(task);
+                task->state = Task::CANCELLED;
+                task->fn = nullptr;
+
+                for (auto& weak : task->dependents) {
+                    auto dependent = weak.lock();
+                    if (dependent) CancelUnlocked(dependent);
+                }
+
+                task->dependents.clear();
+
+                finished.notify_all();
+            }
+        private:
+            unsigned numberOfWorkers;
+            unsigned long nextId;
+            unsigned outstanding;
+            bool terminate;
+
+            std::map<Stage, unsigned> limits;
+            std::map<Stage, unsigned> running;
+            std::map<Stage, Stage> barriers;
+
+            std::vector<TaskReference> ready;
+            std::vector<std::thread> workers;
+
+            std::exception_ptr error;
+
+            mutable std::mutex mutex;
+            std::condition_variable condition;
+            std::condition_variable finished;
+        };
+
+        /**
+            \brief Share a number of threads between the Scheduler and the global task pool
+
+            A worker of the Scheduler that waits for the parallel algorithms of
+            its task executes tasks of the pool in the meantime, so it counts as
+            a busy thread as well. Half of the threads, at least one, are workers
+            of the Scheduler and the rest, at least one, run the pool. Zero means
+            one thread per hardware thread.
+         */
+        inline void SetNumberOfThreads(unsigned threads) {
+            if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+            unsigned workers = std::max(1u, threads / 2);
+
+            Parallel::GlobalTaskPool::Instance()->SetNumberOfThreads(std::max(1u, threads - workers));
+            Scheduler::Instance()->SetNumberOfWorkers(workers);
+        }
+
+    }
+}
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <regex>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+#include <functional>
+
+#include <common/logger.hpp>
+#include <common/time_measurement.hpp>
+
+#include <equations/equations.hpp>
+#include <equations/global_system.hpp>
+
+namespace Construction {
+    namespace Equations {
+
+        /**
+            \class Solver
+
+            \brief Solves the equations of one script and prints the coefficients
+
+            The solver reads the equations of a `.es` script, calculates all
+            the coefficients and equations with the Scheduler and prints the
+            result to the given streams. It is used by `apple solve` and by the
+            jobs of the construction server.
+
+            Since the coefficients, the substitutions and the scheduler are
+            singletons, only one solver may run at a time. Reset() clears the
+            state of the previous script.
+
+            Example:
+                Solver solver (options, std::cout, std::cerr);
+
+                solver.Load(file);
+                solver.PrintDefinitions();
+                solver.Solve([](){ ... });
+                solver.PrintResult();
+         */
+        class Solver {
+        public:
+            struct Options {
+                // Number of equations that are solved in parallel
+                int parallel = 1;
+
+                // Only print the scalars in front of the base tensors
+                bool abc = false;
+
+                // Prettify the output
+                bool colored = false;
+
+                // Solve all equations at once in one sparse linear system
+                bool global = false;
+            };
+
+            typedef std::function<void()>   ProgressFunction;
+        public:
+            Solver(const Options& options, std::ostream& out, std::ostream& err) : options(options), out(out), err(err) { }
+        public:
+            /**
+                \brief Read the equations of a script
+
+                Every non-empty line, that is not a comment, is an equation.
+             */
+            void Load(std::istream& script) {
+                std::string line;
+                while (std::getline(script, line)) {
+                    // Trim lines to deal with Refik's input
+                    line = Trim(line);
+
+                    // Delete all "\r"s
+                    line = std::regex_replace(line, std::regex("\\r"), "");
+
+                    // Ignore empty lines
+                    if (line == "") continue;
+
+                    // Ignore comments
+                    if (line.size() > 1 && line[0] == '/' && line[1] == '/') continue;
+
+                    // Add the equation
+                    auto eq = std::make_shared<Equation>(line, !options.global);
+
+                    // If the equation isn't empty, add it
+                    if (!eq->IsEmpty()) {
+                        equations.push_back(std::move(eq));
+                    }
+                }
+            }
+
+            size_t GetNumberOfEquations() const { return equations.size(); }
+
+            /**
+                \brief Number of progress steps of the coefficients and equations
+             */
+            unsigned GetNumberOfSteps() const {
+                return (options.global ? 0 : equations.size()) + Coefficients::Instance()->GetNumberOfSteps();
+            }
+        public:
+            /**
+                \brief Print the coefficients and the equations that will be solved
+             */
+            void PrintDefinitions() {
+                // Print all the coefficients
+                err << (options.colored  ? "\033[32m" : "") << "Coefficients:" << (options.colored? "\033[0m" : "") << std::endl;
+                for (auto it = Coefficients::Instance()->begin(); it != Coefficients::Instance()->end(); ++it) {
+                    out << (options.colored ? "  \033[36m" : "") << it->second->ToString(false) << (options.colored ? "\033[0m" : "") << std::endl;
+                }
+                err << std::endl;
+
+                // Print the code
+                for (auto& eq : equations) {
+                    err << (options.colored ? " \033[36m" : " ") << "> " << eq->ToLaTeX() << "\033[0m" << std::endl;
+                }
+                err << std::endl;
+            }
+
+            /**
+                \brief Calculate all the coefficients and solve the equations
+
+                The progress function is called after every step. If a
+                coefficient or an equation failed, the exception is rethrown.
+             */
+            void Solve(ProgressFunction progress) {
+                // Limit the number of equations that are solved at the same time
+                Scheduler::Instance()->SetLimit(Scheduler::Stage::EQUATION, options.parallel);
+
+                // Register an observer for the coefficients
+                for (auto it = Coefficients::Instance()->begin(); it != Coefficients::Instance()->end(); ++it) {
+                    it->second->RegisterObserver([progress](const CoefficientReference&) {
+                        progress();
+                    });
+                }
+
+                // Register an observer for the equations
+                for (auto& eq : equations) {
+                    eq->RegisterObserver([progress](const Equation&) {
+                        progress();
+                    });
+                }
+
+                // Start the generation of all required coefficients
+                Coefficients::Instance()->StartAll();
+
+                // Wait for all coefficients, equations and merges to be finished
+                Scheduler::Instance()->Wait();
+
+                // Solve all the equations in one system and merge the result
+                // into the coefficients at once
+                if (options.global) {
+                    systemTime.Start();
+
+                    for (auto& eq : equations) {
+                        system.Insert(eq->Evaluate());
+                    }
+
+                    auto substitution = system.Solve();
+                    systemTime.Stop();
+
+                    SubstitutionManager::Instance()->Fulfill(substitution);
+                    Scheduler::Instance()->Wait();
+                }
+            }
+        public:
+            /**
+                \brief Print all the coefficients with the variables renamed to e_1, e_2, ...
+             */
+            void PrintResult() {
+                int offset = 0;
+
+                // Collect all the variables in the coefficients
+                std::vector<Construction::Tensor::Scalar> variables;
+                for (auto it = Coefficients::Instance()->begin(); it != Coefficients::Instance()->end(); ++it) {
+                    auto tensor = *it->second->Get();
+                    auto stuff = tensor.ExtractVariables();
+                    for (auto& pair : stuff) {
+                        auto _it = std::find(variables.begin(), variables.end(), pair.first);
+                        if (_it == variables.end()) variables.push_back(pair.first);
+                    }
+                }
+
+                // Build a substitution
+                Construction::Tensor::Substitution substitution;
+                int pos = 1;
+                for (auto& variable : variables) {
+                    substitution.Insert(variable, Construction::Tensor::Scalar::Variable("e", pos++));
+                }
+
+                bool colored = options.colored;
+
+                // Print the results
+                if (!options.abc) {
+                    for (auto it = Coefficients::Instance()->begin(); it != Coefficients::Instance()->end(); ++it) {
+                        auto tensor = substitution(*it->second->GetAsync());
+
+                        auto summands = tensor.GetSummands();
+
+                        if (!tensor.IsZeroTensor()) {
+                            offset += summands.size();
+                        }
+
+                        out << (colored ? "  \033[36m" : "") << it->second->ToString(false) << (colored ? "\033[0m" : "") << " = " << std::endl;
+
+                        for (int i=0; i<summands.size(); ++i) {
+                            auto t = summands[i];
+
+                            if (t.IsScaled()) {
+                                auto s = t.SeparateScalefactor();
+                                s.first = s.first.Simplify();
+
+                                out << (colored ? "     \033[32m" : "     ");
+
+                                if (s.first.IsAdded()) {
+                                    out << "(" << s.first << ")";
+                                } else {
+                                    out << s.first;
+                                }
+
+                                out << (colored ? "\033[0m" : "") << " * " << (colored ? "\033[33m" : "");
+
+                                if (s.second.IsAdded()) {
+                                    out << "(" << s.second << ")";
+                                } else out << s.second;
+                            } else if (t.IsScalar()) {
+                                out << "     " << (colored ? "\033[32m" : "") << t.ToString();
+                            } else {
+                                out << "     " << (colored ? "\033[33m" : "") << t.ToString();
+                            }
+
+                            if (colored) out << "\033[0m";
+
+                            if (i < summands.size()-1) out << " + ";
+
+                            out << std::endl;
+                        }
+
+                        out << std::endl;
+                    }
+                } else {
+                    int coeffPos = 1;
+                    for (auto it = Coefficients::Instance()->begin(); it != Coefficients::Instance()->end(); ++it) {
+                        auto tensor = substitution(*it->second->GetAsync()).Simplify();
+
+                        auto summands = tensor.GetSummands();
+
+                        if (!tensor.IsZeroTensor()) {
+                            offset += summands.size();
+                        }
+
+                        out << (colored ? "  \033[36m" : "") << it->second->ToString(false) << (colored ? "\033[0m" : "") << " : " << std::endl;
+
+                        for (int i=0; i<summands.size(); ++i) {
+                            auto t = summands[i];
+
+                            if (t.IsScaled()) {
+                                auto s = t.SeparateScalefactor();
+                                auto abc = Construction::Tensor::Scalar(s.second.GetSummands().size(), 1) * s.first;
+
+                                out << "     " << (colored ? "\033[32m" : "");
+
+                                char c = 'a' + static_cast<char>(i);
+
+                                out << c << coeffPos << " = " << abc.ToString();
+                            } else if (t.IsScalar()) {
+                                out << "     " << (colored ? "\033[32m" : "") << t.ToString();
+                            } else {
+                                out << "     " << (colored ? "\033[33m" : "") << t.ToString();
+                            }
+
+                            if (colored) out << "\033[0m";
+
+                            out << std::endl;
+                        }
+
+                        out << std::endl;
+                        coeffPos++;
+                    }
+                }
+            }
+
+            /**
+                \brief Print the size of the global system or the costs of the equations
+             */
+            void PrintCosts() {
+                // Print the size of the global system
+                if (options.global) {
+                    err << (options.colored  ? "\033[32m" : "") << "Global system (rows / unique rows / variables / time):" << (options.colored? "\033[0m" : "") << std::endl;
+                    err << "  " << system.GetNumberOfRows() << " / " << system.GetNumberOfUniqueRows() << " / " << system.GetNumberOfVariables() << " / " << systemTime << std::endl << std::endl;
+                }
+                // Print the estimated and actual costs of the equations
+                else {
+                    double estimated = 0;
+                    double actual = 0;
+
+                    err << (options.colored  ? "\033[32m" : "") << "Equations (estimated cost / actual cost / time):" << (options.colored? "\033[0m" : "") << std::endl;
+                    err << std::fixed << std::setprecision(0);
+
+                    int i = 1;
+                    for (auto& eq : equations) {
+                        err << "  " << i++ << ". " << eq->GetEstimatedCost() << " / " << eq->GetActualCost() << " / " << eq->GetTime() << std::endl;
+
+                        estimated += eq->GetEstimatedCost();
+                        actual += eq->GetActualCost();
+                    }
+
+                    err << "  Total: " << estimated << " / " << actual << std::endl;
+                    err << "  Shared subexpressions: " << SubexpressionTable::Instance()->GetHits() << std::endl << std::endl;
+                    err.unsetf(std::ios_base::floatfield);
+                }
+            }
+        public:
+            /**
+                \brief Forget the coefficients and substitutions of the previous script
+
+                Has to be called between two scripts in the same process. The
+                CoefficientCache is kept, hence the next script does not have to
+                generate the coefficients it shares with the previous ones.
+             */
+            static void Reset() {
+                Coefficients::Instance()->Clear();
+                VariableIndex::Instance()->Clear();
+                SubstitutionManager::Instance()->Clear();
+                SubexpressionTable::Instance()->Clear();
+            }
+        private:
+            static std::string Trim(const std::string& str, char c = ' ') {
+                size_t begin = str.find_first_not_of(c);
+                if (begin == std::string::npos) return "";
+
+                size_t end = str.find_last_not_of(c);
+                return str.substr(begin, end - begin + 1);
+            }
+        private:
+            Options options;
+
+            std::ostream& out;
+            std::ostream& err;
+
+            std::vector<std::shared_ptr<Equation>> equations;
+
+            GlobalSystem system;
+            Common::TimeMeasurement systemTime;
+        };
+
+    }
+}
@@ -332,12 +332,12 @@ namespace Construction {
                     }
                 }
 
-                Construction::Logger::Debug("Matrix is ", system.first.ToString(false));
+                LOGGER_DEBUG("Matrix is ", system.first.ToString(false));
 
                 // Reduce
                 system.first.ToRowEchelonForm();
 
-                Construction::Logger::Debug("Matrix is ", system.first.ToString(false));
+                LOGGER_DEBUG("Matrix is ", system.first.ToString(false));
 
                 Construction::Logger::Debug("Finished Gaussian elimination.");
 
@@ -8,13 +8,23 @@
 
 #include <language/argument.hpp>
 #include <language/command.hpp>
+#include <language/command_cache.hpp>
 
 #include <language/tensor.hpp>
 #include <language/symmetrization.hpp>
 #include <language/linear_dependent.hpp>
+#include <language/threads.hpp>
+#include <language/profile.hpp>
+#include <language/memory_stats.hpp>
+
+#include <common/task_pool.hpp>
 
 #include <tensor/expression.hpp>
 
+#include <set>
+#include <deque>
+#include <condition_variable>
+
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 
@@ -47,14 +57,49 @@ namespace Construction {
             ~CLI() {
                 //database.SaveToFile("tensors.db");
             }
+        public:
+            /**
+                \class ErrorOutput
+
+                \brief Stream the errors of the current thread are printed to
+
+                While an ErrorOutput exists, Error writes into its stream
+                instead of `std::cout`. The statements of a parallel script
+                collect their errors with their output this way, s.t. they
+                are printed in the order of the script.
+             */
+            class ErrorOutput {
+            public:
+                ErrorOutput(std::ostream& os) : previous(Top()) {
+                    Top() = &os;
+                }
+
+                ~ErrorOutput() {
+                    Top() = previous;
+                }
+
+                ErrorOutput(const ErrorOutput&) = delete;
+                ErrorOutput& operator=(const ErrorOutput&) = delete;
+            public:
+                static std::ostream& Current() {
+                    return Top() ? *Top() : std::cout;
+                }
+            private:
+                static std::ostream*& Top() {
+                    static thread_local std::ostream* top = nullptr;
+                    return top;
+                }
+            private:
+                std::ostream* previous;
+            };
         public:
             void Error(const std::string& message) const {
-                std::cout << "\033[31m" << "Error: " << "\033[0m" << message << std::endl;
+                ErrorOutput::Current() << "\033[31m" << "Error: " << "\033[0m" << message << std::endl;
             }
         public:
             std::string GetExpandedCommandString(const std::shared_ptr<Node>& document) const {
                 if (document->IsPrevious()) {
-                    return lastCmd;
+                    return Session::Instance()->GetLastCommandString();
                 } else if (document->IsCommand()) {
                     auto commandName = std::dynamic_pointer_cast<CommandNode>(document)->GetIdentifier()->GetText();
 
@@ -80,14 +125,11 @@ namespace Construction {
                         // If pointer to previous, add this
                         else if (arg->IsPrevious()) {
                             // Update newLastCmd string
-                            result.append(lastCmd);
+                            result.append(Session::Instance()->GetLastCommandString());
                         }
                         // If is a literal, load the name from memory
                         else if (arg->IsLiteral()) {
-                            auto id = arg->ToString();
-                            auto it = definition.find(id);
-                            if (it == definition.end()) result.append("");
-                            else result.append(it->second);
+                            result.append(Session::Instance()->GetDefinition(arg->ToString()));
                         }
                         // If indices, add this
                         else if (arg->IsIndices()) {
@@ -111,11 +153,93 @@ namespace Construction {
                 }
                 // Literal
                 else if (document->IsLiteral()) {
-                    auto id = document->ToString();
-                    auto it = definition.find(id);
-                    if (it == definition.end()) return "";
-                    return it->second;
+                    return Session::Instance()->GetDefinition(document->ToString());
+                }
+
+                return "";
+            }
+
+            /**
+                \brief Lazy mode, see Thunk
+
+                Silent assignments, i.e. lines ending with `:`, only store how
+                to calculate the value. It is calculated once the variable or
+                `%` is used, printed or stored with SaveSession.
+             */
+            void SetLazy(bool value) { lazy = value; }
+            bool IsLazy() const { return lazy; }
+
+            /**
+                \brief Build the key of an expression in the CommandCache
+
+                The key spells out the expression with the version of every
+                command and the definitions of the variables instead of their
+                names, e.g. `Symmetrize@1(Arbitrary@1("{a b}"),"{a b}")`. There
+                is no key if a command cannot be cached, is unknown or if a
+                variable does not stem from a cachable command.
+
+                \returns True if the expression has a key
+             */
+            bool GetCacheKey(const std::shared_ptr<Node>& document, std::string& key) const {
+                if (document->IsPrevious()) {
+                    key = Session::Instance()->GetLastCommandString();
+                    return !key.empty();
+                } else if (document->IsLiteral()) {
+                    key = Session::Instance()->GetDefinition(std::dynamic_pointer_cast<LiteralNode>(document)->GetText());
+                    return !key.empty();
+                } else if (document->IsNumeric()) {
+                    key = std::dynamic_pointer_cast<NumericNode>(document)->GetText();
+                    return true;
+                } else if (document->IsIndices()) {
+                    key = "\"" + std::dynamic_pointer_cast<IndicesNode>(document)->GetText() + "\"";
+                    return true;
+                } else if (document->IsString()) {
+                    key = "'" + std::dynamic_pointer_cast<StringNode>(document)->GetText() + "'";
+                    return true;
+                } else if (document->IsBinary()) {
+                    std::string lhs, rhs;
+                    if (!GetCacheKey(std::dynamic_pointer_cast<BinaryNode>(document)->GetLeft(), lhs)) return false;
+                    if (!GetCacheKey(std::dynamic_pointer_cast<BinaryNode>(document)->GetRight(), rhs)) return false;
+
+                    key = "(" + lhs + std::string(1, std::dynamic_pointer_cast<BinaryNode>(document)->GetOperator()) + rhs + ")";
+                    return true;
+                } else if (document->IsNegation()) {
+                    std::string inner;
+                    if (!GetCacheKey(std::dynamic_pointer_cast<NegationNode>(document)->GetNode(), inner)) return false;
+
+                    key = "-(" + inner + ")";
+                    return true;
+                } else if (document->IsCommand()) {
+                    auto commandName = std::dynamic_pointer_cast<CommandNode>(document)->GetIdentifier()->GetText();
+
+                    CommandPointer command;
+
+                    try {
+                        command = CommandManagement::Instance()->CreateCommand(commandName);
+                    } catch (UnknownCommandException& err) {
+                        return false;
+                    }
+
+                    if (!command->Cachable()) return false;
+
+                    std::string result = commandName + "@" + std::to_string(command->Version()) + "(";
+
+                    bool first = true;
+                    for (auto& arg : *std::dynamic_pointer_cast<CommandNode>(document)->GetArguments()) {
+                        std::string argKey;
+                        if (!GetCacheKey(arg, argKey)) return false;
+
+                        if (!first) result.append(",");
+                        else first = false;
+
+                        result.append(argKey);
+                    }
+
+                    key = result + ")";
+                    return true;
                 }
+
+                return false;
             }
 
             std::string ToLaTeX(const std::shared_ptr<Node>& document) const {
@@ -169,15 +293,15 @@ namespace Construction {
             }
 
             Expression Execute(const std::shared_ptr<Node>& document, bool silent=false) {
-                // Copy the most recent expression;
-                Expression lastResult = Session::Instance()->GetCurrent();
-                Expression previousResult = lastResult;
+                // Copy the most recent expression, a deferred one is only calculated if needed
+                auto state = Session::Instance()->GetState();
+                Expression lastResult = state.current;
 
                 Common::TimeMeasurement time;
 
                 // Previous token
                 if (document->IsPrevious()) {
-                    return lastResult;
+                    return Session::Instance()->GetCurrent();
                 }
                 // Literals
                 else if (document->IsLiteral()) {
@@ -192,8 +316,8 @@ namespace Construction {
                     }
 
                     lastResult = Session::Instance()->Get(id);
-                    Session::Instance()->SetCurrent(definition[id], lastResult);
-;
+                    Session::Instance()->SetCurrent(Session::Instance()->GetDefinition(id), lastResult);
+
                     return lastResult;
                 }
                 // Numerics
@@ -242,7 +366,7 @@ namespace Construction {
                     auto leftResult = Execute(lhs, true);
 
                     // Reset the current instance to get the same initial conditions
-                    Session::Instance()->SetCurrent("", lastResult);
+                    Session::Instance()->SetState(state);
 
                     // Execute the right command
                     auto rightResult = Execute(rhs, true);
@@ -329,19 +453,19 @@ namespace Construction {
                 } else if (document->IsCommand()) {
                     auto commandName = std::dynamic_pointer_cast<CommandNode>(document)->GetIdentifier()->GetText();
 
-                    std::string expandedCmd = GetExpandedCommandString(document);
-
-                    // if the expandedCmd is in the database, do not evaluate
-                    //
-                    // TODO: if the algorithms are out of the experimental stage,
-                    //       add the caching again
-                    //
-                    /*if (database.Contains(expandedCmd)) {
-                        lastResult = database[expandedCmd];
-                        lastCmd = expandedCmd;
-                        if (!silent) PrintTensor();
-                        return;
-                    }*/
+                    // If the result is already known, do not evaluate
+                    std::string key;
+                    bool cachable = CommandCache::IsEnabled() && GetCacheKey(document, key);
+
+                    if (cachable) {
+                        Expression cached;
+
+                        if (CommandCache::Instance()->Get(key, cached)) {
+                            lastResult = cached;
+                            Session::Instance()->SetCurrent(key, lastResult);
+                            return lastResult;
+                        }
+                    }
 
                     CommandPointer command;
 
@@ -360,7 +484,7 @@ namespace Construction {
                         auto expr = Execute(arg, true);
 
                         // Set the last expression back
-                        Session::Instance()->SetCurrent("", lastResult);
+                        Session::Instance()->SetState(state);
 
                         // Turn the argument into an argument
                         switch (expr.GetType()) {
@@ -404,6 +528,9 @@ namespace Construction {
 
                     Expression newResult;
 
+                    // Only measure the command itself, not its arguments
+                    time.Start();
+
                     // Execute
                     try {
                         newResult = (*command)();
@@ -428,28 +555,56 @@ namespace Construction {
                     // Stop time measurement
                     time.Stop();
 
-                    // Update the session
-                    if (!lastResult.IsVoid()) {
-                        Session::Instance()->SetCurrent(expandedCmd, lastResult);
-                    }
+                    // Update the session and the cache
+                    if (!newResult.IsVoid()) {
+                        if (cachable) {
+                            CommandCache::Instance()->Insert(key, newResult, time.GetMilliseconds());
+                        }
 
-                    // Update database
-                    /*if (command->Cachable()) {
-                        database[lastCmd] = lastResult;
-                    }*/
+                        Session::Instance()->SetCurrent(cachable ? key : "", lastResult);
+                    } else {
+                        // The result is the expression before
+                        lastResult = Session::Instance()->GetCurrent();
+                    }
 
                     return lastResult;
                 } else if (document->IsAssignment()) {
                     auto id = std::dynamic_pointer_cast<AssignmentNode>(document)->GetIdentifier()->GetText();
                     auto expression = std::dynamic_pointer_cast<AssignmentNode>(document)->GetExpression();
 
+                    // In the lazy mode, silent assignments are calculated on first use
+                    if (lazy && silent) {
+                        Session::Bindings bindings;
+                        bool expensive = false;
+
+                        if (Capture(expression, bindings, expensive) && expensive) {
+                            std::string key;
+                            if (!CommandCache::IsEnabled() || !GetCacheKey(expression, key)) key = "";
+
+                            auto thunk = std::make_shared<Thunk>([expression, bindings, state]() {
+                                Session::Scope scope (state, bindings);
+
+                                CLI cli;
+                                return cli.Execute(expression, true);
+                            }, key);
+
+                            Session::Instance()->Set(id, thunk);
+                            Session::Instance()->SetCurrent(key, thunk);
+
+                            return Expression::Void();
+                        }
+                    }
+
                     lastResult = Execute(expression, true);
 
-                    // Store the variable in memory
-                    Session::Instance()->Set(id, lastResult);
+                    // Store the variable in memory together with the command that created it
+                    auto definition = Session::Instance()->GetLastCommandString();
 
-                    definition[id] = lastCmd;
-                    //database[lastCmd] = lastResult;
+                    if (definition.empty()) {
+                        Session::Instance()->Set(id, lastResult);
+                    } else {
+                        Session::Instance()->Set(id, lastResult, definition);
+                    }
 
                     // Print tensors unless in silent mode
                     /*if (!silent) {
@@ -497,7 +652,7 @@ namespace Construction {
                 return "";
             }
 
-            void operator()(const std::string& code) {
+            void operator()(const std::string& code, std::ostream& os = std::cout) {
                 std::string text = code;
 
                 bool silent = false;
@@ -527,10 +682,10 @@ namespace Construction {
 
                     // Print tensors unless in silent mode
                     if (!silent) {
-                        PrintExpression(lastResult);
+                        PrintExpression(lastResult, os);
 
                         // Print the required time
-                        std::cout << "\033[90m   " << time << "\033[0m" << std::endl;
+                        os << "\033[90m   " << time << "\033[0m" << std::endl;
                     }
 
                 #if RECOVER_FROM_EXCEPTIONS == 1
@@ -542,7 +697,7 @@ namespace Construction {
                 #endif
 
                 // Store the session on disk in order to recover in case of crash
-                Session::Instance()->SaveToFile(crashFile);
+                Session::Instance()->Checkpoint(crashFile);
             }
 
             void ExecuteScript(const std::string& filename, bool silent=false) {
@@ -576,8 +731,381 @@ namespace Construction {
                     }
                 }
             }
+
+            /**
+                \brief Execute a script, independent statements concurrently
+
+                All the lines are parsed first. A statement waits for the
+                statements that assign the variables it uses, for the last
+                one that uses or assigns the variable it assigns and, if it
+                refers to `%`, for the statement right before it. Every other
+                statement runs right away on the GlobalTaskPool with its own
+                Session::Scope. Statements with a command that has side
+                effects (see Command::HasSideEffects) run alone.
+
+                The output is collected per statement and printed in the
+                order of the script. As in ExecuteScript, the script stops
+                at the first statement that throws.
+             */
+            void ExecuteScriptInParallel(const std::string& filename, bool silent=false, std::ostream& os = std::cout) {
+                // Load text file
+                std::ifstream file (filename);
+                if (!file.is_open()) return;
+
+                // Also the errors of the script go to its output
+                ErrorOutput errors (os);
+
+                std::vector<std::unique_ptr<Statement>> statements;
+
+                // Read and parse line per line
+                std::string line;
+                while (std::getline(file, line)) {
+                    // Ignore empty lines
+                    if (line == "") continue;
+
+                    // Ignore comments
+                    if (line[0] == '#') continue;
+
+                    // Turn silent?
+                    if (silent && line[line.size()-1] != ':') line.append(":");
+
+                    std::unique_ptr<Statement> statement (new Statement());
+                    statement->code = line;
+                    statement->silent = line[line.size()-1] == ':';
+                    statement->document = parser.Parse(statement->silent ? line.substr(0, line.size()-1) : line);
+
+                    if (statement->document) {
+                        Analyze(statement->document, *statement);
+                    }
+
+                    statements.push_back(std::move(statement));
+                }
+
+                size_t size = statements.size();
+
+                // Build the def-use graph
+                {
+                    std::map<std::string, size_t> assignments;
+                    std::map<std::string, std::vector<size_t>> uses;
+                    size_t barrier = size;
+
+                    for (size_t i=0; i<size; ++i) {
+                        auto& statement = *statements[i];
+                        std::set<size_t> dependencies;
+
+                        if (statement.barrier) {
+                            for (size_t j=0; j<i; ++j) dependencies.insert(j);
+                        } else {
+                            if (barrier < size) dependencies.insert(barrier);
+                            if (statement.previous && i > 0) dependencies.insert(i-1);
+
+                            for (auto& name : statement.uses) {
+                                auto it = assignments.find(name);
+                                if (it != assignments.end()) dependencies.insert(it->second);
+                            }
+
+                            if (!statement.assigns.empty()) {
+                                auto it = assignments.find(statement.assigns);
+                                if (it != assignments.end()) dependencies.insert(it->second);
+
+                                for (auto j : uses[statement.assigns]) {
+                                    if (j != i) dependencies.insert(j);
+                                }
+                            }
+                        }
+
+                        for (auto j : dependencies) {
+                            statements[j]->dependents.push_back(i);
+                        }
+                        statement.pending = dependencies.size();
+
+                        for (auto& name : statement.uses) {
+                            uses[name].push_back(i);
+                        }
+
+                        if (!statement.assigns.empty()) {
+                            assignments[statement.assigns] = i;
+                            uses[statement.assigns].clear();
+                        }
+
+                        if (statement.barrier) barrier = i;
+                    }
+                }
+
+                std::mutex mutex;
+                std::condition_variable condition;
+                std::deque<size_t> ready;
+                unsigned running = 0;
+
+                for (size_t i=0; i<size; ++i) {
+                    if (statements[i]->pending == 0) ready.push_back(i);
+                }
+
+                // Mark a statement as finished and release the statements waiting for it
+                auto finish = [&](size_t i) {
+                    std::unique_lock<std::mutex> lock(mutex);
+
+                    statements[i]->done = true;
+
+                    for (auto j : statements[i]->dependents) {
+                        if (--statements[j]->pending == 0) ready.push_back(j);
+                    }
+
+                    condition.notify_all();
+                };
+
+                size_t next = 0;
+                bool failed = false;
+                const Statement* last = nullptr;
+
+                // All statements run on one pool, a barrier like `Threads` may replace it
+                auto pool = Parallel::GlobalTaskPool::Instance()->GetPool();
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                while (next < size && !failed) {
+                    // Print the finished statements in the order of the script
+                    while (next < size) {
+                        auto& statement = *statements[next];
+
+                        if (!statement.announced) {
+                            os << "> " << statement.code << std::endl;
+                            statement.announced = true;
+                        }
+
+                        if (!statement.done) break;
+
+                        os << statement.output << std::flush;
+
+                        if (statement.failed) {
+                            if (!statement.error.empty()) Error(statement.error);
+
+                            // If an exception is thrown, exit since further evaluation
+                            // of the scripts cannot be garantueed.
+                            Error("Cannot recover from this. Stopping execution of the script ...");
+                            failed = true;
+                            break;
+                        }
+
+                        if (statement.document) {
+                            Session::Instance()->GetNotebook().Append(statement.code);
+                            last = &statement;
+                        }
+
+                        ++next;
+                    }
+
+                    if (failed || next == size) break;
+
+                    // Start the statements whose dependencies are finished
+                    std::deque<size_t> waiting;
+
+                    while (!ready.empty()) {
+                        auto i = ready.front();
+                        ready.pop_front();
+
+                        // Statements that run alone see the result before them, as in ExecuteScript
+                        const Statement* before = (i > 0 && (statements[i]->previous || statements[i]->barrier)) ? statements[i-1].get() : nullptr;
+
+                        if (statements[i]->barrier) {
+                            // Run it alone once everything before is printed
+                            if (i != next) {
+                                waiting.push_back(i);
+                                continue;
+                            }
+
+                            lock.unlock();
+                            pool.reset();
+
+                            Run(*statements[i], before, os);
+                            finish(i);
+
+                            pool = Parallel::GlobalTaskPool::Instance()->GetPool();
+                            lock.lock();
+                        } else {
+                            ++running;
+
+                            auto statement = statements[i].get();
+
+                            pool->Enqueue([this, statement, before, i, &finish, &mutex, &condition, &running]() {
+                                std::stringstream ss;
+                                Run(*statement, before, ss);
+                                statement->output += ss.str();
+
+                                finish(i);
+
+                                // Notify under the lock, the script may return right afterwards
+                                std::unique_lock<std::mutex> lock(mutex);
+                                --running;
+                                condition.notify_all();
+                            });
+                        }
+                    }
+
+                    ready = std::move(waiting);
+
+                    if (!statements[next]->done) {
+                        condition.wait(lock);
+                    }
+                }
+
+                // Wait for the statements that are still running
+                condition.wait(lock, [&]() { return running == 0; });
+                lock.unlock();
+                pool.reset();
+
+                // Continue with the result of the last statement
+                if (last) {
+                    Session::Instance()->SetState(last->state);
+                }
+
+                // Store the session on disk in order to recover in case of crash
+                Session::Instance()->Checkpoint(crashFile);
+            }
+        private:
+            /**
+                \brief Capture the variables an assignment needs to be calculated later
+
+                \param expensive   Set if the expression contains a command
+                \returns False if the expression has to be calculated right away, i.e.
+                          it uses an unknown variable or a command with side effects
+             */
+            bool Capture(const std::shared_ptr<Node>& document, Session::Bindings& bindings, bool& expensive) const {
+                if (document->IsPrevious() || document->IsNumeric() || document->IsIndices() || document->IsString()) {
+                    return true;
+                } else if (document->IsLiteral()) {
+                    auto name = std::dynamic_pointer_cast<LiteralNode>(document)->GetText();
+                    auto thunk = Session::Instance()->GetThunk(name);
+                    if (!thunk) return false;
+
+                    bindings[name] = thunk;
+                    return true;
+                } else if (document->IsBinary()) {
+                    return Capture(std::dynamic_pointer_cast<BinaryNode>(document)->GetLeft(), bindings, expensive) &&
+                           Capture(std::dynamic_pointer_cast<BinaryNode>(document)->GetRight(), bindings, expensive);
+                } else if (document->IsNegation()) {
+                    return Capture(std::dynamic_pointer_cast<NegationNode>(document)->GetNode(), bindings, expensive);
+                } else if (document->IsCommand()) {
+                    auto commandName = std::dynamic_pointer_cast<CommandNode>(document)->GetIdentifier()->GetText();
+
+                    try {
+                        if (CommandManagement::Instance()->CreateCommand(commandName)->HasSideEffects()) return false;
+                    } catch (UnknownCommandException& err) {
+                        return false;
+                    }
+
+                    expensive = true;
+
+                    for (auto& arg : *std::dynamic_pointer_cast<CommandNode>(document)->GetArguments()) {
+                        if (!Capture(arg, bindings, expensive)) return false;
+                    }
+
+                    return true;
+                }
+
+                return false;
+            }
+
+            /**
+                \brief A line of a script that is executed in parallel
+             */
+            struct Statement {
+                std::string code;
+                std::shared_ptr<Node> document;
+                bool silent = false;
+
+                // Def-use information
+                std::set<std::string> uses;
+                std::string assigns;
+                bool previous = false;
+                bool barrier = false;
+
+                // Scheduling
+                std::vector<size_t> dependents;
+                size_t pending = 0;
+                bool done = false;
+                bool announced = false;
+
+                // Result
+                std::string output;
+                bool failed = false;
+                std::string error;
+                Session::State state;
+            };
+
+            /**
+                \brief Collect the variables a statement uses and assigns
+             */
+            void Analyze(const std::shared_ptr<Node>& document, Statement& statement) const {
+                if (document->IsPrevious()) {
+                    statement.previous = true;
+                } else if (document->IsLiteral()) {
+                    statement.uses.insert(std::dynamic_pointer_cast<LiteralNode>(document)->GetText());
+                } else if (document->IsBinary()) {
+                    Analyze(std::dynamic_pointer_cast<BinaryNode>(document)->GetLeft(), statement);
+                    Analyze(std::dynamic_pointer_cast<BinaryNode>(document)->GetRight(), statement);
+                } else if (document->IsNegation()) {
+                    Analyze(std::dynamic_pointer_cast<NegationNode>(document)->GetNode(), statement);
+                } else if (document->IsAssignment()) {
+                    statement.assigns = std::dynamic_pointer_cast<AssignmentNode>(document)->GetIdentifier()->GetText();
+                    Analyze(std::dynamic_pointer_cast<AssignmentNode>(document)->GetExpression(), statement);
+                } else if (document->IsCommand()) {
+                    auto commandName = std::dynamic_pointer_cast<CommandNode>(document)->GetIdentifier()->GetText();
+
+                    // Unknown commands fail when they are executed
+                    try {
+                        if (CommandManagement::Instance()->CreateCommand(commandName)->HasSideEffects()) {
+                            statement.barrier = true;
+                        }
+                    } catch (UnknownCommandException& err) {
+
+                    }
+
+                    for (auto& arg : *std::dynamic_pointer_cast<CommandNode>(document)->GetArguments()) {
+                        Analyze(arg, statement);
+                    }
+                }
+            }
+
+            /**
+                \brief Execute a statement in its own scope and print the result to the stream
+
+                \param before  The statement whose result is `%`
+             */
+            void Run(Statement& statement, const Statement* before, std::ostream& os) {
+                if (!statement.document) {
+                    statement.output = "\033[31mError: \033[0mSomething went wrong :/\n";
+                    return;
+                }
+
+                Session::Scope scope (before ? before->state : Session::State());
+                ErrorOutput errors (os);
+
+                try {
+                    Common::TimeMeasurement time;
+
+                    auto result = Execute(statement.document, statement.silent);
+
+                    time.Stop();
+
+                    // Print tensors unless in silent mode
+                    if (!statement.silent) {
+                        PrintExpression(result, os);
+
+                        // Print the required time
+                        os << "\033[90m   " << time << "\033[0m" << std::endl;
+                    }
+                } catch (const std::exception& e) {
+                    statement.failed = true;
+                    statement.error = e.what();
+                } catch (...) {
+                    statement.failed = true;
+                }
+
+                statement.state = scope.GetState();
+            }
         public:
-            void PrintExpression(const Expression& expression) {
+            void PrintExpression(const Expression& expression, std::ostream& os = std::cout) {
                 /**
                     DEFAULT = 39,
                     BLACK = 30,
@@ -606,25 +1134,21 @@ namespace Construction {
                 std::string line;
 
                 // Change the output color
-                std::cout << "\033[" << expression.GetColorCode() << "m";
+                os << "\033[" << expression.GetColorCode() << "m";
 
                 // Shift the output by three characters
                 while (std::getline(ss, line)) {
-                    std::cout << "   " << line << std::endl;
+                    os << "   " << line << std::endl;
                 }
 
                 // Change the color back
-                std::cout << "\033[0m";
+                os << "\033[0m";
             }
         private:
             Parser parser;
 
-            //TensorDatabase database;
-
-            // Store the command to that was executed to create %
-            std::string lastCmd;
             std::string crashFile;
-            std::map<std::string, std::string> definition;
+            bool lazy = false;
         };
 
     }
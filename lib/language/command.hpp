@@ -194,7 +194,32 @@ namespace Construction {
                 return Execute();
             }
         public:
-            static bool Cachable() { return true; }
+            /**
+                \brief Can the result be taken from the CommandCache?
+
+                Commands with side effects or results that are cheaper to
+                calculate than to store return false.
+             */
+            virtual bool Cachable() const { return true; }
+
+            /**
+                \brief Version of the algorithm behind the command
+
+                It is part of the key in the CommandCache. Increase it whenever
+                the command returns a different result for the same arguments,
+                e.g. a different form of the result of `Symmetrize`, s.t. the
+                old results stored in the expression database are ignored.
+             */
+            virtual unsigned Version() const { return 1; }
+
+            /**
+                \brief Does the command change more than its result?
+
+                E.g. the session, the thread pool or the output. Statements
+                of a parallel script that use such a command are run alone,
+                after all the statements before them.
+             */
+            virtual bool HasSideEffects() const { return false; }
         public:
             virtual std::string Help() const = 0;
             virtual Expression Execute() const = 0;
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <list>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include <common/singleton.hpp>
+#include <common/logger.hpp>
+#include <common/memory.hpp>
+
+#include <tensor/expression.hpp>
+#include <tensor/expression_database.hpp>
+
+using Construction::Tensor::Expression;
+
+namespace Construction {
+    namespace Language {
+
+        /**
+            \class CommandCache
+
+            \brief Results of the CLI commands, keyed by the expanded command
+
+            The key of a result is the fully expanded command that created it,
+            e.g. `Symmetrize@1(Arbitrary@1("{a b c d}",...),"{a b}")`, see
+            CLI::GetCacheKey. It contains the version of every command, hence
+            a changed algorithm never returns stale results.
+
+            The most recent results are kept in memory up to a limit of bytes.
+            Results that took long to calculate are also written into the
+            ExpressionDatabase if it is active, s.t. they survive the process.
+            A lookup that misses the memory asks the database afterwards.
+
+            The cache is disabled by default. `apple cli` and the construction
+            server enable it, `apple solve` keeps it off since the coefficients
+            use the CLI with random variable names.
+         */
+        class CommandCache : public Singleton<CommandCache> {
+        public:
+            static bool IsEnabled() {
+                return Enabled().load(std::memory_order_relaxed);
+            }
+
+            static void Enable() {
+                Enabled() = true;
+            }
+
+            static void Disable() {
+                Enabled() = false;
+            }
+        public:
+            /**
+                \brief Look up the result of a command
+
+                \returns True if the result was found in memory or in the database
+             */
+            bool Get(const std::string& key, Expression& expression) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+
+                    auto it = map.find(key);
+
+                    if (it != map.end()) {
+                        // Mark as most recently used
+                        entries.splice(entries.begin(), entries, it->second);
+
+                        ++hits;
+                        expression = it->second->second;
+                        return true;
+                    }
+                }
+
+                auto database = Tensor::ExpressionDatabase::Instance();
+
+                if (database->IsActive() && database->Contains(key)) {
+                    auto stored = database->Get(key);
+
+                    if (!stored.IsVoid()) {
+                        Construction::Logger::Debug("Found `", key, "` in the database");
+
+                        Store(key, stored);
+
+                        std::unique_lock<std::mutex> lock(mutex);
+                        ++hits;
+                        expression = stored;
+                        return true;
+                    }
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+                ++misses;
+                return false;
+            }
+
+            /**
+                \brief Remember the result of a command
+
+                \param milliseconds     The time the command took
+             */
+            void Insert(const std::string& key, const Expression& expression, double milliseconds) {
+                Store(key, expression);
+
+                auto database = Tensor::ExpressionDatabase::Instance();
+
+                if (milliseconds >= persistenceThreshold && database->IsActive()) {
+                    if (!database->Insert(key, expression)) {
+                        Construction::Logger::Warning("Could not write `", key, "` into the database");
+                    }
+                }
+            }
+
+            void Clear() {
+                std::unique_lock<std::mutex> lock(mutex);
+                entries.clear();
+                map.clear();
+                bytes = 0;
+            }
+
+            /**
+                \brief Limit the memory of the results, older ones are dropped first
+             */
+            void SetMaximalSize(size_t size) {
+                std::unique_lock<std::mutex> lock(mutex);
+                maximalSize = size;
+                Shrink();
+            }
+        public:
+            size_t Size() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return map.size();
+            }
+
+            size_t GetHits() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return hits;
+            }
+
+            size_t GetMisses() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return misses;
+            }
+
+            size_t MemoryFootprint() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return bytes + map.bucket_count() * sizeof(void*);
+            }
+        private:
+            void Store(const std::string& key, const Expression& expression) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                auto it = map.find(key);
+                if (it != map.end()) {
+                    bytes -= GetSize(*it->second);
+                    entries.erase(it->second);
+                    map.erase(it);
+                }
+
+                entries.push_front({ key, expression });
+                map[key] = entries.begin();
+                bytes += GetSize(entries.front());
+
+                Shrink();
+            }
+
+            void Shrink() {
+                // Always keep the most recent result
+                while (bytes > maximalSize && entries.size() > 1) {
+                    auto& last = entries.back();
+
+                    bytes -= GetSize(last);
+                    map.erase(last.first);
+                    entries.pop_back();
+                }
+            }
+
+            static size_t GetSize(const std::pair<std::string, Expression>& entry) {
+                return Common::HASH_NODE_OVERHEAD + Common::TREE_NODE_OVERHEAD + 2 * Common::MemoryFootprint(entry.first) + entry.second.DeepSize();
+            }
+
+            static std::atomic<bool>& Enabled() {
+                static std::atomic<bool> enabled (false);
+                return enabled;
+            }
+        private:
+            typedef std::list<std::pair<std::string, Expression>>   EntryList;
+
+            EntryList entries;
+            std::unordered_map<std::string, EntryList::iterator> map;
+
+            size_t bytes = 0;
+            size_t maximalSize = 256 * 1024 * 1024;
+
+            // Only results that took at least a second are written to disk
+            double persistenceThreshold = 1000;
+
+            size_t hits = 0;
+            size_t misses = 0;
+
+            mutable std::mutex mutex;
+        };
+
+    }
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <functional>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Construction {
+    namespace Language {
+
+        /**
+            \class MappedFile
+
+            \brief Read-only memory map of a whole file
+
+            An empty or missing file is not mapped, see IsOpen().
+         */
+        class MappedFile {
+        public:
+            MappedFile(const std::string& filename) {
+                fd = open(filename.c_str(), O_RDONLY);
+                if (fd < 0) return;
+
+                struct stat info;
+                if (fstat(fd, &info) < 0 || info.st_size == 0) return;
+
+                void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (address == MAP_FAILED) return;
+
+                data = static_cast<const char*>(address);
+                size = info.st_size;
+            }
+
+            ~MappedFile() {
+                if (data) munmap(const_cast<char*>(data), size);
+                if (fd >= 0) close(fd);
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+        public:
+            bool IsOpen() const { return data != nullptr; }
+
+            const char* GetData() const { return data; }
+            size_t Size() const { return size; }
+        private:
+            int fd = -1;
+            const char* data = nullptr;
+            size_t size = 0;
+        };
+
+        /**
+            \class MemoryStreamBuffer
+
+            \brief Stream buffer that reads from memory without copying it
+         */
+        class MemoryStreamBuffer : public std::streambuf {
+        public:
+            MemoryStreamBuffer(const char* data, size_t size) {
+                char* begin = const_cast<char*>(data);
+                setg(begin, begin, begin + size);
+            }
+        };
+
+        /**
+            \class Journal
+
+            \brief Binary format of the snapshots and journals of a session
+
+            A file starts with an eight byte magic and the generation of the
+            snapshot, followed by records of the form
+
+                <type : 1 byte> <size of the name : 8 byte> <name>
+                <size of the data : 8 byte> <data>
+
+            A snapshot holds the whole session, the journal next to it holds
+            the changes since the snapshot was written. Every compaction writes
+            a new snapshot with the next generation, hence a journal that was
+            not truncated afterwards, e.g. since the process died in between,
+            is recognized and ignored.
+
+            A record that was only partially written ends the file. It has to
+            be cut off before new records are appended.
+         */
+        class Journal {
+        public:
+            enum class Record : uint8_t {
+                LINE = 1,
+                CURRENT = 2,
+                VARIABLE = 3,
+                ERASE = 4
+            };
+
+            typedef std::function<void(Record, const std::string&, const char*, size_t)>   Callback;
+
+            static constexpr const char* SNAPSHOT = "CSESSION";
+            static constexpr const char* JOURNAL = "CJOURNAL";
+        public:
+            static void WriteHeader(std::ostream& os, const char* magic, uint64_t generation) {
+                os.write(magic, 8);
+                os.write(reinterpret_cast<const char*>(&generation), sizeof(generation));
+            }
+
+            static void Write(std::ostream& os, Record type, const std::string& name, const std::string& data = "") {
+                uint64_t size;
+
+                os.put(static_cast<char>(type));
+
+                size = name.size();
+                os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+                os << name;
+
+                size = data.size();
+                os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+                os << data;
+            }
+
+            /**
+                \brief Read the header of a mapped file
+
+                \returns False if the file is no snapshot or journal of the given kind
+             */
+            static bool ReadHeader(const MappedFile& file, const char* magic, uint64_t& generation) {
+                if (!file.IsOpen() || file.Size() < HeaderSize()) return false;
+                if (std::memcmp(file.GetData(), magic, 8) != 0) return false;
+
+                std::memcpy(&generation, file.GetData() + 8, sizeof(generation));
+                return true;
+            }
+
+            /**
+                \brief Call the function for every complete record of a mapped file
+
+                The data is handed out as a pointer into the mapped file.
+
+                \returns The offset behind the last complete record
+             */
+            static size_t ReadRecords(const MappedFile& file, const Callback& fn) {
+                const char* data = file.GetData();
+                size_t size = file.Size();
+                size_t pos = HeaderSize();
+
+                while (pos + 1 + sizeof(uint64_t) <= size) {
+                    auto type = static_cast<Record>(data[pos]);
+                    uint64_t length;
+
+                    std::memcpy(&length, data + pos + 1, sizeof(length));
+                    size_t namePos = pos + 1 + sizeof(length);
+                    if (length > size - namePos || namePos + length + sizeof(length) > size) break;
+
+                    std::string name (data + namePos, length);
+
+                    std::memcpy(&length, data + namePos + name.size(), sizeof(length));
+                    size_t dataPos = namePos + name.size() + sizeof(length);
+                    if (length > size - dataPos) break;
+
+                    fn(type, name, data + dataPos, length);
+
+                    pos = dataPos + length;
+                }
+
+                return pos;
+            }
+
+            static constexpr size_t HeaderSize() { return 8 + sizeof(uint64_t); }
+        };
+
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <iostream>
+
+#include <language/command.hpp>
+#include <language/argument.hpp>
+#include <language/session.hpp>
+#include <language/command_cache.hpp>
+
+#include <common/memory.hpp>
+#include <common/statistics.hpp>
+#include <tensor/expression.hpp>
+#include <tensor/expression_database.hpp>
+
+using Construction::Tensor::Expression;
+
+namespace Construction {
+    namespace Language {
+
+        /**
+            \class MemoryStatsCommand
+
+            Prints the allocation counters of the tensor nodes, scalar
+            nodes and matrix entries together with the memory held by
+            the session, the CommandCache and the cache of the expression
+            database.
+         */
+        CLI_COMMAND(MemoryStats)
+            std::string Help() const {
+                return "MemoryStats()";
+            }
+
+            virtual bool Cachable() const override {
+                return false;
+            }
+
+            // Prints the memory of the statements before
+            virtual bool HasSideEffects() const override {
+                return true;
+            }
+
+            Expression Execute() const {
+                Common::MemoryStatistics::Print(std::cout);
+
+                auto database = Construction::Tensor::ExpressionDatabase::Instance();
+
+                std::cout << std::endl;
+                std::cout << "Session:           " << Common::MemoryStatistics::FormatBytes(Session::Instance()->MemoryFootprint()) << " (" << Session::Instance()->Size() << " variables)" << std::endl;
+                std::cout << "Command cache:     " << Common::MemoryStatistics::FormatBytes(CommandCache::Instance()->MemoryFootprint()) << " (" << CommandCache::Instance()->Size() << " results, " << CommandCache::Instance()->GetHits() << " hits)" << std::endl;
+                std::cout << "Database cache:    " << Common::MemoryStatistics::FormatBytes(database->MemoryFootprint()) << " (" << database->GetNumberOfCached() << " expressions)" << std::endl;
+                std::cout << "Peak RSS:          " << Common::MemoryStatistics::FormatBytes(Common::Statistics::GetPeakMemory() * 1024) << std::endl;
+
+                return Expression::Void();
+            }
+        };
+
+        REGISTER_COMMAND(MemoryStats);
+
+    }
+}
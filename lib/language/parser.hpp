@@ -3,6 +3,14 @@
 #include <iostream>
 #include <sstream>
 #include <memory>
+#include <string>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+
+#include <common/singleton.hpp>
 
 namespace Construction {
     namespace Language {
@@ -16,6 +24,9 @@ namespace Construction {
             Tokens for lexical analysis of the input. In our simple language
             this means literals, strings, brackets, comma and % for the previous
             output.
+
+            A token only refers to its text in the input, which has to outlive
+            the token. The content is copied when a node is created from it.
          */
         class Token {
         public:
@@ -40,10 +51,11 @@ namespace Construction {
             /**
                 Constructor of a token
              */
-            Token(Type type, unsigned pos, std::string content) : pos(pos), type(type), content(content) { }
+            Token(Type type, unsigned pos, const char* data, unsigned length) : pos(pos), type(type), data(data), length(length) { }
         public:
             unsigned GetPosition() const { return pos; }
-            std::string GetContent() const { return content; }
+            unsigned GetLength() const { return length; }
+            std::string GetContent() const { return std::string(data, length); }
         public:
             bool IsLiteral() const { return type == LITERAL; }
             bool IsPrevious() const { return type == PREVIOUS; }
@@ -79,13 +91,15 @@ namespace Construction {
             }
         public:
             friend std::ostream& operator<<(std::ostream& os, const Token& token) {
-                os << "(" << token.TypeToString() << " " << token.content << " " << token.pos << ")";
+                os << "(" << token.TypeToString() << " " << token.GetContent() << " " << token.pos << ")";
                 return os;
             }
         private:
             unsigned pos;
             Type type;
-            std::string content;
+
+            const char* data = nullptr;
+            unsigned length = 0;
         };
 
         /**
@@ -192,6 +206,10 @@ namespace Construction {
             void Insert(const std::shared_ptr<Node>& node) {
                 arguments.insert(arguments.begin(), node);
             }
+
+            void Append(const std::shared_ptr<Node>& node) {
+                arguments.push_back(node);
+            }
         public:
             virtual std::string ToString() const;
         public:
@@ -302,22 +320,76 @@ namespace Construction {
             virtual std::string ToString() const { return "%"; }
         };
 
-        class BacktrackingRAII {
-        public:
-            BacktrackingRAII(Parser& parser);
-            virtual ~BacktrackingRAII();
+        /**
+            \class ParseCache
+
+            \brief Syntax trees of the lines that were parsed before
+
+            Scripts and equations repeat the same lines, e.g. every time a
+            script is executed again or the same equation is compiled for
+            another job of the server. The trees are keyed by the hash of
+            the line, the line itself is compared on a hit to rule out
+            collisions. The nodes are never changed after parsing, hence
+            the same tree can be shared by all the callers.
+
+            The most recently used trees are kept up to a number of lines.
+         */
+        class ParseCache : public Singleton<ParseCache> {
         public:
-            void CancelBacktracking() {
-                backtrack = false;
+            std::shared_ptr<Node> Get(const std::string& code) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                auto it = map.find(std::hash<std::string>()(code));
+                if (it == map.end() || it->second->code != code) return nullptr;
+
+                // Mark as most recently used
+                entries.splice(entries.begin(), entries, it->second);
+
+                return it->second->document;
             }
 
-            void DoBacktrack() {
-                backtrack = true;
+            void Insert(const std::string& code, const std::shared_ptr<Node>& document) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                auto hash = std::hash<std::string>()(code);
+
+                auto it = map.find(hash);
+                if (it != map.end()) {
+                    entries.erase(it->second);
+                    map.erase(it);
+                }
+
+                entries.push_front({ code, document });
+                map[hash] = entries.begin();
+
+                while (entries.size() > maximalSize) {
+                    map.erase(std::hash<std::string>()(entries.back().code));
+                    entries.pop_back();
+                }
+            }
+
+            void Clear() {
+                std::unique_lock<std::mutex> lock(mutex);
+                entries.clear();
+                map.clear();
+            }
+
+            size_t Size() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return entries.size();
             }
         private:
-            Parser& parser;
-            int position;
-            bool backtrack=true;
+            struct Entry {
+                std::string code;
+                std::shared_ptr<Node> document;
+            };
+
+            std::list<Entry> entries;
+            std::unordered_map<size_t, std::list<Entry>::iterator> map;
+
+            size_t maximalSize = 4096;
+
+            mutable std::mutex mutex;
         };
 
         /**
@@ -326,665 +398,332 @@ namespace Construction {
             Parser
             The EBNF grammar reads
 
-                EXPRESSION
-                    = ASSIGNMENT
-                    | COMMAND
-                    | PREVIOUS
+                expression
+                    = assignment
+                    | rhs_expression
                     ;
 
-                ASSIGNMENT
-                    = LITERAL = RHS_EXPRESSION
+                assignment
+                    = literal '=' rhs_expression
                     ;
 
-                RHS_EXPRESSION
-                    = LITERAL
-                    | COMMAND
+                rhs_expression
+                    = prefix { ('+' | '-' | '*') prefix }
                     ;
 
-                COMMAND
-                    = LITERAL ( ARGUMENTS )
+                prefix
+                    = '-' prefix
+                    | '(' rhs_expression ')'
+                    | literal '(' [ rhs_expression { ',' rhs_expression } ] ')'
+                    | literal
+                    | previous
+                    | string
+                    | indices
+                    | numeric
                     ;
 
-                ARGUMENTS
-                    = Arguments , Arg
-                    | Arg
-                    ;
-
-                Argument
-                    = Command
-                    | Literal
-                    | PREVIOUS
-
-                    | STRING
-                    | INDICES
-                    | NUMERIC
-                    | EMPTY
-                    ;
+            The lexer runs once over the line and the tokens refer to the
+            text of the line instead of copying it. The binary operators are
+            parsed by precedence climbing, where '*' binds stronger than '+'
+            and '-', and all of them are left associative. Every decision
+            only depends on the current token and the one after it, hence
+            the parser never backtracks.
 
+            A line that was parsed before is taken from the ParseCache.
          */
         class Parser {
         public:
-            enum Mode {
-                DEFAULT = 1,
-
-                ARGUMENT = 100,
-                STRING = 101,
-                NUMERIC = 102,
-            };
-        public:
-            bool IsNumeric(const std::string& d) const {
-                char c = d[0];
-                return c == '0' || c == '1' || c == '2' || c == '3' || c == '4' ||
-                       c == '5' || c == '6' || c == '7' || c == '8' || c == '9';
-            }
-
             /**
                 \brief Lexalize the input
 
-                This method decomposites the input in its ingredients.
-
-                \return Vector with all the input
+                This method decomposites the input in its ingredients. The
+                tokens are terminated by an EOL token.
              */
             void Lexalize(const std::string& code) {
-                bool inString = false;
-                bool inIndices = false;
-                bool inNumeric = false;
-                std::string current;
-
-                for (int i=0; i<code.length(); i++) {
-                    std::string c = std::string(1,code[i]);
-
-                    // If index, then append everything
-                    if (inIndices) {
-                        if (c == "}") {
-                            tokens.push_back(Token(Token::INDICES, i-current.length(), current));
-                            current = "";
-                            inIndices = false;
-                            continue;
-                        }
+                const char* data = code.data();
+                unsigned length = code.length();
+                unsigned i = 0;
 
-                        current.append(c);
-                        continue;
-                    }
+                while (i < length) {
+                    char c = data[i];
+                    unsigned start = i;
 
-                    // If string, then append everything
-                    if (inString) {
-                        if (c == "\"") {
-                            tokens.push_back(Token(Token::STRING, i-current.length(), current));
-                            current = "";
-                            inString = false;
+                    switch (Classify(c)) {
+                        case SPACE:
+                            ++i;
                             continue;
-                        }
 
-                        current.append(c);
-                        continue;
-                    }
-
-
-                    // If a comment starts, stop parsing
-                    if (c == "#") break;
-
-                    // Ignore white spaces
-                    if (c == " ") continue;
-
-                    if (inNumeric) {
-                        if (!IsNumeric(c) && c != ".") {
-                            tokens.push_back(Token(Token::NUMERIC, i-current.length(), current));
-                            current = "";
-                            inNumeric = false;
-                        }
-                    }
-
-                    if (c == "." && inNumeric) {
-                        current.append(c);
-                        continue;
-                    }
-
-                    if (IsNumeric(c) || (c == "-" && IsNumeric(std::string(1, code[i+1])))) {
-                        inNumeric = true;
-                        current.append(c);
-                        continue;
-                    }
-
-                    if (c == "=") {
-                        if (current.length() > 0)
-                            tokens.push_back(Token(Token::LITERAL, i-current.length(),current));
-                        tokens.push_back(Token(Token::ASSIGNMENT, i, c));
-                        current = "";
-                        continue;
-                    }
-
-                    if (c == "(") {
-                        if (current.length() > 0)
-                            tokens.push_back(Token(Token::LITERAL, i-current.length(),current));
-                        tokens.push_back(Token(Token::LBRACKET, i, c));
-                        current = "";
-                        continue;
-                    }
-
-                    if (c == ")") {
-                        if (current.length() > 0)
-                            tokens.push_back(Token(Token::LITERAL, i-current.length(),current));
-                        tokens.push_back(Token(Token::RBRACKET, i, c));
-                        current = "";
-                        continue;
-                    }
+                        case COMMENT:
+                            i = length;
+                            continue;
 
-                    if (c == "%") {
-                        if (current.length() > 0)
-                            tokens.push_back(Token(Token::LITERAL, i-current.length(),current));
-                        tokens.push_back(Token(Token::PREVIOUS, i, c));
-                        current = "";
-                        continue;
-                    }
+                        case DIGIT:
+                            while (i < length && (Classify(data[i]) == DIGIT || data[i] == '.')) ++i;
+                            tokens.push_back(Token(Token::NUMERIC, start, data + start, i - start));
+                            continue;
 
-                    if (c == "+") {
-                        if (current.length() > 0)
-                            tokens.push_back(Token(Token::LITERAL, i-current.length(),current));
-                        tokens.push_back(Token(Token::PLUS, i, c));
-                        current = "";
-                        continue;
-                    }
+                        case DELIMITER: {
+                            // Indices and strings contain everything up to the closing delimiter
+                            char end = (c == '{') ? '}' : '"';
 
-                    if (c == "-") {
-                        if (current.length() > 0)
-                            tokens.push_back(Token(Token::LITERAL, i-current.length(),current));
-                        tokens.push_back(Token(Token::MINUS, i, c));
-                        current = "";
-                        continue;
-                    }
+                            while (++i < length && data[i] != end) { }
 
-                    if (c == "*") {
-                        if (current.length() > 0)
-                            tokens.push_back(Token(Token::LITERAL, i-current.length(),current));
-                        tokens.push_back(Token(Token::ASTERISK, i, c));
-                        current = "";
-                        continue;
-                    }
+                            // Drop an unterminated block
+                            if (i >= length) continue;
 
-                    if (c == ",") {
-                        if (current.length() > 0)
-                            tokens.push_back(Token(Token::LITERAL, i-current.length(),current));
-                        tokens.push_back(Token(Token::COMMA, i, c));
-                        current = "";
-                        continue;
-                    }
+                            tokens.push_back(Token((c == '{') ? Token::INDICES : Token::STRING, start + 1, data + start + 1, i - start - 1));
+                            ++i;
+                            continue;
+                        }
 
-                    if (c == "{") {
-                        if (current.length() > 0)
-                            tokens.push_back(Token(Token::LITERAL, i-current.length(),current));
-                        inIndices = true;
-                        current = "";
-                        continue;
-                    }
+                        case SYMBOL: {
+                            // A minus in front of a number is its sign
+                            if (c == '-' && i + 1 < length && Classify(data[i+1]) == DIGIT) {
+                                ++i;
+                                while (i < length && (Classify(data[i]) == DIGIT || data[i] == '.')) ++i;
+                                tokens.push_back(Token(Token::NUMERIC, start, data + start, i - start));
+                                continue;
+                            }
+
+                            tokens.push_back(Token(GetSymbolType(c), start, data + start, 1));
+                            ++i;
+                            continue;
+                        }
 
-                    if (c == "\"") {
-                        if (current.length() > 0)
-                            tokens.push_back(Token(Token::LITERAL, i-current.length(),current));
-                        inString = true;
-                        current = "";
-                        continue;
+                        default:
+                            // Literals may contain digits after the first character
+                            while (i < length && (Classify(data[i]) == LETTER || Classify(data[i]) == DIGIT)) ++i;
+                            tokens.push_back(Token(Token::LITERAL, start, data + start, i - start));
+                            continue;
                     }
-
-                    // potentially check if it is a letter
-
-                    current.append(c);
                 }
 
-                if (current.length() > 0)
-                    tokens.push_back(Token(Token::LITERAL, code.length()-current.length(),current));
+                tokens.push_back(Token(Token::EOL, length, data + length, 0));
             }
         public:
             int GetPosition() const { return currentPos; }
-            void GoToPosition(int pos) {
-                if (pos > tokens.size()-1) return;
-
-                // Set the tokens
-                current = tokens[pos];
-                if (pos < tokens.size()-1) lookAhead = tokens[pos+1];
-                else lookAhead = Token(Token::EOL, 0, "");
-
-                currentPos = pos;
-            }
 
             void GetNext() {
-                if (currentPos < tokens.size()-1) {
-                    current = tokens[++currentPos];
-                    if (currentPos < tokens.size()-1)
-                        lookAhead = tokens[currentPos+1];
-                    else lookAhead = Token(Token::EOL, 0, "");
-                }
+                if (currentPos < tokens.size()-1) ++currentPos;
             }
-        public:
-            std::shared_ptr<Node> ParseIndices() {
-                BacktrackingRAII backtracking(*this);
-
-                if (current.IsIndices()) {
-                    backtracking.CancelBacktracking();
-
-                    auto result = std::make_shared<IndicesNode>(current.GetContent());
-
-                    // Move cursor
-                    GetNext();
-
-                    return std::move(result);
-                }
-
-                return nullptr;
-            }
-
-            std::shared_ptr<Node> ParseString() {
-                BacktrackingRAII backtracking(*this);
-
-                if (current.IsString()) {
-                    backtracking.CancelBacktracking();
-
-                    auto result = std::make_shared<StringNode>(current.GetContent());
-
-                    // Move cursor
-                    GetNext();
-
-                    return std::move(result);
-                }
-
-                return nullptr;
-            }
-
-            std::shared_ptr<Node> ParseNumeric() {
-                BacktrackingRAII backtracking(*this);
-
-                if (current.IsNumeric()) {
-                    backtracking.CancelBacktracking();
-
-                    auto result = std::make_shared<NumericNode>(current.GetContent());
-
-                    // Move cursor
-                    GetNext();
-
-                    return std::move(result);
-                }
-
-                // Move cursor
-
-                return nullptr;
-            }
-
-            std::shared_ptr<LiteralNode> ParseLiteral() {
-                BacktrackingRAII backtracking (*this);
-
-                // If not a literal, return
-                if (!current.IsLiteral()) return nullptr;
-
-                // Go to the next position
-                backtracking.CancelBacktracking();
-
-                // Make result
-                auto result = std::make_shared<LiteralNode>(current.GetContent());
-
-                // Move cursor
-                GetNext();
+        private:
+            const Token& Current() const { return tokens[currentPos]; }
 
-                return std::move(result);
+            const Token& LookAhead() const {
+                return (currentPos < tokens.size()-1) ? tokens[currentPos+1] : tokens.back();
             }
 
             /**
-                \brief Parses a primary expression
-
-                Parses a primary expression
-
-                    primary ::=
-                            | literal
-                            | string
-                            | indices
-                            | previous
-                            | numeric
-                            ;
+                \brief Binding power of a binary operator, zero for any other token
              */
-            std::shared_ptr<Node> ParsePrimary() {
-                BacktrackingRAII backtracking(*this);
-
-                auto literal = ParseLiteral();
-                if (literal) {
-                    backtracking.CancelBacktracking();
-                    return std::move(literal);
-                }
-
-                auto primary = ParseIndices();
-                if (primary) {
-                    backtracking.CancelBacktracking();
-                    return std::move(primary);
-                }
-
-                primary = ParseString();
-                if (primary) {
-                    backtracking.CancelBacktracking();
-                    return std::move(primary);
-                }
-
-                primary = ParseNumeric();
-                if (primary) {
-                    backtracking.CancelBacktracking();
-                    return std::move(primary);
-                }
-
-                if (current.IsPrevious()) {
-                    backtracking.CancelBacktracking();
-
-                    auto result = std::make_shared<PreviousNode>();
-                    GetNext();
-
-                    return std::move(result);
-                }
-
-                return nullptr;
+            static unsigned GetBindingPower(const Token& token) {
+                if (token.IsPlus() || token.IsMinus()) return 1;
+                if (token.IsAsterisk()) return 2;
+                return 0;
             }
-
+        public:
             /**
-                \brief Parses a list of arguments
-
-                Parses a list of arguments.
+                \brief Parses a prefix expression
 
-                    arguments ::=
-                            | rhs_expression ',' arguments
-                            | rhs_expression
-                            ;
+                This is everything that can appear as an operand of a
+                binary operator.
              */
-            std::shared_ptr<ArgumentsNode> ParseArguments() {
-                BacktrackingRAII backtracking(*this);
-
-                // Parse for the first argument
-                auto arg = ParseRHSExpression();
+            std::shared_ptr<Node> ParsePrefix() {
+                auto& token = Current();
 
-                if (current.IsComma()) {
-                    // Go to next token
+                if (token.IsMinus()) {
                     GetNext();
 
-                    // Parse for the arguments
-                    auto args = ParseArguments();
-                    if (!args) return nullptr;
-
-                    // Insert the argument at the beginning
-                    args->Insert(std::move(arg));
-
-                    backtracking.CancelBacktracking();
-
-                    return std::move(args);
-                }
-
-                auto args = std::make_shared<ArgumentsNode>();
-                args->Insert(std::move(arg));
-
-                backtracking.CancelBacktracking();
-
-                return std::move(args);
-            }
-
-            /**
-                \brief Parses a function call expression
-
-                Parses a call expression. This can either be a function call
-                or a reference to a variable
-
-                    call_expression ::=
-                            | literal '(' arguments ')'
-                            | primary
-                            ;
-             */
-            std::shared_ptr<Node> ParseCallExpression() {
-                BacktrackingRAII backtracking(*this);
+                    auto expression = ParsePrefix();
+                    if (!expression) return nullptr;
 
-                // If the current token is a literal parse for a function call
-                if (current.IsLiteral()) {
-                    auto identifier = ParseLiteral();
+                    return std::make_shared<NegationNode>(std::move(expression));
+                } else if (token.IsLeftBracket()) {
+                    GetNext();
 
-                    if (!identifier) return nullptr;
+                    auto expression = ParseRHSExpression();
+                    if (!expression || !Current().IsRightBracket()) return nullptr;
 
-                    if (!current.IsLeftBracket()) {
-                        // Finally cancel backtracking
-                        backtracking.CancelBacktracking();
+                    GetNext();
+                    return expression;
+                } else if (token.IsLiteral()) {
+                    auto identifier = std::make_shared<LiteralNode>(token.GetContent());
+                    GetNext();
 
-                        return std::move(identifier);
-                    }
+                    if (!Current().IsLeftBracket()) return std::move(identifier);
 
-                    // Move parser to next token
                     GetNext();
 
                     auto arguments = ParseArguments();
+                    if (!arguments || !Current().IsRightBracket()) return nullptr;
 
-                    if (!arguments || !current.IsRightBracket()) return nullptr;
-
-                    // Finally cancel backtracking
-                    backtracking.CancelBacktracking();
-
-                    // Go to the next token
                     GetNext();
-
                     return std::make_shared<CommandNode>(std::move(identifier), std::move(arguments));
                 }
 
-                // Parse for a primary expression
-                auto primary = ParsePrimary();
-                if (!primary) return nullptr;
-
-                // Cancel backtracking
-                backtracking.CancelBacktracking();
-
-                return std::move(primary);
-            }
-
-            /**
-                \brief Parses an expression in brackets
-
-                Parses an expression in brackets
-
-                    bracket_expression ::=
-                            | '(' rhs_expression ')'
-                            | '-' bracket_expression
-                            | call_expression
-                            ;
-             */
-            std::shared_ptr<Node> ParseBracketExpression() {
-                BacktrackingRAII backtracking(*this);
-
-                // If left bracket
-                if (current.IsLeftBracket()) {
-                    GetNext();
-
-                    // Parse for an expression
-                    auto expression = ParseRHSExpression();
-                    if (!expression) return nullptr;
-
-                    if (!current.IsRightBracket()) return nullptr;
+                std::shared_ptr<Node> result;
 
-                    // Stop backtracking
-                    backtracking.CancelBacktracking();
-
-                    return std::move(expression);
-                } else if (current.IsMinus()) {
-                    GetNext();
-
-                    // Parse the bracket expression
-                    auto expression = ParseBracketExpression();
-
-                    // Stop backtracking
-                    backtracking.CancelBacktracking();
-
-                    return std::make_shared<NegationNode>(std::move(expression));
+                if (token.IsIndices()) {
+                    result = std::make_shared<IndicesNode>(token.GetContent());
+                } else if (token.IsString()) {
+                    result = std::make_shared<StringNode>(token.GetContent());
+                } else if (token.IsNumeric()) {
+                    result = std::make_shared<NumericNode>(token.GetContent());
+                } else if (token.IsPrevious()) {
+                    result = std::make_shared<PreviousNode>();
                 } else {
-                    auto expression = ParseCallExpression();
-
-                    if (!expression) return nullptr;
-
-                    // Stop backtracking
-                    backtracking.CancelBacktracking();
-
-                    return std::move(expression);
+                    return nullptr;
                 }
+
+                GetNext();
+                return result;
             }
 
             /**
-                \brief Parses a multiplicative expression
-
-                Parses a multiplicative expression.
+                \brief Parses a list of arguments
 
-                    multiplicative_expression ::=
-                                | bracket_expression '*' multiplicative_expression
-                                | bracket_expression
-                                ;
+                The list may be empty, e.g. `MemoryStats()`.
              */
-            std::shared_ptr<Node> ParseMultiplicativeExpression() {
-                BacktrackingRAII backtracking(*this);
+            std::shared_ptr<ArgumentsNode> ParseArguments() {
+                auto arguments = std::make_shared<ArgumentsNode>();
+                if (Current().IsRightBracket()) return arguments;
 
-                auto bracket = ParseBracketExpression();
-                if (!bracket) return nullptr;
+                while (true) {
+                    auto arg = ParseRHSExpression();
+                    if (!arg) return nullptr;
 
-                backtracking.CancelBacktracking();
+                    arguments->Append(std::move(arg));
 
-                if (current.IsAsterisk()) {
-                    // Move to next token
+                    if (!Current().IsComma()) return arguments;
                     GetNext();
-
-                    // Parse the next term
-                    auto rhs = ParseMultiplicativeExpression();
-                    if (!rhs) {
-                        backtracking.DoBacktrack();
-                        return nullptr;
-                    }
-
-                    return std::make_shared<BinaryNode>(std::move(bracket), std::move(rhs), '*');
-                } else {
-                    return std::move(bracket);
                 }
             }
 
             /**
                 \brief Parses a rhs expression
 
-                Parses a right hand side expression. This is either a sum of
-                objects or a multiplicative expression.
-
-                    rhs_expression ::=
-                                | multiplicative_expression ('+' | '-') rhs_expression
-                                | multiplicative_expression
-                                ;
+                Parses the binary operators with at least the given binding
+                power by precedence climbing.
              */
-            std::shared_ptr<Node> ParseRHSExpression() {
-                BacktrackingRAII backtracking(*this);
-
-                auto multiplicative = ParseMultiplicativeExpression();
-                if (multiplicative == nullptr) return nullptr;
+            std::shared_ptr<Node> ParseRHSExpression(unsigned minimalPower = 1) {
+                auto lhs = ParsePrefix();
+                if (!lhs) return nullptr;
 
-                // Cancel backtracking
-                backtracking.CancelBacktracking();
-
-                // If it is a position
-                if (current.IsMinus() || current.IsPlus()) {
-                    // Get the operation
-                    char op = (current.IsPlus()) ? '+' : '-';
-
-                    // Move to next token
+                unsigned power;
+                while ((power = GetBindingPower(Current())) >= minimalPower && power > 0) {
+                    char op = Current().IsPlus() ? '+' : (Current().IsMinus() ? '-' : '*');
                     GetNext();
 
-                    // Parse the second part
-                    auto other = ParseRHSExpression();
-
-                    // If this was not a rhs expression, move back
-                    if (other == nullptr) {
-                        backtracking.DoBacktrack();
-                        return nullptr;
-                    }
+                    // Left associative, i.e. the right side only takes stronger operators
+                    auto rhs = ParseRHSExpression(power + 1);
+                    if (!rhs) return nullptr;
 
-                    // Build the binary operation node
-                    return std::make_shared<BinaryNode>(std::move(multiplicative), std::move(other), op);
-                } else {
-                    return std::move(multiplicative);
+                    lhs = std::make_shared<BinaryNode>(std::move(lhs), std::move(rhs), op);
                 }
+
+                return lhs;
             }
 
             /**
                 Parses an assignment
-
                     assignment ::= literal '=' rhs_expression
              */
             std::shared_ptr<AssignmentNode> ParseAssignment() {
-                BacktrackingRAII backtracking(*this);
+                auto identifier = std::make_shared<LiteralNode>(Current().GetContent());
 
-                auto identifier = ParseLiteral();
-                if (identifier == nullptr) return nullptr;
-
-                if (!current.IsAssignment()) return nullptr;
+                // Skip the literal and the `=`
+                GetNext();
                 GetNext();
 
                 auto expression = ParseRHSExpression();
                 if (expression == nullptr) return nullptr;
 
-                // Cancel backtracking
-                backtracking.CancelBacktracking();
-
                 return std::make_shared<AssignmentNode>(std::move(identifier), std::move(expression));
             }
 
             /**
                 \brief Parse an expression
 
-                An expression is either an assignment or a rhs expression
-
-                expression ::=
-                        | assignment
-                        | rhs_expression
-                        ;
+                An expression is either an assignment or a rhs expression,
+                which is decided by the token after the first one.
              */
             std::shared_ptr<Node> ParseExpression() {
-                BacktrackingRAII backtrack(*this);
-
-                // Parse an assignment first
-                auto node = ParseAssignment();
-                if (node != nullptr) {
-                    backtrack.CancelBacktracking();
-                    return std::move(node);
-                }
-
-                // Parse a rhs node otherwise
-                auto rhs = ParseRHSExpression();
-                if (rhs != nullptr) {
-                    backtrack.CancelBacktracking();
-                    return std::move(rhs);
+                if (Current().IsLiteral() && LookAhead().IsAssignment()) {
+                    return ParseAssignment();
                 }
 
-                // No expression found, return nullptr
-                return nullptr;
+                return ParseRHSExpression();
             }
         public:
             std::shared_ptr<Node> Parse(const std::string& code) {
+                if (auto document = ParseCache::Instance()->Get(code)) {
+                    return document;
+                }
+
                 this->text = code;
                 tokens.clear();
                 currentPos = 0;
 
                 // Lexalize the input
-                Lexalize(code);
+                Lexalize(text);
 
-                if (tokens.size() < 1) {
+                if (tokens.size() < 2) {
                     return nullptr;
                 }
 
-                current = tokens[0];
-                if (tokens.size() > 1)
-                    lookAhead = tokens[1];
-                else lookAhead = Token(Token::EOL, 0, "");
+                auto document = ParseExpression();
 
-                std::shared_ptr<Node> document;
+                // The whole line has to be consumed
+                if (document == nullptr || !Current().IsEndOfLine()) {
+                    return nullptr;
+                }
+
+                ParseCache::Instance()->Insert(code, document);
+
+                return document;
+            }
+        private:
+            enum CharacterClass {
+                LETTER,
+                DIGIT,
+                SPACE,
+                SYMBOL,
+                DELIMITER,
+                COMMENT
+            };
+
+            static CharacterClass Classify(char c) {
+                static const std::vector<CharacterClass> classes = []() {
+                    std::vector<CharacterClass> classes (256, LETTER);
 
-                document = ParseExpression();
+                    for (char c = '0'; c <= '9'; ++c) classes[static_cast<unsigned char>(c)] = DIGIT;
+                    for (char c : { ' ', '\t', '\r', '\n' }) classes[static_cast<unsigned char>(c)] = SPACE;
+                    for (char c : { '=', '(', ')', '%', '+', '-', '*', ',' }) classes[static_cast<unsigned char>(c)] = SYMBOL;
+                    for (char c : { '{', '"' }) classes[static_cast<unsigned char>(c)] = DELIMITER;
+                    classes['#'] = COMMENT;
+
+                    return classes;
+                }();
+
+                return classes[static_cast<unsigned char>(c)];
+            }
 
-                return std::move(document);
+            static Token::Type GetSymbolType(char c) {
+                switch (c) {
+                    case '=': return Token::ASSIGNMENT;
+                    case '(': return Token::LBRACKET;
+                    case ')': return Token::RBRACKET;
+                    case '%': return Token::PREVIOUS;
+                    case '+': return Token::PLUS;
+                    case '-': return Token::MINUS;
+                    case '*': return Token::ASTERISK;
+                    default: return Token::COMMA;
+                }
             }
         private:
             std::vector<Token> tokens;
             std::string text;
-
             unsigned currentPos;
-            Token current;
-            Token lookAhead;
         };
 
 
@@ -992,16 +731,6 @@ namespace Construction {
             IMPLEMENTATION
          **************************************************************************************************************/
 
-        BacktrackingRAII::BacktrackingRAII(Parser& parser) : parser(parser) {
-                position = parser.GetPosition();
-        }
-
-        BacktrackingRAII::~BacktrackingRAII() {
-            if (backtrack) {
-                parser.GoToPosition(position);
-            }
-        }
-
         std::string CommandNode::ToString() const {
             std::stringstream ss;
             ss << "(" << name << " " << identifier->ToString() << " " << arguments->ToString() << ")";
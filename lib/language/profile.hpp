@@ -0,0 +1,54 @@
+#pragma once
+
+#include <iostream>
+
+#include <language/command.hpp>
+#include <language/argument.hpp>
+
+#include <common/profiler.hpp>
+#include <tensor/expression.hpp>
+
+using Construction::Tensor::Expression;
+
+namespace Construction {
+    namespace Language {
+
+        /**
+            \class ProfileCommand
+
+            Prints the timings of the profiler per call path. If the
+            profiler was not running yet, it is started and the report
+            is available on the next call.
+         */
+        CLI_COMMAND(Profile)
+            std::string Help() const {
+                return "Profile()";
+            }
+
+            virtual bool Cachable() const override {
+                return false;
+            }
+
+            // Prints the profile of the statements before
+            virtual bool HasSideEffects() const override {
+                return true;
+            }
+
+            Expression Execute() const {
+                if (!Common::Profiler::IsEnabled()) {
+                    Common::Profiler::Enable();
+                    std::cout << "Started the profiler, call Profile() again to see the timings" << std::endl;
+
+                    return Expression::Void();
+                }
+
+                Common::Profiler::Instance()->Print(std::cout);
+
+                return Expression::Void();
+            }
+        };
+
+        REGISTER_COMMAND(Profile);
+
+    }
+}
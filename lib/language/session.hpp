@@ -1,10 +1,14 @@
 #pragma once
 
 #include <string>
+#include <algorithm>
 #include <sstream>
 #include <map>
+#include <set>
 #include <fstream>
 #include <mutex>
+#include <cstdio>
+#include <cstdint>
 
 #include <common/singleton.hpp>
 #include <common/error.hpp>
@@ -12,6 +16,8 @@
 
 #include <tensor/expression.hpp>
 #include <language/notebook.hpp>
+#include <language/thunk.hpp>
+#include <language/journal.hpp>
 
 #include <language/command.hpp>
 #include <language/argument.hpp>
@@ -35,22 +41,105 @@ namespace Construction {
 
         class Session : public Singleton<Session> {
         public:
-            Session() : current(Expression::Void()) { }
+            typedef std::map<std::string, std::shared_ptr<Thunk>>   Bindings;
+
+            /**
+                \brief The current expression `%` and the command that created it
+
+                In the lazy mode the current expression may still be a thunk,
+                which is only forced by GetCurrent.
+             */
+            struct State {
+                Expression current = Expression::Void();
+                std::string lastCmd;
+                std::shared_ptr<Thunk> deferred;
+            };
+
+            /**
+                \class Scope
+
+                \brief Private current expression of a statement
+
+                While a scope exists, the state of the current expression of
+                the creating thread is taken from the scope instead of the
+                session. Hence statements of a script can run concurrently,
+                each with its own `%`. Scopes on the same thread are nested,
+                e.g. if a worker executes another statement while it waits
+                for its own tasks.
+
+                The bindings of a scope shadow the variables of the session.
+                A thunk uses them to see the variables as they were when it
+                was created.
+             */
+            class Scope {
+            public:
+                Scope(const State& state, const Bindings& bindings = Bindings()) : state(state), bindings(bindings), previous(Top()) {
+                    Top() = this;
+                }
+
+                ~Scope() {
+                    Top() = previous;
+                }
+
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+            public:
+                const State& GetState() const { return state; }
+            private:
+                friend class Session;
+
+                static Scope*& Top() {
+                    static thread_local Scope* top = nullptr;
+                    return top;
+                }
+
+                std::shared_ptr<Thunk> Find(const std::string& name) const {
+                    auto it = bindings.find(name);
+                    return (it != bindings.end()) ? it->second : nullptr;
+                }
+            private:
+                State state;
+                Bindings bindings;
+                Scope* previous;
+            };
+        public:
+            Session() { }
         public:
-            Expression GetCurrent() const {
-                Expression result;
+            /**
+                \brief The current expression, a deferred one is forced
+             */
+            Expression GetCurrent() {
+                std::shared_ptr<Thunk> deferred;
 
                 // Scope based locking
                 {
                     std::unique_lock<std::mutex> lock(mutex);
-                    result = current;
+
+                    auto& state = GetCurrentState();
+                    if (!state.deferred) return state.current;
+
+                    deferred = state.deferred;
                 }
 
-                return result;
+                auto value = deferred->Force();
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                // Memoize unless the current expression changed in the meantime
+                auto& state = GetCurrentState();
+                if (state.deferred == deferred) {
+                    state.current = value;
+                    state.deferred = nullptr;
+
+                    TouchCurrent();
+                }
+
+                return value;
             }
 
             std::string GetLastCommandString() const {
-                return lastCmd;
+                std::unique_lock<std::mutex> lock(mutex);
+                return GetCurrentState().lastCmd;
             }
 
             Notebook& GetNotebook() { return notebook; }
@@ -58,8 +147,41 @@ namespace Construction {
             void SetCurrent(const std::string& cmd, const Expression& tensors) {
                 std::unique_lock<std::mutex> lock(mutex);
 
-                lastCmd = cmd;
-                current = tensors;
+                auto& state = GetCurrentState();
+                state.lastCmd = cmd;
+                state.current = tensors;
+                state.deferred = nullptr;
+
+                TouchCurrent();
+            }
+
+            /**
+                \brief Set the current expression to a value that is calculated on first use
+             */
+            void SetCurrent(const std::string& cmd, const std::shared_ptr<Thunk>& thunk) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                auto& state = GetCurrentState();
+                state.lastCmd = cmd;
+                state.current = Expression::Void();
+                state.deferred = thunk;
+
+                TouchCurrent();
+            }
+
+            /**
+                \brief Copy of the state of the current expression without forcing it
+             */
+            State GetState() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return GetCurrentState();
+            }
+
+            void SetState(const State& state) {
+                std::unique_lock<std::mutex> lock(mutex);
+                GetCurrentState() = state;
+
+                TouchCurrent();
             }
 
             /*Expression& Get(const std::string& name) {
@@ -67,62 +189,424 @@ namespace Construction {
             }*/
 
             bool Contains(const std::string& name) const {
+                if (auto scope = Scope::Top()) {
+                    if (scope->Find(name)) return true;
+                }
+
                 std::unique_lock<std::mutex> lock(mutex);
-                auto it = memory.find(name);
-                return it != memory.end();
+                return memory.find(name) != memory.end() || thunks.find(name) != thunks.end();
             }
 
             std::vector<std::string> Variables() const {
+                std::unique_lock<std::mutex> lock(mutex);
+
                 std::vector<std::string> result;
 
                 for (auto& kv : memory) {
                     result.push_back(kv.first);
                 }
 
+                for (auto& kv : thunks) {
+                    result.push_back(kv.first);
+                }
+
+                std::sort(result.begin(), result.end());
+
                 return result;
             }
 
-            Expression Get(const std::string& name) const {
+            /**
+                \brief The value of a variable, a lazy one is forced and memoized
+             */
+            Expression Get(const std::string& name) {
+                std::shared_ptr<Thunk> thunk;
+
+                if (auto scope = Scope::Top()) {
+                    thunk = scope->Find(name);
+                    if (thunk) return thunk->Force();
+                }
+
+                // Scope based locking
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+
+                    auto it = memory.find(name);
+                    if (it != memory.end()) return it->second;
+
+                    auto _it = thunks.find(name);
+                    if (_it == thunks.end()) return Expression::Void();
+
+                    thunk = _it->second;
+                }
+
+                auto value = thunk->Force();
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                // Memoize unless the variable was reassigned in the meantime
+                auto it = thunks.find(name);
+                if (it != thunks.end() && it->second == thunk) {
+                    memory[name] = value;
+                    thunks.erase(it);
+                    dirty.insert(name);
+                }
+
+                return value;
+            }
+
+            /**
+                \brief The variable as a thunk, without forcing it
+
+                Used to capture the inputs of a lazy assignment.
+
+                \returns nullptr if the variable does not exist
+             */
+            std::shared_ptr<Thunk> GetThunk(const std::string& name) const {
+                if (auto scope = Scope::Top()) {
+                    if (auto thunk = scope->Find(name)) return thunk;
+                }
+
                 std::unique_lock<std::mutex> lock(mutex);
 
+                auto _it = thunks.find(name);
+                if (_it != thunks.end()) return _it->second;
+
                 auto it = memory.find(name);
+                if (it == memory.end()) return nullptr;
 
-                if (it == memory.end()) {
-                    return Expression::Void();
-                } else {
-                    return it->second;
-                }
+                auto definition = definitions.find(name);
+                return Thunk::FromValue(it->second, (definition != definitions.end()) ? definition->second : "");
             }
 
             void Set(const std::string& name, const Expression& expression) {
                 std::unique_lock<std::mutex> lock(mutex);
 
                 memory[name] = expression;
+                thunks.erase(name);
+                definitions.erase(name);
+                dirty.insert(name);
             }
 
             void Set(const std::string& name, Expression&& expression) {
                 std::unique_lock<std::mutex> lock(mutex);
 
                 memory[name] = std::move(expression);
+                thunks.erase(name);
+                definitions.erase(name);
+                dirty.insert(name);
             }
 
-            void TurnCurrentIntoAVariable(const std::string& name) {
+            /**
+                \brief Set a variable to the result of a command
+
+                The definition is the key of the command in the CommandCache.
+                Every other way to change the variable forgets the definition,
+                s.t. a command using the variable is only looked up in the
+                cache as long as the variable still holds this result.
+             */
+            void Set(const std::string& name, const Expression& expression, const std::string& definition) {
                 std::unique_lock<std::mutex> lock(mutex);
 
-                auto it = memory.find(name);
-                if (it == memory.end()) {
-                    memory.insert({ name, current });
-                } else {
-                    it->second = current;
+                memory[name] = expression;
+                thunks.erase(name);
+                definitions[name] = definition;
+                dirty.insert(name);
+            }
+
+            /**
+                \brief Set a variable to a value that is calculated on first use
+             */
+            void Set(const std::string& name, const std::shared_ptr<Thunk>& thunk) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                memory.erase(name);
+                thunks[name] = thunk;
+                dirty.insert(name);
+
+                if (thunk->GetDefinition().empty()) definitions.erase(name);
+                else definitions[name] = thunk->GetDefinition();
+            }
+
+            /**
+                \brief The definition of a variable or an empty string if it is unknown
+             */
+            std::string GetDefinition(const std::string& name) const {
+                if (auto scope = Scope::Top()) {
+                    if (auto thunk = scope->Find(name)) return thunk->GetDefinition();
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                auto it = definitions.find(name);
+                return (it != definitions.end()) ? it->second : "";
+            }
+
+            /**
+                \brief Calculate all the lazy variables and the current expression
+             */
+            void Force() {
+                GetCurrent();
+
+                for (auto& name : Variables()) {
+                    Get(name);
                 }
             }
 
+            void TurnCurrentIntoAVariable(const std::string& name) {
+                auto value = GetCurrent();
+
+                std::unique_lock<std::mutex> lock(mutex);
+
+                memory[name] = value;
+                thunks.erase(name);
+                dirty.insert(name);
+
+                // Keep the command that created the current expression
+                if (this->state.lastCmd.empty()) definitions.erase(name);
+                else definitions[name] = this->state.lastCmd;
+            }
+
             Expression& operator[](const std::string& name) {
+                // Force a lazy variable, the caller may change it
+                if (thunks.find(name) != thunks.end()) Get(name);
+
+                definitions.erase(name);
+                dirty.insert(name);
                 return memory[name];
             }
 
-            size_t Size() const { return memory.size(); }
+            size_t Size() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return memory.size() + thunks.size();
+            }
+
+            /**
+                \brief Estimate the memory held by the variables and the current result
+
+                Lazy variables that are not calculated yet are not counted.
+             */
+            size_t MemoryFootprint() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return Common::HeapSize(memory) + state.current.DeepSize();
+            }
         public:
+            /**
+                \brief Write the changes since the last checkpoint into the crash file
+
+                The crash file is a snapshot of the whole session with a journal
+                next to it (`<filename>.journal`). A checkpoint only appends the
+                new lines of the notebook, the current expression if it changed
+                and the changed variables to the journal. Once the journal is
+                larger than the snapshot, both are compacted into a new snapshot,
+                hence the cost of all checkpoints stays linear in the changes.
+
+                Lazy variables that are not calculated yet are written as erased,
+                like in SaveToFile.
+             */
+            void Checkpoint(const std::string& filename) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                std::stringstream os;
+
+                // Compact into a new snapshot, also if the old one was deleted
+                if (filename != checkpointFile || journalSize > std::max(snapshotSize, minimalJournalSize) || access(filename.c_str(), F_OK) != 0) {
+                    Journal::WriteHeader(os, Journal::SNAPSHOT, ++generation);
+
+                    for (auto& line : notebook) {
+                        Journal::Write(os, Journal::Record::LINE, line);
+                    }
+
+                    Journal::Write(os, Journal::Record::CURRENT, "", Serialize(state.current));
+
+                    for (auto& pair : memory) {
+                        Journal::Write(os, Journal::Record::VARIABLE, pair.first, Serialize(pair.second));
+                    }
+
+                    // Replace the snapshot at once
+                    {
+                        std::ofstream file (filename + ".tmp", std::ios::binary | std::ios::trunc);
+                        file << os.rdbuf();
+                    }
+                    std::rename((filename + ".tmp").c_str(), filename.c_str());
+
+                    // Start a new journal
+                    {
+                        std::ofstream file (filename + ".journal", std::ios::binary | std::ios::trunc);
+                        Journal::WriteHeader(file, Journal::JOURNAL, generation);
+                    }
+
+                    checkpointFile = filename;
+                    snapshotSize = static_cast<size_t>(os.tellp());
+                    journalSize = Journal::HeaderSize();
+                } else {
+                    for (size_t i=journaledLines; i<notebook.Size(); ++i) {
+                        Journal::Write(os, Journal::Record::LINE, notebook[i]);
+                    }
+
+                    if (currentDirty) {
+                        Journal::Write(os, Journal::Record::CURRENT, "", Serialize(state.current));
+                    }
+
+                    for (auto& name : dirty) {
+                        auto it = memory.find(name);
+
+                        if (it == memory.end()) {
+                            Journal::Write(os, Journal::Record::ERASE, name);
+                        } else {
+                            Journal::Write(os, Journal::Record::VARIABLE, name, Serialize(it->second));
+                        }
+                    }
+
+                    if (os.tellp() > 0) {
+                        std::ofstream file (filename + ".journal", std::ios::binary | std::ios::app);
+                        file << os.rdbuf();
+
+                        journalSize += static_cast<size_t>(os.tellp());
+                    }
+                }
+
+                journaledLines = notebook.Size();
+                currentDirty = false;
+                dirty.clear();
+            }
+
+            /**
+                \brief Restore the session from a crash file written by Checkpoint
+
+                The snapshot and the journal are mapped into memory and the
+                expressions are deserialized right from the mapping. Afterwards
+                the checkpoints continue the same journal, without a partially
+                written record at its end.
+
+                \throws CannotOpenSessionException
+             */
+            void Restore(const std::string& filename) {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                MappedFile snapshot (filename);
+                MappedFile journal (filename + ".journal");
+
+                uint64_t snapshotGeneration, journalGeneration;
+                if (!Journal::ReadHeader(snapshot, Journal::SNAPSHOT, snapshotGeneration)) {
+                    throw CannotOpenSessionException();
+                }
+
+                // Clear
+                notebook.Clear();
+                state = State();
+                memory.clear();
+                thunks.clear();
+                definitions.clear();
+
+                auto apply = [&](Journal::Record type, const std::string& name, const char* data, size_t size) {
+                    switch (type) {
+                        case Journal::Record::LINE:
+                            notebook.Append(name);
+                            break;
+
+                        case Journal::Record::CURRENT:
+                            state.current = Deserialize(data, size);
+                            break;
+
+                        case Journal::Record::VARIABLE:
+                            memory[name] = Deserialize(data, size);
+                            break;
+
+                        case Journal::Record::ERASE:
+                            memory.erase(name);
+                            break;
+
+                        default:
+                            throw CannotOpenSessionException();
+                    }
+                };
+
+                Journal::ReadRecords(snapshot, apply);
+
+                // A journal of another generation belongs to an older snapshot
+                bool appendable = true;
+                journalSize = Journal::HeaderSize();
+                if (Journal::ReadHeader(journal, Journal::JOURNAL, journalGeneration) && journalGeneration == snapshotGeneration) {
+                    journalSize = Journal::ReadRecords(journal, apply);
+
+                    // Cut off a record the crash interrupted, otherwise the
+                    // next checkpoint would append behind it. If that fails,
+                    // the next checkpoint compacts into a new snapshot instead
+                    if (journalSize < journal.Size() && truncate((filename + ".journal").c_str(), journalSize) != 0) {
+                        appendable = false;
+                    }
+                }
+
+                checkpointFile = appendable ? filename : "";
+                generation = snapshotGeneration;
+                snapshotSize = snapshot.Size();
+                journaledLines = notebook.Size();
+                currentDirty = false;
+                dirty.clear();
+
+                // Print the notebook and the most recent result
+                for (auto& line : notebook) {
+                    std::cout << "> " << line << std::endl;
+                }
+
+                std::stringstream ss;
+                ss << state.current.ToString();
+                std::string line;
+
+                std::cout << "\033[" << state.current.GetColorCode() << "m";
+
+                while (std::getline(ss, line)) {
+                    std::cout << "   " << line << std::endl;
+                }
+
+                std::cout << "\033[0m";
+            }
+
+            /**
+                \brief Delete the snapshot and the journal of a crash file
+             */
+            static void RemoveCheckpoint(const std::string& filename) {
+                std::remove(filename.c_str());
+                std::remove((filename + ".journal").c_str());
+            }
+        private:
+            static std::string Serialize(const Expression& expression) {
+                std::stringstream ss;
+                expression.Serialize(ss);
+                return ss.str();
+            }
+
+            static Expression Deserialize(const char* data, size_t size) {
+                MemoryStreamBuffer buffer (data, size);
+                std::istream is (&buffer);
+
+                auto expression = Expression::Deserialize(is);
+                if (!expression) throw CannotOpenSessionException();
+
+                return *expression;
+            }
+
+            void TouchCurrent() {
+                if (!Scope::Top()) currentDirty = true;
+            }
+
+            State& GetCurrentState() {
+                if (auto scope = Scope::Top()) return scope->state;
+                return state;
+            }
+
+            const State& GetCurrentState() const {
+                if (auto scope = Scope::Top()) return scope->state;
+                return state;
+            }
+        public:
+            /**
+                \brief Store the notebook, the current expression and the variables
+
+                Lazy variables that are not calculated yet are skipped, their
+                lines are still part of the notebook. Call Force() before to
+                store everything.
+             */
             void SaveToFile(const std::string& filename) const {
                 std::unique_lock<std::mutex> lock(mutex);
 
@@ -148,7 +632,7 @@ namespace Construction {
                     // Store last command string
                     {
                         std::stringstream ss;
-                        current.Serialize(ss);
+                        state.current.Serialize(ss);
 
                         size_t size = ss.str().size();
                         os.write(reinterpret_cast<const char*>(&size), sizeof(size));
@@ -213,8 +697,13 @@ namespace Construction {
 
                 // Clear
                 notebook.Clear();
-                current = Expression::Void();
+                state = State();
                 memory.clear();
+                thunks.clear();
+                definitions.clear();
+
+                // The next checkpoint writes a new snapshot
+                checkpointFile.clear();
 
                 // Decompress
                 {
@@ -263,18 +752,18 @@ namespace Construction {
 
                         if (!expression) throw CannotOpenSessionException();
 
-                        current = *expression;
+                        state.current = *expression;
                     }
                 }
 
                 // Print the most recent result
                 {
                     std::stringstream ss;
-                    ss << current.ToString();
+                    ss << state.current.ToString();
                     std::string line;
 
                     // Change the output color
-                    std::cout << "\033[" << current.GetColorCode() << "m";
+                    std::cout << "\033[" << state.current.GetColorCode() << "m";
 
                     // Shift the output by three characters
                     while (std::getline(ss, line)) {
@@ -334,9 +823,22 @@ namespace Construction {
             Notebook notebook;
 
             mutable std::mutex mutex;
-            std::string lastCmd;
-            Expression current;
+            State state;
             std::map<std::string, Expression> memory;
+            std::map<std::string, std::shared_ptr<Thunk>> thunks;
+            std::map<std::string, std::string> definitions;
+
+            // Changes since the last checkpoint
+            std::set<std::string> dirty;
+            bool currentDirty = false;
+            size_t journaledLines = 0;
+
+            // The crash file of the checkpoints
+            std::string checkpointFile;
+            uint64_t generation = 0;
+            size_t snapshotSize = 0;
+            size_t journalSize = 0;
+            size_t minimalJournalSize = 64 * 1024;
         };
 
         /**
@@ -349,8 +851,21 @@ namespace Construction {
                 return "SaveSession(<String>)";
             }
 
+            // Changes the session or the disk
+            virtual bool Cachable() const override {
+                return false;
+            }
+
+            // Writes the variables of the statements before
+            virtual bool HasSideEffects() const override {
+                return true;
+            }
+
             Expression Execute() const {
                 auto filename = GetString(0);
+
+                // Calculate the lazy variables to store them as well
+                Session::Instance()->Force();
                 Session::Instance()->SaveToFile(filename);
 
                 return Expression::Void();
@@ -373,6 +888,16 @@ namespace Construction {
                 return "LoadSession(<String>)";
             }
 
+            // Changes the session or the disk
+            virtual bool Cachable() const override {
+                return false;
+            }
+
+            // Replaces the variables
+            virtual bool HasSideEffects() const override {
+                return true;
+            }
+
             Expression Execute() const {
                 auto filename = GetString(0);
                 Session::Instance()->LoadFromFile(filename);
@@ -21,10 +21,6 @@ namespace Construction {
                 return "Symmetrize(<Tensors>, <Indices>, ...)";
             }
 
-            static bool Cachable() {
-                return false;
-            }
-
             std::string ToLaTeX(const std::vector<std::string>& args) const {
                 std::string output = "Symmetrize(";
 
@@ -57,10 +53,6 @@ namespace Construction {
                 return "AntiSymmetrize(<Tensors>, <Indices>, ...)";
             }
 
-            static bool Cachable() {
-                return false;
-            }
-
             std::string ToLaTeX(const std::vector<std::string>& args) const {
                 std::string output = "AntiSymmetrize(";
 
@@ -93,7 +85,7 @@ namespace Construction {
                 return "ExchangeSymmetrize(<Tensors>, <Indices>)";
             }
 
-            static bool Cachable() {
+            virtual bool Cachable() const override {
                 return true;
             }
 
@@ -124,7 +116,7 @@ namespace Construction {
                 return "BlockSymmetrize(<Tensors>, <Indices>, ...)";
             };
 
-            static bool Cachable() {
+            virtual bool Cachable() const override {
                 return true;
             }
 
@@ -159,7 +151,7 @@ namespace Construction {
                 return "IsSymmetric(<Tensors>, <Indices>)";
             }
 
-            static bool Cachable() {
+            virtual bool Cachable() const override {
                 return false;
             }
 
@@ -182,7 +174,7 @@ namespace Construction {
                 return "HasExchangeSymmetry(<Tensor>, <Indices>)";
             }
 
-            static bool Cachable() {
+            virtual bool Cachable() const override {
                 return false;
             }
 
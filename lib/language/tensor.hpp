@@ -208,7 +208,7 @@ namespace Construction {
                 return "Add(<Tensor>, <Tensor>...)";
             }
 
-            static bool Cachable() {
+            virtual bool Cachable() const override {
                 return false;
             }
 
@@ -252,7 +252,7 @@ namespace Construction {
                 return "Subtract(<Tensor>, <Tensor>...)";
             }
 
-            static bool Cachable() {
+            virtual bool Cachable() const override {
                 return false;
             }
 
@@ -294,7 +294,7 @@ namespace Construction {
                 return "Negate(<Tensor>)";
             }
 
-            static bool Cachable() {
+            virtual bool Cachable() const override {
                 return false;
             }
 
@@ -332,7 +332,7 @@ namespace Construction {
                 return args[1] + " * " + args[0];
             }
 
-            static bool Cachable() {
+            virtual bool Cachable() const override {
                 return false;
             }
 
@@ -364,7 +364,7 @@ namespace Construction {
                 return output;
             }
 
-            static bool Cachable() {
+            virtual bool Cachable() const override {
                 return false;
             }
 
@@ -388,7 +388,7 @@ namespace Construction {
                 return "Contract(<Tensor>, <Tensor>...)";
             }
 
-            static bool Cachable() {
+            virtual bool Cachable() const override {
                 return false;
             }
 
@@ -453,7 +453,7 @@ namespace Construction {
                 return "DegreesOfFreedom(<Tensors>)";
             }
 
-            static bool Cachable() {
+            virtual bool Cachable() const override {
                 return false;
             }
 
@@ -473,7 +473,7 @@ namespace Construction {
                 return "IsZero(<Tensor>)";
             }
 
-            static bool Cachable() {
+            virtual bool Cachable() const override {
                 return false;
             }
 
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <language/command.hpp>
+#include <language/argument.hpp>
+
+#include <common/task_pool.hpp>
+#include <equations/scheduler.hpp>
+#include <tensor/expression.hpp>
+
+using Construction::Tensor::Expression;
+
+namespace Construction {
+    namespace Language {
+
+        /**
+            \class ThreadsCommand
+
+            Sets the number of threads, which are shared by the global
+            executor and the workers of the Scheduler of the equations, see
+            Equations::SetNumberOfThreads. Zero means one thread per hardware
+            thread.
+         */
+        CLI_COMMAND(Threads)
+            std::string Help() const {
+                return "Threads(<Numeric>)";
+            }
+
+            virtual bool Cachable() const override {
+                return false;
+            }
+
+            // Recreates the pool the statements run on
+            virtual bool HasSideEffects() const override {
+                return true;
+            }
+
+            Expression Execute() const {
+                auto threads = GetNumeric(0).ToDouble();
+                if (threads < 0) threads = 0;
+
+                Equations::SetNumberOfThreads(static_cast<unsigned>(threads));
+
+                return Expression::Void();
+            }
+        };
+
+        REGISTER_COMMAND(Threads);
+        REGISTER_ARGUMENT(Threads, 0, ArgumentType::NUMERIC);
+
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <mutex>
+#include <memory>
+#include <functional>
+
+#include <tensor/expression.hpp>
+
+using Construction::Tensor::Expression;
+
+namespace Construction {
+    namespace Language {
+
+        /**
+            \class Thunk
+
+            \brief Value of a variable that is calculated on first use
+
+            In the lazy mode of the CLI an assignment stores a thunk instead
+            of its result. The function captures everything the expression
+            needs, i.e. the AST and the values of the variables it uses, s.t.
+            the result is the same as if it had been evaluated right away.
+            Force() calculates the value once and releases the captured
+            inputs, every later call returns the memoized value.
+
+            Example:
+                auto thunk = std::make_shared<Thunk>([]() {
+                    return Expression(...);
+                });
+
+                thunk->Force();
+         */
+        class Thunk {
+        public:
+            typedef std::function<Expression()>     Function;
+        public:
+            Thunk(Function fn, const std::string& definition = "") : fn(std::move(fn)), definition(definition) { }
+
+            /**
+                \brief A thunk that is already evaluated
+             */
+            static std::shared_ptr<Thunk> FromValue(const Expression& value, const std::string& definition = "") {
+                auto thunk = std::make_shared<Thunk>(nullptr, definition);
+                thunk->value = value;
+                return thunk;
+            }
+        public:
+            /**
+                \brief Calculate the value if this did not happen yet
+
+                If the calculation throws, the thunk stays unevaluated and
+                the next call tries again.
+             */
+            Expression Force() {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                if (fn) {
+                    value = fn();
+
+                    // Release the captured inputs
+                    fn = nullptr;
+                }
+
+                return value;
+            }
+
+            bool IsForced() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return !fn;
+            }
+
+            /**
+                \brief The key of the value in the CommandCache, see Session::GetDefinition
+             */
+            const std::string& GetDefinition() const { return definition; }
+        private:
+            Function fn;
+            Expression value;
+            std::string definition;
+
+            mutable std::mutex mutex;
+        };
+
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <ostream>
+#include <cstdlib>
+
+#include <server/protocol.hpp>
+
+namespace Construction {
+    namespace Server {
+
+        /**
+            \class Client
+
+            \brief Thin client of the construction server
+
+            Sends one request to the server and streams the answer, i.e. the
+            output of the job to `out` and the log, progress and errors to
+            `err`, until the job is done.
+
+            Example:
+                Client client ("construction.sock");
+                client.SetOption("parallel", "4");
+
+                int code = client.Submit(Message::Type::SOLVE, script, std::cout, std::cerr);
+         */
+        class Client {
+        public:
+            Client(const std::string& path) : path(path) { }
+        public:
+            void SetOption(const std::string& name, const std::string& value) {
+                options[name] = value;
+            }
+
+            /**
+                \brief Send the request and print the answer
+
+                \returns The exit code of the job, -1 if the server could not be reached
+             */
+            int Submit(Message::Type type, const std::string& payload, std::ostream& out, std::ostream& err) {
+                int fd = Connection::Connect(path);
+
+                if (fd < 0) {
+                    err << "Could not connect to the construction server at `" << path << "`" << std::endl;
+                    return -1;
+                }
+
+                Connection connection (fd);
+
+                for (auto& option : options) {
+                    connection.Send(Message::Type::OPTION, option.first + "=" + option.second);
+                }
+
+                if (!connection.Send(type, payload)) {
+                    err << "Could not send the request to the construction server" << std::endl;
+                    return -1;
+                }
+
+                Message message;
+                bool progress = false;
+
+                while (connection.Receive(message)) {
+                    // Clean the line of the progress
+                    if (progress && message.type != Message::Type::PROGRESS) {
+                        err << std::string(40, ' ') << "\r";
+                        progress = false;
+                    }
+
+                    switch (message.type) {
+                        case Message::Type::OUTPUT:
+                            out << message.payload << std::flush;
+                            break;
+
+                        case Message::Type::LOG:
+                            err << message.payload << std::flush;
+                            break;
+
+                        case Message::Type::QUEUED:
+                            err << "Queued: " << message.payload << std::endl;
+                            break;
+
+                        case Message::Type::PROGRESS:
+                            err << "  Progress: " << message.payload << "\r" << std::flush;
+                            progress = true;
+                            break;
+
+                        case Message::Type::ERROR:
+                            err << "\033[31m" << "Error: " << "\033[0m" << message.payload << std::endl;
+                            break;
+
+                        case Message::Type::DONE:
+                            return std::atoi(message.payload.c_str());
+
+                        default:
+                            break;
+                    }
+                }
+
+                err << "The construction server closed the connection" << std::endl;
+                return -1;
+            }
+        private:
+            std::string path;
+            std::map<std::string, std::string> options;
+        };
+
+    }
+}
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <sstream>
+#include <ostream>
+#include <streambuf>
+
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+namespace Construction {
+    namespace Server {
+
+        /**
+            \class Message
+
+            \brief A single frame of the construction server protocol
+
+            Every frame consists of a header line with the type and the length
+            of the payload, followed by the payload itself, e.g.
+
+                OUTPUT 12
+                Hello World!
+
+            The payload may contain newlines and arbitrary bytes. A client sends
+            any number of OPTION frames (`key=value`) followed by exactly one
+            request (SOLVE, COMMAND, STATUS or SHUTDOWN). The server answers with
+            a stream of QUEUED, PROGRESS, OUTPUT, LOG and ERROR frames and closes
+            the connection after the final DONE frame with the exit code.
+         */
+        struct Message {
+            enum class Type {
+                // Requests
+                OPTION,
+                SOLVE,
+                COMMAND,
+                STATUS,
+                SHUTDOWN,
+
+                // Responses
+                QUEUED,
+                PROGRESS,
+                OUTPUT,
+                LOG,
+                ERROR,
+                DONE,
+
+                UNKNOWN
+            };
+
+            Type type;
+            std::string payload;
+
+            static std::string ToString(Type type) {
+                switch (type) {
+                    case Type::OPTION: return "OPTION";
+                    case Type::SOLVE: return "SOLVE";
+                    case Type::COMMAND: return "COMMAND";
+                    case Type::STATUS: return "STATUS";
+                    case Type::SHUTDOWN: return "SHUTDOWN";
+                    case Type::QUEUED: return "QUEUED";
+                    case Type::PROGRESS: return "PROGRESS";
+                    case Type::OUTPUT: return "OUTPUT";
+                    case Type::LOG: return "LOG";
+                    case Type::ERROR: return "ERROR";
+                    case Type::DONE: return "DONE";
+                    default: return "UNKNOWN";
+                }
+            }
+
+            static Type FromString(const std::string& name) {
+                for (int i=0; i<static_cast<int>(Type::UNKNOWN); ++i) {
+                    if (ToString(static_cast<Type>(i)) == name) return static_cast<Type>(i);
+                }
+                return Type::UNKNOWN;
+            }
+        };
+
+        /**
+            \class Connection
+
+            \brief One end of a Unix domain socket speaking the frame protocol
+
+            Sending is thread safe, since the progress of a job is reported
+            from the worker threads of the scheduler. Receiving is only done
+            by the thread that owns the connection. The socket is closed on
+            destruction.
+         */
+        class Connection {
+        public:
+            explicit Connection(int fd) : fd(fd) { }
+
+            ~Connection() {
+                Close();
+            }
+
+            Connection(const Connection&) = delete;
+            Connection& operator=(const Connection&) = delete;
+        public:
+            /**
+                \brief Connect to the socket at the given path
+
+                \returns The file descriptor or -1 on failure
+             */
+            static int Connect(const std::string& path) {
+                int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+                if (fd < 0) return -1;
+
+                sockaddr_un address = GetAddress(path);
+
+                if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+                    close(fd);
+                    return -1;
+                }
+
+                return fd;
+            }
+
+            static sockaddr_un GetAddress(const std::string& path) {
+                sockaddr_un address = { };
+                address.sun_family = AF_UNIX;
+                path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+                return address;
+            }
+        public:
+            bool IsOpen() const { return fd >= 0; }
+
+            void Close() {
+                if (fd >= 0) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+
+            /**
+                \brief Let Receive fail if nothing arrives for the given seconds, 0 waits forever
+             */
+            void SetReceiveTimeout(unsigned seconds) {
+                if (fd < 0) return;
+
+                timeval timeout = { };
+                timeout.tv_sec = seconds;
+
+                setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            }
+        public:
+            /**
+                \brief Send a frame
+
+                \returns False if the other end is gone
+             */
+            bool Send(Message::Type type, const std::string& payload = "") {
+                std::string frame = Message::ToString(type) + " " + std::to_string(payload.size()) + "\n" + payload;
+
+                std::unique_lock<std::mutex> lock(mutex);
+                return Write(frame);
+            }
+
+            /**
+                \brief Receive the next frame
+
+                \returns False if the connection was closed or the frame is broken
+             */
+            bool Receive(Message& message) {
+                std::string header;
+                if (!ReadLine(header)) return false;
+
+                auto space = header.find(' ');
+                if (space == std::string::npos) return false;
+
+                message.type = Message::FromString(header.substr(0, space));
+
+                size_t size;
+                std::stringstream ss (header.substr(space + 1));
+                if (!(ss >> size)) return false;
+
+                return Read(message.payload, size);
+            }
+        private:
+            bool Write(const std::string& data) {
+                if (fd < 0) return false;
+
+                size_t written = 0;
+                while (written < data.size()) {
+                    // Do not raise SIGPIPE if the client went away
+                    auto result = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+
+                    if (result < 0) {
+                        if (errno == EINTR) continue;
+                        return false;
+                    }
+
+                    written += result;
+                }
+
+                return true;
+            }
+
+            bool Fill() {
+                char chunk[4096];
+
+                while (true) {
+                    auto result = recv(fd, chunk, sizeof(chunk), 0);
+
+                    if (result < 0 && errno == EINTR) continue;
+                    if (result <= 0) return false;
+
+                    buffer.append(chunk, result);
+                    return true;
+                }
+            }
+
+            bool ReadLine(std::string& line) {
+                size_t pos;
+                while ((pos = buffer.find('\n')) == std::string::npos) {
+                    if (!Fill()) return false;
+                }
+
+                line = buffer.substr(0, pos);
+                buffer.erase(0, pos + 1);
+                return true;
+            }
+
+            bool Read(std::string& data, size_t size) {
+                while (buffer.size() < size) {
+                    if (!Fill()) return false;
+                }
+
+                data = buffer.substr(0, size);
+                buffer.erase(0, size);
+                return true;
+            }
+        private:
+            int fd;
+
+            std::string buffer;
+            std::mutex mutex;
+        };
+
+        /**
+            \class MessageStream
+
+            \brief Output stream that sends everything written to it as frames of one type
+
+            The text is collected line by line and sent on every newline
+            (e.g. std::endl) or explicit flush, such that the client sees
+            the output of a job while it is running.
+         */
+        class MessageStream : public std::ostream {
+        private:
+            class Buffer : public std::stringbuf {
+            public:
+                Buffer(Connection& connection, Message::Type type) : connection(connection), type(type) { }
+            protected:
+                virtual int sync() override {
+                    auto text = str();
+
+                    if (!text.empty()) {
+                        connection.Send(type, text);
+                        str("");
+                    }
+
+                    return 0;
+                }
+            private:
+                Connection& connection;
+                Message::Type type;
+            };
+        public:
+            MessageStream(Connection& connection, Message::Type type) : std::ostream(nullptr), buffer(connection, type) {
+                rdbuf(&buffer);
+            }
+
+            ~MessageStream() {
+                flush();
+            }
+        private:
+            Buffer buffer;
+        };
+
+    }
+}
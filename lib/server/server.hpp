@@ -0,0 +1,408 @@
+#pragma once
+
+#include <map>
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <exception>
+
+#include <cstdio>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <common/logger.hpp>
+#include <common/memory.hpp>
+#include <common/statistics.hpp>
+#include <common/scope_guard.hpp>
+#include <common/task_pool.hpp>
+#include <common/time_measurement.hpp>
+
+#include <equations/solver.hpp>
+#include <language/cli.hpp>
+#include <tensor/expression_database.hpp>
+
+#include <server/protocol.hpp>
+
+namespace Construction {
+    namespace Server {
+
+        /**
+            \class Server
+
+            \brief Long running process that solves scripts for thin clients
+
+            The server listens on a Unix domain socket and runs the requests
+            of the clients (see Message) on a small pool of job threads. Between
+            the jobs it keeps the process warm: the ExpressionDatabase, the
+            pool of the tensor algorithms and above all the CoefficientCache,
+            s.t. every index structure is generated only once for all jobs.
+
+            The coefficients, substitutions and the Scheduler of the equations
+            are singletons, hence solve jobs are run one after another. CLI
+            jobs are run one after another as well: the variables and the
+            current expression `%` live in the Session singleton, and the
+            locking of the Session only keeps the single calls consistent,
+            not a sequence of commands of one client. Both kinds of jobs use
+            disjoint state, so a CLI job can run next to a solve job. Hence
+            there is one queue for each kind and at most one job thread works
+            on it, waiting jobs never occupy a thread. A client whose job has
+            to wait receives a QUEUED frame. The coefficients of a waiting
+            script are still taken from the cache once it runs.
+
+            STATUS and SHUTDOWN requests are answered on the accepting thread,
+            s.t. they are never stuck behind a long running job.
+         */
+        class Server {
+        private:
+            struct Job {
+                std::shared_ptr<Connection> connection;
+                Message request;
+                std::map<std::string, std::string> options;
+            };
+        public:
+            /**
+                \param jobs    Number of job threads, more than two are never busy
+             */
+            Server(const std::string& path, unsigned jobs) : path(path), jobs(std::min(jobs, 2u)), pool(this->jobs) { }
+
+            ~Server() {
+                Shutdown();
+
+                if (listener >= 0) {
+                    close(listener);
+                    std::remove(path.c_str());
+                }
+            }
+        public:
+            /**
+                \brief Bind to the socket
+
+                A stale socket file of a previous server is replaced.
+
+                \returns False if the socket could not be created
+             */
+            bool Listen() {
+                listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+                if (listener < 0) {
+                    Construction::Logger::Error("Could not create a socket");
+                    return false;
+                }
+
+                std::remove(path.c_str());
+
+                sockaddr_un address = Connection::GetAddress(path);
+
+                if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, 16) < 0) {
+                    Construction::Logger::Error("Could not listen on `", path, "`");
+
+                    close(listener);
+                    listener = -1;
+                    return false;
+                }
+
+                Construction::Logger::Info("Listening on `", path, "` with ", jobs, " job thread(s)");
+                return true;
+            }
+
+            /**
+                \brief Accept clients until the server is shut down
+             */
+            void Run() {
+                while (!stopped) {
+                    int fd = accept(listener, nullptr, nullptr);
+
+                    if (fd < 0) {
+                        if (errno == EINTR) continue;
+                        break;
+                    }
+
+                    Accept(std::make_shared<Connection>(fd));
+                }
+
+                Construction::Logger::Info("Stopped listening on `", path, "`");
+            }
+
+            /**
+                \brief Stop accepting clients, the running jobs are finished
+             */
+            void Shutdown() {
+                if (stopped.exchange(true)) return;
+
+                // Wake up the accept call
+                if (listener >= 0) shutdown(listener, SHUT_RDWR);
+            }
+        private:
+            /**
+                \brief Read the request of a new client and queue its job
+
+                The client sends the options and the request right after it
+                connected, so a client that stays silent only blocks the
+                accepting thread until the timeout.
+             */
+            void Accept(std::shared_ptr<Connection> connection) {
+                connection->SetReceiveTimeout(requestTimeout);
+
+                std::map<std::string, std::string> options;
+                Message message;
+
+                // Collect the options until the request
+                while (connection->Receive(message)) {
+                    switch (message.type) {
+                        case Message::Type::OPTION: {
+                            auto pos = message.payload.find('=');
+                            if (pos == std::string::npos) options[message.payload] = "";
+                            else options[message.payload.substr(0, pos)] = message.payload.substr(pos + 1);
+                            break;
+                        }
+
+                        case Message::Type::SOLVE:
+                        case Message::Type::COMMAND:
+                            connection->SetReceiveTimeout(0);
+                            Submit({ connection, std::move(message), std::move(options) });
+                            return;
+
+                        case Message::Type::STATUS:
+                            connection->Send(Message::Type::OUTPUT, GetStatus());
+                            Done(*connection, 0);
+                            return;
+
+                        case Message::Type::SHUTDOWN:
+                            Construction::Logger::Info("Shutdown requested by a client");
+
+                            Shutdown();
+                            Done(*connection, 0);
+                            return;
+
+                        default:
+                            connection->Send(Message::Type::ERROR, "Unexpected message " + Message::ToString(message.type));
+                            Done(*connection, -1);
+                            return;
+                    }
+                }
+            }
+
+            /**
+                \brief Queue a solve or CLI job
+
+                If no job thread works on the queue of its kind, one is started.
+                Otherwise the client is told that its job has to wait.
+             */
+            void Submit(Job&& job) {
+                bool solve = job.request.type == Message::Type::SOLVE;
+                auto connection = job.connection;
+
+                bool busy;
+
+                {
+                    std::unique_lock<std::mutex> lock(queueMutex);
+
+                    auto& queue = solve ? solves : commands;
+                    auto& active = solve ? solving : executing;
+
+                    queue.push_back(std::move(job));
+                    ++queued;
+
+                    busy = active;
+                    active = true;
+                }
+
+                if (busy) {
+                    connection->Send(Message::Type::QUEUED, solve ? "Waiting for the running script to finish" : "Waiting for the running commands to finish");
+                    return;
+                }
+
+                pool.Enqueue([this, solve]() {
+                    Work(solve);
+                });
+            }
+
+            /**
+                \brief Run the jobs of one queue until it is empty
+             */
+            void Work(bool solve) {
+                auto& queue = solve ? solves : commands;
+                auto& active = solve ? solving : executing;
+
+                while (true) {
+                    Job job;
+
+                    {
+                        std::unique_lock<std::mutex> lock(queueMutex);
+
+                        if (queue.empty()) {
+                            active = false;
+                            return;
+                        }
+
+                        job = std::move(queue.front());
+                        queue.pop_front();
+                    }
+
+                    --queued;
+                    ++running;
+
+                    if (solve) {
+                        Done(*job.connection, Solve(*job.connection, job.request.payload, job.options));
+                    } else {
+                        Done(*job.connection, Execute(*job.connection, job.request.payload));
+                    }
+
+                    --running;
+                    ++finished;
+                }
+            }
+
+            void Done(Connection& connection, int code) {
+                connection.Send(Message::Type::DONE, std::to_string(code));
+            }
+
+            /**
+                \brief Solve a `.es` script and stream the result
+             */
+            int Solve(Connection& connection, const std::string& script, const std::map<std::string, std::string>& options) {
+                Construction::Logger::Info("Start to solve a script with ", std::count(script.begin(), script.end(), '\n'), " line(s)");
+
+                // Forget the coefficients of this script afterwards, the cache keeps them
+                Common::ScopeGuard guard ([]() {
+                    Equations::Solver::Reset();
+                });
+
+                Equations::Solver::Options solverOptions;
+                solverOptions.parallel = GetOption<int>(options, "parallel", 1);
+                solverOptions.abc = GetOption<bool>(options, "abc", false);
+                solverOptions.colored = GetOption<bool>(options, "colored", false);
+                solverOptions.global = GetOption<bool>(options, "global", false);
+
+                int seed = GetOption<int>(options, "seed", 0);
+                if (seed != 0) {
+                    Equations::Coefficient::SetSeed(seed);
+                }
+
+                MessageStream out (connection, Message::Type::OUTPUT);
+                MessageStream log (connection, Message::Type::LOG);
+
+                Common::TimeMeasurement time;
+                auto hits = Equations::CoefficientCache::Instance()->GetHits();
+
+                try {
+                    Equations::Solver solver (solverOptions, out, log);
+
+                    std::stringstream ss (script);
+                    solver.Load(ss);
+                    solver.PrintDefinitions();
+
+                    unsigned steps = solver.GetNumberOfSteps();
+                    std::atomic<unsigned> done (0);
+
+                    solver.Solve([&]() {
+                        connection.Send(Message::Type::PROGRESS, std::to_string(++done) + "/" + std::to_string(steps));
+                    });
+
+                    solver.PrintResult();
+                    solver.PrintCosts();
+                } catch (const std::exception& e) {
+                    connection.Send(Message::Type::ERROR, std::string("Could not solve the script: ") + e.what());
+                    return -1;
+                } catch (...) {
+                    connection.Send(Message::Type::ERROR, "Could not solve the script");
+                    return -1;
+                }
+
+                time.Stop();
+
+                log << "Coefficients from the cache: " << Equations::CoefficientCache::Instance()->GetHits() - hits << std::endl;
+                log << time << std::endl;
+
+                return 0;
+            }
+
+            /**
+                \brief Execute CLI commands line by line and stream the output
+             */
+            int Execute(Connection& connection, const std::string& code) {
+                Language::CLI cli;
+                MessageStream out (connection, Message::Type::OUTPUT);
+
+                std::stringstream ss (code);
+                std::string line;
+
+                while (std::getline(ss, line)) {
+                    // Ignore empty lines and comments
+                    if (line == "" || line[0] == '#') continue;
+
+                    try {
+                        cli(line, out);
+                    } catch (const std::exception& e) {
+                        connection.Send(Message::Type::ERROR, "Could not execute `" + line + "`: " + e.what());
+                        return -1;
+                    } catch (...) {
+                        connection.Send(Message::Type::ERROR, "Could not execute `" + line + "`");
+                        return -1;
+                    }
+                }
+
+                return 0;
+            }
+
+            std::string GetStatus() const {
+                auto cache = Equations::CoefficientCache::Instance();
+
+                std::stringstream ss;
+                ss << "Socket: " << path << std::endl;
+                ss << "Jobs: " << running << " running / " << queued << " queued / " << finished << " finished" << std::endl;
+                ss << "Threads: " << Parallel::GlobalTaskPool::Instance()->GetNumberOfThreads() << " in the pool, " << Equations::Scheduler::Instance()->GetNumberOfWorkers() << " scheduler worker(s)" << std::endl;
+                ss << "Coefficient cache: " << cache->Size() << " structure(s), " << cache->GetHits() << " hit(s), " << cache->GetMisses() << " miss(es), " << cache->GetEvictions() << " eviction(s), " << Common::MemoryStatistics::FormatBytes(cache->MemoryFootprint()) << std::endl;
+                ss << "Command cache: " << Language::CommandCache::Instance()->Size() << " result(s), " << Language::CommandCache::Instance()->GetHits() << " hit(s), " << Language::CommandCache::Instance()->GetMisses() << " miss(es), " << Common::MemoryStatistics::FormatBytes(Language::CommandCache::Instance()->MemoryFootprint()) << std::endl;
+                ss << "Database cache: " << Tensor::ExpressionDatabase::Instance()->GetNumberOfCached() << " expression(s), " << Common::MemoryStatistics::FormatBytes(Tensor::ExpressionDatabase::Instance()->MemoryFootprint()) << std::endl;
+                ss << "Session: " << Common::MemoryStatistics::FormatBytes(Language::Session::Instance()->MemoryFootprint()) << std::endl;
+                ss << "Peak RSS: " << Common::MemoryStatistics::FormatBytes(Common::Statistics::GetPeakMemory() * 1024) << std::endl;
+                return ss.str();
+            }
+        private:
+            template<typename T>
+            static T GetOption(const std::map<std::string, std::string>& options, const std::string& name, T defaultValue) {
+                auto it = options.find(name);
+                if (it == options.end()) return defaultValue;
+
+                // A flag without a value is set
+                if (it->second.empty()) return T(1);
+
+                T value;
+                std::stringstream ss (it->second);
+                if (!(ss >> value)) return defaultValue;
+                return value;
+            }
+        private:
+            std::string path;
+            unsigned jobs;
+
+            int listener = -1;
+            std::atomic<bool> stopped { false };
+
+            std::atomic<unsigned> running { 0 };
+            std::atomic<unsigned> queued { 0 };
+            std::atomic<unsigned> finished { 0 };
+
+            // Seconds a new client may take to send its request
+            unsigned requestTimeout = 10;
+
+            std::deque<Job> solves;
+            std::deque<Job> commands;
+
+            bool solving = false;
+            bool executing = false;
+
+            std::mutex queueMutex;
+
+            // Declared last, s.t. the running jobs finish before the rest is destroyed
+            Common::TaskPool pool;
+        };
+
+    }
+}
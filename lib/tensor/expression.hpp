@@ -8,6 +8,7 @@
 
 #include <common/serializable.hpp>
 #include <common/printable.hpp>
+#include <common/memory.hpp>
 
 using Construction::Common::Serializable;
 
@@ -43,6 +44,11 @@ namespace Construction {
 			virtual inline int GetColorCode() const { return 32; }
 		public:
 			virtual std::unique_ptr<AbstractExpression> Clone() const = 0;
+
+			/**
+				\brief Memory of the expression including everything it owns
+			 */
+			virtual size_t DeepSize() const = 0;
 		public:
 			virtual std::string ToString() const override { return ""; }
 		public:
@@ -62,6 +68,8 @@ namespace Construction {
 			virtual ExpressionPointer Clone() const override { return std::move(ExpressionPointer(new VoidExpression())); }
 
 			virtual bool IsVoidExpression() const override { return true; }
+
+			virtual size_t DeepSize() const override { return sizeof(VoidExpression) + Common::HeapSize(printed_text); }
 		public:
 			virtual std::string ToString() const override {
 				return "";
@@ -87,6 +95,8 @@ namespace Construction {
 			virtual int GetColorCode() const override { return (value) ? 32 : 31; }
 
 			virtual bool IsBooleanExpression() const override { return true; }
+
+			virtual size_t DeepSize() const override { return sizeof(BoolExpression) + Common::HeapSize(printed_text); }
 		public:
 			virtual void Serialize(std::ostream& os) const override {
 				WriteBinary<char>(os, static_cast<char>(value));
@@ -106,6 +116,8 @@ namespace Construction {
 		public:
 			virtual bool IsStringExpression() const override { return true; }
 			virtual ExpressionPointer Clone() const override { return std::move(ExpressionPointer(new StringExpression(value))); }
+
+			virtual size_t DeepSize() const override { return sizeof(StringExpression) + Common::HeapSize(printed_text) + Common::HeapSize(value); }
 		public:
 			virtual std::string ToString() const override {
 				return value;
@@ -220,6 +232,11 @@ namespace Construction {
 			}
 		public:
 			virtual std::string ToString() const override { return pointer->ToString(); }
+		public:
+			/**
+				\brief Memory of the expression including everything it owns
+			 */
+			size_t DeepSize() const { return sizeof(Expression) + Common::HeapSize(printed_text) + Common::HeapSize(pointer); }
 		public:
 			virtual void Serialize(std::ostream& os) const override;
             static std::unique_ptr<Expression> Deserialize(std::istream& is);
@@ -114,10 +114,10 @@ namespace Construction {
                     exists = file.good();
                 }
 
-                if (exists) ReadKeysFromFile(filename);
-
                 // Set initialized
                 initialized = true;
+
+                if (exists) ReadKeysFromFile(filename);
             }
         public:
             void Deactivate() {
@@ -127,6 +127,9 @@ namespace Construction {
             void Activate() {
                 active = true;
             }
+
+            bool IsInitialized() const { return initialized; }
+            bool IsActive() const { return initialized && active; }
         private:
             void ReadKeysFromFile(const std::string& filename) {
                 assert(initialized && "The expression database needs to be initialized first");
@@ -552,6 +555,22 @@ namespace Construction {
             size_t Size() const {
                 return definitions.size();
             }
+
+            /**
+                \brief Return the number of expressions in the cache
+             */
+            size_t GetNumberOfCached() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return cache_values.size();
+            }
+
+            /**
+                \brief Estimate the memory held by the cache and the index of the definitions
+             */
+            size_t MemoryFootprint() const {
+                std::unique_lock<std::mutex> lock(mutex);
+                return Common::HeapSize(definitions) + Common::HeapSize(cache_keys) + Common::HeapSize(cache_values);
+            }
         private:
             std::unordered_map<std::string, size_t> definitions;
 
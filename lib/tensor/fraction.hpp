@@ -174,6 +174,10 @@ namespace Construction {
                 return static_cast<double>(numerator) / static_cast<double>(denominator);
             }
 
+            virtual size_t DeepSize() const override {
+                return sizeof(FractionBase) + Common::HeapSize(numerator) + Common::HeapSize(denominator);
+            }
+
             virtual std::string ToString() const override {
                 // Do not write 0 to complicated
                 if (numerator == 0) return "0";
@@ -5,13 +5,20 @@
 #include <sstream>
 #include <map>
 #include <algorithm>
+#include <unordered_map>
+#include <mutex>
+#include <memory>
+#include <cstdint>
 
 #include <tensor/expression.hpp>
+#include <tensor/index_combinations.hpp>
 
 #include <common/error.hpp>
 #include <common/printable.hpp>
 #include <common/range.hpp>
 #include <common/serializable.hpp>
+#include <common/singleton.hpp>
+#include <common/small_vector.hpp>
 #include <common/task_pool.hpp>
 
 namespace Construction {
@@ -103,6 +110,134 @@ namespace Construction {
 				"Alpha", "Beta", "Gamma", "Delta", "Epsilon", "Zeta", "Eta", "Theta", "Iota", "Kappa", "Lambda", "Mu", "Nu", "Xi", "Omicron", "Pi", "Rho", "Sigma", "Tau", "Upsilon", "Phi", "Chi", "Psi", "Omega",
 		};
 
+		/**
+			\class IndexTable
+
+			\brief Global table of the distinct indices
+
+			Every distinct combination of name, printed text and range is
+			stored once and identified by a 32 bit ID, s.t. an Index is only
+			a handle into this table. Copying an index never allocates and
+			comparing two indices compares integers.
+
+			Besides the strings the table precomputes what the comparison
+			of two indices needs, i.e. if the index is roman, greek or part
+			of a series and its position in that order. Indices that only
+			differ in their range share the same symbol, since they are equal.
+
+			The entries are never removed and never move in memory, hence
+			they can be read without a lock. ID 0 is the default index.
+		 */
+		class IndexTable : public Singleton<IndexTable> {
+		public:
+			enum class Kind : uint8_t {
+				NONE = 0,
+				ROMAN = 1,
+				GREEK = 2,
+				SERIES = 3
+			};
+
+			struct Entry {
+				std::string name;
+				std::string printed;
+				Range range = Range(1,3);
+
+				// Equal for indices with the same name and printed text
+				uint32_t symbol = 0;
+
+				// Order of the index among the ones of the same kind
+				Kind kind = Kind::NONE;
+				int position = 0;
+				uint32_t prefix = 0;
+			};
+		public:
+			IndexTable() {
+				Intern("", "", Range(1,3));
+			}
+		public:
+			/**
+				\brief Returns the ID of the index, adds it if it is new
+			 */
+			uint32_t Intern(const std::string& name, const std::string& printed, const Range& range) {
+				std::string symbolKey = name + '\0' + printed;
+				std::string key = symbolKey + '\0' + std::to_string(range.GetFrom()) + ":" + std::to_string(range.GetTo());
+
+				std::unique_lock<std::mutex> lock(mutex);
+
+				auto it = ids.find(key);
+				if (it != ids.end()) return it->second;
+
+				uint32_t id = size;
+				if ((id >> CHUNK_BITS) >= MAX_CHUNKS) throw Exception("Too many distinct indices");
+
+				auto& chunk = chunks[id >> CHUNK_BITS];
+				if (!chunk) chunk.reset(new Entry[1 << CHUNK_BITS]);
+
+				auto& entry = chunk[id & CHUNK_MASK];
+				entry.name = name;
+				entry.printed = printed;
+				entry.range = range;
+				entry.symbol = symbols.emplace(symbolKey, symbols.size()).first->second;
+
+				Classify(entry);
+
+				ids[key] = id;
+				++size;
+
+				return id;
+			}
+
+			inline const Entry& Get(uint32_t id) const {
+				return chunks[id >> CHUNK_BITS][id & CHUNK_MASK];
+			}
+
+			size_t Size() const {
+				std::unique_lock<std::mutex> lock(mutex);
+				return size;
+			}
+		private:
+			void Classify(Entry& entry) {
+				const std::string& name = entry.name;
+
+				// Roman indices, lower case first
+				if (name.length() == 1 && name == entry.printed && ((name[0] >= 'a' && name[0] <= 'z') || (name[0] >= 'A' && name[0] <= 'Z'))) {
+					entry.kind = Kind::ROMAN;
+					entry.position = name[0] - 'a';
+					if (entry.position < 0) entry.position = name[0] - 'A' + 26;
+					return;
+				}
+
+				// Greek indices in the order of GreekSymbols
+				auto greek = GreekSymbols.find(name);
+				if (greek != GreekSymbols.end() && greek->second == entry.printed) {
+					entry.kind = Kind::GREEK;
+					entry.position = std::distance(GreekSymbols.begin(), greek);
+					return;
+				}
+
+				// Series indices with the same prefix, e.g. \alpha_1 and \alpha_2
+				size_t posDash = name.find("_");
+				if (posDash != std::string::npos && entry.printed.find("_") != std::string::npos) {
+					entry.kind = Kind::SERIES;
+					entry.position = atoi(name.substr(posDash+1).c_str());
+					entry.prefix = prefixes.emplace(name.substr(0, posDash), prefixes.size()).first->second;
+				}
+			}
+		private:
+			static constexpr unsigned CHUNK_BITS = 10;
+			static constexpr unsigned CHUNK_MASK = (1 << CHUNK_BITS) - 1;
+			static constexpr unsigned MAX_CHUNKS = 4096;
+
+			std::unique_ptr<Entry[]> chunks[MAX_CHUNKS];
+			uint32_t size = 0;
+
+			std::unordered_map<std::string, uint32_t> ids;
+			std::unordered_map<std::string, uint32_t> symbols;
+			std::unordered_map<std::string, uint32_t> prefixes;
+
+			mutable std::mutex mutex;
+		};
+
 		/**
 			\class Index
 
@@ -111,8 +246,12 @@ namespace Construction {
 			Class for a single index. Note that this is abstractly and
 			just marks a slot to plug a specific combination for the
 			valid range of the index.
+
+			The name, printed text and range are stored in the IndexTable,
+			the index itself only holds the ID of the entry and whether it
+			is contravariant.
 		 */
-		class Index : public Printable, Serializable<Index> {
+		class Index {
 		public:
 			/**
 				\brief Constructor of an index
@@ -121,55 +260,35 @@ namespace Construction {
 				and a printable version in form of LaTeX code. It is also important to give a
 				range to the index.
 			 */
-			Index() : range(1,3) { }
+			Index() = default;
 
 			Index(const std::string& name, const std::string& printable, const Range& range)
-				: Printable(printable), name(name), range(range) { }
+				: id(IndexTable::Instance()->Intern(name, printable, range)), symbol(Table().Get(id).symbol) { }
 
 			Index(const std::string& name, const Range& range)
-				: Printable(name), name(name), range(range) { }
+				: Index(name, name, range) { }
 
 			Index(const std::string& name)
-				: Printable(name), name(name), range(Range::SpaceRange()) { }
-
-			// Copy constructor
-			Index(const Index& other) : name(other.name), Printable(other.GetPrintedText()), range(other.range), up(other.up) { }
-			// Move constructor (TODO)
-			Index(Index&& other)
-			  : name(std::move(other.name)), Printable(std::move(other.printed_text)), range(std::move(other.range)), up(std::move(other.up)) { }
+				: Index(name, name, Range::SpaceRange()) { }
 		public:
-			/**
-				Copy assignment operator
-			 */
-			Index& operator=(const Index& other) {
-				name = other.name;
-				printed_text = other.printed_text;
-				range = other.range;
-                up = other.up;
-				return *this;
+			inline const std::string& GetName() const {
+				return Table().Get(id).name;
 			}
 
-			/**
-				Move assignment operator
-			 */
-			Index& operator=(Index&& other) {
-				name = std::move(other.name);
-				printed_text = std::move(other.printed_text);
-				range = std::move(other.range);
-                up = std::move(other.up);
-				return *this;
+			inline const std::string& GetPrintedText() const {
+				return Table().Get(id).printed;
 			}
-		public:
-			inline std::string GetName() const {
-				return name;
+
+			inline void SetPrintedText(const std::string& text) {
+				*this = Index(GetName(), text, GetRange()).WithContravariance(up);
 			}
 
 			inline Range GetRange() const {
-				return range;
+				return Table().Get(id).range;
 			}
 
 			inline void SetRange(const Range& value) {
-				range = value;
+				*this = Index(GetName(), GetPrintedText(), value).WithContravariance(up);
 			}
 
 			inline bool IsContravariant() const {
@@ -179,57 +298,38 @@ namespace Construction {
 			inline void SetContravariant(bool value) {
 				up = value;
 			}
+
+			/**
+				\brief Returns the ID of the index in the IndexTable
+			 */
+			inline uint32_t GetID() const {
+				return id;
+			}
+		public:
+			std::string ToString() const { return GetPrintedText(); }
+			operator std::string() const { return ToString(); }
+
+			friend std::ostream& operator<<(std::ostream& os, const Index& index) {
+				os << index.ToString();
+				return os;
+			}
 		public:
 			/**
 				Equality operator
 			 */
 			inline bool operator==(const Index& other) const {
-				return name == other.name && printed_text == other.printed_text;
+				return symbol == other.symbol;
 			}
 
 			/**
 				Inequality operator
 			 */
 			inline bool operator!=(const Index& other) const {
-				return name != other.name || printed_text != other.printed_text;
+				return symbol != other.symbol;
 			}
 
 			bool operator<(const Index& other) const {
-				// Compare roman indices
-				if (IsRomanIndex()) {
-					if (!other.IsRomanIndex()) throw IndicesIncomparableException();
-
-					int posX = name[0] - 'a';
-					if (posX < 0) posX = name[0] - 'A' + 26;
-
-					int posY = other.name[0] - 'a';
-					if (posY < 0) posY = other.name[0] - 'A' + 26;
-
-					return posX < posY;
-				}
-				// Compare greek indices
-				else if (IsGreekIndex()) {
-					if (!other.IsGreekIndex()) throw IndicesIncomparableException();
-
-					return std::distance(GreekSymbols.find(name), GreekSymbols.find(other.name)) > 0;
-				}
-				// Compare series indices
-				else if (IsSeriesIndex()) {
-					if (!other.IsSeriesIndex()) throw IndicesIncomparableException();
-
-					// If the prefix does not match also throw exception
-					int posDash = name.find("_");
-					if (name.substr(0, posDash) != other.name.substr(0, name.find("_"))) {
-						throw IndicesIncomparableException();
-					}
-
-					int posX = atoi(name.substr(posDash+1, name.length()-posDash-1).c_str());
-					int posY = atoi(other.name.substr(posDash+1, other.name.length()-posDash-1).c_str());
-
-					return posX < posY;
-				}
-				// cannot compare the indices
-				else throw IndicesIncomparableException();
+				return Position(other) < other.Position(*this);
 			}
 
 			inline bool operator<=(const Index& other) const {
@@ -237,41 +337,7 @@ namespace Construction {
 			}
 
 			bool operator>(const Index& other) const {
-				// Compare roman indices
-				if (IsRomanIndex()) {
-					if (!other.IsRomanIndex()) throw IndicesIncomparableException();
-
-					int posX = name[0] - 'a';
-					if (posX < 0) posX = name[0] - 'A' + 26;
-
-					int posY = other.name[0] - 'a';
-					if (posY < 0) posY = other.name[0] - 'A' + 26;
-
-					return posX > posY;
-				}
-					// Compare greek indices
-				else if (IsGreekIndex()) {
-					if (!other.IsGreekIndex()) throw IndicesIncomparableException();
-
-					return std::distance(GreekSymbols.find(name), GreekSymbols.find(other.name)) < 0;
-				}
-					// Compare series indices
-				else if (IsSeriesIndex()) {
-					if (!other.IsSeriesIndex()) throw IndicesIncomparableException();
-
-					// If the prefix does not match also throw exception
-					int posDash = name.find("_");
-					if (name.substr(0, posDash) != other.name.substr(0, name.find("_"))) {
-						throw IndicesIncomparableException();
-					}
-
-					int posX = atoi(name.substr(posDash, name.length()-posDash).c_str());
-					int posY = atoi(other.name.substr(posDash, other.name.length()-posDash).c_str());
-
-					return posX > posY;
-				}
-					// cannot compare the indices
-				else throw IndicesIncomparableException();
+				return Position(other) > other.Position(*this);
 			}
 
 			inline bool operator>=(const Index& other) const {
@@ -291,6 +357,7 @@ namespace Construction {
 			 	\throws IndexOutOfRangeException
 			 */
 			unsigned operator()(unsigned value) const {
+				auto& range = Table().Get(id).range;
 				if (!(value >= range.GetFrom() && value <= range.GetTo())) {
 					throw IndexOutOfRangeException();
 				}
@@ -305,7 +372,7 @@ namespace Construction {
 			 	one and lies in the correct range.
 			 */
 			bool IsRomanIndex() const {
-				return name.length() == 1 && name == printed_text && ((name[0] >= 'a' && name[0] <= 'z') || (name[0] >= 'A' && name[0] <= 'Z'));
+				return Table().Get(id).kind == IndexTable::Kind::ROMAN;
 			}
 
 			/**
@@ -316,7 +383,7 @@ namespace Construction {
 			 	and the TeX code matches.
 			 */
 			bool IsGreekIndex() const {
-				return GreekSymbols.find(name) != GreekSymbols.end() && GreekSymbols.at(name) == printed_text;
+				return Table().Get(id).kind == IndexTable::Kind::GREEK;
 			}
 
 			/**
@@ -326,13 +393,14 @@ namespace Construction {
 			 	when comparing indices. Checks if the name and TeX code contain "_".
 			 */
 			bool IsSeriesIndex() const {
-				return name.find("_") != std::string::npos && printed_text.find("_") != std::string::npos;
+				return Table().Get(id).kind == IndexTable::Kind::SERIES;
 			}
 		public:
 			void Serialize(std::ostream& os) const {
-				os << name << ";";
-				os << printed_text << ";";
-				range.Serialize(os);
+				auto& entry = Table().Get(id);
+				os << entry.name << ";";
+				os << entry.printed << ";";
+				entry.range.Serialize(os);
 			}
 
 			static std::unique_ptr<Index> Deserialize(std::istream& is) {
@@ -349,9 +417,46 @@ namespace Construction {
 
 				return std::move(std::unique_ptr<Index>(new Index(name, printed_text, *rangePtr)));
 			}
+		public:
+			size_t DeepSize() const {
+				return sizeof(Index);
+			}
+		private:
+			static inline const IndexTable& Table() {
+				// Avoid the lock of Instance() in every comparison
+				static const IndexTable* table = IndexTable::Instance();
+				return *table;
+			}
+
+			Index WithContravariance(bool value) const {
+				Index result = *this;
+				result.up = value;
+				return result;
+			}
+
+			/**
+				\brief Position of the index in the order of the kind of both indices
+
+				\throws IndicesIncomparableException
+			 */
+			int Position(const Index& other) const {
+				auto& entry = Table().Get(id);
+				auto& otherEntry = Table().Get(other.id);
+
+				if (entry.kind == IndexTable::Kind::NONE || entry.kind != otherEntry.kind) {
+					throw IndicesIncomparableException();
+				}
+
+				// If the prefix does not match also throw exception
+				if (entry.kind == IndexTable::Kind::SERIES && entry.prefix != otherEntry.prefix) {
+					throw IndicesIncomparableException();
+				}
+
+				return entry.position;
+			}
 		private:
-			std::string name;
-			Range range;
+			uint32_t id = 0;
+			uint32_t symbol = 0;
 			bool up = false;
 		};
 
@@ -398,6 +503,14 @@ namespace Construction {
 			std::map<std::string, unsigned> assignment;
 		};
 
+		/**
+			\brief Storage of the indices of a tensor
+
+			Typical tensors have less than 12 indices, s.t. they are stored
+			inline without allocating.
+		 */
+		typedef Common::SmallVector<Index, 12>		IndexVector;
+
 		/**
 			\class Indices
 		 */
@@ -497,11 +610,11 @@ namespace Construction {
 				return std::vector<unsigned>();
 			}
 		public:
-			std::vector<Index>::iterator begin() { return indices.begin(); }
-			std::vector<Index>::iterator end() { return indices.end(); }
+			IndexVector::iterator begin() { return indices.begin(); }
+			IndexVector::iterator end() { return indices.end(); }
 
-			std::vector<Index>::const_iterator begin() const { return indices.begin(); }
-			std::vector<Index>::const_iterator end() const { return indices.end(); }
+			IndexVector::const_iterator begin() const { return indices.begin(); }
+			IndexVector::const_iterator end() const { return indices.end(); }
 
 			Index operator[](unsigned id) const {
 				if (id >= indices.size()) throw IndexOutOfRangeException();
@@ -767,125 +880,68 @@ namespace Construction {
 				return result;
 			}
 
-            /**
-				\brief Returns all the possible index combinations for the tensor.
-
-			 	Returns all the possible index combinations for the tensor.
-			 	It uses a recursive inline methods that fixes the indices one by one
-			 	until all indices have a value. In this case the combination is added to the
-			 	result.
+			/**
+				\brief Returns the ranges of the indices
 			 */
-			std::vector<std::vector<unsigned>> GetAllIndexCombinations() const {
-
-				// Result
-				std::vector<std::vector<unsigned>> result;
+			std::vector<Range> GetRanges() const {
+				std::vector<Range> result;
+				for (auto& index : indices) {
+					result.push_back(index.GetRange());
+				}
+				return result;
+			}
 
-				// Helper method to recursively determine the index combinations
-				std::function<void(const std::vector<unsigned>&)> fn = [&](const std::vector<unsigned>& input) -> void {
-					// If all indices are fixed, add the combination to the list
-					if (input.size() == Size()) {
-						result.push_back(input);
-						return;
-					}
+			/**
+				\brief Returns all the possible index combinations without materializing them
+			 */
+			IndexCombinations GetCombinations() const {
+				return IndexCombinations(GetRanges());
+			}
 
-					// Get range of next unfixed index
-					auto range = indices[input.size()].GetRange();
+			/**
+				\brief Returns the interesting index combinations without materializing them
 
-					// Iterate over the range
-					for (auto i : range) {
-						// Add the index to the list
-						std::vector<unsigned> newInput = input;
-						newInput.push_back(i);
+				See GetAllInterestingIndexCombinations.
 
-						// Recursive call to go to next index
-						fn(newInput);
-					}
-				};
+				\param negative	The number of directions with negative signature at the start of the range
+			 */
+			IndexCombinations GetInterestingCombinations(unsigned negative = 0) const {
+				return IndexCombinations(GetRanges(), IndexCombinations::Mode::INTERESTING, negative);
+			}
 
-				// Start recursion
-				std::vector<unsigned> input;
-				fn({});
+            /**
+				\brief Returns all the possible index combinations for the tensor.
 
-				return result;
+			 	Returns all the possible index combinations for the tensor.
+			 	Prefer GetCombinations() if the combinations are only
+			 	iterated over.
+			 */
+			std::vector<std::vector<unsigned>> GetAllIndexCombinations() const {
+				return GetCombinations().ToVector();
 			}
 
 			/**
                 \brief Returns all the possible interesting index combinations for the tensor.
 
-                 Returns all the possible index combinations for the tensor.
-                 It uses a recursive inline methods that fixes the indices one by one
-                 until all indices have a value. In this case the combination is added to the
-                 result.
+                 Returns the index combinations in which the values first appear in
+                 increasing order, e.g. where the first index is 1 and the first index
+                 that is not 1 is 2 for spatial indices. With a metric of signature
+                 (p,q) this holds separately for the first p values and the others.
+
+                 Every other combination is one of these up to a permutation of the
+                 values that keeps the metric. Tensors built from the metric, delta and
+                 epsilon only change their sign under such a permutation, and the sign
+                 only depends on the number of epsilons. A component of an even and of
+                 an odd number of epsilons is never nonzero for the same combination,
+                 since the values appear an even or odd number of times respectively.
+                 Thus the other components do not contain new information.
+                 Prefer GetInterestingCombinations() if the combinations are only
+                 iterated over.
+
+                 \param negative	The number of directions with negative signature at the start of the range
              */
-			std::vector<std::vector<unsigned>> GetAllInterestingIndexCombinations() const {
-				// Result
-				std::vector<std::vector<unsigned>> result;
-
-				// Heurestics for special cases
-				if (Size() == 0) return result;
-
-				assert(indices[0].GetRange().GetDimension() == 3 && "Cannot apply the index heuristics for spacetime ranges");
-
-				// Helper method to recursively determine the index combinations
-				std::function<void(const std::vector<unsigned>&)> fn = [&](const std::vector<unsigned>& input) -> void {
-					// If all indices are fixed, add the combination to the list
-					if (input.size() == Size()) {
-						result.push_back(input);
-						return;
-					}
-
-					// Get range of next unfixed index
-					auto range = indices[input.size()].GetRange();
-
-					// Iterate over the range
-					for (auto i : range) {
-						// Add the index to the list
-						std::vector<unsigned> newInput = input;
-						newInput.push_back(i);
-
-						// Recursive call to go to next index
-						fn(newInput);
-					}
-				};
-
-				// Helper method to recursively determine the index combinations
-				std::function<void(const std::vector<unsigned>&)> gn = [&](const std::vector<unsigned>& input) -> void {
-					// If all indices are fixed, add the combination to the list
-					if (input.size() == Size()) {
-						result.push_back(input);
-						return;
-					}
-
-					// Get range of next unfixed index
-					auto range = indices[input.size()].GetRange();
-
-					// Add a 1 as index and still use the method
-					{
-						std::vector<unsigned> newInput = input;
-						newInput.push_back(1);
-
-						// Recursion to add a 1
-						gn(newInput);
-					}
-
-					// Add a 2 as index and still use the standard method from now on
-					{
-						std::vector<unsigned> newInput = input;
-						newInput.push_back(2);
-
-						// Recursion to add a 1
-						fn(newInput);
-					}
-				};
-
-				// Set the first index to one
-                if (Size() == 1) {
-					fn({});
-				} else {
-					gn({1});
-				}
-
-				return result;
+			std::vector<std::vector<unsigned>> GetAllInterestingIndexCombinations(unsigned negative = 0) const {
+				return GetInterestingCombinations(negative).ToVector();
 			}
 		public:
 			static Indices GetSeries(unsigned N, const std::string& name, const std::string& printed, const Range& range, unsigned offset=0) {
@@ -1119,8 +1175,8 @@ namespace Construction {
              */
             bool ContainsContractions() const {
                 bool result = false;
-                std::vector<Index> copy = indices;
-                std::vector<Index> duplicates;
+                IndexVector copy = indices;
+                IndexVector duplicates;
 
                 for (int i=0; i<copy.size(); ++i) {
                     // Already used
@@ -1162,7 +1218,7 @@ namespace Construction {
                 \throws CannotContractIndicesException
              */
             Indices Contract(const Indices& other) const {
-                std::vector<Index> other_ = other.indices;
+                IndexVector other_ = other.indices;
                 Indices result;
 
                 // Iterate over all indices
@@ -1203,6 +1259,10 @@ namespace Construction {
 		public:
 			virtual std::unique_ptr<AbstractExpression> Clone() const override { return std::move(ExpressionPointer(new Indices(*this))); }
 			virtual bool IsIndicesExpression() const override { return true; }
+
+			virtual size_t DeepSize() const override {
+				return sizeof(Indices) + Common::HeapSize(printed_text) + Common::HeapSize(indices);
+			}
 		public:
 			void Serialize(std::ostream& os) const override {
 				// Write the size of the indices
@@ -1232,7 +1292,7 @@ namespace Construction {
 				return std::move(result);
 			}
 		private:
-			std::vector<Index> indices;
+			IndexVector indices;
 		};
 
 		std::vector<unsigned> IndexAssignments::operator()(const Indices& indices) const {
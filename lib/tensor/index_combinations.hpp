@@ -0,0 +1,328 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <functional>
+
+#include <common/error.hpp>
+#include <common/range.hpp>
+#include <common/small_vector.hpp>
+
+namespace Construction {
+	namespace Tensor {
+
+		using Common::Range;
+
+		/**
+			\class IndexCombinations
+
+			\brief Lazy sequence of the index combinations of some indices
+
+			Enumerates the combinations like an odometer, i.e. the last index
+			runs fastest, without materializing them. Every combination is
+			identified by its packed form, the mixed radix number with the
+			dimensions of the ranges as digits, e.g. a base 3 integer for
+			spatial indices. The packed forms are increasing in the order of
+			the enumeration.
+
+			The iterator holds one combination that is updated in place, s.t.
+			the whole enumeration allocates only once. The reference returned
+			by the iterator is invalidated by the next increment.
+
+			In the INTERESTING mode only one combination is enumerated for every
+			relabeling of the values that keeps the metric, i.e. a permutation of
+			the first p values of the range with negative signature and one of the
+			others. These are the combinations in which the values of each part
+			appear in increasing order, e.g. 1112.. but not 1113.. for spatial
+			indices, see Indices::GetAllInterestingIndexCombinations. It needs
+			all the indices to have the same range, otherwise all combinations
+			are enumerated.
+
+			A filter restricts the sequence further, e.g. to one representative
+			of every orbit of the index symmetries of a tensor.
+
+			For parallel consumers the sequence can be split into chunks of
+			consecutive packed forms that are enumerated independently.
+
+			Example:
+				for (auto& combination : indices.GetCombinations()) {
+					tensor.Evaluate(combination);
+				}
+		 */
+		class IndexCombinations {
+		public:
+			typedef uint64_t	Packed;
+			typedef std::function<bool(const std::vector<unsigned>&)>	Filter;
+
+			enum class Mode {
+				ALL,
+				INTERESTING
+			};
+		public:
+			class Iterator {
+			public:
+				Iterator(const IndexCombinations* parent, Packed packed) : parent(parent), packed(packed) {
+					if (packed >= parent->last) {
+						this->packed = parent->last;
+						return;
+					}
+
+					parent->Unpack(packed, current);
+					Skip();
+				}
+			public:
+				inline const std::vector<unsigned>& operator*() const { return current; }
+				inline const std::vector<unsigned>* operator->() const { return &current; }
+
+				/**
+					\brief Returns the packed form of the current combination
+				 */
+				inline Packed GetPacked() const { return packed; }
+
+				Iterator& operator++() {
+					Advance();
+					Skip();
+					return *this;
+				}
+
+				inline bool operator==(const Iterator& other) const { return packed == other.packed; }
+				inline bool operator!=(const Iterator& other) const { return packed != other.packed; }
+			private:
+				/**
+					Step to the next combination in the odometer order
+				 */
+				void Advance() {
+					size_t i = current.size();
+
+					while (i-- > 0) {
+						if (++current[i] < parent->from[i] + parent->dimensions[i]) {
+							packed += parent->strides[i];
+							if (packed >= parent->last) packed = parent->last;
+							return;
+						}
+
+						// Carry to the previous index
+						current[i] = parent->from[i];
+						packed -= (parent->dimensions[i] - 1) * parent->strides[i];
+					}
+
+					packed = parent->last;
+				}
+
+				/**
+					Skip the combinations that are not interesting or do not pass the filter
+				 */
+				void Skip() {
+					while (packed < parent->last) {
+						if (parent->mode == Mode::INTERESTING) {
+							size_t p = parent->FindUninteresting(current);
+
+							if (p < current.size()) {
+								// Nothing with this prefix and a larger value of the same part at p is interesting,
+								// jump to the last of these combinations
+								unsigned maximum = parent->from[p] + parent->dimensions[p] - 1;
+								if (current[p] < parent->from[p] + parent->negative) {
+									maximum = parent->from[p] + parent->negative - 1;
+								}
+
+								packed += (maximum - current[p]) * parent->strides[p];
+								current[p] = maximum;
+
+								for (size_t q = p + 1; q < current.size(); ++q) {
+									maximum = parent->from[q] + parent->dimensions[q] - 1;
+									packed += (maximum - current[q]) * parent->strides[q];
+									current[q] = maximum;
+								}
+
+								Advance();
+								continue;
+							}
+						}
+
+						if (parent->filter && !parent->filter(current)) {
+							Advance();
+							continue;
+						}
+
+						return;
+					}
+				}
+			private:
+				const IndexCombinations* parent;
+				Packed packed;
+				std::vector<unsigned> current;
+			};
+		public:
+			IndexCombinations() = default;
+
+			IndexCombinations(const std::vector<Range>& ranges, Mode mode = Mode::ALL, unsigned negative = 0) : mode(mode), negative(negative) {
+				for (auto& range : ranges) {
+					from.push_back(range.GetFrom());
+					dimensions.push_back(range.GetDimension());
+				}
+
+				strides.push_back(1);
+				for (size_t i = ranges.size(); i-- > 0; ) {
+					if (dimensions[i] != 0 && strides.front() > std::numeric_limits<Packed>::max() / dimensions[i]) {
+						throw Exception("Too many index combinations");
+					}
+
+					strides.insert(strides.begin(), strides.front() * dimensions[i]);
+				}
+
+				// The number of all combinations
+				last = strides.front();
+				strides.erase(strides.begin());
+
+				// Without indices there is nothing interesting
+				if (mode == Mode::INTERESTING && ranges.size() == 0) last = 0;
+
+				// For a single index all the values are interesting
+				if (ranges.size() == 1) this->mode = Mode::ALL;
+
+				// Values of different ranges cannot be relabeled together
+				for (auto& range : ranges) {
+					if (range != ranges.front()) this->mode = Mode::ALL;
+				}
+
+				if (!ranges.empty()) this->negative = std::min(negative, ranges.front().GetDimension());
+			}
+		public:
+			Iterator begin() const { return Iterator(this, first); }
+			Iterator end() const { return Iterator(this, last); }
+
+			/**
+				\brief Returns the number of combinations
+
+				In the INTERESTING mode or with a filter the combinations are counted.
+			 */
+			size_t Size() const {
+				if (mode == Mode::ALL && !filter) return last - first;
+
+				size_t result = 0;
+				for (auto it = begin(); it != end(); ++it) ++result;
+				return result;
+			}
+
+			bool IsEmpty() const { return begin() == end(); }
+
+			Packed GetFirst() const { return first; }
+			Packed GetLast() const { return last; }
+		public:
+			/**
+				\brief Checks if the combination is part of the sequence
+			 */
+			bool Contains(const std::vector<unsigned>& combination) const {
+				if (combination.size() != from.size()) return false;
+
+				for (size_t i = 0; i < combination.size(); ++i) {
+					if (combination[i] < from[i] || combination[i] >= from[i] + dimensions[i]) return false;
+				}
+
+				Packed packed = Pack(combination);
+				if (packed < first || packed >= last) return false;
+
+				if (mode == Mode::INTERESTING && FindUninteresting(combination) < combination.size()) return false;
+
+				return !filter || filter(combination);
+			}
+		public:
+			/**
+				\brief The combinations with packed forms in [first, last)
+			 */
+			IndexCombinations Slice(Packed first, Packed last) const {
+				IndexCombinations result = *this;
+				result.first = std::min(std::max(first, this->first), this->last);
+				result.last = std::max(std::min(last, this->last), result.first);
+				return result;
+			}
+
+			/**
+				\brief Only the combinations for which the filter returns true, see Symmetry::IsCanonical
+			 */
+			IndexCombinations Restrict(const Filter& filter) const {
+				IndexCombinations result = *this;
+
+				if (this->filter) {
+					auto previous = this->filter;
+					result.filter = [previous, filter](const std::vector<unsigned>& combination) {
+						return previous(combination) && filter(combination);
+					};
+				} else {
+					result.filter = filter;
+				}
+
+				return result;
+			}
+
+			/**
+				\brief The id-th of count chunks of about the same number of packed forms
+			 */
+			IndexCombinations Chunk(unsigned id, unsigned count) const {
+				Packed size = last - first;
+				Packed chunk = (size + count - 1) / count;
+				return Slice(first + id * chunk, first + (id + 1) * chunk);
+			}
+		public:
+			Packed Pack(const std::vector<unsigned>& combination) const {
+				Packed result = 0;
+				for (size_t i = 0; i < combination.size(); ++i) {
+					result += (combination[i] - from[i]) * strides[i];
+				}
+				return result;
+			}
+
+			void Unpack(Packed packed, std::vector<unsigned>& combination) const {
+				combination.resize(from.size());
+				for (size_t i = 0; i < from.size(); ++i) {
+					combination[i] = from[i] + packed / strides[i];
+					packed %= strides[i];
+				}
+			}
+
+			/**
+				\brief Materialize the combinations
+			 */
+			std::vector<std::vector<unsigned>> ToVector() const {
+				std::vector<std::vector<unsigned>> result;
+				for (auto& combination : *this) {
+					result.push_back(combination);
+				}
+				return result;
+			}
+		private:
+			/**
+				Returns the first position at which a value of a part of the range
+				appears before a smaller value of the same part, or the size of the
+				combination if there is none. All the ranges are the same here.
+			 */
+			size_t FindUninteresting(const std::vector<unsigned>& combination) const {
+				// The next unused value of the negative and of the positive directions
+				unsigned next[2] = { from[0], from[0] + negative };
+
+				for (size_t p = 0; p < combination.size(); ++p) {
+					auto& value = next[(combination[p] < from[0] + negative) ? 0 : 1];
+
+					if (combination[p] == value) ++value;
+					else if (combination[p] > value) return p;
+				}
+
+				return combination.size();
+			}
+		private:
+			Common::SmallVector<unsigned, 12> from;
+			Common::SmallVector<unsigned, 12> dimensions;
+			Common::SmallVector<Packed, 12> strides;
+
+			Mode mode = Mode::ALL;
+			unsigned negative = 0;
+			Filter filter;
+
+			Packed first = 0;
+			Packed last = 0;
+		};
+
+	}
+}
@@ -89,6 +89,22 @@ namespace Construction {
             }
         public:
             virtual std::unique_ptr<AbstractScalar> Clone() const = 0;
+
+            /**
+                \brief Memory of the node including all the nodes it owns
+             */
+            virtual size_t DeepSize() const = 0;
+        public:
+            // Count the scalar nodes, the size is the one of the actual type
+            static void* operator new(size_t size) {
+                Common::MemoryStatistics::ScalarNodes().Allocate(size);
+                return ::operator new(size);
+            }
+
+            static void operator delete(void* pointer, size_t size) {
+                Common::MemoryStatistics::ScalarNodes().Deallocate(size);
+                ::operator delete(pointer);
+            }
         public:
             /** Arithmetics **/
 
@@ -141,6 +157,8 @@ namespace Construction {
             operator double() const { return c; }
 
             virtual double ToDouble() const override { return c; }
+
+            virtual size_t DeepSize() const override { return sizeof(FloatingPointScalar); }
         public:
             virtual void Serialize(std::ostream& os) const override {
                 // Call parent
@@ -204,6 +222,10 @@ namespace Construction {
             inline const ScalarPointer& GetFirst() const { return A; }
             inline const ScalarPointer& GetSecond() const { return B; }
 
+            virtual size_t DeepSize() const override {
+                return sizeof(AddedScalar) + Common::HeapSize(A) + Common::HeapSize(B);
+            }
+
             /*inline ConstScalarPointer GetFirst() const { return A; }
             inline ConstScalarPointer GetSecond() const { return B; }*/
         public:
@@ -276,6 +298,10 @@ namespace Construction {
                 // do nothing
                 return nullptr;
             }
+
+            virtual size_t DeepSize() const override {
+                return sizeof(MultipliedScalar) + Common::HeapSize(A) + Common::HeapSize(B);
+            }
         public:
             friend class AbstractScalar;
         private:
@@ -334,6 +360,10 @@ namespace Construction {
             virtual ExpressionPointer Clone() const override { return std::move(ExpressionPointer(new Scalar(*this))); }
 
             virtual bool IsScalarExpression() const override { return true; }
+
+            virtual size_t DeepSize() const override {
+                return sizeof(Scalar) + Common::HeapSize(printed_text) + Common::HeapSize(pointer);
+            }
         public:
             inline AbstractScalar::Type GetType() const { return pointer->GetType(); }
             inline std::string TypeToString() const { return pointer->TypeToString(); }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <common/error.hpp>
+#include <common/profiler.hpp>
 #include <tensor/scalar.hpp>
 #include <tensor/tensor.hpp>
 
@@ -51,6 +52,7 @@ namespace Construction {
 			}
 
 			inline Tensor operator()(const Tensor& tensor) const {
+                PROFILE_ZONE("Substitution::Apply");
 				return tensor.SubstituteVariables(substitutions);
 			}
 		public:
@@ -79,6 +81,8 @@ namespace Construction {
 
              */
             static Substitution Merge(const std::vector<Substitution>& substitutions) {
+                PROFILE_ZONE("Substitution::Merge");
+
                 if (substitutions.size() == 0) return Substitution();
                 if (substitutions.size() == 1) return substitutions[0];
 
@@ -217,6 +221,10 @@ namespace Construction {
 
 				return std::move(result);
 			}
+		public:
+			virtual size_t DeepSize() const override {
+				return sizeof(Substitution) + Common::HeapSize(printed_text) + Common::HeapSize(substitutions);
+			}
 		private:
 			std::vector< std::pair<Scalar, Scalar> > substitutions;
 		};
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <vector>
+
+#include <tensor/index.hpp>
+
 namespace Construction {
     namespace Tensor {
 
@@ -82,6 +86,10 @@ namespace Construction {
             Used for symmetry deduction to get rid of the numerical evaluation
             as much as possible.
 
+            A (anti)symmetry in single indices is given by their positions,
+            a block (anti)symmetry by the first and last position of every
+            block, where all the blocks have the same length. Exchanging two
+            blocks moves them as a whole.
          */
         class ElementarySymmetry {
         public:
@@ -136,6 +144,53 @@ namespace Construction {
                     } else return Permutation::From(trimmedFirst, trimmedSecond).IsEven();
                 }
             }
+        public:
+            Type GetType() const { return type; }
+
+            bool IsSymmetric() const {
+                return type == Type::SYMMETRY || type == Type::BLOCKSYMMETRY;
+            }
+
+            const std::vector<std::pair<unsigned, unsigned>>& GetBlocks() const { return blocks; }
+        public:
+            /**
+                \brief Checks if the index combination is the representative of its orbit
+
+                The representative has the values of the blocks in increasing
+                lexicographic order. For antisymmetries the order has to be strict,
+                since the component of a combination with two equal blocks vanishes.
+             */
+            bool IsCanonical(const std::vector<unsigned>& combination) const {
+                for (size_t i=1; i<blocks.size(); ++i) {
+                    int order = Compare(combination, blocks[i-1], blocks[i]);
+                    if (order > 0 || (order == 0 && !IsSymmetric())) return false;
+                }
+                return true;
+            }
+
+            /**
+                \brief Bring the blocks of the index combination into increasing order
+             */
+            void Canonicalize(std::vector<unsigned>& combination) const {
+                // Insertion sort, there are only a few blocks
+                for (size_t i=1; i<blocks.size(); ++i) {
+                    for (size_t j=i; j>0 && Compare(combination, blocks[j-1], blocks[j]) > 0; --j) {
+                        for (unsigned k=0; k <= blocks[j].second - blocks[j].first; ++k) {
+                            std::swap(combination[blocks[j-1].first + k], combination[blocks[j].first + k]);
+                        }
+                    }
+                }
+            }
+        private:
+            static int Compare(const std::vector<unsigned>& combination, const std::pair<unsigned, unsigned>& first, const std::pair<unsigned, unsigned>& second) {
+                for (unsigned i=0; i <= first.second - first.first; ++i) {
+                    unsigned a = combination[first.first + i];
+                    unsigned b = combination[second.first + i];
+
+                    if (a != b) return (a < b) ? -1 : 1;
+                }
+                return 0;
+            }
         private:
             std::vector<std::pair<unsigned, unsigned>> blocks;
             Type type;
@@ -143,6 +198,14 @@ namespace Construction {
 
         /**
             \class Symmetry
+
+            \brief The declared symmetries of the indices of a tensor
+
+            Besides comparing index structures, the symmetries reduce the
+            components a tensor has to be evaluated at. Symmetries in disjoint
+            indices and exchanges of blocks with the same inner symmetries
+            generate a group whose orbits have exactly one canonical
+            combination, see Restrict.
          */
         class Symmetry {
         public:
@@ -150,6 +213,58 @@ namespace Construction {
                 symmetries.push_back(symmetry);
             }
 
+            bool IsEmpty() const { return symmetries.empty(); }
+            size_t Size() const { return symmetries.size(); }
+
+            const std::vector<ElementarySymmetry>& GetSymmetries() const { return symmetries; }
+
+            /**
+                \brief Checks if the index combination is the representative of its orbit
+             */
+            bool IsCanonical(const std::vector<unsigned>& combination) const {
+                for (auto& symmetry : symmetries) {
+                    if (!symmetry.IsCanonical(combination)) return false;
+                }
+                return true;
+            }
+
+            /**
+                \brief Returns the representative of the orbit of the index combination
+             */
+            std::vector<unsigned> Canonicalize(std::vector<unsigned> combination) const {
+                // Every step makes the combination lexicographically smaller
+                bool changed = true;
+                while (changed) {
+                    changed = false;
+                    for (auto& symmetry : symmetries) {
+                        if (symmetry.IsCanonical(combination)) continue;
+
+                        auto previous = combination;
+                        symmetry.Canonicalize(combination);
+                        changed = changed || combination != previous;
+                    }
+                }
+                return combination;
+            }
+
+            /**
+                \brief Only keep one combination of every orbit of the symmetries
+
+                The components at the other combinations of an orbit are equal
+                to the one of the representative up to a sign, or vanish. A
+                combination whose representative is not among the combinations,
+                e.g. not interesting, is kept as well, s.t. no component is lost.
+             */
+            IndexCombinations Restrict(const IndexCombinations& combinations) const {
+                if (IsEmpty()) return combinations;
+
+                auto copy = *this;
+                return combinations.Restrict([copy, combinations](const std::vector<unsigned>& combination) {
+                    if (copy.IsCanonical(combination)) return true;
+                    return !combinations.Contains(copy.Canonicalize(combination));
+                });
+            }
+
             bool IsEqual(const Indices& first, const Indices& second, bool ignoreSign=false) const {
                 for (auto& symmetry : symmetries) {
                     if (!symmetry.IsEqual(first, second, ignoreSign)) return false;
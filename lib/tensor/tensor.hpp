@@ -2,12 +2,16 @@
 
 #include <string>
 #include <vector>
+#include <set>
 #include <algorithm>
 #include <numeric>
 #include <cmath>
 #include <memory>
 
-#include <common/task_pool.hpp>
+#include <common/parallel.hpp>
+#include <common/trace.hpp>
+#include <common/profiler.hpp>
+#include <common/memory.hpp>
 #include <common/logger.hpp>
 #include <tensor/permutation.hpp>
 #include <tensor/fraction.hpp>
@@ -136,6 +140,33 @@ namespace Construction {
 			virtual std::unique_ptr<AbstractTensor> Clone() const {
 				return std::unique_ptr<AbstractTensor>(new AbstractTensor(*this));
 			}
+		public:
+			/**
+				\brief Memory of the node including all the nodes it owns
+			 */
+			virtual size_t DeepSize() const {
+				return sizeof(AbstractTensor) + BaseHeapSize();
+			}
+
+			/**
+				\brief Collect the (p,q) signatures of all the metrics in the tensor
+			 */
+			virtual void CollectSignatures(std::set<std::pair<int, int>>& signatures) const { }
+
+			// Count the tensor nodes, the size is the one of the actual type
+			static void* operator new(size_t size) {
+				Common::MemoryStatistics::TensorNodes().Allocate(size);
+				return ::operator new(size);
+			}
+
+			static void operator delete(void* pointer, size_t size) {
+				Common::MemoryStatistics::TensorNodes().Deallocate(size);
+				::operator delete(pointer);
+			}
+		protected:
+			size_t BaseHeapSize() const {
+				return Common::HeapSize(name) + Common::HeapSize(printed_text) + Common::HeapSize(indices);
+			}
 		public:
 			/**
 				Check if two tensors are equal
@@ -165,11 +196,8 @@ namespace Construction {
 				// If the indices do not match, the tensors are clearly not equal
 				if (indices != other.indices) return false;
 
-				// Get all index combinations
-				auto combinations = GetAllIndexCombinations();
-
 				// Iterate over all index combinations
-				for (auto& combination : combinations) {
+				for (auto& combination : GetIndexCombinations()) {
 					// if the components do not match => return false
 					if (Evaluate(combination) != other(combination)) return false;
 				}
@@ -397,11 +425,63 @@ namespace Construction {
 			 	result.
 			 */
 			std::vector<std::vector<unsigned>> GetAllIndexCombinations() const {
-                return indices.GetAllInterestingIndexCombinations();
+                return GetIndexCombinations().ToVector();
 			}
 
 			virtual std::vector<std::vector<unsigned>> GetAllInterestingIndexCombinations() const {
-				return indices.GetAllInterestingIndexCombinations();
+				return GetIndexCombinations().ToVector();
+			}
+
+			/**
+				\brief Returns the index combinations of GetAllIndexCombinations without materializing them
+
+				Only the interesting combinations for the signature of the metrics in
+				the tensor are used, see Indices::GetAllInterestingIndexCombinations.
+				If it contains metrics of different signatures, all the combinations
+				are used.
+			 */
+			IndexCombinations GetIndexCombinations() const {
+				std::set<std::pair<int, int>> signatures;
+				CollectSignatures(signatures);
+
+				// Only the number of negative directions matters
+				std::set<unsigned> negatives;
+				for (auto& signature : signatures) {
+					negatives.insert(std::max(signature.first, 0));
+				}
+
+				if (negatives.size() > 1) return indices.GetCombinations();
+
+				return indices.GetInterestingCombinations((negatives.empty()) ? 0 : *negatives.begin());
+			}
+
+			/**
+				\brief Position of each index of the tensor in the given indices
+
+				Evaluating the tensor at the values of the given indices, picked
+				at these positions, is the same as evaluating the tensor with
+				the IndexAssignments of the given indices, but does not build
+				the assignment for every combination. As for the assignments the
+				indices are matched by name.
+
+				\throws IncompleteIndexAssignmentException
+			 */
+			std::vector<unsigned> GetPositionsIn(const Indices& other) const {
+				std::vector<unsigned> result;
+
+				for (auto& index : indices) {
+					int position = -1;
+
+					// The last index of the same name wins, like in an IndexAssignments
+					for (unsigned i=0; i<other.Size(); ++i) {
+						if (other[i].GetName() == index.GetName()) position = i;
+					}
+
+					if (position < 0) throw IncompleteIndexAssignmentException();
+					result.push_back(position);
+				}
+
+				return result;
 			}
 
 			/**
@@ -413,11 +493,8 @@ namespace Construction {
 			 	not yield zero.
 			 */
 			bool IsZero() const {
-				// Get all index combinations
-				auto combinations = GetAllIndexCombinations();
-
 				// Iterate over all combinations
-				for (auto& combination : combinations) {
+				for (auto& combination : GetIndexCombinations()) {
 					auto r = Evaluate(combination);
 					if (r.HasVariables() || r.ToDouble() != 0) return false;
 					//if (Evaluate(combination) != 0) return false;
@@ -441,7 +518,7 @@ namespace Construction {
 			std::string name;
 			Indices indices;
 
-			TensorType type;
+			TensorType type = TensorType::CUSTOM;
 
 			//EvaluationFunction evaluator;
 		};
@@ -634,6 +711,16 @@ namespace Construction {
 
                 return std::move(TensorPointer(new AddedTensor(std::move(newSummands), indices)));
             }
+		public:
+			virtual size_t DeepSize() const override {
+				return sizeof(AddedTensor) + BaseHeapSize() + Common::HeapSize(summands);
+			}
+
+			virtual void CollectSignatures(std::set<std::pair<int, int>>& signatures) const override {
+				for (auto& summand : summands) {
+					summand->CollectSignatures(signatures);
+				}
+			}
 		private:
 			std::vector<TensorPointer> summands;
 		};
@@ -707,9 +794,9 @@ namespace Construction {
             	\brief Evaluates the tensor component
 
             	Evaluates the tensor components. For this, we first
-            	check the index assignment, then seperate the
-            	assignments into two IndexAssignments objects for each
-            	tensor and assign them to the given tensors.
+            	check the index assignment, then pick the values of
+            	the indices of both tensors from the given ones and
+            	sum over the contracted indices.
 
             	\throws IncompleteIndexAssignmentException
          	 */
@@ -727,51 +814,31 @@ namespace Construction {
                     }
                 }
 
-                // Prepare result
-                Scalar result = 0;
-
-                // Get all the contracted index combinations
-                auto contractedArgs = contracted.GetAllIndexCombinations();
-                bool containsContractions = contractedArgs.size() > 0;
+                // All the indices with a value, the free ones last s.t. they win
+                Indices all = contracted;
+                all.Append(indices);
 
-                // If the tensor does not contain contractions
-                if (!containsContractions) contractedArgs.push_back({0});
+                auto positionsA = A->GetPositionsIn(all);
+                auto positionsB = B->GetPositionsIn(all);
 
-                // Merge with the given args
-                for (auto& args_ : contractedArgs) {
-                    IndexAssignments assignment1;
-                    IndexAssignments assignment2;
-
-                    // Set the value of the contracted indices
-                    if (containsContractions) {
-                        for (unsigned i=0; i<contracted.Size(); ++i) {
-                            assignment1[contracted[i].GetName()] = args_[i];
-                            assignment2[contracted[i].GetName()] = args_[i];
-                        }
-                    }
+                std::vector<unsigned> values (all.Size());
+                std::copy(args.begin(), args.end(), values.begin() + contracted.Size());
 
-                    // Set the values of the rest
-                    {
-                        unsigned i=0;
-                        auto indicesA = A->GetIndices();
-                        auto indicesB = B->GetIndices();
+                std::vector<unsigned> argsA (positionsA.size());
+                std::vector<unsigned> argsB (positionsB.size());
 
-                        // Iterate over all the indices
-                        for (auto& index : indices) {
-                            if (indicesA.ContainsIndex(index)) {
-                                assignment1[index.GetName()] = args[i];
-                            }
+                // Prepare result
+                Scalar result = 0;
 
-                            if (indicesB.ContainsIndex(index)) {
-                                assignment2[index.GetName()] = args[i];
-                            }
+                // Sum over all the contracted index combinations
+                for (auto& combination : contracted.GetCombinations()) {
+                    std::copy(combination.begin(), combination.end(), values.begin());
 
-                            i++;
-                        }
-                    }
+                    for (unsigned i=0; i<positionsA.size(); ++i) argsA[i] = values[positionsA[i]];
+                    for (unsigned i=0; i<positionsB.size(); ++i) argsB[i] = values[positionsB[i]];
 
                     // Add this to the result
-                    result += (*A)(assignment1) * (*B)(assignment2);
+                    result += A->Evaluate(argsA) * B->Evaluate(argsB);
                 }
 
 				return result;
@@ -822,6 +889,15 @@ namespace Construction {
                 bool b = *static_cast<const MultipliedTensor&>(other).A == *B && *static_cast<const MultipliedTensor&>(other).B == *A;
                 return a || b;
             }
+		public:
+			virtual size_t DeepSize() const override {
+				return sizeof(MultipliedTensor) + BaseHeapSize() + Common::HeapSize(A) + Common::HeapSize(B);
+			}
+
+			virtual void CollectSignatures(std::set<std::pair<int, int>>& signatures) const override {
+				A->CollectSignatures(signatures);
+				B->CollectSignatures(signatures);
+			}
 		private:
 			TensorPointer A;
 			TensorPointer B;
@@ -949,6 +1025,14 @@ namespace Construction {
 
 				return TensorPointer(new ScaledTensor(std::move(A), c));
 			}
+		public:
+			virtual size_t DeepSize() const override {
+				return sizeof(ScaledTensor) + BaseHeapSize() + Common::HeapSize(A) + Common::HeapSize(c);
+			}
+
+			virtual void CollectSignatures(std::set<std::pair<int, int>>& signatures) const override {
+				A->CollectSignatures(signatures);
+			}
 		private:
 			ConstTensorPointer A;
 			Scalar c;
@@ -1133,6 +1217,14 @@ namespace Construction {
 				auto A = AbstractTensor::Deserialize(is)->Clone();
 				return TensorPointer(new SubstituteTensor(std::move(A), indices));
 			}
+		public:
+			virtual size_t DeepSize() const override {
+				return sizeof(SubstituteTensor) + BaseHeapSize() + Common::HeapSize(A);
+			}
+
+			virtual void CollectSignatures(std::set<std::pair<int, int>>& signatures) const override {
+				A->CollectSignatures(signatures);
+			}
 		private:
 			TensorPointer A;
 		};
@@ -1200,6 +1292,10 @@ namespace Construction {
 			}
         public:
             Scalar GetValue() const { return value; }
+		public:
+			virtual size_t DeepSize() const override {
+				return sizeof(ScalarTensor) + BaseHeapSize() + Common::HeapSize(value);
+			}
 		private:
 			Scalar value;
 		};
@@ -1669,6 +1765,14 @@ namespace Construction {
 
 				return TensorPointer(new GammaTensor(indices, p, q));
 			}
+		public:
+			virtual size_t DeepSize() const override {
+				return sizeof(GammaTensor) + BaseHeapSize();
+			}
+
+			virtual void CollectSignatures(std::set<std::pair<int, int>>& signatures) const override {
+				signatures.insert(signature);
+			}
 		private:
 			std::pair<int, int> signature;
 		};
@@ -1920,6 +2024,10 @@ namespace Construction {
 				unsigned numGamma = (indices.Size() % 2 == 0) ? indices.Size()/2 : (indices.Size()-3)/2;
 				return std::move(TensorPointer(new EpsilonGammaTensor(numEpsilon, numGamma, indices)));*/
 			}
+		public:
+			virtual size_t DeepSize() const override {
+				return sizeof(EpsilonGammaTensor) + BaseHeapSize();
+			}
 		private:
 			unsigned numEpsilon;
 			unsigned numGamma;
@@ -2017,6 +2125,15 @@ namespace Construction {
 					result = std::move(EpsilonGammaTensor::DoDeserialize(is, indices));
 					break;
 
+				// Only consist of their indices
+				case TensorType::EPSILON:
+					result = TensorPointer(new EpsilonTensor(indices));
+					break;
+
+				case TensorType::DELTA:
+					result = TensorPointer(new DeltaTensor(indices));
+					break;
+
 				case TensorType::SUBSTITUTE:
 					result = std::move(SubstituteTensor::DoDeserialize(is, indices));
 					break;
@@ -2159,6 +2276,8 @@ namespace Construction {
 			inline bool AllRangesEqual() const { return pointer->AllRangesEqual(); }
 
 			inline std::vector<std::vector<unsigned>> GetAllIndexCombinations() const { return pointer->GetAllIndexCombinations(); }
+			inline IndexCombinations GetIndexCombinations() const { return pointer->GetIndexCombinations(); }
+			inline std::vector<unsigned> GetPositionsIn(const Indices& indices) const { return pointer->GetPositionsIn(indices); }
 
 			inline bool IsZero() const { return pointer->IsZero(); }
 		public:
@@ -2205,6 +2324,38 @@ namespace Construction {
                 return false;
 			}
 
+			/**
+				\brief Returns all the variables in the scale factors of the summands
+
+				Returns every variable that appears in front of the summands
+				exactly once. In contrast to ExtractVariables this does not
+				expand the tensor.
+			 */
+			std::vector<scalar_type> GetVariables() const {
+				std::vector<scalar_type> result;
+                auto summands = GetSummands();
+
+                for (auto& t : summands) {
+                    auto variables = t.SeparateScalefactor().first.GetVariables();
+
+                    for (auto& variable : variables) {
+                        if (std::find(result.begin(), result.end(), variable) == result.end()) {
+                            result.push_back(std::move(variable));
+                        }
+                    }
+                }
+
+                return result;
+			}
+
+			/**
+				\brief Number of summands without copying them
+			 */
+			size_t GetNumberOfSummands() const {
+				if (IsAdded()) return As<AddedTensor>()->Size();
+				return IsZeroTensor() ? 0 : 1;
+			}
+
 			/**
 				\brief Splits the tensor in its summands
 
@@ -2240,6 +2391,8 @@ namespace Construction {
 				\returns {Tensor}	The expanded tensorial expression
 			 */
 			Tensor Expand() const {
+                PROFILE_ZONE("Tensor::Expand");
+
 				// Look at sums
 				if (IsAdded()) {
 					auto summands = GetSummands();
@@ -2320,6 +2473,8 @@ namespace Construction {
                 `Canonicalize` and assumes that its result is unique.
              */
             Tensor FastSimplify() const {
+                PROFILE_ZONE("Tensor::FastSimplify");
+
                 if (IsScaled()) {
                     auto pair = SeparateScalefactor();
                     return pair.first * pair.second.FastSimplify();
@@ -2374,9 +2529,16 @@ namespace Construction {
 				equal if they have the same components in one coordinate system, this is completely
 				fine.
 
+				If every summand is known to have the given symmetries, e.g. since they
+				were symmetrized, only one component of every orbit is evaluated. The
+				symmetries are not passed on to the parts of scaled or multiplied tensors.
+
+				\param symmetry		The symmetries of each summand in the positions of the indices
 				\returns {Tensor}	The simplified tensorial expression
 			 */
-			Tensor Simplify() const {
+			Tensor Simplify(const Symmetry& symmetry = Symmetry()) const {
+                PROFILE_ZONE("Tensor::Simplify");
+
                 Construction::Logger::Debug("Simplify a tensor");
 
 				// Scaling heuristics
@@ -2403,54 +2565,35 @@ namespace Construction {
 
 				// Get the indices of the resulting tensor
 				auto indices = GetIndices();
-				auto combinations = GetAllIndexCombinations();
+				auto combinations = symmetry.Restrict(GetIndexCombinations());
 
-				unsigned dimension = combinations.size();
+				unsigned dimension = combinations.Size();
+
+                Common::TraceScope trace ("Simplify");
+                if (trace.IsEnabled()) {
+                    trace.Set("summands", summands.size());
+                    trace.Set("rows", dimension);
+                    trace.Set("columns", summands.size());
+                }
 
 				Vector::Matrix<Construction::Tensor::Fraction> M (dimension, summands.size());
 
 				// Insert the values into the matrix
 				{
-					std::mutex mutex;
-
-                    Common::TaskPool pool(4);
-
-					for (int i=0; i<summands.size(); i++) {
-						pool.Enqueue([&](unsigned id, const Tensor& tensor) {
-
-							for (int j=0; j<dimension; j++) {
-								IndexAssignments assignment;
-
-								// Convert into index assignment
-                        		int k = 0;
-                        		for (auto &index : indices) {
-                            		assignment[index.GetName()] = combinations[j][k];
-                            		k++;
-                        		}
+                    // Evaluate the columns in parallel
+                    std::vector<std::vector<std::pair<unsigned, Construction::Tensor::Fraction>>> columns (summands.size());
 
-                        		// Calculate the value of the assignment
-                                Construction::Tensor::Fraction value;
-
-                                {
-                                    auto _value = tensor(assignment);
-                                    if (_value.IsFraction())
-                                        value = *_value.As<Fraction>();
-                                    else value = Construction::Tensor::Fraction::FromDouble(_value.ToDouble());
-                                }
-
-                        		// only lock and insert if necessary
-                        		if (value != Construction::Tensor::Fraction(0)) {
-                        			std::unique_lock<std::mutex> lock(mutex);
-
-                        			// Insert the value into the matrix
-                        			M(j,id) = value;
-                        		}
-							}
+                    Parallel::For(0, summands.size(), [&](size_t id) {
+                        auto tensor = summands[id].SeparateScalefactor().second;
+                        columns[id] = EvaluateColumn(tensor, indices, combinations);
+                    });
 
-						}, i, summands[i].SeparateScalefactor().second);
+                    // Insert the values into the matrix
+                    for (unsigned id=0; id<columns.size(); ++id) {
+                        for (auto& entry : columns[id]) {
+                            M(entry.first, id) = entry.second;
+                        }
                     }
-
-					pool.Wait();
 				}
 
                 Construction::Logger::Debug("Finished insert into matrix");
@@ -2567,7 +2710,7 @@ namespace Construction {
 			}
 
             Tensor CollectByVariables() const {
-                Construction::Logger::Debug("Collect by variables in tensor ", ToString());
+                LOGGER_DEBUG("Collect by variables in tensor ", ToString());
 
                 // Expand first
                 auto expanded = Expand();
@@ -2627,7 +2770,7 @@ namespace Construction {
 			}
 
 			Tensor SubstituteVariables(const std::vector<std::pair<scalar_type, scalar_type>>& substitutions) const {
-                Construction::Logger::Debug("Substitute variables into ", ToString());
+                LOGGER_DEBUG("Substitute variables into ", ToString());
 
 				Tensor result = *this;
 
@@ -2635,7 +2778,7 @@ namespace Construction {
 					result = std::move(result.SubstituteVariable(substitution.first, substitution.second));
 				}
 
-                Construction::Logger::Debug("Finished substitution. Result is: ", result.ToString(), ". Collect by variables ...");
+                LOGGER_DEBUG("Finished substitution. Result is: ", result.ToString(), ". Collect by variables ...");
 
 				return result;//.CollectByVariables();
 			}
@@ -2683,7 +2826,7 @@ namespace Construction {
 				auto expanded = Expand();
 
 				if (expanded.IsZeroTensor()) {
-					Construction::Logger::Debug("Expanding ", ToString(), " yields zero");
+					LOGGER_DEBUG("Expanding ", ToString(), " yields zero");
 				} else {
 					Construction::Logger::Debug("Expanded the equation into ", expanded);
 				}
@@ -2738,12 +2881,55 @@ namespace Construction {
 				return result;
 			}
 
+			/**
+				\brief Evaluate a tensor for all the given index combinations
+
+				The combinations are the values of the given indices, which
+				have to contain all the indices of the tensor. Returns the
+				non-zero values together with the number of the combination,
+				i.e. the row in a matrix. Throws if a value is not a number,
+				e.g. because the tensor still contains variables.
+			 */
+			static std::vector<std::pair<unsigned, Fraction>> EvaluateColumn(const Tensor& tensor, const Indices& indices, const IndexCombinations& combinations) {
+				std::vector<std::pair<unsigned, Fraction>> result;
+				if (combinations.IsEmpty()) return result;
+
+				auto positions = tensor.GetPositionsIn(indices);
+				std::vector<unsigned> args (positions.size());
+
+				unsigned j = 0;
+				for (auto& combination : combinations) {
+					for (unsigned i=0; i<positions.size(); ++i) {
+						args[i] = combination[positions[i]];
+					}
+
+                    auto s = tensor(args);
+
+                    Fraction value;
+                    if (s.IsFraction()) {
+                        value = *s.As<Fraction>();
+                    } else if (s.IsFloatingPoint()) {
+                        value = Fraction::FromDouble(s.ToDouble());
+                    } else {
+                        // A variable or a sum would silently become zero otherwise
+                        throw Exception("Cannot evaluate `" + s.ToString() + "` to a number");
+                    }
+
+                    if (value != Fraction(0)) result.push_back({ j, value });
+                    ++j;
+				}
+
+				return result;
+			}
+
 			/**
 				\brief Convert the tensorial equation into a homogeneous linear system
 
 
 			 */
 			std::pair< Vector::Matrix<Construction::Tensor::Fraction>, std::vector<scalar_type> > ToHomogeneousLinearSystem() const {
+                PROFILE_ZONE("Tensor::ToHomogeneousLinearSystem");
+
                 // Ignore zero tensors
                 if (IsZeroTensor()) {
                     return { Vector::Matrix<Construction::Tensor::Fraction>(0,0), { } };
@@ -2754,43 +2940,33 @@ namespace Construction {
 
 				// Get all the index assignments
 				auto indices = GetIndices();
-				auto combinations = GetAllIndexCombinations();
+				auto combinations = GetIndexCombinations();
 
 				// Get the dimensions of the system
-				unsigned n = combinations.size();
+				unsigned n = combinations.Size();
 				unsigned m = variables.size();
 
 				// Create matrix
 				Vector::Matrix<Construction::Tensor::Fraction> M(n, m);
 				std::vector<scalar_type> _variables;
 
-				// Iterate over all variables
-				int i = 0;
 				for (auto& pair : variables) {
 					_variables.push_back(pair.first);
+				}
 
-					// Evaluate all the components
-					for (int j=0; j<combinations.size(); j++) {
-						IndexAssignments assignment;
-
-                        // Convert into index assignment
-                        int k = 0;
-                        for (auto &index : indices) {
-                            assignment[index.GetName()] = combinations[j][k];
-                            k++;
-                        }
+				// Evaluate all the components of the variables in parallel
+                std::vector<std::vector<std::pair<unsigned, Construction::Tensor::Fraction>>> columns (m);
 
-                        // Plug the value of the assignment into the matrix
-                        auto s = (pair.second)(assignment);
-                        if (s.IsFraction()) {
-                            M(j,i) = *s.As<Fraction>();
-                        } else if (s.IsFloatingPoint()) {
-                            M(j, i) = Fraction::FromDouble(s.ToDouble());
-                        }
-					}
+                Parallel::For(0, m, [&](size_t i) {
+                    columns[i] = EvaluateColumn(variables[i].second, indices, combinations);
+                });
 
-					i++;
-				}
+                // Plug the values into the matrix
+                for (unsigned i=0; i<m; ++i) {
+                    for (auto& entry : columns[i]) {
+                        M(entry.first, i) = entry.second;
+                    }
+                }
 
                 Construction::Logger::Debug("Finished matrix for equation");
 
@@ -2881,7 +3057,9 @@ namespace Construction {
                 \returns    Tensor          The symmetrized tensor
              */
 			Tensor Symmetrize(const Indices& indices) const {
-                Construction::Logger::Debug("Start symmetrization of ", ToString());
+                PROFILE_ZONE("Tensor::Symmetrize");
+
+                LOGGER_DEBUG("Start symmetrization of ", ToString());
 
 				// Handle sums differently
 				if (IsAdded()) {
@@ -2893,28 +3071,16 @@ namespace Construction {
 
 					// Symmetrize all the summands in parallel
 					{
-						bool firstEntry = true;
-						std::mutex mutex;
-
-                        Common::TaskPool pool(1);
-
-						symmetrizedSummands = pool.Map<std::pair<scalar_type,Tensor>, Tensor>(summands, [&](const Tensor& tensor) {
-							auto result = tensor.Symmetrize(indices).SeparateScalefactor();
-
-							// Extract the scale of the first entry
-							{
-								std::unique_lock<std::mutex> lock(mutex);
-								if (firstEntry) {
-									firstEntry = false;
-									overalScale = result.first;
-								}
-							}
+						Parallel::Map(summands, symmetrizedSummands, [&](const Tensor& tensor) {
+							return tensor.Symmetrize(indices).SeparateScalefactor();
+						});
 
-							// If this has a different scale, remember this
-							if (overalScale != result.first) hasSameScale = false;
+						// Check if all the summands have the same scale as the first one
+						if (!symmetrizedSummands.empty()) overalScale = symmetrizedSummands[0].first;
 
-							return result;
-						});
+						for (auto& summand : symmetrizedSummands) {
+							if (overalScale != summand.first) hasSameScale = false;
+						}
 
                         // Sort by indices
                         std::sort(symmetrizedSummands.begin(), symmetrizedSummands.end(), [&](const std::pair<scalar_type, Tensor>& a, const std::pair<scalar_type, Tensor>& b) {
@@ -3068,9 +3234,7 @@ namespace Construction {
 
 					// Move the tensors on the stack
 					{
-                        Common::TaskPool pool(1);
-
-						stack = pool.Map<Tensor,Indices>(permutations, [this](const Indices& indices) {
+						Parallel::Map(permutations, stack, [this](const Indices& indices) {
 							Tensor clone = *this;
 							clone.SetIndices(indices);
 							return clone.Canonicalize();
@@ -3143,6 +3307,8 @@ namespace Construction {
                 \returns    Tensor          The anti-symmetrized tensor
              */
 			Tensor AntiSymmetrize(const Indices& indices) const {
+                PROFILE_ZONE("Tensor::AntiSymmetrize");
+
                 // Handle sums differently
 				if (IsAdded()) {
 					auto summands = GetSummands();
@@ -3153,28 +3319,16 @@ namespace Construction {
 
 					// Symmetrize all the summands in parallel
 					{
-						bool firstEntry = true;
-						std::mutex mutex;
-
-                        Common::TaskPool pool(4);
-
-						symmetrizedSummands = pool.Map<std::pair<scalar_type,Tensor>, Tensor>(summands, [&](const Tensor& tensor) {
-							auto result = tensor.AntiSymmetrize(indices).SeparateScalefactor();
-
-							// Extract the scale of the first entry
-							{
-								std::unique_lock<std::mutex> lock(mutex);
-								if (firstEntry) {
-									firstEntry = false;
-									overalScale = result.first;
-								}
-							}
+						Parallel::Map(summands, symmetrizedSummands, [&](const Tensor& tensor) {
+							return tensor.AntiSymmetrize(indices).SeparateScalefactor();
+						});
 
-							// If this has a different scale, remember this
-                            if (overalScale != result.first && overalScale != -result.first) hasSameScale = false;
+						// Check if all the summands have the same scale (up to a sign) as the first one
+						if (!symmetrizedSummands.empty()) overalScale = symmetrizedSummands[0].first;
 
-							return result;
-						});
+						for (auto& summand : symmetrizedSummands) {
+                            if (overalScale != summand.first && overalScale != -summand.first) hasSameScale = false;
+						}
 					}
 
 					Tensor result = Tensor::Zero();
@@ -3292,9 +3446,7 @@ namespace Construction {
 					{
                         auto originalIndices = GetIndices();
 
-                        Common::TaskPool pool(4);
-
-						stack = pool.Map<Tensor,Indices>(permutations, [this, &originalIndices](const Indices& indices) {
+						Parallel::Map(permutations, stack, [this, &originalIndices](const Indices& indices) {
 							Tensor clone = *this;
 							clone.SetIndices(indices);
 
@@ -3355,7 +3507,9 @@ namespace Construction {
                 Exchange symmetrizes the tensor
              */
             Tensor ExchangeSymmetrize(const Indices& from, const Indices& indices) const {
-                Construction::Logger::Debug("Start exchange symmetrization of ", ToString());
+                PROFILE_ZONE("Tensor::ExchangeSymmetrize");
+
+                LOGGER_DEBUG("Start exchange symmetrization of ", ToString());
 
                 if (IsAdded()) {
                     auto summands = GetSummands();
@@ -3367,8 +3521,6 @@ namespace Construction {
 
 					// Symmetrize all the summands in parallel
 					{
-						bool firstEntry = true;
-						std::mutex mutex;
                         auto originalIndices = GetIndices();
 
                         // Generate tensor mapping
@@ -3377,30 +3529,18 @@ namespace Construction {
                             mapping[from[i]] = indices[i];
                         }
 
-                        Common::TaskPool pool(4);
-
-						symmetrizedSummands = pool.Map<std::pair<scalar_type,Tensor>, Tensor>(summands, [&](const Tensor& tensor) {
+						Parallel::Map(summands, symmetrizedSummands, [&](const Tensor& tensor) {
                             // Call exchange symmetrization on the summand
-							auto result = tensor.ExchangeSymmetrize(tensor.GetIndices(), tensor.GetIndices().Shuffle(mapping)).SeparateScalefactor();
-
-							// Extract the scale of the first entry
-							{
-								std::unique_lock<std::mutex> lock(mutex);
-
-								if (firstEntry) {
-									firstEntry = false;
-									overalScale = result.first;
-								}
-							}
+							return tensor.ExchangeSymmetrize(tensor.GetIndices(), tensor.GetIndices().Shuffle(mapping)).SeparateScalefactor();
+                        });
 
-							// If this has a different scale, remember this
-                            if (overalScale != result.first && overalScale != -result.first) hasSameScale = false;
-                            if (!hasVariables) {
-                                if (result.first.HasVariables()) hasVariables = true;
-                            }
+						// Check if all the summands have the same scale (up to a sign) as the first one
+						if (!symmetrizedSummands.empty()) overalScale = symmetrizedSummands[0].first;
 
-                            return result;
-                        });
+						for (auto& summand : symmetrizedSummands) {
+                            if (overalScale != summand.first && overalScale != -summand.first) hasSameScale = false;
+                            if (summand.first.HasVariables()) hasVariables = true;
+						}
 
                         // If all have the same scale, expand the sum and sort by indices
                         if (!hasVariables) {
@@ -3675,18 +3815,31 @@ namespace Construction {
 				// Split into the summands
 				auto summands = GetSummands();
 
-                Common::TaskPool pool;
-
 				// Map in parallel
-                std::vector<Tensor> result = pool.MapEmit<Tensor, Tensor>(summands,  [&](const Tensor& tensor, std::function<void(Tensor&&)> emit) -> void {
-                    auto transformed = fn(std::move(tensor));
+                std::vector<Tensor> transformed;
+                Parallel::Map(summands, transformed, fn);
 
-                    if (!transformed.IsZeroTensor()) emit(std::move(transformed));
-                });
+                // Drop the zeros
+                std::vector<Tensor> result;
+                result.reserve(transformed.size());
+
+                for (auto& tensor : transformed) {
+                    if (!tensor.IsZeroTensor()) result.push_back(std::move(tensor));
+                }
 
 				return Tensor::Add(std::move(result));
 			}
 		public:
+			/**
+				\brief Memory of the tensor including all its nodes
+			 */
+			virtual size_t DeepSize() const override {
+				return sizeof(Tensor) + Common::HeapSize(printed_text) + Common::HeapSize(pointer);
+			}
+
+			/**
+				\brief Size of the top node only, see DeepSize() for the whole tree
+			 */
 			size_t Size() const {
 				switch (pointer->GetType()) {
 					case AbstractTensor::TensorType::ADDITION:
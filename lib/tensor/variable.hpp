@@ -34,6 +34,10 @@ namespace Construction {
             virtual ScalarPointer Clone() const override {
                 return ScalarPointer(new Variable(*this));
             }
+
+            virtual size_t DeepSize() const override {
+                return sizeof(Variable) + Common::HeapSize(name) + Common::HeapSize(printed_text);
+            }
         public:
             virtual std::string ToString() const override { 
                 return printed_text;
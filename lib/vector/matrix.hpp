@@ -2,6 +2,10 @@
 
 #include <common/logger.hpp>
 #include <common/error.hpp>
+#include <common/trace.hpp>
+#include <common/profiler.hpp>
+#include <common/statistics.hpp>
+#include <common/memory.hpp>
 #include <vector/vector.hpp>
 
 #include <iomanip>
@@ -70,6 +74,8 @@ namespace Construction {
             bool operator!=(const MatrixIndex& other) const {
                 return (row != other.row) || (column != other.column);
             }
+        public:
+            size_t DeepSize() const { return sizeof(MatrixIndex); }
         private:
             unsigned row;
             unsigned column;
@@ -438,6 +444,23 @@ namespace Construction {
                 \brief Returns the row echelon form of the matrix
              */
             void ToRowEchelonForm() {
+                PROFILE_ZONE("Matrix::ToRowEchelonForm");
+
+                Common::TraceScope trace ("ToRowEchelonForm");
+                if (trace.IsEnabled()) {
+                    trace.Set("rows", GetNumberOfRows());
+                    trace.Set("columns", GetNumberOfColumns());
+                }
+
+                // Remember the size of the largest matrix
+                {
+                    auto statistics = Common::Statistics::Instance();
+                    statistics->Maximum("matrix.rows", GetNumberOfRows());
+                    statistics->Maximum("matrix.columns", GetNumberOfColumns());
+                    statistics->Maximum("matrix.entries", static_cast<long long>(GetNumberOfRows()) * GetNumberOfColumns());
+                    statistics->Maximum("matrix.bytes", DeepSize());
+                }
+
                 // Get the number of rows
                 unsigned numRows = GetNumberOfRows();
 
@@ -467,6 +490,7 @@ namespace Construction {
                 // Do magic
                 unsigned lead=0;
                 for (unsigned r=0; r<numRows; ++r) {
+                    trace.Set("rank", r);
                     if (lead >= GetNumberOfColumns()) return;
 
                     // Search for first line that has a non-zero entry as pivot element
@@ -508,8 +532,10 @@ namespace Construction {
                     }
                     lead++;
 
-                    Construction::Logger::Debug("Gauss step: ", ToString(false));
+                    LOGGER_DEBUG("Gauss step: ", ToString(false));
                 }
+
+                trace.Set("rank", numRows);
             }
         public:
             void SwapRows(unsigned i, unsigned j) {
@@ -581,11 +607,21 @@ namespace Construction {
                 os << v.ToString();
                 return os;
             }
+        public:
+            /**
+                \brief Memory of the matrix including all its entries
+             */
+            size_t DeepSize() const {
+                return sizeof(Matrix) + Common::HeapSize(values);
+            }
         private:
+            // The entries are counted in the global memory statistics
+            typedef Common::CountingAllocator<std::pair<const MatrixIndex, T>, &Common::MemoryStatistics::MatrixEntries> Allocator;
+
             unsigned n;
             unsigned m;
 
-            std::map<MatrixIndex, T> values;
+            std::map<MatrixIndex, T, std::less<MatrixIndex>, Allocator> values;
         };
 
     }
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <vector>
+#include <limits>
+
+#include <common/logger.hpp>
+#include <common/profiler.hpp>
+
+namespace Construction {
+    namespace Vector {
+
+        /**
+            \class SparseSystem
+
+            \brief Sparse homogeneous linear system
+
+            Homogeneous linear system whose rows are stored as sparse maps
+            from the column to the (non-zero) value. Rows are normalized
+            on insertion, such that their first non-zero entry is one, which
+            allows to drop rows that are multiples of each other.
+
+            The system is reduced with a fill-reducing ordering: in every
+            step the pivot is taken from the shortest remaining row, in the
+            column that appears in the fewest rows (a restricted Markowitz
+            criterion). The pivot column is eliminated from all other rows,
+            so after the reduction every pivot row expresses its pivot variable
+            in terms of the free variables only.
+         */
+        template<class T>
+        class SparseSystem {
+        public:
+            typedef std::map<unsigned, T>   Row;
+        public:
+            /**
+                \brief Insert a row into the system
+
+                Returns false if the row is zero or a multiple of a row
+                that was inserted before.
+             */
+            bool Insert(Row row) {
+                // Remove zeros
+                for (auto it = row.begin(); it != row.end();) {
+                    if (it->second == T(0)) it = row.erase(it);
+                    else ++it;
+                }
+
+                if (row.empty()) return false;
+
+                // Normalize
+                T first = row.begin()->second;
+                for (auto& entry : row) {
+                    entry.second /= first;
+                }
+
+                // Ignore duplicates
+                if (!known.insert(row).second) return false;
+
+                unsigned id = rows.size();
+
+                for (auto& entry : row) {
+                    columns[entry.first].insert(id);
+                }
+
+                rows.push_back(std::move(row));
+                pivots.push_back(NO_PIVOT);
+
+                return true;
+            }
+        public:
+            size_t GetNumberOfRows() const { return rows.size(); }
+
+            size_t GetNumberOfPivots() const {
+                size_t result = 0;
+                for (auto& pivot : pivots) {
+                    if (pivot != NO_PIVOT) ++result;
+                }
+                return result;
+            }
+        public:
+            /**
+                \brief Reduce the system
+
+                Performs a Gauss-Jordan elimination of the rows in the
+                order given by the fill-reducing pivot strategy.
+             */
+            void Reduce() {
+                PROFILE_ZONE("SparseSystem::Reduce");
+
+                std::set<std::pair<size_t, unsigned>> active;
+                for (unsigned i=0; i<rows.size(); ++i) {
+                    if (pivots[i] == NO_PIVOT && !rows[i].empty()) active.insert({ rows[i].size(), i });
+                }
+
+                while (!active.empty()) {
+                    // Take the shortest row
+                    auto current = *active.begin();
+                    active.erase(active.begin());
+
+                    unsigned r = current.second;
+                    auto& row = rows[r];
+
+                    if (row.empty()) continue;
+
+                    // Take the column with the fewest entries
+                    unsigned column = row.begin()->first;
+                    size_t count = std::numeric_limits<size_t>::max();
+
+                    for (auto& entry : row) {
+                        auto size = columns[entry.first].size();
+                        if (size < count) {
+                            count = size;
+                            column = entry.first;
+                        }
+                    }
+
+                    // Normalize the pivot row
+                    T x = row[column];
+                    for (auto& entry : row) {
+                        entry.second /= x;
+                    }
+
+                    pivots[r] = column;
+
+                    // Eliminate the column from all the other rows
+                    auto others = columns[column];
+                    for (auto i : others) {
+                        if (i == r) continue;
+
+                        bool isActive = pivots[i] == NO_PIVOT;
+                        if (isActive) active.erase({ rows[i].size(), i });
+
+                        Eliminate(i, r, column);
+
+                        if (isActive && !rows[i].empty()) active.insert({ rows[i].size(), i });
+                    }
+                }
+
+                Construction::Logger::Debug("Reduced sparse system with ", rows.size(), " rows to ", GetNumberOfPivots(), " pivots");
+            }
+        public:
+            /**
+                \brief Iterate over the reduced rows
+
+                Calls the function with the pivot column and the row for
+                every pivot row in the system.
+             */
+            template<class F>
+            void ForEachPivot(F fn) const {
+                for (unsigned i=0; i<rows.size(); ++i) {
+                    if (pivots[i] != NO_PIVOT) fn(pivots[i], rows[i]);
+                }
+            }
+        private:
+            /**
+                Subtracts the multiple of the pivot row from the i-th row
+                which eliminates the given column
+             */
+            void Eliminate(unsigned i, unsigned pivotRow, unsigned column) {
+                auto& row = rows[i];
+                T factor = row[column];
+
+                for (auto& entry : rows[pivotRow]) {
+                    auto it = row.find(entry.first);
+
+                    if (it == row.end()) {
+                        row.insert({ entry.first, -factor * entry.second });
+                        columns[entry.first].insert(i);
+                        continue;
+                    }
+
+                    it->second -= factor * entry.second;
+
+                    if (it->second == T(0)) {
+                        columns[entry.first].erase(i);
+                        row.erase(it);
+                    }
+                }
+            }
+        private:
+            static constexpr unsigned NO_PIVOT = std::numeric_limits<unsigned>::max();
+
+            std::vector<Row> rows;
+            std::vector<unsigned> pivots;
+            std::map<unsigned, std::set<unsigned>> columns;
+            std::set<Row> known;
+        };
+
+        template<class T>
+        constexpr unsigned SparseSystem<T>::NO_PIVOT;
+
+    }
+}
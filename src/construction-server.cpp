@@ -0,0 +1,5 @@
+#include <cmd/server.hpp>
+
+int main(int argc, char** argv) {
+    return Cobalt::Execute<Construction::Cmd::ServerCommand>(argc, argv);
+}
@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include <common/logger.hpp>
+
+namespace {
+
+    std::string CountedMessage(int& evaluations) {
+        ++evaluations;
+        return "message";
+    }
+
+    std::string TemporaryFilename() {
+        char filename[] = "/tmp/logger_test_XXXXXX";
+        int descriptor = mkstemp(filename);
+        if (descriptor >= 0) close(descriptor);
+        return filename;
+    }
+
+}
+
+SCENARIO("Logger", "[logger]") {
+    auto manager = Construction::Common::LoggerManager::Instance();
+
+    GIVEN(" a file logger that only prints errors") {
+        std::string filename = TemporaryFilename();
+
+        Construction::Logger::File("test", filename);
+        manager->SetDebugLevel("test", Construction::Common::DebugLevel::ERROR);
+
+        WHEN(" logging below the level") {
+            int evaluations = 0;
+            LOGGER_INFO("Info ", CountedMessage(evaluations));
+
+            THEN(" the arguments are not evaluated") {
+                REQUIRE(evaluations == 0);
+                REQUIRE(!Construction::Logger::IsEnabled(Construction::Common::DebugLevel::INFO));
+            }
+        }
+
+        WHEN(" logging an error") {
+            int evaluations = 0;
+            LOGGER_ERROR("Error ", CountedMessage(evaluations));
+
+            THEN(" it is written to the file") {
+                REQUIRE(evaluations == 1);
+
+                std::ifstream file (filename);
+                std::stringstream ss;
+                ss << file.rdbuf();
+
+                REQUIRE(ss.str().find("Error ") != std::string::npos);
+                REQUIRE(ss.str().find("message") != std::string::npos);
+            }
+        }
+
+        manager->SetDebugLevel("test", Construction::Common::DebugLevel::NOTHING);
+        std::remove(filename.c_str());
+    }
+}
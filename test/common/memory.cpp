@@ -0,0 +1,61 @@
+#include <common/memory.hpp>
+#include <tensor/tensor.hpp>
+
+using Construction::Common::MemoryStatistics;
+using Construction::Tensor::Indices;
+
+SCENARIO("Memory accounting", "[memory]") {
+
+    GIVEN(" a tensor and the sum of two tensors") {
+        auto A = Construction::Tensor::Tensor::Gamma(Indices::GetRomanSeries(2, {1,3}));
+        auto B = Construction::Tensor::Tensor::Delta(Indices::GetRomanSeries(2, {1,3}));
+
+        auto sum = A + B;
+
+        THEN(" the deep size contains the summands") {
+            REQUIRE(sum.IsAdded());
+            REQUIRE(A.DeepSize() > A.Size());
+            REQUIRE(sum.DeepSize() > A.DeepSize() + B.DeepSize() - 2 * sizeof(Construction::Tensor::Tensor));
+        }
+    }
+
+    GIVEN(" the counter of the tensor nodes") {
+        auto& counter = MemoryStatistics::TensorNodes();
+
+        counter.Flush();
+        auto live = counter.GetLive();
+        auto allocations = counter.GetAllocations();
+
+        {
+            auto A = Construction::Tensor::Tensor::Gamma(Indices::GetRomanSeries(2, {1,3}));
+            counter.Flush();
+
+            THEN(" the node is counted while it lives") {
+                REQUIRE(counter.GetLive() == live + 1);
+                REQUIRE(counter.GetAllocations() == allocations + 1);
+            }
+        }
+
+        counter.Flush();
+
+        THEN(" it is released afterwards") {
+            REQUIRE(counter.GetLive() == live);
+        }
+    }
+
+    GIVEN(" a thread that allocates less than a batch") {
+        auto& counter = MemoryStatistics::TensorNodes();
+
+        counter.Flush();
+        auto allocations = counter.GetAllocations();
+
+        std::thread thread ([]() {
+            auto A = Construction::Tensor::Tensor::Gamma(Indices::GetRomanSeries(2, {1,3}));
+        });
+        thread.join();
+
+        THEN(" its changes are added when it exits") {
+            REQUIRE(counter.GetAllocations() == allocations + 1);
+        }
+    }
+}
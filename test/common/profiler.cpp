@@ -0,0 +1,78 @@
+#include <thread>
+
+#include <common/profiler.hpp>
+
+namespace {
+
+    void ProfiledLeaf() {
+        PROFILE_ZONE("Leaf");
+    }
+
+    void ProfiledRecursion(int depth) {
+        PROFILE_ZONE("Recursion");
+        if (depth > 0) ProfiledRecursion(depth - 1);
+    }
+
+}
+
+SCENARIO("Profiler", "[profiler]") {
+    auto profiler = Construction::Common::Profiler::Instance();
+
+    GIVEN(" a disabled profiler") {
+        Construction::Common::Profiler::Disable();
+        profiler->Reset();
+
+        ProfiledLeaf();
+
+        THEN(" nothing is recorded") {
+            REQUIRE(profiler->GetReport().empty());
+        }
+    }
+
+    GIVEN(" nested zones in several threads") {
+        Construction::Common::Profiler::Enable();
+        profiler->Reset();
+
+        auto work = []() {
+            PROFILE_ZONE("Outer");
+
+            for (int i=0; i<3; ++i) {
+                ProfiledLeaf();
+            }
+
+            ProfiledRecursion(4);
+        };
+
+        std::thread first (work);
+        std::thread second (work);
+        first.join();
+        second.join();
+
+        Construction::Common::Profiler::Disable();
+
+        auto report = profiler->GetReport();
+
+        THEN(" the zones are merged by their call path") {
+            REQUIRE(report.size() == 3);
+
+            REQUIRE(report[0].name == "Outer");
+            REQUIRE(report[0].depth == 0);
+            REQUIRE(report[0].statistics.GetCount() == 2);
+
+            REQUIRE(report[1].name == "Leaf");
+            REQUIRE(report[1].depth == 1);
+            REQUIRE(report[1].statistics.GetCount() == 6);
+
+            // Recursive calls are folded into the outermost one
+            REQUIRE(report[2].name == "Recursion");
+            REQUIRE(report[2].statistics.GetCount() == 2);
+        }
+
+        THEN(" the exclusive time does not contain the nested zones") {
+            auto& outer = report[0].statistics;
+            REQUIRE(outer.GetExclusive() <= outer.GetInclusive() - report[1].statistics.GetInclusive());
+            REQUIRE(outer.GetMin() <= outer.GetPercentile(0.5));
+            REQUIRE(outer.GetPercentile(0.5) <= outer.GetMax());
+        }
+    }
+}
@@ -0,0 +1,135 @@
+#include <common/parallel.hpp>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <numeric>
+#include <thread>
+
+SCENARIO("Task pool", "[task-pool]") {
+
+    GIVEN(" a pool with two workers") {
+
+        Construction::Common::TaskPool pool(2);
+
+        WHEN(" tasks recursively enqueue tasks and wait for them") {
+            std::atomic<int> leaves (0);
+
+            std::function<void(int)> spawn = [&](int depth) {
+                if (depth == 0) {
+                    ++leaves;
+                    return;
+                }
+
+                for (int i=0; i<3; ++i) {
+                    pool.Enqueue(spawn, depth-1);
+                }
+
+                // Waiting inside a worker must not deadlock
+                pool.Wait();
+            };
+
+            spawn(4);
+
+            THEN(" all the tasks are executed") {
+                REQUIRE(leaves == 81);
+            }
+        }
+
+        WHEN(" mapping a vector") {
+            std::vector<int> input (100);
+            std::iota(input.begin(), input.end(), 0);
+
+            auto output = pool.Map<int, int>(input, [](const int& x) { return x*x; });
+
+            THEN(" the order of the elements is kept") {
+                REQUIRE(output.size() == 100);
+                REQUIRE(output[7] == 49);
+                REQUIRE(output[99] == 9801);
+            }
+        }
+    }
+
+}
+
+SCENARIO("Parallel algorithms", "[parallel]") {
+
+    GIVEN(" a range of numbers") {
+
+        std::vector<int> input (1000);
+        std::iota(input.begin(), input.end(), 1);
+
+        WHEN(" mapping with a small grain size") {
+            std::vector<long> output;
+            Construction::Parallel::Map(input, output, [](const int& x) -> long { return 2*x; }, 7);
+
+            THEN(" every element is mapped to its own slot") {
+                REQUIRE(output.size() == 1000);
+                REQUIRE(output[0] == 2);
+                REQUIRE(output[999] == 2000);
+            }
+        }
+
+        WHEN(" reducing the range") {
+            auto sum = Construction::Parallel::Reduce(0, input.size(), 0L, [&](long& acc, size_t i) {
+                acc += input[i];
+            }, [](long& result, const long& acc) {
+                result += acc;
+            }, 13);
+
+            THEN(" the result is the sum of all elements") {
+                REQUIRE(sum == 500500);
+            }
+        }
+
+        WHEN(" the number of threads changes while a loop is running") {
+            auto pool = Construction::Parallel::GlobalTaskPool::Instance();
+            auto threads = pool->GetNumberOfThreads();
+
+            std::atomic<long> sum (0);
+
+            std::thread loop ([&]() {
+                Construction::Parallel::For(0, input.size(), [&](size_t i) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                    sum += input[i];
+                }, 10);
+            });
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            pool->SetNumberOfThreads(threads + 1);
+
+            loop.join();
+            pool->SetNumberOfThreads(threads);
+
+            THEN(" the loop finishes on the old pool") {
+                REQUIRE(sum == 500500);
+                REQUIRE(pool->GetNumberOfThreads() == threads);
+            }
+        }
+
+        WHEN(" a task tries to change the number of threads") {
+            auto pool = Construction::Parallel::GlobalTaskPool::Instance();
+            auto threads = pool->GetNumberOfThreads();
+
+            auto result = pool->Enqueue([&]() {
+                pool->SetNumberOfThreads(threads + 1);
+            });
+
+            THEN(" it is refused") {
+                REQUIRE_THROWS_AS(result.get(), std::runtime_error);
+                REQUIRE(pool->GetNumberOfThreads() == threads);
+            }
+        }
+
+        WHEN(" a mapped element throws") {
+            std::vector<int> small (input.begin(), input.begin() + 10);
+
+            THEN(" the exception reaches the caller") {
+                REQUIRE_THROWS_AS((Construction::Parallel::Map<int, int>(small, [](const int& x) -> int {
+                    if (x == 5) throw std::runtime_error("Five");
+                    return x;
+                })), std::runtime_error);
+            }
+        }
+    }
+
+}
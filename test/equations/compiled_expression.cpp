@@ -0,0 +1,26 @@
+#include <equations/compiled_expression.hpp>
+#include <language/command.hpp>
+
+using Construction::Equations::CompiledExpression;
+using Construction::WrongNumberOfArgumentsException;
+using Construction::WrongArgumentTypeException;
+
+// The commands bound directly to the API, like Gamma, Add or Symmetrize,
+// do not go through the interpreter. Before the call is built, their
+// operands are checked against the argument types that are registered
+// for the command of the same name. An equation with wrong arguments is
+// hence rejected with the same exception as by the interpreted command,
+// see Command::ValidateArguments, instead of failing somewhere inside
+// the API.
+
+SCENARIO("Compiled expressions", "[compiled-expression]") {
+
+    GIVEN(" commands bound to the API with wrong arguments") {
+        THEN(" they are rejected like the commands themselves") {
+            REQUIRE_THROWS_AS(CompiledExpression("Gamma({a b}, {c d})", {}), WrongNumberOfArgumentsException);
+            REQUIRE_THROWS_AS(CompiledExpression("Add(Gamma({a b}))", {}), WrongNumberOfArgumentsException);
+            REQUIRE_THROWS_AS(CompiledExpression("Symmetrize(Gamma({a b}), 2)", {}), WrongArgumentTypeException);
+            REQUIRE_THROWS_AS(CompiledExpression("Simplify({a b})", {}), WrongArgumentTypeException);
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#include <equations/solver.hpp>
+#include <equations/global_system.hpp>
+#include <tensor/expression_database.hpp>
+#include <sstream>
+
+using Construction::Equations::Solver;
+using Construction::Equations::Coefficients;
+using Construction::Equations::GlobalSystem;
+
+namespace {
+
+    const char* script =
+        "Add(Multiply(Gamma({a b}),#<lambda:0:0:0:0:{}>),Scale(#<lambda:0:0:2:0:{a b}>,-2))\n"
+        "Add(Multiply(Gamma({c d}),#<lambda:0:0:2:0:{a b}>),Scale(Symmetrize(Multiply(Gamma({c a}),#<lambda:0:0:2:0:{b d}>),{a b}),2),Scale(#<lambda:2:0:2:0:{c d a b}>,-2))\n"
+        "#<lambda:0:0:2:1:{a b c}>\n"
+        "Add(Multiply(Gamma({d e}),#<lambda:0:0:2:1:{a b c}>),Scale(Multiply(Gamma({c e}),#<lambda:0:0:2:1:{a b d}>),-1),Scale(#<lambda:2:0:2:1:{d e a b c}>,-2),Scale(Symmetrize(Multiply(Gamma({d a}),#<lambda:0:0:2:1:{b e c}>),{a b}),2))\n";
+
+    /**
+        \brief Solve the script and return the coefficients by name
+
+        The free variables of all coefficients are renamed to name_1, name_2, ...
+        with one substitution, like in Solver::PrintResult.
+     */
+    std::map<std::string, Construction::Tensor::Tensor> SolveScript(bool global, const std::string& name, unsigned& numberOfVariables) {
+        Solver::Reset();
+
+        // Like `solve` without `--database`, do not touch the disk
+        Construction::Tensor::ExpressionDatabase::Instance()->Initialize("construct.db");
+        Construction::Tensor::ExpressionDatabase::Instance()->Deactivate();
+
+        Solver::Options options;
+        options.global = global;
+
+        std::stringstream out, err;
+        std::istringstream in (script);
+
+        Solver solver (options, out, err);
+        solver.Load(in);
+        solver.Solve([]() { });
+
+        std::vector<Construction::Tensor::Scalar> variables;
+        for (auto it = Coefficients::Instance()->begin(); it != Coefficients::Instance()->end(); ++it) {
+            for (auto& pair : it->second->Get()->ExtractVariables()) {
+                if (std::find(variables.begin(), variables.end(), pair.first) == variables.end()) {
+                    variables.push_back(pair.first);
+                }
+            }
+        }
+
+        Construction::Tensor::Substitution substitution;
+        for (unsigned i=0; i<variables.size(); ++i) {
+            substitution.Insert(variables[i], Construction::Tensor::Scalar::Variable(name, i+1));
+        }
+
+        std::map<std::string, Construction::Tensor::Tensor> result;
+        for (auto it = Coefficients::Instance()->begin(); it != Coefficients::Instance()->end(); ++it) {
+            result.insert({ it->second->ToString(false), substitution(*it->second->Get()) });
+        }
+
+        numberOfVariables = variables.size();
+        Solver::Reset();
+        return result;
+    }
+
+}
+
+SCENARIO("Global linear system", "[global-system]") {
+
+    GIVEN(" a script with several equations on the same coefficients") {
+        unsigned mergedVariables, globalVariables;
+        auto merged = SolveScript(false, "x", mergedVariables);
+        auto global = SolveScript(true, "y", globalVariables);
+
+        THEN(" both solve for the same coefficients") {
+            REQUIRE(merged.size() == global.size());
+            for (auto& pair : merged) {
+                REQUIRE(global.find(pair.first) != global.end());
+            }
+        }
+
+        // The solutions only differ by the choice of the free variables. They
+        // span the same space iff the relations x = y between the two
+        // parametrizations leave as many free variables as one of them has.
+        THEN(" the solutions span the same space") {
+            REQUIRE(mergedVariables > 0);
+            REQUIRE(mergedVariables == globalVariables);
+
+            GlobalSystem system;
+            for (auto& pair : merged) {
+                system.Insert(pair.second - global.at(pair.first));
+            }
+
+            auto substitution = system.Solve();
+            REQUIRE(std::distance(substitution.begin(), substitution.end()) == mergedVariables);
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include <equations/scheduler.hpp>
+#include <mutex>
+#include <algorithm>
+#include <stdexcept>
+
+SCENARIO("Scheduler", "[scheduler]") {
+
+    GIVEN(" a dependency graph of coefficients, equations and a merge") {
+
+        auto scheduler = Construction::Equations::Scheduler::Instance();
+        typedef Construction::Equations::Scheduler::Stage Stage;
+
+        std::mutex mutex;
+        std::vector<std::string> order;
+
+        auto record = [&](const std::string& name) {
+            return [&, name]() {
+                std::unique_lock<std::mutex> lock(mutex);
+                order.push_back(name);
+            };
+        };
+
+        auto position = [&](const std::string& name) {
+            return std::find(order.begin(), order.end(), name) - order.begin();
+        };
+
+        auto a = scheduler->Create(Stage::COEFFICIENT, record("a"));
+        auto b = scheduler->Create(Stage::COEFFICIENT, record("b"));
+        auto eq = scheduler->Create(Stage::EQUATION, record("eq"));
+        auto merge = scheduler->Create(Stage::MERGE, record("merge"));
+
+        scheduler->DependsOn(eq, a);
+        scheduler->DependsOn(eq, b);
+        scheduler->DependsOn(merge, eq);
+
+        WHEN(" submitting all the tasks") {
+            scheduler->Submit(merge);
+            scheduler->Submit(eq);
+            scheduler->Submit(b);
+            scheduler->Submit(a);
+
+            scheduler->Wait();
+
+            THEN(" every task runs once and after its dependencies") {
+                REQUIRE(order.size() == 4);
+                REQUIRE(position("a") < position("eq"));
+                REQUIRE(position("b") < position("eq"));
+                REQUIRE(position("eq") < position("merge"));
+            }
+        }
+
+        WHEN(" a dependency fails") {
+            auto failing = scheduler->Create(Stage::COEFFICIENT, []() {
+                throw std::runtime_error("Failed");
+            });
+
+            scheduler->DependsOn(a, failing);
+
+            scheduler->Submit(a);
+            scheduler->Submit(b);
+            scheduler->Submit(eq);
+            scheduler->Submit(merge);
+            scheduler->Submit(failing);
+
+            THEN(" the error is reported and the dependents are cancelled") {
+                REQUIRE_THROWS_AS(scheduler->Wait(), std::runtime_error);
+                REQUIRE(position("b") == 0);
+                REQUIRE(order.size() == 1);
+            }
+        }
+    }
+
+    GIVEN(" fewer workers than before") {
+
+        auto scheduler = Construction::Equations::Scheduler::Instance();
+        typedef Construction::Equations::Scheduler::Stage Stage;
+
+        auto workers = scheduler->GetNumberOfWorkers();
+        scheduler->SetNumberOfWorkers(1);
+
+        std::atomic<int> running (0);
+        std::atomic<int> maximum (0);
+
+        for (int i=0; i<8; ++i) {
+            scheduler->Submit(scheduler->Create(Stage::COEFFICIENT, [&]() {
+                int now = ++running;
+
+                int seen = maximum;
+                while (now > seen && !maximum.compare_exchange_weak(seen, now)) { }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                --running;
+            }));
+        }
+
+        scheduler->Wait();
+        scheduler->SetNumberOfWorkers(workers);
+
+        THEN(" the surplus workers stay idle") {
+            REQUIRE(maximum == 1);
+        }
+    }
+
+}
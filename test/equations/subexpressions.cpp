@@ -0,0 +1,46 @@
+#include <equations/compiled_expression.hpp>
+
+using Construction::Equations::CompiledExpression;
+using Construction::Equations::SubexpressionTable;
+
+// Subexpressions of the equations of a script are only calculated once,
+// also if they occur with other index names
+
+SCENARIO("Common subexpressions", "[subexpressions]") {
+    SubexpressionTable::Instance()->Clear();
+
+    GIVEN(" two equations with the same subexpression and other indices") {
+        CompiledExpression first ("Symmetrize(Multiply(Gamma({a b}), Gamma({c d})), {b c})", {});
+        CompiledExpression second ("Symmetrize(Multiply(Gamma({e f}), Gamma({g h})), {f g})", {});
+
+        THEN(" the subexpression is reused") {
+            REQUIRE(SubexpressionTable::Instance()->GetHits() > 0);
+        }
+
+        THEN(" the result is the renamed one of the first equation") {
+            auto result = second.Evaluate();
+
+            SubexpressionTable::Instance()->Clear();
+            CompiledExpression fresh ("Symmetrize(Multiply(Gamma({e f}), Gamma({g h})), {f g})", {});
+
+            REQUIRE((result - fresh.Evaluate()).Simplify().IsZeroTensor());
+            REQUIRE(!result.IsZeroTensor());
+        }
+    }
+
+    GIVEN(" a renaming that changes a contracted index") {
+        CompiledExpression first ("Multiply(InverseGamma({a m}), Epsilon({m b c}))", {});
+        CompiledExpression second ("Multiply(InverseGamma({m a}), Epsilon({a b c}))", {});
+
+        THEN(" the subexpression is calculated again") {
+            auto result = second.Evaluate();
+
+            SubexpressionTable::Instance()->Clear();
+            CompiledExpression fresh ("Multiply(InverseGamma({m a}), Epsilon({a b c}))", {});
+
+            REQUIRE((result - fresh.Evaluate()).Simplify().IsZeroTensor());
+        }
+    }
+
+    SubexpressionTable::Instance()->Clear();
+}
@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <sstream>
+
+#include <language/cli.hpp>
+#include <language/command_cache.hpp>
+
+using Construction::Language::CLI;
+using Construction::Language::CommandCache;
+using Construction::Language::Session;
+
+// The CLI of `apple cli` with the cache enabled
+SCENARIO("Command cache", "[command-cache]") {
+    CommandCache::Enable();
+    CommandCache::Instance()->Clear();
+
+    CLI cli;
+    std::stringstream out;
+
+    GIVEN(" a command that is executed twice") {
+        cli("A = Symmetrize(Gamma({a b}), {a b}):", out);
+
+        auto hits = CommandCache::Instance()->GetHits();
+        cli("B = Symmetrize(Gamma({a b}), {a b}):", out);
+
+        THEN(" the second result is taken from the cache") {
+            REQUIRE(CommandCache::Instance()->GetHits() == hits + 1);
+            REQUIRE(Session::Instance()->GetDefinition("A") != "");
+            REQUIRE(Session::Instance()->GetDefinition("A") == Session::Instance()->GetDefinition("B"));
+            REQUIRE(Session::Instance()->Get("A").ToString() == Session::Instance()->Get("B").ToString());
+        }
+    }
+
+    GIVEN(" a variable that is changed afterwards") {
+        cli("C = Gamma({a b}):", out);
+        cli("D = Symmetrize(C, {a b}):", out);
+
+        Session::Instance()->Set("C", Session::Instance()->Get("D"));
+
+        auto hits = CommandCache::Instance()->GetHits();
+        auto size = CommandCache::Instance()->Size();
+        cli("E = Symmetrize(C, {a b}):", out);
+
+        THEN(" commands using it are not looked up") {
+            REQUIRE(Session::Instance()->GetDefinition("C") == "");
+            REQUIRE(CommandCache::Instance()->GetHits() == hits);
+            REQUIRE(CommandCache::Instance()->Size() == size);
+        }
+    }
+
+    GIVEN(" a command that cannot be cached") {
+        auto size = CommandCache::Instance()->Size();
+        cli("F = Add(Gamma({a b}), Gamma({a b})):", out);
+
+        THEN(" only its cachable arguments are stored") {
+            REQUIRE(CommandCache::Instance()->Size() == size + 1);
+            REQUIRE(Session::Instance()->GetDefinition("F") == "");
+        }
+    }
+
+    CommandCache::Disable();
+    std::remove(".crashfile");
+}
@@ -0,0 +1,86 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <language/cli.hpp>
+#include <language/journal.hpp>
+
+using Construction::Language::CLI;
+using Construction::Language::Session;
+using Construction::Language::MappedFile;
+
+// Crash recovery of `apple cli`, the session is written incrementally
+
+SCENARIO("Session journal", "[journal]") {
+    std::string filename = "journal_test_crashfile";
+
+    CLI cli;
+    std::stringstream out;
+
+    cli("JA = Gamma({a b}):", out);
+    cli("JB = Symmetrize(Gamma({a b}), {a b}):", out);
+
+    auto session = Session::Instance();
+    auto value = session->Get("JB").ToString();
+
+    session->Checkpoint(filename);
+
+    GIVEN(" a changed variable") {
+        size_t snapshotSize = MappedFile(filename).Size();
+        size_t journalSize = MappedFile(filename + ".journal").Size();
+
+        session->Set("JA", session->Get("JB"));
+        session->Checkpoint(filename);
+
+        THEN(" only the change is appended to the journal") {
+            REQUIRE(MappedFile(filename).Size() == snapshotSize);
+            REQUIRE(MappedFile(filename + ".journal").Size() > journalSize);
+        }
+
+        WHEN(" the session is restored") {
+            session->Set("JA", Expression::Void());
+            session->Set("JB", Expression::Void());
+
+            session->Restore(filename);
+
+            THEN(" the variables are the ones of the last checkpoint") {
+                REQUIRE(session->Get("JA").ToString() == value);
+                REQUIRE(session->Get("JB").ToString() == value);
+            }
+        }
+    }
+
+    GIVEN(" a journal whose last record was cut in half by a crash") {
+        auto original = session->Get("JA").ToString();
+        size_t journalSize = MappedFile(filename + ".journal").Size();
+
+        session->Set("JA", session->Get("JB"));
+        session->Checkpoint(filename);
+
+        size_t written = MappedFile(filename + ".journal").Size();
+        REQUIRE(truncate((filename + ".journal").c_str(), journalSize + (written - journalSize) / 2) == 0);
+
+        session->Restore(filename);
+
+        THEN(" the restore cuts off the incomplete record") {
+            REQUIRE(session->Get("JA").ToString() == original);
+            REQUIRE(MappedFile(filename + ".journal").Size() == journalSize);
+        }
+
+        WHEN(" the session is checkpointed again and restored") {
+            session->Set("JC", session->Get("JB"));
+            session->Checkpoint(filename);
+            session->Set("JC", Expression::Void());
+
+            session->Restore(filename);
+
+            THEN(" the new records are read") {
+                REQUIRE(session->Get("JA").ToString() == original);
+                REQUIRE(session->Get("JC").ToString() == value);
+            }
+        }
+    }
+
+    Session::RemoveCheckpoint(filename);
+    Session::RemoveCheckpoint(".crashfile");
+}
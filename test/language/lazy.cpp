@@ -0,0 +1,52 @@
+#include <cstdio>
+#include <memory>
+#include <sstream>
+
+#include <language/cli.hpp>
+#include <language/thunk.hpp>
+
+using Construction::Language::CLI;
+using Construction::Language::Session;
+using Construction::Language::Thunk;
+
+// Silent assignments of a lazy CLI are only calculated on first use
+SCENARIO("Lazy session values", "[lazy]") {
+    CLI cli;
+    cli.SetLazy(true);
+
+    std::stringstream out;
+
+    GIVEN(" a silent assignment") {
+        cli("LA = Symmetrize(Gamma({a b}), {a b}):", out);
+        cli("LB = Symmetrize(LA, {a b}):", out);
+
+        THEN(" it is not calculated") {
+            std::shared_ptr<Thunk> thunk = Session::Instance()->GetThunk("LA");
+
+            REQUIRE(Session::Instance()->Contains("LA"));
+            REQUIRE(!thunk->IsForced());
+            REQUIRE(!Session::Instance()->GetThunk("LB")->IsForced());
+        }
+
+        WHEN(" an input is reassigned before the value is used") {
+            cli("LA = Delta({a b}):", out);
+            cli("LC = Symmetrize(Symmetrize(Gamma({a b}), {a b}), {a b})", out);
+
+            THEN(" the value is calculated with the old input") {
+                REQUIRE(Session::Instance()->Get("LB").ToString() == Session::Instance()->Get("LC").ToString());
+                REQUIRE(Session::Instance()->Get("LA").ToString() != Session::Instance()->Get("LC").ToString());
+            }
+        }
+
+        WHEN(" `%` is used") {
+            cli("LD = %", out);
+
+            THEN(" the previous assignment is calculated") {
+                REQUIRE(Session::Instance()->GetThunk("LB")->IsForced());
+                REQUIRE(Session::Instance()->Get("LD").ToString() == Session::Instance()->Get("LB").ToString());
+            }
+        }
+    }
+
+    std::remove(".crashfile");
+}
@@ -0,0 +1,57 @@
+#include <memory>
+
+#include <language/parser.hpp>
+
+using Construction::Language::Parser;
+using Construction::Language::ParseCache;
+using Construction::Language::Node;
+
+// The tree is printed in prefix notation, e.g. `(+ A B)`,
+// an empty string means that the line could not be parsed
+static std::string ParseToString(const std::string& code) {
+    Parser parser;
+    auto document = parser.Parse(code);
+    return document ? document->ToString() : "";
+}
+
+SCENARIO("Parser", "[parser]") {
+    GIVEN(" binary operators") {
+        THEN(" they are left associative") {
+            REQUIRE(ParseToString("A - B + C") == "(+ (- A B) C)");
+            REQUIRE(ParseToString("A * B * C") == "(* (* A B) C)");
+        }
+
+        THEN(" the multiplication binds stronger") {
+            REQUIRE(ParseToString("A + B * C") == "(+ A (* B C))");
+            REQUIRE(ParseToString("(A + B) * C") == "(* (+ A B) C)");
+        }
+    }
+
+    GIVEN(" commands and assignments") {
+        THEN(" the arguments are kept in order") {
+            REQUIRE(ParseToString("X1 = Scale(Gamma({a b}), -2, \"text\")") == "X1 := (Command Scale (Command Gamma {a b}), -2, \"text\")");
+            REQUIRE(ParseToString("MemoryStats()") == "(Command MemoryStats )");
+            REQUIRE(ParseToString("A = % # comment") == "A := %");
+        }
+
+        THEN(" incomplete lines are rejected") {
+            REQUIRE(ParseToString("Scale(A, 2") == "");
+            REQUIRE(ParseToString("A B") == "");
+            REQUIRE(ParseToString("A +") == "");
+        }
+    }
+
+    GIVEN(" a line that was parsed before") {
+        ParseCache::Instance()->Clear();
+
+        Parser parser;
+        auto first = parser.Parse("Symmetrize(Gamma({a b}), {a b})");
+        auto second = parser.Parse("Symmetrize(Gamma({a b}), {a b})");
+
+        THEN(" the tree is reused") {
+            REQUIRE(first != nullptr);
+            REQUIRE(first == second);
+            REQUIRE(ParseCache::Instance()->Size() == 1);
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <language/cli.hpp>
+
+using Construction::Language::CLI;
+using Construction::Language::Session;
+
+SCENARIO("Parallel scripts", "[script]") {
+    std::string filename = "parallel_script_test.txt";
+
+    {
+        std::ofstream file (filename);
+        file << "# Independent statements" << std::endl;
+        file << "X = Gamma({a b})" << std::endl;
+        file << "Y = Delta({a b})" << std::endl;
+        file << "Symmetrize(X, {a b})" << std::endl;
+        file << "Z = %" << std::endl;
+        file << "X = Y" << std::endl;
+        file << "W = X" << std::endl;
+    }
+
+    GIVEN(" a script executed in parallel") {
+        CLI cli;
+        std::stringstream out;
+
+        // Reference values of the sequential execution
+        cli.ExecuteScript(filename, true);
+        auto z = Session::Instance()->Get("Z").ToString();
+        auto w = Session::Instance()->Get("W").ToString();
+
+        Session::Instance()->Set("X", Expression::Void());
+        Session::Instance()->Set("Z", Expression::Void());
+        Session::Instance()->Set("W", Expression::Void());
+
+        cli.ExecuteScriptInParallel(filename, false, out);
+
+        THEN(" the output is in the order of the script") {
+            auto text = out.str();
+            auto x = text.find("> X = Gamma");
+            auto y = text.find("> Y = Delta");
+            auto last = text.find("> W = X");
+
+            REQUIRE(x != std::string::npos);
+            REQUIRE(y != std::string::npos);
+            REQUIRE(last != std::string::npos);
+            REQUIRE(x < y);
+            REQUIRE(y < last);
+        }
+
+        THEN(" every statement sees the variables and the `%` of the statements before") {
+            REQUIRE(Session::Instance()->Get("Z").ToString() == z);
+            REQUIRE(Session::Instance()->Get("W").ToString() == w);
+            REQUIRE(Session::Instance()->Get("W").ToString() == Session::Instance()->Get("Y").ToString());
+        }
+    }
+
+    GIVEN(" a script with failing statements between printing ones") {
+        std::string errors = "parallel_script_errors_test.txt";
+
+        {
+            std::ofstream file (errors);
+            file << "Gamma({a b})" << std::endl;
+            file << "Unknown({a b})" << std::endl;
+            file << "Gamma({c d})" << std::endl;
+            file << "Symmetrize(Gamma({a b}), 2)" << std::endl;
+            file << "Gamma({e f})" << std::endl;
+        }
+
+        CLI cli;
+        std::stringstream out;
+        cli.ExecuteScriptInParallel(errors, false, out);
+        std::remove(errors.c_str());
+
+        THEN(" the errors are printed in the order of the script") {
+            auto text = out.str();
+            auto unknown = text.find("> Unknown");
+            auto unknownError = text.find("I do not know this command");
+            auto second = text.find("> Gamma({c d})");
+            auto symmetrize = text.find("> Symmetrize");
+            auto symmetrizeError = text.find("Wrong argument type");
+            auto last = text.find("> Gamma({e f})");
+
+            REQUIRE(unknownError != std::string::npos);
+            REQUIRE(symmetrizeError != std::string::npos);
+            REQUIRE(unknown < unknownError);
+            REQUIRE(unknownError < second);
+            REQUIRE(symmetrize < symmetrizeError);
+            REQUIRE(symmetrizeError < last);
+        }
+    }
+
+    std::remove(filename.c_str());
+    std::remove(".crashfile");
+}
@@ -6,4 +6,22 @@
 //#include "api.cpp"
 //#include "vector.cpp"
 
-#include "equations/metric.cpp"
\ No newline at end of file
+#include "equations/metric.cpp"
+#include "equations/scheduler.cpp"
+#include "common/task_pool.cpp"
+#include "common/profiler.cpp"
+#include "common/memory.cpp"
+#include "common/logger.cpp"
+#include "server/protocol.cpp"
+#include "language/command_cache.cpp"
+#include "language/script.cpp"
+#include "language/lazy.cpp"
+#include "equations/subexpressions.cpp"
+#include "equations/compiled_expression.cpp"
+#include "language/parser.cpp"
+#include "language/journal.cpp"
+#include "tensor/index_table.cpp"
+#include "tensor/index_combinations.cpp"
+#include "tensor/symmetry.cpp"
+#include "equations/global_system.cpp"
+#include "server/server.cpp"
\ No newline at end of file
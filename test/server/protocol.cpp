@@ -0,0 +1,56 @@
+#include <string>
+#include <sys/socket.h>
+
+#include <server/protocol.hpp>
+
+using Construction::Server::Connection;
+using Construction::Server::Message;
+using Construction::Server::MessageStream;
+
+// Connected pair of sockets in the same process
+SCENARIO("Server protocol", "[server]") {
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    Connection client (fds[0]);
+    Connection server (fds[1]);
+
+    GIVEN(" a frame with newlines in the payload") {
+        REQUIRE(client.Send(Message::Type::SOLVE, "A\nB\n"));
+
+        THEN(" it is received in one piece") {
+            Message message;
+            REQUIRE(server.Receive(message));
+            REQUIRE(message.type == Message::Type::SOLVE);
+            REQUIRE(message.payload == "A\nB\n");
+        }
+    }
+
+    GIVEN(" a message stream") {
+        {
+            MessageStream out (server, Message::Type::OUTPUT);
+            out << "Hello" << " World" << std::endl;
+            out << "Bye";
+        }
+
+        THEN(" every line and the rest are sent as frames") {
+            Message message;
+
+            REQUIRE(client.Receive(message));
+            REQUIRE(message.type == Message::Type::OUTPUT);
+            REQUIRE(message.payload == "Hello World\n");
+
+            REQUIRE(client.Receive(message));
+            REQUIRE(message.payload == "Bye");
+        }
+    }
+
+    GIVEN(" a closed connection") {
+        client.Close();
+
+        THEN(" nothing is received") {
+            Message message;
+            REQUIRE(!server.Receive(message));
+        }
+    }
+}
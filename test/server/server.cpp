@@ -0,0 +1,71 @@
+#include <cstdio>
+#include <thread>
+#include <sstream>
+
+#include <server/client.hpp>
+#include <server/server.hpp>
+
+using Construction::Server::Client;
+using Construction::Server::Message;
+using Construction::Server::Server;
+using Construction::Equations::CoefficientCache;
+
+namespace {
+    const char* socketPath = "server_test.sock";
+}
+
+// A server on its own socket, the requests are sent by clients in the
+// same process
+SCENARIO("Construction server", "[server]") {
+    std::string path = socketPath;
+
+    Server server (path, 4);
+    REQUIRE(server.Listen());
+
+    std::thread thread ([&]() {
+        server.Run();
+    });
+
+    GIVEN(" a status request and a command") {
+        std::stringstream status, statusLog;
+        int statusCode = Client(path).Submit(Message::Type::STATUS, "", status, statusLog);
+
+        std::stringstream out, log;
+        int code = Client(path).Submit(Message::Type::COMMAND, "Gamma({a b})", out, log);
+
+        THEN(" both are answered") {
+            REQUIRE(statusCode == 0);
+            REQUIRE(status.str().find("Jobs:") != std::string::npos);
+
+            REQUIRE(code == 0);
+            REQUIRE(out.str() != "");
+        }
+    }
+
+    GIVEN(" a coefficient cache that exceeds its limit") {
+        auto cache = CoefficientCache::Instance();
+        cache->Clear();
+
+        cache->Insert("first", Construction::Tensor::Tensor::Gamma(Construction::Tensor::Indices::GetRomanSeries(2, {1,3})));
+        cache->Insert("second", Construction::Tensor::Tensor::Gamma(Construction::Tensor::Indices::GetRomanSeries(2, {1,3})));
+        cache->SetMaximalSize(1);
+
+        THEN(" the least recently used structures are dropped") {
+            Construction::Tensor::Tensor tensor;
+
+            REQUIRE(cache->Size() == 1);
+            REQUIRE(cache->GetEvictions() == 1);
+            REQUIRE(!cache->Get("first", tensor));
+            REQUIRE(cache->Get("second", tensor));
+        }
+
+        cache->SetMaximalSize(512 * 1024 * 1024);
+        cache->Clear();
+    }
+
+    std::stringstream out, log;
+    REQUIRE(Client(path).Submit(Message::Type::SHUTDOWN, "", out, log) == 0);
+
+    thread.join();
+    Construction::Language::Session::RemoveCheckpoint(".crashfile");
+}
@@ -0,0 +1,262 @@
+#include <random>
+
+#include <tensor/index.hpp>
+#include <tensor/tensor.hpp>
+
+using Construction::Tensor::IndexCombinations;
+using Construction::Tensor::Fraction;
+
+namespace {
+
+    // Reference: all the combinations, the last index runs fastest
+    std::vector<std::vector<unsigned>> AllCombinations(unsigned rank, unsigned from, unsigned to) {
+        std::vector<std::vector<unsigned>> result = { {} };
+        for (unsigned i=0; i<rank; ++i) {
+            std::vector<std::vector<unsigned>> next;
+            for (auto& combination : result) {
+                for (unsigned value=from; value<=to; ++value) {
+                    next.push_back(combination);
+                    next.back().push_back(value);
+                }
+            }
+            result = next;
+        }
+        return result;
+    }
+
+    // All the products of metrics of the given signature in the indices
+    std::vector<Construction::Tensor::Tensor> Metrics(const Construction::Tensor::Indices& indices, int p, int q) {
+        if (indices.Size() == 2) return { Construction::Tensor::Tensor::Gamma(indices, p, q) };
+
+        std::vector<Construction::Tensor::Tensor> result;
+        for (unsigned i=1; i<indices.Size(); ++i) {
+            auto rest = indices;
+            rest.Remove(i);
+            rest.Remove(0);
+
+            auto gamma = Construction::Tensor::Tensor::Gamma({ indices[0], indices[i] }, p, q);
+            for (auto& tensor : Metrics(rest, p, q)) {
+                result.push_back(gamma * tensor);
+            }
+        }
+        return result;
+    }
+
+    // The products of an epsilon in the first dimension indices and metrics in the others, for all the orderings
+    std::vector<Construction::Tensor::Tensor> EpsilonMetrics(const Construction::Tensor::Indices& indices, unsigned dimension, int p, int q) {
+        std::vector<Construction::Tensor::Tensor> result;
+        std::vector<bool> chosen (indices.Size(), false);
+        std::fill(chosen.begin(), chosen.begin() + dimension, true);
+
+        do {
+            Construction::Tensor::Indices epsilon, rest;
+            for (unsigned i=0; i<indices.Size(); ++i) {
+                if (chosen[i]) epsilon.Insert(indices[i]);
+                else rest.Insert(indices[i]);
+            }
+
+            if (rest.Size() == 0) {
+                result.push_back(Construction::Tensor::Tensor::Epsilon(epsilon));
+                continue;
+            }
+
+            for (auto& tensor : Metrics(rest, p, q)) {
+                result.push_back(Construction::Tensor::Tensor::Epsilon(epsilon) * tensor);
+            }
+        } while (std::prev_permutation(chosen.begin(), chosen.end()));
+
+        return result;
+    }
+
+    // Rank of the matrix of the tensors and of random linear combinations of them evaluated at the combinations
+    unsigned Rank(const std::vector<Construction::Tensor::Tensor>& tensors, const Construction::Tensor::Indices& indices, const IndexCombinations& combinations, unsigned random) {
+        std::mt19937 generator (42);
+        std::uniform_int_distribution<int> distribution (-3, 3);
+
+        unsigned columns = tensors.size() + random;
+
+        std::vector<std::vector<int>> coefficients (columns, std::vector<int>(tensors.size(), 0));
+        for (unsigned j=0; j<columns; ++j) {
+            if (j < tensors.size()) {
+                coefficients[j][j] = 1;
+                continue;
+            }
+
+            for (auto& c : coefficients[j]) c = distribution(generator);
+        }
+
+        std::vector<std::vector<unsigned>> positions;
+        for (auto& tensor : tensors) {
+            positions.push_back(tensor.GetPositionsIn(indices));
+        }
+
+        Construction::Vector::Matrix<Fraction> M (combinations.Size(), columns);
+
+        unsigned row = 0;
+        for (auto& combination : combinations) {
+            for (unsigned k=0; k<tensors.size(); ++k) {
+                std::vector<unsigned> args;
+                for (auto& position : positions[k]) args.push_back(combination[position]);
+
+                auto value = Fraction::FromDouble(tensors[k](args).ToDouble());
+                if (value == Fraction(0)) continue;
+
+                for (unsigned j=0; j<columns; ++j) {
+                    M(row, j) = M(row, j) + Fraction(coefficients[j][k]) * value;
+                }
+            }
+            ++row;
+        }
+
+        M.ToRowEchelonForm();
+
+        unsigned rank = 0;
+        for (unsigned i=0; i<M.GetNumberOfRows(); ++i) {
+            for (unsigned j=0; j<columns; ++j) {
+                if (M(i, j) != Fraction(0)) {
+                    ++rank;
+                    break;
+                }
+            }
+        }
+        return rank;
+    }
+
+}
+
+SCENARIO("Index combinations", "[index-combinations]") {
+
+    GIVEN(" four spatial indices") {
+        auto indices = Construction::Tensor::Indices::GetRomanSeries(4, {1,3});
+        auto reference = AllCombinations(4, 1, 3);
+
+        THEN(" the odometer yields all the combinations in order") {
+            auto combinations = indices.GetCombinations();
+
+            REQUIRE(combinations.Size() == 81);
+            REQUIRE(combinations.ToVector() == reference);
+        }
+
+        THEN(" the packed form is the base 3 number of the combination") {
+            auto combinations = indices.GetCombinations();
+            IndexCombinations::Packed expected = 0;
+
+            for (auto it = combinations.begin(); it != combinations.end(); ++it, ++expected) {
+                REQUIRE(it.GetPacked() == expected);
+                REQUIRE(combinations.Pack(*it) == expected);
+            }
+        }
+
+        THEN(" the interesting combinations start with 1 and continue with 1 or 2") {
+            std::vector<std::vector<unsigned>> expected;
+            for (auto& combination : reference) {
+                auto it = std::find_if(combination.begin(), combination.end(), [](unsigned value) { return value != 1; });
+                if (combination[0] == 1 && (it == combination.end() || *it == 2)) expected.push_back(combination);
+            }
+
+            auto combinations = indices.GetInterestingCombinations();
+
+            REQUIRE(combinations.ToVector() == expected);
+            REQUIRE(combinations.Size() == expected.size());
+            REQUIRE(indices.GetAllInterestingIndexCombinations() == expected);
+        }
+
+        THEN(" the chunks together yield every combination once") {
+            for (auto mode : { IndexCombinations::Mode::ALL, IndexCombinations::Mode::INTERESTING }) {
+                IndexCombinations combinations (indices.GetRanges(), mode);
+                std::vector<std::vector<unsigned>> joined;
+
+                for (unsigned id=0; id<7; ++id) {
+                    auto chunk = combinations.Chunk(id, 7).ToVector();
+                    joined.insert(joined.end(), chunk.begin(), chunk.end());
+                }
+
+                REQUIRE(joined == combinations.ToVector());
+            }
+        }
+    }
+
+    GIVEN(" four spacetime indices") {
+        auto indices = Construction::Tensor::Indices::GetRomanSeries(4, {0,3});
+        auto reference = AllCombinations(4, 0, 3);
+
+        THEN(" the values of the time and the space directions first appear in increasing order") {
+            std::vector<std::vector<unsigned>> expected;
+            for (auto& combination : reference) {
+                unsigned time = 0, space = 1;
+                bool interesting = true;
+
+                for (auto value : combination) {
+                    auto& next = (value == 0) ? time : space;
+                    if (value > next) interesting = false;
+                    if (value == next) ++next;
+                }
+
+                if (interesting) expected.push_back(combination);
+            }
+
+            REQUIRE(indices.GetAllInterestingIndexCombinations(1) == expected);
+            REQUIRE(indices.GetInterestingCombinations(1).Contains({ 1, 0, 2, 0 }));
+            REQUIRE(!indices.GetInterestingCombinations(1).Contains({ 0, 2, 1, 1 }));
+            REQUIRE(indices.GetInterestingCombinations().Size() == 15);
+        }
+
+        THEN(" the tensors use the signature of their metrics") {
+            auto pair = indices.Partial({0,1});
+
+            REQUIRE(Construction::Tensor::Tensor::Gamma(pair, 0, 4).GetIndexCombinations().Size() == 2);
+            REQUIRE(Construction::Tensor::Tensor::Gamma(pair, 1, 3).GetIndexCombinations().Size() == 5);
+
+            auto mixed = Construction::Tensor::Tensor::Gamma(pair, 1, 3) * Construction::Tensor::Tensor::Gamma(indices.Partial({2,3}), 0, 4);
+            REQUIRE(mixed.GetIndexCombinations().Size() == 256);
+        }
+    }
+
+    GIVEN(" random tensors built from metrics and epsilons in four dimensions") {
+        auto indices = Construction::Tensor::Indices::GetRomanSeries(6, {0,3});
+
+        THEN(" the interesting combinations have the rank of all the combinations") {
+            for (int p=0; p<=2; ++p) {
+                auto tensors = Metrics(indices, p, 4-p);
+                auto epsilons = EpsilonMetrics(indices, 4, p, 4-p);
+                tensors.insert(tensors.end(), epsilons.begin(), epsilons.end());
+
+                auto all = indices.GetCombinations();
+                auto interesting = indices.GetInterestingCombinations(p);
+
+                auto rank = Rank(tensors, indices, all, 4);
+
+                REQUIRE(interesting.Size() < all.Size());
+                REQUIRE(rank >= 15);
+                REQUIRE(Rank(tensors, indices, interesting, 4) == rank);
+            }
+        }
+    }
+
+    GIVEN(" indices without and with mixed ranges") {
+        Construction::Tensor::Indices empty;
+        Construction::Tensor::Indices mixed = { Construction::Tensor::Index("a", "a", {1,3}), Construction::Tensor::Index("b", "b", {0,3}) };
+
+        THEN(" no indices have one empty but no interesting combination") {
+            REQUIRE(empty.GetCombinations().Size() == 1);
+            REQUIRE(empty.GetInterestingCombinations().IsEmpty());
+        }
+
+        THEN(" every index runs over its own range") {
+            auto combinations = mixed.GetCombinations().ToVector();
+
+            REQUIRE(combinations.size() == 12);
+            REQUIRE(combinations.front() == std::vector<unsigned>({ 1, 0 }));
+            REQUIRE(combinations.back() == std::vector<unsigned>({ 3, 3 }));
+        }
+    }
+
+    GIVEN(" a tensor with a variable in front") {
+        auto indices = Construction::Tensor::Indices::GetRomanSeries(2, {1,3});
+        auto tensor = Construction::Tensor::Scalar::Variable("x") * Construction::Tensor::Tensor::Gamma(indices);
+
+        THEN(" its values cannot be put into a matrix") {
+            REQUIRE_THROWS_AS(Construction::Tensor::Tensor::EvaluateColumn(tensor, indices, indices.GetCombinations()), Construction::Exception);
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#include <sstream>
+
+#include <tensor/index.hpp>
+
+using Construction::Tensor::Index;
+using Construction::Tensor::Indices;
+using Construction::Tensor::IndexTable;
+using Construction::Tensor::IndexVector;
+using Construction::Tensor::IndicesIncomparableException;
+
+static bool IsInline(const Indices& indices) {
+    return IndexVector(indices.begin(), indices.end()).IsInline();
+}
+
+SCENARIO("Interned indices", "[index-table]") {
+
+    GIVEN(" indices with the same name") {
+        Index a ("a", "a", {1,3});
+        Index b ("a", "a", {1,3});
+        Index c ("a", "a", {0,3});
+
+        THEN(" equal indices share the entry of the table") {
+            REQUIRE(a.GetID() == b.GetID());
+            REQUIRE(IndexTable::Instance()->Intern("a", "a", {1,3}) == a.GetID());
+        }
+
+        THEN(" the range has its own entry, but the indices are still equal") {
+            REQUIRE(a.GetID() != c.GetID());
+            REQUIRE(a == c);
+            REQUIRE(c.GetRange().GetFrom() == 0);
+        }
+
+        THEN(" changing the range keeps the name and the orientation") {
+            Index d = a;
+            d.SetContravariant(true);
+            d.SetRange({0,3});
+
+            REQUIRE(d.GetID() == c.GetID());
+            REQUIRE(d.GetName() == "a");
+            REQUIRE(d.IsContravariant());
+        }
+
+        THEN(" the serialization restores the index") {
+            std::stringstream ss;
+            c.Serialize(ss);
+
+            auto restored = Index::Deserialize(ss);
+            REQUIRE(restored->GetID() == c.GetID());
+        }
+    }
+
+    GIVEN(" indices of the different kinds") {
+        Index a ("a"), b ("b");
+        Index mu ("mu", "\\mu", {0,3}), nu ("nu", "\\nu", {0,3});
+        Index alpha2 ("alpha_2", "\\alpha_2", {1,3}), alpha10 ("alpha_10", "\\alpha_{10}", {1,3});
+        Index beta1 ("beta_1", "\\beta_1", {1,3});
+
+        THEN(" indices of the same kind are ordered") {
+            REQUIRE(a < b);
+            REQUIRE(b > a);
+            REQUIRE(mu < nu);
+            REQUIRE(nu > mu);
+            REQUIRE(alpha2 < alpha10);
+            REQUIRE(alpha10 > alpha2);
+        }
+
+        THEN(" indices of different kinds or series cannot be compared") {
+            REQUIRE_THROWS_AS(a < mu, IndicesIncomparableException);
+            REQUIRE_THROWS_AS(alpha2 < beta1, IndicesIncomparableException);
+        }
+    }
+
+    GIVEN(" the indices of a tensor") {
+        auto indices = Indices::GetRomanSeries(12, {1,3});
+
+        THEN(" they are stored inline up to twelve indices") {
+            REQUIRE(indices.Size() == 12);
+            REQUIRE(IsInline(indices));
+
+            IndexVector more (indices.begin(), indices.end());
+            more.push_back(Index("A"));
+            REQUIRE(!more.IsInline());
+            REQUIRE(more.size() == 13);
+            REQUIRE(more[12].GetName() == "A");
+        }
+
+        THEN(" contracting works on the inline storage") {
+            auto first = Indices::GetRomanSeries(3, {1,3});
+            Indices second = { Index("a"), Index("d") };
+            second[0].SetContravariant(true);
+
+            auto result = first.Contract(second);
+            REQUIRE(result.Size() == 3);
+            REQUIRE(result[0].GetName() == "b");
+            REQUIRE(result[2].GetName() == "d");
+        }
+    }
+}
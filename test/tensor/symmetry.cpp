@@ -0,0 +1,181 @@
+#include <language/api.hpp>
+#include <tensor/tensor.hpp>
+#include <equations/coefficient.hpp>
+
+using Construction::Tensor::Indices;
+using Construction::Tensor::Symmetry;
+using Construction::Tensor::ElementarySymmetry;
+
+namespace {
+
+    // A symmetry with a single elementary symmetry
+    Symmetry SymmetryOf(const std::vector<unsigned>& positions, bool symmetric) {
+        Symmetry result;
+        result.Add(ElementarySymmetry(positions, symmetric));
+        return result;
+    }
+
+}
+
+SCENARIO("Symmetry reduced index combinations", "[symmetry]") {
+
+    GIVEN(" three indices") {
+        auto indices = Indices::GetRomanSeries(3, {1,3});
+        auto combinations = indices.GetCombinations();
+
+        THEN(" a symmetry keeps one combination of every multiset") {
+            auto reduced = SymmetryOf({ 0, 1, 2 }, true).Restrict(combinations);
+
+            REQUIRE(reduced.Size() == 10);
+            for (auto& combination : reduced) {
+                REQUIRE(std::is_sorted(combination.begin(), combination.end()));
+            }
+        }
+
+        THEN(" an antisymmetry drops the combinations with equal values") {
+            auto reduced = SymmetryOf({ 0, 1, 2 }, false).Restrict(combinations);
+
+            REQUIRE(reduced.Size() == 1);
+            REQUIRE(*reduced.begin() == std::vector<unsigned>({ 1, 2, 3 }));
+        }
+    }
+
+    GIVEN(" an exchange of two blocks") {
+        auto indices = Indices::GetRomanSeries(4, {1,3});
+
+        Symmetry symmetry;
+        symmetry.Add(ElementarySymmetry(std::vector<std::pair<unsigned, unsigned>>({ { 0, 1 }, { 2, 3 } }), true));
+
+        THEN(" the blocks of the representatives are ordered") {
+            auto reduced = symmetry.Restrict(indices.GetCombinations());
+
+            // 9 pairs of equal blocks and 36 unordered pairs of different ones
+            REQUIRE(reduced.Size() == 45);
+            REQUIRE(symmetry.IsCanonical({ 1, 2, 1, 3 }));
+            REQUIRE(!symmetry.IsCanonical({ 1, 3, 1, 2 }));
+        }
+    }
+
+    GIVEN(" an exchange of two later blocks on the interesting combinations") {
+        auto indices = Indices::GetRomanSeries(6, {1,3});
+
+        Symmetry symmetry;
+        symmetry.Add(ElementarySymmetry(std::vector<std::pair<unsigned, unsigned>>({ { 2, 3 }, { 4, 5 } }), true));
+
+        THEN(" combinations whose representative is not interesting are kept") {
+            auto reduced = symmetry.Restrict(indices.GetInterestingCombinations());
+
+            REQUIRE(symmetry.Canonicalize({ 1, 1, 2, 1, 1, 3 }) == std::vector<unsigned>({ 1, 1, 1, 3, 2, 1 }));
+            REQUIRE(reduced.Contains({ 1, 1, 2, 1, 1, 3 }));
+            REQUIRE(!reduced.Contains({ 1, 2, 1, 2, 1, 1 }));
+            REQUIRE(reduced.Contains({ 1, 2, 1, 1, 1, 2 }));
+        }
+    }
+
+    GIVEN(" a tensor symmetrized like a coefficient") {
+        auto indices = Indices::GetRomanSeries(4, {1,3});
+        auto exchanged = indices.Partial({2,3});
+        exchanged.Append(indices.Partial({0,1}));
+
+        auto tensor = Construction::Language::API::Arbitrary(indices)
+            .Symmetrize(indices.Partial({0,1}))
+            .Symmetrize(indices.Partial({2,3}))
+            .ExchangeSymmetrize(indices, exchanged);
+
+        Symmetry symmetry;
+        symmetry.Add(ElementarySymmetry(std::vector<unsigned>({ 0, 1 }), true));
+        symmetry.Add(ElementarySymmetry(std::vector<unsigned>({ 2, 3 }), true));
+        symmetry.Add(ElementarySymmetry(std::vector<std::pair<unsigned, unsigned>>({ { 0, 1 }, { 2, 3 } }), true));
+
+        THEN(" simplifying with the symmetries yields the same tensor") {
+            auto full = tensor.Simplify();
+            auto reduced = tensor.Simplify(symmetry);
+
+            REQUIRE(reduced.ToString() == full.ToString());
+            REQUIRE(reduced.GetNumberOfSummands() == full.GetNumberOfSummands());
+        }
+    }
+
+    GIVEN(" a coefficient with three identical blocks") {
+        Construction::Equations::CoefficientDefinition definition;
+        for (int i=0; i<3; ++i) {
+            definition.AddBlock(2, 0, Construction::Equations::CoefficientDefinition::SymmetryType::SYMMETRIC);
+        }
+        definition.exchangeSymmetries = { true, true };
+
+        // Generated like in Coefficient::Calculate
+        auto indices = Indices::GetRomanSeries(6, {1,3});
+        auto blocks = [&](unsigned first, unsigned second, unsigned third) {
+            auto result = indices.Partial({ 2*first, 2*first+1 });
+            result.Append(indices.Partial({ 2*second, 2*second+1 }));
+            result.Append(indices.Partial({ 2*third, 2*third+1 }));
+            return result;
+        };
+
+        auto tensor = Construction::Language::API::Arbitrary(indices)
+            .Symmetrize(indices.Partial({0,1}))
+            .Symmetrize(indices.Partial({2,3}))
+            .Symmetrize(indices.Partial({4,5}))
+            .ExchangeSymmetrize(indices, blocks(1, 0, 2))
+            .ExchangeSymmetrize(indices, blocks(0, 2, 1));
+
+        auto symmetry = definition.GetSymmetry();
+
+        // Compare all the components with the ones of exchanged blocks
+        auto invariant = [&](unsigned first, unsigned second) {
+            for (auto& combination : indices.GetAllIndexCombinations()) {
+                auto exchanged = combination;
+                std::swap_ranges(exchanged.begin() + 2*first, exchanged.begin() + 2*first + 2, exchanged.begin() + 2*second);
+
+                auto difference = tensor(combination) - tensor(exchanged);
+                if (!difference.IsNumeric() || difference.ToDouble() != 0) return false;
+            }
+            return true;
+        };
+
+        THEN(" only the exchange applied last is declared") {
+            REQUIRE(!invariant(0, 1));
+            REQUIRE(invariant(1, 2));
+
+            REQUIRE(symmetry.IsCanonical({ 2, 2, 1, 1, 3, 3 }));
+            REQUIRE(!symmetry.IsCanonical({ 1, 1, 3, 3, 2, 2 }));
+        }
+
+        THEN(" simplifying with its symmetries yields the same tensor") {
+            auto full = tensor.Simplify();
+            auto reduced = tensor.Simplify(symmetry);
+
+            REQUIRE(reduced.ToString() == full.ToString());
+            REQUIRE(reduced.GetNumberOfSummands() == full.GetNumberOfSummands());
+        }
+    }
+
+    GIVEN(" a coefficient with four identical blocks with a derivative each") {
+        Construction::Equations::CoefficientDefinition definition;
+        for (int i=0; i<4; ++i) {
+            definition.AddBlock(1, 1, Construction::Equations::CoefficientDefinition::SymmetryType::NONE);
+        }
+        definition.exchangeSymmetries = { true, true, true };
+
+        auto indices = Indices::GetRomanSeries(8, {1,3});
+        auto tensor = Construction::Language::API::Arbitrary(indices);
+
+        for (unsigned i=0; i<3; ++i) {
+            Indices exchanged;
+            for (unsigned j=0; j<4; ++j) {
+                unsigned block = (j == i) ? i+1 : ((j == i+1) ? i : j);
+                exchanged.Append(indices.Partial({ 2*block, 2*block+1 }));
+            }
+
+            tensor = tensor.ExchangeSymmetrize(indices, exchanged);
+        }
+
+        THEN(" simplifying with its symmetries yields the same tensor") {
+            auto full = tensor.Simplify();
+            auto reduced = tensor.Simplify(definition.GetSymmetry());
+
+            REQUIRE(reduced.ToString() == full.ToString());
+            REQUIRE(reduced.GetNumberOfSummands() == full.GetNumberOfSummands());
+        }
+    }
+}